@@ -121,7 +121,8 @@ typedef struct cg_import_s {
 	void (*FreeTag)(mem_tag_t tag);
 
 	/**
-	 * @brief Creates and starts a thread for the given function.
+	 * @brief Runs the given function on the thread pool. The thread is
+	 * detached, and so the returned handle is always NULL.
 	 * @param name The thread name.
 	 * @param run The thread function.
 	 * @param data User data.
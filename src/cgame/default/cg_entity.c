@@ -179,10 +179,10 @@ void Cg_ApplyMeshModelTag(r_entity_t *child, const r_entity_t *parent, const cha
 	Matrix4x4_Normalize(&local, &local);
 
 	// add local origins to the local offset
-	Matrix4x4_Concat(&local, &local, &child->matrix);
+	Matrix4x4_Concatf(&local, &local, &child->matrix);
 
 	// move by parent matrix
-	Matrix4x4_Concat(&world, &parent->matrix, &local);
+	Matrix4x4_Concatf(&world, &parent->matrix, &local);
 
 	child->effects |= EF_LINKED;
 
@@ -227,7 +227,7 @@ r_entity_t *Cg_AddLinkedEntity(const r_entity_t *parent, const r_model_t *model,
 
 	r_entity_t *r_ent = cgi.AddEntity(&ent);
 
-	Matrix4x4_CreateFromEntity(&r_ent->matrix, r_ent->origin, r_ent->angles, r_ent->scale);
+	Matrix4x4_CreateFromEntityf(&r_ent->matrix, r_ent->origin, r_ent->angles, r_ent->scale);
 
 	Cg_ApplyMeshModelTag(r_ent, parent, tag_name);
 
@@ -348,9 +348,9 @@ static void Cg_AddClientEntity(cl_entity_t *ent, r_entity_t *e) {
 	r_entity_t *r_torso = cgi.AddEntity(&torso);
 	r_entity_t *r_head = cgi.AddEntity(&head);
 
-	Matrix4x4_CreateFromEntity(&r_legs->matrix, r_legs->origin, r_legs->angles, r_legs->scale);
-	Matrix4x4_CreateFromEntity(&r_torso->matrix, r_torso->origin, r_torso->angles, r_torso->scale);
-	Matrix4x4_CreateFromEntity(&r_head->matrix, r_head->origin, r_head->angles, r_head->scale);
+	Matrix4x4_CreateFromEntityf(&r_legs->matrix, r_legs->origin, r_legs->angles, r_legs->scale);
+	Matrix4x4_CreateFromEntityf(&r_torso->matrix, r_torso->origin, r_torso->angles, r_torso->scale);
+	Matrix4x4_CreateFromEntityf(&r_head->matrix, r_head->origin, r_head->angles, r_head->scale);
 
 	Cg_ApplyMeshModelTag(r_torso, r_legs, "tag_torso");
 	Cg_ApplyMeshModelTag(r_head, r_torso, "tag_head");
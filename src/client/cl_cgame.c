@@ -133,6 +133,17 @@ static char *Cl_ConfigString(uint16_t index) {
 	return cl.config_strings[index];
 }
 
+/**
+ * @brief The client game has no means of waiting on threads, so they are
+ * detached as soon as they are created.
+ */
+static thread_t *Cl_Thread(const char *name, ThreadRunFunc run, void *data) {
+
+	Thread_Detach(Thread_Create_(name, run, data));
+
+	return NULL;
+}
+
 /**
  * @brief Initializes the client game subsystem
  */
@@ -165,7 +176,7 @@ void Cl_InitCgame(void) {
 	import.Free = Mem_Free;
 	import.FreeTag = Mem_FreeTag;
 
-	import.Thread = Thread_Create_;
+	import.Thread = Cl_Thread;
 
 	import.BaseDir = Fs_BaseDir;
 	import.OpenFile = Fs_OpenRead;
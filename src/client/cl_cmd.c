@@ -79,6 +79,11 @@ static void Cl_WriteMovementCommand(mem_buf_t *buf) {
 		Net_WriteLong(buf, cl.frame.frame_num);
 	}
 
+	// echo the pending frame, once cached, so that the server may delta from it
+	if (cl.protocol >= PROTOCOL_MAJOR_CACHE) {
+		Net_WriteLong(buf, cl.cached_frame_num);
+	}
+
 	cl_cmd_t *from = &null_cmd, *to = &cl.cmds[(cls.net_chan.outgoing_sequence - 2) & CMD_MASK];
 	Net_WriteDeltaMoveCmd(buf, &from->cmd, &to->cmd);
 
@@ -35,7 +35,7 @@ static void Cl_WriteDemoHeader(void) {
 
 	// write the server data
 	Net_WriteByte(&msg, SV_CMD_SERVER_DATA);
-	Net_WriteShort(&msg, PROTOCOL_MAJOR);
+	Net_WriteShort(&msg, cl.protocol);
 	Net_WriteShort(&msg, cls.cgame->protocol);
 	Net_WriteByte(&msg, 1); // demo_server byte
 	Net_WriteString(&msg, Cvar_GetString("game"));
@@ -73,7 +73,7 @@ static void Cl_WriteDemoHeader(void) {
 		}
 
 		Net_WriteByte(&msg, SV_CMD_BASELINE);
-		Net_WriteDeltaEntity(&msg, &null_state, &cl.entities[i].baseline, true);
+		Net_WriteDeltaEntity(&msg, &null_state, &cl.entities[i].baseline, true, cl.protocol);
 	}
 
 	Net_WriteByte(&msg, SV_CMD_CBUF_TEXT);
@@ -31,9 +31,9 @@ static void Cl_ParsePlayerState(const cl_frame_t *delta_frame, cl_frame_t *frame
 	static player_state_t null_state;
 
 	if (delta_frame && delta_frame->valid) {
-		Net_ReadDeltaPlayerState(&net_message, &delta_frame->ps, &frame->ps);
+		Net_ReadDeltaPlayerState(&net_message, &delta_frame->ps, &frame->ps, cl.protocol);
 	} else {
-		Net_ReadDeltaPlayerState(&net_message, &null_state, &frame->ps);
+		Net_ReadDeltaPlayerState(&net_message, &null_state, &frame->ps, cl.protocol);
 	}
 
 	if (cl.demo_server) { // if playing a demo, force freeze
@@ -85,7 +85,11 @@ static void Cl_ReadDeltaEntity(cl_frame_t *frame, const entity_state_t *from, ui
 
 	frame->num_entities++;
 
-	Net_ReadDeltaEntity(&net_message, from, to, number, bits);
+	Net_ReadDeltaEntity(&net_message, from, to, number, bits, cl.protocol);
+
+	if (net_message.read > net_message.size) {
+		Com_Error(ERROR_DROP, "End of message\n");
+	}
 
 	// check to see if the delta was successful and valid
 	if (!Cl_ValidDeltaEntity(frame, ent, from, to)) {
@@ -163,7 +167,11 @@ static void Cl_ParseEntities(const cl_frame_t *delta_frame, cl_frame_t *frame) {
 		}
 
 		// now deal with the new entity
-		const uint16_t bits = Net_ReadShort(&net_message);
+		const uint16_t bits = Net_ReadEntityFlags(&net_message, cl.protocol);
+
+		if (net_message.read > net_message.size) {
+			Com_Error(ERROR_DROP, "End of message\n");
+		}
 
 		if (bits & U_REMOVE) { // remove it, no delta
 
@@ -239,6 +247,88 @@ static void Cl_ParseEntities(const cl_frame_t *delta_frame, cl_frame_t *frame) {
 	}
 }
 
+/**
+ * @brief Retains the cached frames the server has advertised, and caches the
+ * pending frame if it is still held in the frame backup. The pending frame is
+ * echoed to the server once it has been cached, so that the server may delta
+ * from it should we fall too far behind.
+ */
+static void Cl_UpdateCachedFrames(int32_t acked, int32_t pending) {
+	cl_cached_frame_t *free_frame = NULL;
+
+	cl.cached_frame_num = 0;
+
+	for (size_t i = 0; i < lengthof(cl.cached_frames); i++) {
+		cl_cached_frame_t *cached = &cl.cached_frames[i];
+
+		if (cached->frame.frame_num > 0) {
+			if (cached->frame.frame_num == pending) {
+				cl.cached_frame_num = pending;
+				continue;
+			}
+			if (cached->frame.frame_num == acked) {
+				continue;
+			}
+		}
+
+		cached->frame.frame_num = 0;
+		free_frame = cached;
+	}
+
+	if (pending <= 0 || cl.cached_frame_num == pending || free_frame == NULL) {
+		return;
+	}
+
+	const cl_frame_t *frame = &cl.frames[pending & PACKET_MASK];
+
+	if (!frame->valid || frame->frame_num != pending) {
+		return;
+	}
+
+	if (frame->num_entities > MAX_PACKET_ENTITIES) {
+		return;
+	}
+
+	if (cl.entity_state - frame->entity_state > ENTITY_STATE_BACKUP - PACKET_BACKUP) {
+		return;
+	}
+
+	free_frame->frame = *frame;
+	free_frame->frame.entity_state = 0;
+
+	for (uint16_t i = 0; i < frame->num_entities; i++) {
+		free_frame->entity_states[i] = cl.entity_states[(frame->entity_state + i) & ENTITY_STATE_MASK];
+	}
+
+	cl.cached_frame_num = pending;
+}
+
+/**
+ * @return The cached frame for the specified frame number, with its entity states
+ * restored to cl.entity_states so that it may be delta'd from, or NULL.
+ */
+static const cl_frame_t *Cl_CachedDeltaFrame(int32_t frame_num) {
+
+	for (size_t i = 0; i < lengthof(cl.cached_frames); i++) {
+		const cl_cached_frame_t *cached = &cl.cached_frames[i];
+
+		if (cached->frame.frame_num > 0 && cached->frame.frame_num == frame_num) {
+
+			cl.cached_delta_frame = cached->frame;
+			cl.cached_delta_frame.entity_state = cl.entity_state;
+
+			for (uint16_t j = 0; j < cached->frame.num_entities; j++) {
+				cl.entity_states[cl.entity_state & ENTITY_STATE_MASK] = cached->entity_states[j];
+				cl.entity_state++;
+			}
+
+			return &cl.cached_delta_frame;
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * @brief Parses a new server frame, ensuring that the previously received frame is interpolated
  * before proceeding. This ensure that all server frames are processed, even if their simulation
@@ -253,9 +343,34 @@ void Cl_ParseFrame(void) {
 	memset(&cl.frame, 0, sizeof(cl.frame));
 
 	cl.frame.frame_num = Net_ReadLong(&net_message);
-	cl.frame.delta_frame_num = Net_ReadLong(&net_message);
 
-	cl.suppress_count += Net_ReadByte(&net_message);
+	size_t len; // the length of the area bits
+
+	if (cl.protocol >= PROTOCOL_MAJOR_BITS) {
+		net_bits_t bits;
+
+		Net_BeginReadingBits(&bits, &net_message);
+
+		const int32_t offset = Net_ReadBitsVarInt(&bits);
+		cl.frame.delta_frame_num = offset ? cl.frame.frame_num - offset : -1;
+
+		cl.suppress_count += Net_ReadBitsVarInt(&bits);
+		len = Net_ReadBits(&bits, 8);
+
+		if (cl.protocol >= PROTOCOL_MAJOR_CACHE) {
+			const int32_t acked = Net_ReadBitsVarInt(&bits);
+			const int32_t pending = Net_ReadBitsVarInt(&bits);
+
+			Cl_UpdateCachedFrames(acked ? cl.frame.frame_num - acked : 0,
+			                      pending ? cl.frame.frame_num - pending : 0);
+		}
+
+		Net_EndReadingBits(&bits);
+	} else {
+		cl.frame.delta_frame_num = Net_ReadLong(&net_message);
+		cl.suppress_count += Net_ReadByte(&net_message);
+		len = Net_ReadByte(&net_message);
+	}
 
 	if (cl_draw_net_messages->integer == 3) {
 		Com_Print("   frame:%i  delta:%i\n", cl.frame.frame_num, cl.frame.delta_frame_num);
@@ -266,6 +381,14 @@ void Cl_ParseFrame(void) {
 	} else { // delta compressed frame
 		cl.delta_frame = &cl.frames[cl.frame.delta_frame_num & PACKET_MASK];
 
+		// the server may delta from a cached frame once the frame backup is exhausted
+		if (!cl.delta_frame->valid || cl.delta_frame->frame_num != cl.frame.delta_frame_num) {
+			const cl_frame_t *cached = Cl_CachedDeltaFrame(cl.frame.delta_frame_num);
+			if (cached) {
+				cl.delta_frame = cached;
+			}
+		}
+
 		if (!cl.delta_frame->valid) {
 			Com_Error(ERROR_DROP, "Delta from invalid frame\n");
 		} else if (cl.delta_frame->frame_num != cl.frame.delta_frame_num) {
@@ -287,7 +410,6 @@ void Cl_ParseFrame(void) {
 
 	cl.frame.valid = true;
 
-	const size_t len = Net_ReadByte(&net_message); // read area_bits
 	Net_ReadData(&net_message, &cl.frame.area_bits, len);
 
 	Cl_ParsePlayerState(cl.delta_frame, &cl.frame);
@@ -448,8 +570,8 @@ void Cl_Interpolate(void) {
 			Cm_EntityBounds(ent->current.solid, ent->current.origin, angles, ent->mins, ent->maxs,
 			                ent->abs_mins, ent->abs_maxs);
 
-			Matrix4x4_CreateFromEntity(&ent->matrix, ent->current.origin, angles, 1.0);
-			Matrix4x4_Invert_Simple(&ent->inverse_matrix, &ent->matrix);
+			Matrix4x4_CreateFromEntityf(&ent->matrix, ent->current.origin, angles, 1.0);
+			Matrix4x4_Invert_Simplef(&ent->inverse_matrix, &ent->matrix);
 		}
 	}
 
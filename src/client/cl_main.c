@@ -284,6 +284,8 @@ void Cl_Disconnect(void) {
 
 	Cl_SendDisconnect();
 
+	Netchan_Close(&cls.net_chan);
+
 	Cl_ClearState();
 
 	if (cls.demo_file) {
@@ -420,7 +422,13 @@ static void Cl_ConnectionlessPacket(void) {
 
 	// servers list from master
 	if (!g_strcmp0(c, "servers")) {
-		Cl_ParseServers();
+		Cl_ParseServers(false);
+		return;
+	}
+
+	// servers list, including IPv6 servers, from master
+	if (!g_strcmp0(c, "servers6")) {
+		Cl_ParseServers(true);
 		return;
 	}
 
@@ -142,20 +142,24 @@ static void Cl_ParseBaseline(void) {
 	static entity_state_t null_state;
 
 	const uint16_t number = Net_ReadShort(&net_message);
-	const uint16_t bits = Net_ReadShort(&net_message);
+	const uint16_t bits = Net_ReadEntityFlags(&net_message, cl.protocol);
+
+	if (number >= MAX_ENTITIES || net_message.read > net_message.size) {
+		Com_Error(ERROR_DROP, "Bad baseline: %i\n", number);
+	}
 
 	cl_entity_t *ent = &cl.entities[number];
 
-	Net_ReadDeltaEntity(&net_message, &null_state, &ent->baseline, number, bits);
+	Net_ReadDeltaEntity(&net_message, &null_state, &ent->baseline, number, bits, cl.protocol);
 
 	// initialize clipping matrices
 	if (ent->baseline.solid) {
 		if (ent->baseline.solid == SOLID_BSP) {
-			Matrix4x4_CreateFromEntity(&ent->matrix, ent->baseline.origin, ent->baseline.angles, 1.0);
-			Matrix4x4_Invert_Simple(&ent->inverse_matrix, &ent->matrix);
+			Matrix4x4_CreateFromEntityf(&ent->matrix, ent->baseline.origin, ent->baseline.angles, 1.0);
+			Matrix4x4_Invert_Simplef(&ent->inverse_matrix, &ent->matrix);
 		} else { // bounding-box entities
-			Matrix4x4_CreateFromEntity(&ent->matrix, ent->baseline.origin, vec3_origin, 1.0);
-			Matrix4x4_Invert_Simple(&ent->inverse_matrix, &ent->matrix);
+			Matrix4x4_CreateFromEntityf(&ent->matrix, ent->baseline.origin, vec3_origin, 1.0);
+			Matrix4x4_Invert_Simplef(&ent->inverse_matrix, &ent->matrix);
 		}
 	}
 }
@@ -276,10 +280,12 @@ static void Cl_ParseServerData(void) {
 	const uint16_t minor = Net_ReadShort(&net_message);
 
 	// ensure protocol major matches
-	if (major != PROTOCOL_MAJOR) {
+	if (major < PROTOCOL_MAJOR_LEGACY || major > PROTOCOL_MAJOR) {
 		Com_Error(ERROR_DROP, "Server is using protocol major %d, you have %d\n", major, PROTOCOL_MAJOR);
 	}
 
+	cl.protocol = major;
+
 	// determine if we're viewing a demo
 	cl.demo_server = Net_ReadByte(&net_message);
 
@@ -260,6 +260,13 @@ static void Cl_DrawRendererStats(void) {
 	y += ch;
 
 	R_DrawString(0, y, va("cull: %d pass, %d fail", r_view.cull_passes, r_view.cull_fails), CON_COLOR_WHITE);
+	y += ch;
+
+	thread_stats_t thread_stats;
+	Thread_Stats(&thread_stats);
+
+	R_DrawString(0, y, va("threads: %u waits, %u spun, %u slept; %.2fms", thread_stats.waits, thread_stats.spins,
+	                      thread_stats.sleeps, thread_stats.wait_time / 1000.0), CON_COLOR_WHITE);
 
 	R_BindFont(NULL, NULL, NULL);
 }
@@ -203,42 +203,46 @@ void Cl_Servers_f(void) {
 	addr.type = NA_DATAGRAM;
 	addr.port = htons(PORT_MASTER);
 
-	Netchan_OutOfBandPrint(NS_UDP_CLIENT, &addr, "getservers");
+	Netchan_OutOfBandPrint(NS_UDP_CLIENT, &addr, "getservers6");
 
 	Cl_SendBroadcast();
 }
 
 /**
- * @brief
+ * @brief Parses the servers list from the master. IPv4 servers are listed as
+ * 4 byte addresses, while the `servers6` response lists all servers as 16 byte
+ * IPv6 addresses, with IPv4 servers v4-mapped. Older masters answer our
+ * `getservers6` request with the IPv4 list.
  */
-void Cl_ParseServers(void) {
+void Cl_ParseServers(_Bool ipv6) {
 	cl_server_info_t *server;
 
-	byte *buffptr = net_message.data + 12;
-	byte *buffend = buffptr + net_message.size - 12;
+	const size_t header = ipv6 ? 13 : 12;
+	const size_t addr_len = ipv6 ? 16 : 4;
+
+	byte *buffptr = net_message.data + header;
+	byte *buffend = buffptr + net_message.size - header;
 
 	// parse the list
-	while (buffptr + 1 < buffend) {
+	while (buffptr + addr_len + 1 < buffend) {
 		net_addr_t addr;
-		byte ip[4];
+		memset(&addr, 0, sizeof(addr));
 
-		ip[0] = *buffptr++; // parse the address
-		ip[1] = *buffptr++;
-		ip[2] = *buffptr++;
-		ip[3] = *buffptr++;
+		addr.type = NA_DATAGRAM;
 
-		uint16_t port = (*buffptr++) << 8; // and the port
-		port += *buffptr++;
+		if (ipv6) {
+			memcpy(&addr.addr, buffptr, addr_len); // parse the address
+		} else {
+			addr.addr.s6_addr[10] = addr.addr.s6_addr[11] = 0xff;
+			memcpy(&addr.addr.s6_addr[12], buffptr, addr_len);
+		}
 
-		char s[32];
-		g_snprintf(s, sizeof(s), "%d.%d.%d.%d:%d", ip[0], ip[1], ip[2], ip[3], port);
+		buffptr += addr_len;
 
-		Com_Debug(DEBUG_CLIENT, "Parsed %s\n", s);
+		memcpy(&addr.port, buffptr, sizeof(addr.port)); // and the port, in network byte order
+		buffptr += sizeof(addr.port);
 
-		if (!Net_StringToNetaddr(s, &addr)) { // make sure it's valid
-			Com_Warn("Invalid address: %s\n", s);
-			break;
-		}
+		Com_Debug(DEBUG_CLIENT, "Parsed %s\n", Net_NetaddrToString(&addr));
 
 		if (!addr.port) { // 0's mean we're done
 			break;
@@ -29,6 +29,6 @@ void Cl_Servers_f(void);
 void Cl_FreeServers(void);
 void Cl_Ping_f(void);
 void Cl_ParseServerInfo(void);
-void Cl_ParseServers(void);
+void Cl_ParseServers(_Bool ipv6);
 void Cl_Servers_List_f(void);
 #endif /* __CL_LOCAL_H__ */
@@ -44,6 +44,16 @@ typedef struct {
 	uint32_t time; // simulation time for which the frame is valid
 } cl_frame_t;
 
+/**
+ * @brief Frames the server has asked the client to cache, so that it may delta
+ * from them once the client falls too far behind to delta from its frame
+ * backup. The frame's entity_state indexes entity_states.
+ */
+typedef struct {
+	cl_frame_t frame;
+	entity_state_t entity_states[MAX_PACKET_ENTITIES];
+} cl_cached_frame_t;
+
 typedef struct {
 	entity_animation_t animation;
 	uint32_t time;
@@ -166,6 +176,10 @@ typedef struct {
 	cl_frame_t frame; // the most recent frame received from server
 	cl_frame_t frames[PACKET_BACKUP]; // for calculating delta compression
 
+	cl_cached_frame_t cached_frames[2]; // the acknowledged and pending cached frames
+	cl_frame_t cached_delta_frame; // a cached frame, restored to entity_states to delta from
+	int32_t cached_frame_num; // the pending frame, once cached, echoed to the server
+
 	const cl_frame_t *delta_frame; // the delta frame for the current frame
 	const cl_frame_t *previous_frame; // the last interpolated frame, if sequential
 
@@ -190,6 +204,7 @@ typedef struct {
 	// tracked view angles to account for spawn and teleport direction changes
 	vec3_t angles;
 
+	uint16_t protocol; // the protocol major version of the server or demo
 	_Bool demo_server; // we're viewing a demo
 	_Bool third_person; // we're viewing third person camera
 
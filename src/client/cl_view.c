@@ -47,6 +47,8 @@ void Cl_ClearView(void) {
 	r_view.num_mesh_models = r_view.num_mesh_tris = 0;
 
 	r_view.cull_passes = r_view.cull_fails = 0;
+
+	Thread_ResetStats();
 }
 
 /**
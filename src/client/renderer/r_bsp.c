@@ -125,7 +125,7 @@ static void R_RotateLightsForBspInlineModel(const r_entity_t *e) {
 
 	for (uint16_t i = 0; i < r_view.num_lights; i++, l++) {
 		if (e) {
-			Matrix4x4_Transform(&e->inverse_matrix, light_origins[i], l->origin);
+			Matrix4x4_Transformf(&e->inverse_matrix, light_origins[i], l->origin);
 			R_MarkLight(l, nodes + e->model->bsp_inline->head_node);
 		} else {
 			VectorCopy(light_origins[i], l->origin);
@@ -55,7 +55,7 @@ void R_RotateForEntity(const r_entity_t *e) {
 
 	R_GetMatrix(R_MATRIX_MODELVIEW, &modelview);
 
-	Matrix4x4_Concat(&modelview, &modelview, &e->matrix);
+	Matrix4x4_Concatf(&modelview, &modelview, &e->matrix);
 
 	R_SetMatrix(R_MATRIX_MODELVIEW, &modelview);
 }
@@ -67,14 +67,14 @@ void R_RotateForEntity(const r_entity_t *e) {
 void R_SetMatrixForEntity(r_entity_t *e) {
 
 	if (!(e->effects & EF_LINKED)) { // child models use explicit matrix, do not recompute
-		Matrix4x4_CreateFromEntity(&e->matrix, e->origin, e->angles, e->scale);
+		Matrix4x4_CreateFromEntityf(&e->matrix, e->origin, e->angles, e->scale);
 	}
 
 	if (IS_MESH_MODEL(e->model)) {
 		R_ApplyMeshModelConfig(e);
 	}
 
-	Matrix4x4_Invert_Simple(&e->inverse_matrix, &e->matrix);
+	Matrix4x4_Invert_Simplef(&e->inverse_matrix, &e->matrix);
 }
 
 /**
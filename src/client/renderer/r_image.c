@@ -138,7 +138,7 @@ void R_Screenshot_f(void) {
 		glReadPixels(0, 0, s->width, s->height, GL_BGR, GL_UNSIGNED_BYTE, s->buffer);
 	}
 
-	Thread_Create(R_Screenshot_f_encode, s);
+	Thread_Detach(Thread_Create(R_Screenshot_f_encode, s));
 }
 
 /**
@@ -281,6 +281,28 @@ static void R_LoadHeightmap(const char *name, const SDL_Surface *surf) {
 	}
 }
 
+/**
+ * @brief Resolves the file backing the specified image, for prefetching.
+ *
+ * @return The filename, or NULL if the image is already loaded or can not be
+ * found.
+ */
+const char *R_ResolveImage(const char *name) {
+	char key[MAX_QPATH];
+
+	if (!name || !name[0]) {
+		return NULL;
+	}
+
+	StripExtension(name, key);
+
+	if (R_FindMedia(key)) {
+		return NULL;
+	}
+
+	return Img_ResolveImage(key);
+}
+
 /**
  * @brief Loads the image by the specified name.
  */
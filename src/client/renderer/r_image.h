@@ -23,6 +23,7 @@
 
 #include "r_types.h"
 
+const char *R_ResolveImage(const char *name);
 r_image_t *R_LoadImage(const char *name, r_image_type_t type);
 
 #ifdef __R_LOCAL_H__
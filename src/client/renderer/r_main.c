@@ -356,6 +356,34 @@ void R_InitView(void) {
 	Matrix4x4_FromOrtho(&r_view.matrix_base_ui, 0.0, r_context.window_width, r_context.window_height, 0.0, -1.0, 1.0);
 }
 
+/**
+ * @brief Queues the files backing the models and images named in the config
+ * strings for asynchronous loading, so that they are read while the world
+ * loads. R_LoadModel and R_LoadImage then claim them through Fs_Load.
+ */
+static void R_PrefetchMedia(void) {
+
+	GPtrArray *filenames = g_ptr_array_new_with_free_func(Mem_Free);
+
+	for (uint32_t i = 1; i < MAX_MODELS && cl.config_strings[CS_MODELS + i][0]; i++) {
+		const char *filename = R_ResolveModel(cl.config_strings[CS_MODELS + i]);
+		if (filename) {
+			g_ptr_array_add(filenames, Mem_CopyString(filename));
+		}
+	}
+
+	for (uint32_t i = 0; i < MAX_IMAGES && cl.config_strings[CS_IMAGES + i][0]; i++) {
+		const char *filename = R_ResolveImage(cl.config_strings[CS_IMAGES + i]);
+		if (filename) {
+			g_ptr_array_add(filenames, Mem_CopyString(filename));
+		}
+	}
+
+	Fs_LoadAsyncBatch((const char **) filenames->pdata, filenames->len, NULL, NULL);
+
+	g_ptr_array_free(filenames, true);
+}
+
 /**
  * @brief Loads all media for the renderer subsystem.
  */
@@ -371,6 +399,8 @@ void R_LoadMedia(void) {
 
 	R_BeginLoading();
 
+	R_PrefetchMedia();
+
 	Cl_LoadingProgress(1, "world");
 
 	R_LoadModel(cl.config_strings[CS_MODELS]); // load the world
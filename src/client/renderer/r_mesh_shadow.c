@@ -77,7 +77,7 @@ static void R_RotateForMeshShadow_default(const r_entity_t *e, const r_shadow_t
 
 	R_GetMatrix(R_MATRIX_MODELVIEW, &modelview);
 
-	Matrix4x4_Concat(&proj, &modelview, &proj);
+	Matrix4x4_Concatf(&proj, &modelview, &proj);
 
 	R_SetMatrix(R_MATRIX_MODELVIEW, &proj);
 }
@@ -91,7 +91,7 @@ static void R_CalculateShadowMatrix_default(const r_entity_t *e, const r_shadow_
 	// transform the light position and shadow plane into model space
 	vec4_t light, plane;
 
-	Matrix4x4_Transform(&e->inverse_matrix, s->illumination->light.origin, light);
+	Matrix4x4_Transformf(&e->inverse_matrix, s->illumination->light.origin, light);
 	light[3] = 1.0;
 
 	const cm_bsp_plane_t *p = &s->plane;
@@ -121,7 +121,7 @@ static void R_CalculateShadowMatrix_default(const r_entity_t *e, const r_shadow_
 	matrix.m[2][3] = 0.0 - light[3] * plane[2];
 	matrix.m[3][3] = dot - light[3] * plane[3];
 
-	Matrix4x4_Transform(&r_view.matrix, s->illumination->light.origin, light);
+	Matrix4x4_Transformf(&r_view.matrix, s->illumination->light.origin, light);
 	light[3] = s->illumination->light.radius;
 
 	Matrix4x4_TransformQuakePlane(&r_view.matrix, p->normal, p->dist, plane);
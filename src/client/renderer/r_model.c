@@ -105,6 +105,39 @@ static void R_FreeModel(r_media_t *self) {
 	R_GetError(mod->media.name);
 }
 
+/**
+ * @brief Resolves the file backing the specified model, for prefetching.
+ *
+ * @return The filename, or NULL if the model is already loaded, is an inline
+ * model, or can not be found.
+ */
+const char *R_ResolveModel(const char *name) {
+	static char filename[MAX_QPATH];
+	char key[MAX_QPATH];
+
+	if (!name || !name[0] || *name == '*') {
+		return NULL;
+	}
+
+	StripExtension(name, key);
+
+	if (R_FindMedia(key)) {
+		return NULL;
+	}
+
+	const r_model_format_t *format = r_model_formats;
+	for (size_t i = 0; i < lengthof(r_model_formats); i++, format++) {
+
+		g_snprintf(filename, sizeof(filename), "%s%s", key, format->extension);
+
+		if (Fs_Exists(filename)) {
+			return format->type == MOD_BSP ? NULL : filename;
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * @brief Loads the model by the specified name.
  */
@@ -156,13 +189,22 @@ r_model_t *R_LoadModel(const char *name) {
 
 		void *buf = NULL;
 
-		Fs_Load(filename, &buf);
+		// BSP models are large, and read only once, so map them rather than copy
+		if (format->type == MOD_BSP) {
+			Fs_Map(filename, (const void **) &buf);
+		} else {
+			Fs_Load(filename, &buf);
+		}
 
 		// load it
 		format->Load(mod, buf);
 
 		// free the file
-		Fs_Free(buf);
+		if (format->type == MOD_BSP) {
+			Fs_Unmap(buf);
+		} else {
+			Fs_Free(buf);
+		}
 
 		// calculate an approximate radius from the bounding box
 		vec3_t tmp;
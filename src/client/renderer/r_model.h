@@ -23,6 +23,7 @@
 
 #include "r_types.h"
 
+const char *R_ResolveModel(const char *name);
 r_model_t *R_LoadModel(const char *name);
 r_model_t *R_WorldModel(void);
 
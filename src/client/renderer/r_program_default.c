@@ -276,7 +276,7 @@ void R_UseLight_default(const uint16_t light_index, const matrix4x4_t *world_vie
 
 	if (light && light->radius) {
 		vec3_t origin;
-		Matrix4x4_Transform(world_view, light->origin, origin);
+		Matrix4x4_Transformf(world_view, light->origin, origin);
 
 		R_ProgramParameter3fv(&p->lights[light_index].origin, origin);
 		R_ProgramParameter3fv(&p->lights[light_index].color, light->color);
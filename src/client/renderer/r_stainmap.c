@@ -394,7 +394,7 @@ void R_AddStains(void) {
 
 			// add a "new" stain for the transformed position
 			r_view.stains[r_view.num_stains] = *s;
-			Matrix4x4_Transform(&ent->inverse_matrix, s->origin, r_view.stains[r_view.num_stains].origin);
+			Matrix4x4_Transformf(&ent->inverse_matrix, s->origin, r_view.stains[r_view.num_stains].origin);
 
 			if (R_StainNode(&r_view.stains[r_view.num_stains], node)) {
 				r_view.num_stains++;
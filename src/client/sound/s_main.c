@@ -204,6 +204,28 @@ void S_Frame(void) {
 	S_MixChannels();
 }
 
+/**
+ * @brief Queues the files backing the samples named in the config strings for
+ * asynchronous loading, so that they are read while earlier samples decode.
+ * S_LoadSample then claims them through Fs_Load.
+ */
+static void S_PrefetchMedia(void) {
+	extern cl_client_t cl;
+
+	GPtrArray *filenames = g_ptr_array_new_with_free_func(Mem_Free);
+
+	for (uint32_t i = 0; i < MAX_SOUNDS && cl.config_strings[CS_SOUNDS + i][0]; i++) {
+		const char *filename = S_ResolveSample(cl.config_strings[CS_SOUNDS + i]);
+		if (filename) {
+			g_ptr_array_add(filenames, Mem_CopyString(filename));
+		}
+	}
+
+	Fs_LoadAsyncBatch((const char **) filenames->pdata, filenames->len, NULL, NULL);
+
+	g_ptr_array_free(filenames, true);
+}
+
 /**
  * @brief Loads all media for the sound subsystem.
  */
@@ -222,6 +244,8 @@ void S_LoadMedia(void) {
 
 	S_BeginLoading();
 
+	S_PrefetchMedia();
+
 	Cl_LoadingProgress(80, "sounds");
 
 	if (*cl_chat_sound->string) {
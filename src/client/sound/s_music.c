@@ -316,6 +316,7 @@ static int S_MusicThread(void *data) {
 	
 		if (s_music_state.shutdown) {
 			SDL_mutexV(s_music_state.mutex);
+			Mem_ThreadShutdown();
 			return 1;
 		}
 
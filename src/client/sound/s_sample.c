@@ -192,6 +192,50 @@ static void S_LoadSampleChunk(s_sample_t *sample) {
 	}
 }
 
+/**
+ * @brief Resolves the file backing the specified sample, trying sound paths
+ * and sample types in the same order as S_LoadSampleChunk, for prefetching.
+ *
+ * @return The filename, or NULL if the sample is already loaded, is a place
+ * holder, or can not be found.
+ */
+const char *S_ResolveSample(const char *name) {
+	static char path[MAX_QPATH];
+	char key[MAX_QPATH];
+
+	if (!name || !name[0] || name[0] == '*') {
+		return NULL;
+	}
+
+	StripExtension(name, key);
+
+	if (S_FindMedia(key)) {
+		return NULL;
+	}
+
+	for (int32_t i = 0; SOUND_PATHS[i]; i++) {
+
+		for (int32_t j = 0; SAMPLE_TYPES[j]; j++) {
+
+			if (key[0] == '#') { // global path
+				g_snprintf(path, sizeof(path), "%s%s", key + 1, SAMPLE_TYPES[j]);
+			} else {
+				g_snprintf(path, sizeof(path), "%s%s%s", SOUND_PATHS[i], key, SAMPLE_TYPES[j]);
+			}
+
+			if (Fs_Exists(path)) {
+				return path;
+			}
+		}
+
+		if (key[0] == '#') {
+			break;
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * @brief Free event listener for s_sample_t.
  */
@@ -21,6 +21,7 @@
 
 #pragma once
 
+const char *S_ResolveSample(const char *name);
 s_sample_t *S_LoadSample(const char *name);
 
 #ifdef __S_LOCAL_H__
@@ -29,13 +29,32 @@ typedef struct cmd_args_s {
 	char args[MAX_STRING_CHARS];
 } cmd_args_t;
 
+/**
+ * @brief The command buffer starts at this size, doubling as needed to at most
+ * CBUF_MAX_CHARS.
+ */
 #define CBUF_CHARS 8192
+#define CBUF_MAX_CHARS (1024 * 1024 * 4)
 
 typedef struct cmd_state_s {
 	GHashTable *commands;
 
-	mem_buf_t buf;
-	char buffers[2][CBUF_CHARS];
+	/**
+	 * @brief The command buffer. Pending text lies between the read and write
+	 * cursors. Text inserted at the front is written immediately before the
+	 * read cursor when it fits, so neither executing a line nor inserting text
+	 * moves the pending text.
+	 */
+	struct {
+		char *data;
+		size_t size;
+		size_t read, write;
+	} buf;
+
+	/**
+	 * @brief Text deferred until Cbuf_InsertFromDefer (command line arguments).
+	 */
+	char *defer;
 
 	cmd_args_t args;
 
@@ -48,19 +67,63 @@ static cmd_state_t cmd_state;
 
 #define MAX_ALIAS_LOOP_COUNT 8
 
+/**
+ * @brief Ensures the command buffer can hold `len` bytes, growing it if needed.
+ *
+ * @return True on success, false if the command buffer would overflow.
+ */
+static _Bool Cbuf_Reserve(size_t len) {
+
+	if (len <= cmd_state.buf.size) {
+		return true;
+	}
+
+	if (len > CBUF_MAX_CHARS) {
+		Com_Warn("Overflow\n");
+		return false;
+	}
+
+	size_t size = cmd_state.buf.size ?: CBUF_CHARS;
+	while (size < len) {
+		size *= 2;
+	}
+
+	size = MIN(size, CBUF_MAX_CHARS);
+
+	if (cmd_state.buf.data) {
+		cmd_state.buf.data = Mem_Realloc(cmd_state.buf.data, size);
+	} else {
+		cmd_state.buf.data = Mem_TagMalloc(size, MEM_TAG_CMD);
+	}
+
+	cmd_state.buf.size = size;
+
+	return true;
+}
+
 /**
  * @brief Adds command text at the end of the buffer
  */
 void Cbuf_AddText(const char *text) {
 
-	const size_t l = strlen(text);
+	const size_t len = strlen(text);
+	const size_t pending = cmd_state.buf.write - cmd_state.buf.read;
 
-	if (cmd_state.buf.size + l >= cmd_state.buf.max_size) {
-		Com_Warn("Overflow\n");
-		return;
+	if (cmd_state.buf.write + len > cmd_state.buf.size) {
+
+		if (!Cbuf_Reserve(pending + len)) {
+			return;
+		}
+
+		// reclaim the space preceding the read cursor
+		memmove(cmd_state.buf.data, cmd_state.buf.data + cmd_state.buf.read, pending);
+
+		cmd_state.buf.read = 0;
+		cmd_state.buf.write = pending;
 	}
 
-	Mem_WriteBuffer(&cmd_state.buf, text, l);
+	memcpy(cmd_state.buf.data + cmd_state.buf.write, text, len);
+	cmd_state.buf.write += len;
 }
 
 /**
@@ -68,50 +131,56 @@ void Cbuf_AddText(const char *text) {
  */
 void Cbuf_InsertText(const char *text) {
 
-	if (text  && strlen(text)) {
-		void *temp;
+	const size_t len = text ? strlen(text) : 0;
+	if (len == 0) {
+		return;
+	}
 
-		// copy off any commands still remaining in the exec buffer
-		const size_t size = cmd_state.buf.size;
-		if (size) {
-			temp = Mem_TagMalloc(size, MEM_TAG_CMD);
-			memcpy(temp, cmd_state.buf.data, size);
-			Mem_ClearBuffer(&cmd_state.buf);
-		} else {
-			temp = NULL; // shut up compiler
+	if (len <= cmd_state.buf.read) {
+		cmd_state.buf.read -= len;
+	} else {
+		const size_t pending = cmd_state.buf.write - cmd_state.buf.read;
+
+		if (!Cbuf_Reserve(len + pending)) {
+			return;
 		}
 
-		// add the entire text of the file
-		Cbuf_AddText(text);
+		memmove(cmd_state.buf.data + len, cmd_state.buf.data + cmd_state.buf.read, pending);
 
-		// add the copied off data
-		if (size) {
-			Mem_WriteBuffer(&cmd_state.buf, temp, size);
-			Mem_Free(temp);
-		}
+		cmd_state.buf.read = 0;
+		cmd_state.buf.write = len + pending;
 	}
+
+	memcpy(cmd_state.buf.data + cmd_state.buf.read, text, len);
 }
 
 /**
- * @brief
+ * @brief Moves the pending command text to the deferred buffer.
  */
 void Cbuf_CopyToDefer(void) {
 
-	memcpy(cmd_state.buffers[1], cmd_state.buffers[0], cmd_state.buf.size);
+	const size_t pending = cmd_state.buf.write - cmd_state.buf.read;
 
-	memset(cmd_state.buffers[0], 0, sizeof(cmd_state.buffers[0]));
+	Mem_Free(cmd_state.defer);
 
-	cmd_state.buf.size = 0;
+	cmd_state.defer = Mem_TagMalloc(pending + 1, MEM_TAG_CMD);
+	memcpy(cmd_state.defer, cmd_state.buf.data + cmd_state.buf.read, pending);
+	cmd_state.defer[pending] = '\0';
+
+	cmd_state.buf.read = cmd_state.buf.write = 0;
 }
 
 /**
- * @brief
+ * @brief Inserts the deferred command text at the beginning of the buffer.
  */
 void Cbuf_InsertFromDefer(void) {
 
-	Cbuf_InsertText(cmd_state.buffers[1]);
+	if (cmd_state.defer) {
+		Cbuf_InsertText(cmd_state.defer);
 
-	memset(cmd_state.buffers[1], 0, sizeof(cmd_state.buffers[1]));
+		Mem_Free(cmd_state.defer);
+		cmd_state.defer = NULL;
+	}
 }
 
 /**
@@ -121,16 +190,18 @@ void Cbuf_Execute(void) {
 
 	cmd_state.alias_loop_count = 0; // don't allow infinite alias loops
 
-	while (cmd_state.buf.size) {
+	while (cmd_state.buf.read < cmd_state.buf.write) {
 
 		// read a single command line from the buffer
 		char line[sizeof(cmd_state.args.args)] = "";
 
 		// find a \n or; line break
-		char *text = (char *) cmd_state.buf.data;
+		const char *text = cmd_state.buf.data + cmd_state.buf.read;
+		const size_t pending = cmd_state.buf.write - cmd_state.buf.read;
 
-		uint32_t i, quotes = 0;
-		for (i = 0; i < cmd_state.buf.size; i++) {
+		size_t i;
+		uint32_t quotes = 0;
+		for (i = 0; i < pending; i++) {
 			if (text[i] == '"') {
 				quotes++;
 			}
@@ -142,26 +213,23 @@ void Cbuf_Execute(void) {
 			}
 		}
 
-		if (i == sizeof(line)) {
+		if (i >= sizeof(line)) {
 			Com_Warn("Command exceeded %" PRIuPTR " chars, discarded\n", sizeof(line));
 		} else {
-			g_strlcpy(line, text, i + 1);
+			memcpy(line, text, i);
+			line[i] = '\0';
 		}
 
-		// delete the text from the command buffer and move remaining commands down
-		// this is necessary because commands (exec, alias) can insert data at the
-		// beginning of the text buffer
+		// advance the read cursor past the line; commands (exec, alias) may then
+		// insert text in front of it without moving the remaining commands
 
-		if (i == cmd_state.buf.size) {
-			cmd_state.buf.size = 0;
-		} else {
-			i++;
+		cmd_state.buf.read += MIN(i + 1, pending);
 
-			cmd_state.buf.size = cmd_state.buf.size - i;
-			memmove(text, text + i, cmd_state.buf.size);
+		if (cmd_state.buf.read == cmd_state.buf.write) {
+			cmd_state.buf.read = cmd_state.buf.write = 0;
 		}
 
-		// execute the command linequit
+		// execute the command line
 
 		Cmd_ExecuteString(line);
 
@@ -684,7 +752,7 @@ void Cmd_Init(void) {
 
 	cmd_state.commands = g_hash_table_new_full(g_stri_hash, g_stri_equal, NULL, Cmd_HashTable_Free);
 
-	Mem_InitBuffer(&cmd_state.buf, (byte *) cmd_state.buffers[0], sizeof(cmd_state.buffers[0]));
+	Cbuf_Reserve(CBUF_CHARS);
 
 	Cmd_Add("cmd_list", Cmd_List_f, 0, NULL);
 	cmd_t *exec_cmd = Cmd_Add("exec", Cmd_Exec_f, CMD_SYSTEM, NULL);
@@ -716,7 +784,7 @@ void Cmd_Init(void) {
 	Cbuf_AddText("\n");
 	Cbuf_CopyToDefer();
 
-	// Com_Debug("Deferred buffer: %s", cmd_state.buffers[1]);
+	// Com_Debug("Deferred buffer: %s", cmd_state.defer);
 }
 
 /**
@@ -725,6 +793,14 @@ void Cmd_Init(void) {
 void Cmd_Shutdown(void) {
 
 	g_hash_table_destroy(cmd_state.commands);
+	cmd_state.commands = NULL;
+
+	Mem_Free(cmd_state.buf.data);
+	cmd_state.buf.data = NULL;
+	cmd_state.buf.size = cmd_state.buf.read = cmd_state.buf.write = 0;
+
+	Mem_Free(cmd_state.defer);
+	cmd_state.defer = NULL;
 }
 
 /*
@@ -32,8 +32,8 @@ static void Cm_LoadBspPlanes(void) {
 	const int32_t num_planes = cm_bsp.bsp.num_planes;
 	const bsp_plane_t *in = cm_bsp.bsp.planes;
 
-	cm_bsp_plane_t *out = cm_bsp.planes = Mem_TagMalloc(sizeof(cm_bsp_plane_t) * (num_planes + 12),
-	                                      MEM_TAG_CMODEL); // extra for box hull
+	cm_bsp_plane_t *out = cm_bsp.planes = Mem_TagMalloc(sizeof(cm_bsp_plane_t) * (num_planes + 12 * CM_MAX_BOX_HULLS),
+	                                      MEM_TAG_CMODEL); // extra for box hulls
 
 	for (int32_t i = 0; i < num_planes; i++, in++, out++) {
 
@@ -56,8 +56,8 @@ static void Cm_LoadBspNodes(void) {
 	const int32_t num_nodes = cm_bsp.bsp.num_nodes;
 	const bsp_node_t *in = cm_bsp.bsp.nodes;
 
-	cm_bsp_node_t *out = cm_bsp.nodes = Mem_TagMalloc(sizeof(cm_bsp_node_t) * (num_nodes + 6),
-	                                    MEM_TAG_CMODEL); // extra for box hull
+	cm_bsp_node_t *out = cm_bsp.nodes = Mem_TagMalloc(sizeof(cm_bsp_node_t) * (num_nodes + 6 * CM_MAX_BOX_HULLS),
+	                                    MEM_TAG_CMODEL); // extra for box hulls
 
 	for (int32_t i = 0; i < num_nodes; i++, in++, out++) {
 
@@ -105,8 +105,8 @@ static void Cm_LoadBspLeafs(void) {
 	const int32_t num_leafs = cm_bsp.bsp.num_leafs;
 	const bsp_leaf_t *in = cm_bsp.bsp.leafs;
 
-	cm_bsp_leaf_t *out = cm_bsp.leafs = Mem_TagMalloc(sizeof(cm_bsp_leaf_t) * (num_leafs + 1),
-	                                    MEM_TAG_CMODEL); // extra for box hull
+	cm_bsp_leaf_t *out = cm_bsp.leafs = Mem_TagMalloc(sizeof(cm_bsp_leaf_t) * (num_leafs + CM_MAX_BOX_HULLS),
+	                                    MEM_TAG_CMODEL); // extra for box hulls
 
 	for (int32_t i = 0; i < num_leafs; i++, in++, out++) {
 
@@ -130,8 +130,8 @@ static void Cm_LoadBspLeafBrushes(void) {
 	const int32_t num_leaf_brushes = cm_bsp.bsp.num_leaf_brushes;
 	const uint16_t *in = cm_bsp.bsp.leaf_brushes;
 
-	uint16_t *out = cm_bsp.leaf_brushes = Mem_TagMalloc(sizeof(uint16_t) * (num_leaf_brushes + 1),
-	                                      MEM_TAG_CMODEL); // extra for box hull
+	uint16_t *out = cm_bsp.leaf_brushes = Mem_TagMalloc(sizeof(uint16_t) * (num_leaf_brushes + CM_MAX_BOX_HULLS),
+	                                      MEM_TAG_CMODEL); // extra for box hulls
 
 	for (int32_t i = 0; i < num_leaf_brushes; i++, in++, out++) {
 
@@ -169,8 +169,8 @@ static void Cm_LoadBspBrushes(void) {
 	const int32_t num_brushes = cm_bsp.bsp.num_brushes;
 	const bsp_brush_t *in = cm_bsp.bsp.brushes;
 
-	cm_bsp_brush_t *out = cm_bsp.brushes = Mem_TagMalloc(sizeof(cm_bsp_brush_t) * (num_brushes + 1),
-	                                       MEM_TAG_CMODEL); // extra for box hull
+	cm_bsp_brush_t *out = cm_bsp.brushes = Mem_TagMalloc(sizeof(cm_bsp_brush_t) * (num_brushes + CM_MAX_BOX_HULLS),
+	                                       MEM_TAG_CMODEL); // extra for box hulls
 
 	for (int32_t i = 0; i < num_brushes; i++, in++, out++) {
 
@@ -190,8 +190,8 @@ static void Cm_LoadBspBrushSides(void) {
 	const int32_t num_brush_sides = cm_bsp.bsp.num_brush_sides;
 	const bsp_brush_side_t *in = cm_bsp.bsp.brush_sides;
 
-	cm_bsp_brush_side_t *out = cm_bsp.brush_sides = Mem_TagMalloc(sizeof(cm_bsp_brush_side_t) * (num_brush_sides + 6),
-	                           MEM_TAG_CMODEL); // extra for box hull
+	cm_bsp_brush_side_t *out = cm_bsp.brush_sides = Mem_TagMalloc(sizeof(cm_bsp_brush_side_t) * (num_brush_sides + 6 * CM_MAX_BOX_HULLS),
+	                           MEM_TAG_CMODEL); // extra for box hulls
 
 	for (int32_t i = 0; i < num_brush_sides; i++, in++, out++) {
 
@@ -238,7 +238,8 @@ static void Cm_SetupBspBrushes(void) {
 }
 
 /**
- * @brief
+ * @brief Loads the visibility lump, and decompresses the PVS and PHS of every
+ * cluster if they fit within cm_vis_budget.
  */
 static void Cm_LoadBspVisibility(void) {
 
@@ -248,7 +249,32 @@ static void Cm_LoadBspVisibility(void) {
 	if (cm_bsp.bsp.vis_data_size == 0) {
 		Bsp_AllocLump(&cm_bsp.bsp, BSP_LUMP_VISIBILITY, MAX_BSP_VISIBILITY);
 		cm_bsp.bsp.vis_data.vis->num_clusters = cm_bsp.bsp.num_leafs;
+		return;
+	}
+
+	const bsp_vis_t *vis = cm_bsp.bsp.vis_data.vis;
+
+	const size_t row_size = (vis->num_clusters + 7) >> 3;
+	const size_t size = row_size * vis->num_clusters * (DVIS_PHS + 1);
+
+	// if the matrix fits within our budget, decompress it once, rather than on each lookup
+	if (size > cm_vis_budget) {
+		Com_Debug(DEBUG_COLLISION, "Visibility matrix of %zd bytes exceeds cm_vis_budget\n", size);
+		return;
 	}
+
+	cm_bsp.vis_matrix = Mem_TagMalloc(size, MEM_TAG_CMODEL);
+	cm_bsp.vis_row_size = row_size;
+
+	byte *out = cm_bsp.vis_matrix;
+
+	for (int32_t i = 0; i <= DVIS_PHS; i++) {
+		for (int32_t j = 0; j < vis->num_clusters; j++, out += row_size) {
+			Bsp_DecompressVis(&cm_bsp.bsp, cm_bsp.bsp.vis_data.raw + vis->bit_offsets[j][i], out);
+		}
+	}
+
+	Com_Debug(DEBUG_COLLISION, "Decompressed visibility for %d clusters, %zd bytes\n", vis->num_clusters, size);
 }
 
 /**
@@ -359,18 +385,8 @@ cm_bsp_model_t *Cm_LoadBspModel(const char *name, int64_t *size) {
 
 	Bsp_UnloadLumps(&cm_bsp.bsp, BSP_LUMPS_ALL);
 
-	// free dynamic memory
-	Mem_Free(cm_bsp.materials);
-	Mem_Free(cm_bsp.planes);
-	Mem_Free(cm_bsp.nodes);
-	Mem_Free(cm_bsp.texinfos);
-	Mem_Free(cm_bsp.leafs);
-	Mem_Free(cm_bsp.leaf_brushes);
-	Mem_Free(cm_bsp.models);
-	Mem_Free(cm_bsp.brushes);
-	Mem_Free(cm_bsp.brush_sides);
-	Mem_Free(cm_bsp.areas);
-	Mem_Free(cm_bsp.portal_open);
+	// free dynamic memory, including the materials linked to cm_bsp.materials
+	Mem_FreeTag(MEM_TAG_CMODEL);
 
 	memset(&cm_bsp, 0, sizeof(cm_bsp));
 
@@ -383,21 +399,21 @@ cm_bsp_model_t *Cm_LoadBspModel(const char *name, int64_t *size) {
 	}
 
 	// load the common BSP structure and the lumps we need
-	bsp_header_t *file;
+	const bsp_header_t *file;
 
-	if (Fs_Load(name, (void **) &file) == -1) {
+	if (Fs_Map(name, (const void **) &file) == -1) {
 		Com_Error(ERROR_DROP, "Couldn't load %s\n", name);
 	}
 
 	int32_t version = Bsp_Verify(file);
 
 	if (version != BSP_VERSION && version != BSP_VERSION_QUETOO) {
-		Fs_Free(file);
+		Fs_Unmap(file);
 		Com_Error(ERROR_DROP, "%s has unsupported version: %d\n", name, version);
 	}
 
 	if (!Bsp_LoadLumps(file, &cm_bsp.bsp, CM_BSP_LUMPS)) {
-		Fs_Free(file);
+		Fs_Unmap(file);
 		Com_Error(ERROR_DROP, "Lump error loading %s\n", name);
 	}
 
@@ -410,7 +426,7 @@ cm_bsp_model_t *Cm_LoadBspModel(const char *name, int64_t *size) {
 
 	g_strlcpy(cm_bsp.name, name, sizeof(cm_bsp.name));
 
-	Fs_Free(file);
+	Fs_Unmap(file);
 
 	Cm_LoadBspMaterials(name);
 
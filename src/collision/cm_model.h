@@ -55,6 +55,9 @@ typedef struct {
 	_Bool *portal_open;
 	int32_t flood_valid;
 
+	byte *vis_matrix; // the decompressed PVS and PHS of all clusters, if within cm_vis_budget
+	size_t vis_row_size;
+
 	cm_material_t **materials;
 	size_t num_materials;
 } cm_bsp_t;
@@ -19,6 +19,8 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include <SDL_atomic.h>
+
 #include "cm_local.h"
 
 /**
@@ -128,123 +130,145 @@ typedef struct {
 	cm_bsp_leaf_t *leaf;
 } cm_box_t;
 
-static cm_box_t cm_box;
+/**
+ * @brief Each thread that clips to boxes uses its own box hull, indexed by
+ * Thread_Index, so that traces may run concurrently.
+ */
+static cm_box_t cm_box_hulls[CM_MAX_BOX_HULLS];
 
 /**
- * @brief Appends a brush (6 nodes, 12 planes) opaquely to the primary BSP
- * structure to represent the bounding box used for Cm_BoxLeafnums. This brush
- * is never tested by the rest of the collision detection code, as it resides
- * just beyond the parsed size of the map.
+ * @brief Appends brushes (6 nodes, 12 planes each) opaquely to the primary BSP
+ * structure to represent the bounding boxes used for Cm_BoxLeafnums. These
+ * brushes are never tested by the rest of the collision detection code, as
+ * they reside just beyond the parsed size of the map.
  */
 void Cm_InitBoxHull(void) {
 	static cm_bsp_texinfo_t null_surface;
 
-	if (cm_bsp.bsp.num_planes + 12 > MAX_BSP_PLANES) {
+	if (cm_bsp.bsp.num_planes + 12 * CM_MAX_BOX_HULLS > MAX_BSP_PLANES) {
 		Com_Error(ERROR_DROP, "MAX_BSP_PLANES\n");
 	}
 
-	if (cm_bsp.bsp.num_nodes + 6 > MAX_BSP_NODES) {
+	if (cm_bsp.bsp.num_nodes + 6 * CM_MAX_BOX_HULLS > MAX_BSP_NODES) {
 		Com_Error(ERROR_DROP, "MAX_BSP_NODES\n");
 	}
 
-	if (cm_bsp.bsp.num_leafs + 1 > MAX_BSP_LEAFS) {
+	if (cm_bsp.bsp.num_leafs + CM_MAX_BOX_HULLS > MAX_BSP_LEAFS) {
 		Com_Error(ERROR_DROP, "MAX_BSP_LEAFS\n");
 	}
 
-	if (cm_bsp.bsp.num_leaf_brushes + 1 > MAX_BSP_LEAF_BRUSHES) {
+	if (cm_bsp.bsp.num_leaf_brushes + CM_MAX_BOX_HULLS > MAX_BSP_LEAF_BRUSHES) {
 		Com_Error(ERROR_DROP, "MAX_BSP_LEAF_BRUSHES\n");
 	}
 
-	if (cm_bsp.bsp.num_brushes + 1 > MAX_BSP_BRUSHES) {
+	if (cm_bsp.bsp.num_brushes + CM_MAX_BOX_HULLS > MAX_BSP_BRUSHES) {
 		Com_Error(ERROR_DROP, "MAX_BSP_BRUSHES\n");
 	}
 
-	if (cm_bsp.bsp.num_brush_sides + 6 > MAX_BSP_BRUSH_SIDES) {
+	if (cm_bsp.bsp.num_brush_sides + 6 * CM_MAX_BOX_HULLS > MAX_BSP_BRUSH_SIDES) {
 		Com_Error(ERROR_DROP, "MAX_BSP_BRUSH_SIDES\n");
 	}
 
-	// head node
-	cm_box.head_node = cm_bsp.bsp.num_nodes;
-
-	// planes
-	cm_box.planes = &cm_bsp.planes[cm_bsp.bsp.num_planes];
-
-	// leaf
-	cm_box.leaf = &cm_bsp.leafs[cm_bsp.bsp.num_leafs];
-	cm_box.leaf->contents = CONTENTS_MONSTER;
-	cm_box.leaf->first_leaf_brush = cm_bsp.bsp.num_leaf_brushes;
-	cm_box.leaf->num_leaf_brushes = 1;
-
-	// leaf brush
-	cm_bsp.leaf_brushes[cm_bsp.bsp.num_leaf_brushes] = cm_bsp.bsp.num_brushes;
-
-	// brush
-	cm_box.brush = &cm_bsp.brushes[cm_bsp.bsp.num_brushes];
-	cm_box.brush->num_sides = 6;
-	cm_box.brush->first_brush_side = cm_bsp.bsp.num_brush_sides;
-	cm_box.brush->contents = CONTENTS_MONSTER;
-
-	for (int32_t i = 0; i < 6; i++) {
-
-		// fill in planes, two per side
-		cm_bsp_plane_t *plane = &cm_box.planes[i * 2];
-		plane->type = i >> 1;
-		VectorClear(plane->normal);
-		plane->normal[i >> 1] = 1.0;
-		plane->sign_bits = Cm_SignBitsForPlane(plane);
-		plane->num = (cm_bsp.bsp.num_planes >> 1) + (i >> 1) + 1;
-
-		plane = &cm_box.planes[i * 2 + 1];
-		plane->type = PLANE_ANY_X + (i >> 1);
-		VectorClear(plane->normal);
-		plane->normal[i >> 1] = -1.0;
-		plane->sign_bits = Cm_SignBitsForPlane(plane);
-		plane->num = (cm_bsp.bsp.num_planes >> 1) + (i >> 1) + 1;
-
-		const int32_t side = i & 1;
-
-		// fill in nodes, one per side
-		cm_bsp_node_t *node = &cm_bsp.nodes[cm_box.head_node + i];
-		node->plane = cm_bsp.planes + (cm_bsp.bsp.num_planes + i * 2);
-		node->children[side] = -1 - cm_bsp.bsp.num_leafs;
-		if (i != 5) {
-			node->children[side ^ 1] = cm_box.head_node + i + 1;
-		} else {
-			node->children[side ^ 1] = -1 - cm_bsp.bsp.num_leafs;
-		}
+	for (int32_t h = 0; h < CM_MAX_BOX_HULLS; h++) {
+		cm_box_t *box = &cm_box_hulls[h];
+
+		const int32_t first_plane = cm_bsp.bsp.num_planes + h * 12;
+		const int32_t first_brush_side = cm_bsp.bsp.num_brush_sides + h * 6;
+		const int32_t leaf_num = cm_bsp.bsp.num_leafs + h;
+
+		// head node
+		box->head_node = cm_bsp.bsp.num_nodes + h * 6;
+
+		// planes
+		box->planes = &cm_bsp.planes[first_plane];
+
+		// leaf
+		box->leaf = &cm_bsp.leafs[leaf_num];
+		box->leaf->contents = CONTENTS_MONSTER;
+		box->leaf->first_leaf_brush = cm_bsp.bsp.num_leaf_brushes + h;
+		box->leaf->num_leaf_brushes = 1;
+
+		// leaf brush
+		cm_bsp.leaf_brushes[cm_bsp.bsp.num_leaf_brushes + h] = cm_bsp.bsp.num_brushes + h;
+
+		// brush
+		box->brush = &cm_bsp.brushes[cm_bsp.bsp.num_brushes + h];
+		box->brush->num_sides = 6;
+		box->brush->first_brush_side = first_brush_side;
+		box->brush->contents = CONTENTS_MONSTER;
+
+		for (int32_t i = 0; i < 6; i++) {
+
+			// fill in planes, two per side
+			cm_bsp_plane_t *plane = &box->planes[i * 2];
+			plane->type = i >> 1;
+			VectorClear(plane->normal);
+			plane->normal[i >> 1] = 1.0;
+			plane->sign_bits = Cm_SignBitsForPlane(plane);
+			plane->num = (first_plane >> 1) + (i >> 1) + 1;
+
+			plane = &box->planes[i * 2 + 1];
+			plane->type = PLANE_ANY_X + (i >> 1);
+			VectorClear(plane->normal);
+			plane->normal[i >> 1] = -1.0;
+			plane->sign_bits = Cm_SignBitsForPlane(plane);
+			plane->num = (first_plane >> 1) + (i >> 1) + 1;
+
+			const int32_t side = i & 1;
+
+			// fill in nodes, one per side
+			cm_bsp_node_t *node = &cm_bsp.nodes[box->head_node + i];
+			node->plane = cm_bsp.planes + (first_plane + i * 2);
+			node->children[side] = -1 - leaf_num;
+			if (i != 5) {
+				node->children[side ^ 1] = box->head_node + i + 1;
+			} else {
+				node->children[side ^ 1] = -1 - leaf_num;
+			}
 
-		// fill in brush sides, one per side
-		cm_bsp_brush_side_t *bside = &cm_bsp.brush_sides[cm_bsp.bsp.num_brush_sides + i];
-		bside->plane = cm_bsp.planes + (cm_bsp.bsp.num_planes + i * 2 + side);
-		bside->surface = &null_surface;
+			// fill in brush sides, one per side
+			cm_bsp_brush_side_t *bside = &cm_bsp.brush_sides[first_brush_side + i];
+			bside->plane = cm_bsp.planes + (first_plane + i * 2 + side);
+			bside->surface = &null_surface;
+		}
 	}
 }
 
 /**
- * @brief Initializes the box hull for the specified bounds, returning the
- * head node for the resulting box hull tree.
+ * @return The box hull of the calling thread.
+ */
+static cm_box_t *Cm_BoxHull(void) {
+	return &cm_box_hulls[Thread_Index()];
+}
+
+/**
+ * @brief Initializes the calling thread's box hull for the specified bounds,
+ * returning the head node for the resulting box hull tree. The box hull remains
+ * valid until the same thread sets it again.
  */
 int32_t Cm_SetBoxHull(const vec3_t mins, const vec3_t maxs, const int32_t contents) {
 
-	VectorCopy(mins, cm_box.brush->mins);
-	VectorCopy(maxs, cm_box.brush->maxs);
-
-	cm_box.planes[0].dist = maxs[0];
-	cm_box.planes[1].dist = -maxs[0];
-	cm_box.planes[2].dist = mins[0];
-	cm_box.planes[3].dist = -mins[0];
-	cm_box.planes[4].dist = maxs[1];
-	cm_box.planes[5].dist = -maxs[1];
-	cm_box.planes[6].dist = mins[1];
-	cm_box.planes[7].dist = -mins[1];
-	cm_box.planes[8].dist = maxs[2];
-	cm_box.planes[9].dist = -maxs[2];
-	cm_box.planes[10].dist = mins[2];
-	cm_box.planes[11].dist = -mins[2];
-
-	cm_box.leaf->contents = cm_box.brush->contents = contents;
-
-	return cm_box.head_node;
+	cm_box_t *box = Cm_BoxHull();
+
+	VectorCopy(mins, box->brush->mins);
+	VectorCopy(maxs, box->brush->maxs);
+
+	box->planes[0].dist = maxs[0];
+	box->planes[1].dist = -maxs[0];
+	box->planes[2].dist = mins[0];
+	box->planes[3].dist = -mins[0];
+	box->planes[4].dist = maxs[1];
+	box->planes[5].dist = -maxs[1];
+	box->planes[6].dist = mins[1];
+	box->planes[7].dist = -mins[1];
+	box->planes[8].dist = maxs[2];
+	box->planes[9].dist = -maxs[2];
+	box->planes[10].dist = mins[2];
+	box->planes[11].dist = -mins[2];
+
+	box->leaf->contents = box->brush->contents = contents;
+
+	return box->head_node;
 }
 
 /**
@@ -312,7 +336,7 @@ int32_t Cm_PointContents(const vec3_t p, int32_t head_node) {
 int32_t Cm_TransformedPointContents(const vec3_t p, int32_t head_node, const matrix4x4_t *inverse_matrix) {
 	vec3_t p0;
 
-	Matrix4x4_Transform(inverse_matrix, p, p0);
+	Matrix4x4_Transformf(inverse_matrix, p, p0);
 
 	return Cm_PointContents(p0, head_node);
 }
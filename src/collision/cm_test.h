@@ -22,6 +22,12 @@
 #pragma once
 
 #include "cm_types.h"
+#include "thread.h"
+
+/**
+ * @brief One box hull for each thread pool worker, plus one for the main thread.
+ */
+#define CM_MAX_BOX_HULLS (MAX_THREADS + 1)
 
 vec_t Cm_DistanceToPlane(const vec3_t point, const cm_bsp_plane_t *plane);
 int32_t Cm_SignBitsForPlane(const cm_bsp_plane_t *plane);
@@ -478,8 +478,8 @@ cm_trace_t Cm_TransformedBoxTrace(const vec3_t start, const vec3_t end, const ve
 
 	vec3_t start0, end0;
 
-	Matrix4x4_Transform(inverse_matrix, start, start0);
-	Matrix4x4_Transform(inverse_matrix, end, end0);
+	Matrix4x4_Transformf(inverse_matrix, start, start0);
+	Matrix4x4_Transformf(inverse_matrix, end, end0);
 
 	// sweep the box through the model
 	cm_trace_t trace = Cm_BoxTrace(start0, end0, mins, maxs, head_node, contents);
@@ -27,41 +27,80 @@
 _Bool cm_no_areas = false;
 
 /**
- * @brief
- *
- * @remarks `pvs` must be at least `MAX_BSP_LEAFS >> 3` in length.
+ * @brief The memory budget, in bytes, for decompressing the PVS and PHS of every
+ * cluster when the BSP is loaded. Larger maps are decompressed on each lookup.
  */
-size_t Cm_ClusterPVS(const int32_t cluster, byte *pvs) {
+size_t cm_vis_budget = CM_VIS_BUDGET;
 
-	const bsp_vis_t *vis = cm_bsp.bsp.vis_data.vis;
-	const size_t len = (vis->num_clusters + 7) >> 3;
+/**
+ * @return The decompressed row of the specified cluster and visibility type, or
+ * NULL if the visibility matrix was not decompressed or the cluster is invalid.
+ */
+static const byte *Cm_ClusterVisRow(const int32_t cluster, const int32_t type) {
 
-	if (cluster == -1) {
-		memset(pvs, 0, len);
-	} else {
-		Bsp_DecompressVis(&cm_bsp.bsp, cm_bsp.bsp.vis_data.raw + vis->bit_offsets[cluster][DVIS_PVS], pvs);
+	const int32_t num_clusters = cm_bsp.bsp.vis_data.vis->num_clusters;
+
+	if (!cm_bsp.vis_matrix || cluster < 0 || cluster >= num_clusters) {
+		return NULL;
 	}
 
-	return len;
+	return cm_bsp.vis_matrix + (type * num_clusters + cluster) * cm_bsp.vis_row_size;
 }
 
 /**
- * @brief
+ * @brief Copies or decompresses the row of the specified cluster and visibility type.
  */
-size_t Cm_ClusterPHS(const int32_t cluster, byte *phs) {
+static size_t Cm_ClusterVis(const int32_t cluster, const int32_t type, byte *out) {
 
 	const bsp_vis_t *vis = cm_bsp.bsp.vis_data.vis;
 	const size_t len = (vis->num_clusters + 7) >> 3;
 
 	if (cluster == -1) {
-		memset(phs, 0, len);
+		memset(out, 0, len);
 	} else {
-		Bsp_DecompressVis(&cm_bsp.bsp, cm_bsp.bsp.vis_data.raw + vis->bit_offsets[cluster][DVIS_PHS], phs);
+		const byte *row = Cm_ClusterVisRow(cluster, type);
+		if (row) {
+			memcpy(out, row, len);
+		} else {
+			Bsp_DecompressVis(&cm_bsp.bsp, cm_bsp.bsp.vis_data.raw + vis->bit_offsets[cluster][type], out);
+		}
 	}
 
 	return len;
 }
 
+/**
+ * @brief
+ *
+ * @remarks `pvs` must be at least `MAX_BSP_LEAFS >> 3` in length.
+ */
+size_t Cm_ClusterPVS(const int32_t cluster, byte *pvs) {
+	return Cm_ClusterVis(cluster, DVIS_PVS, pvs);
+}
+
+/**
+ * @brief
+ */
+size_t Cm_ClusterPHS(const int32_t cluster, byte *phs) {
+	return Cm_ClusterVis(cluster, DVIS_PHS, phs);
+}
+
+/**
+ * @return The PVS row of the specified cluster, without copying it, or NULL if
+ * it must be decompressed with Cm_ClusterPVS.
+ */
+const byte *Cm_ClusterPVSRow(const int32_t cluster) {
+	return Cm_ClusterVisRow(cluster, DVIS_PVS);
+}
+
+/**
+ * @return The PHS row of the specified cluster, without copying it, or NULL if
+ * it must be decompressed with Cm_ClusterPHS.
+ */
+const byte *Cm_ClusterPHSRow(const int32_t cluster) {
+	return Cm_ClusterVisRow(cluster, DVIS_PHS);
+}
+
 /**
  * @brief Recurse over the area portals, marking adjacent ones as flooded.
  */
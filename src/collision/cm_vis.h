@@ -25,6 +25,8 @@
 
 size_t Cm_ClusterPVS(const int32_t cluster, byte *pvs);
 size_t Cm_ClusterPHS(const int32_t cluster, byte *phs);
+const byte *Cm_ClusterPVSRow(const int32_t cluster);
+const byte *Cm_ClusterPHSRow(const int32_t cluster);
 
 void Cm_SetAreaPortalState(const int32_t portal_num, const _Bool open);
 _Bool Cm_AreasConnected(const int32_t area1, const int32_t area2);
@@ -34,6 +36,13 @@ _Bool Cm_HeadnodeVisible(const int32_t head_node, const byte *vis);
 
 extern _Bool cm_no_areas;
 
+/**
+ * @brief The default memory budget for decompressed visibility, in bytes.
+ */
+#define CM_VIS_BUDGET (16 << 20)
+
+extern size_t cm_vis_budget;
+
 #ifdef __CM_LOCAL_H__
 void Cm_FloodAreas(void);
 #endif /* __CM_LOCAL_H__ */
@@ -45,7 +45,22 @@
  * of core net messages or serialized data types change. The game and client
  * game maintain PROTOCOL_MINOR as well.
  */
-#define PROTOCOL_MAJOR		1023
+#define PROTOCOL_MAJOR		1027
+
+/**
+ * @brief Earlier protocol major versions, which servers and clients still
+ * accept so that older peers and demos remain playable. The legacy protocol
+ * sends entity positions as full precision floats; the quantized protocol
+ * sends them as fixed point deltas, and the bits protocol bit packs frame,
+ * player state and entity deltas. The cache protocol adds a per-client cache
+ * of acknowledged frames, which lagged clients are delta'd from, and
+ * PROTOCOL_MAJOR adds fragmentation of large net channel messages.
+ */
+#define PROTOCOL_MAJOR_LEGACY		1023
+#define PROTOCOL_MAJOR_QUANTIZED	1024
+#define PROTOCOL_MAJOR_BITS			1025
+#define PROTOCOL_MAJOR_CACHE		1026
+#define PROTOCOL_MAJOR_FRAGMENT		1027
 
 /**
  * @brief The IP address of the master server, where the authoritative list of
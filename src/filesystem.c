@@ -20,11 +20,27 @@
  */
 
 #include <physfs.h>
+#include <SDL_atomic.h>
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
 
 #include "filesystem.h"
 
+#if HAVE_MMAP
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
 #define FS_FILE_BUFFER (1024 * 1024 * 2)
 
+/**
+ * @brief The number of I/O workers, and the maximum number of asynchronous
+ * loads in flight at once.
+ */
+#define FS_ASYNC_THREADS 2
+#define FS_ASYNC_QUEUE 64
+
 typedef struct fs_state_s {
 
 	/**
@@ -51,10 +67,163 @@ typedef struct fs_state_s {
 	 * they are freed (Fs_Free) in all code paths.
 	 */
 	GHashTable *loaded_files;
+
+	/**
+	 * @brief Guards the loaded files and the file cache, which are reached
+	 * from worker threads through Fs_Load, Fs_Map and the write functions.
+	 */
+	SDL_mutex *lock;
+
+	/**
+	 * @brief The shared file cache backing Fs_Map.
+	 */
+	struct {
+		/**
+		 * @brief Current entries, keyed by filename.
+		 */
+		GHashTable *files;
+
+		/**
+		 * @brief All entries, including stale ones still referenced, keyed by
+		 * the buffer handed out.
+		 */
+		GHashTable *buffers;
+
+		/**
+		 * @brief Unreferenced entries, least recently used first.
+		 */
+		GQueue unused;
+		size_t unused_size;
+
+		uint32_t hits, misses;
+	} cache;
+
+	/**
+	 * @brief The I/O workers backing Fs_LoadAsync.
+	 */
+	struct {
+		SDL_Thread *threads[FS_ASYNC_THREADS];
+
+		SDL_mutex *lock;
+		SDL_cond *work_cond; // signaled when loads are queued
+		SDL_cond *done_cond; // broadcast when loads complete
+
+		GQueue pending; // loads waiting for a worker
+		GQueue completed; // loads waiting for their callback
+
+		/**
+		 * @brief Prefetched loads, keyed by filename, to be claimed by Fs_Load.
+		 */
+		GHashTable *prefetched;
+
+		uint32_t in_flight; // loads occupying the bounded queue
+		uint32_t callbacks; // loads whose callbacks have yet to run
+		_Bool shutdown;
+	} async;
+
+	/**
+	 * @brief The path index, resolving files and directories to the search
+	 * path entry providing them without probing each entry in turn.
+	 */
+	struct {
+		/**
+		 * @brief The current index, replaced wholesale when it is rebuilt.
+		 */
+		struct fs_index_s *current;
+
+		/**
+		 * @brief Guards the current index. Indexes are built outside of it,
+		 * so it is only held while the index is read or updated in memory.
+		 */
+		SDL_mutex *lock;
+
+		/**
+		 * @brief Incremented whenever entries are freed, so that enumerations
+		 * can detect that their position was invalidated.
+		 */
+		uint32_t removals;
+	} index;
 } fs_state_t;
 
+/**
+ * @brief A path index over some search path entries.
+ */
+typedef struct fs_index_s {
+	/**
+	 * @brief The indexed entries, keyed by path.
+	 */
+	GHashTable *paths;
+
+	/**
+	 * @brief The root directory, whose children are the top-level entries.
+	 */
+	struct fs_index_entry_s *root;
+
+	/**
+	 * @brief The interned search path entries.
+	 */
+	GStringChunk *strings;
+
+	/**
+	 * @brief False if a search path entry could not be indexed, in which
+	 * case all lookups defer to PhysFS.
+	 */
+	_Bool complete;
+} fs_index_t;
+
+/**
+ * @brief Directory mounts are indexed to this depth, guarding against
+ * symbolic link cycles.
+ */
+#define FS_INDEX_DEPTH 32
+
+/**
+ * @brief An indexed file or directory.
+ */
+typedef struct fs_index_entry_s {
+	const char *dir; // the providing search path entry
+	const char *name; // the base name, within path
+
+	struct fs_index_entry_s *parent;
+	struct fs_index_entry_s *children;
+	struct fs_index_entry_s *next; // the next sibling
+
+	char path[]; // the key
+} fs_index_entry_t;
+
+/**
+ * @brief Unreferenced memory-mapped cache entries are retained up to this many
+ * bytes. Their pages belong to the page cache, which reclaims them as needed.
+ * Loaded copies (e.g. deflated archive entries) are freed once unreferenced.
+ */
+#define FS_CACHE_SIZE (256 * 1024 * 1024)
+
+/**
+ * @brief A shared, immutable file buffer, either memory-mapped or loaded.
+ */
+typedef struct {
+	char *filename;
+	int64_t mod_time;
+
+	const void *buffer;
+	int64_t len;
+
+	void *base; // the start of the mapping, or NULL if the buffer was loaded
+	size_t base_len; // the length of the mapping
+
+	int32_t refs;
+	GList *unused; // the link in the unused queue, if unreferenced
+} fs_cache_entry_t;
+
 static fs_state_t fs_state;
 
+static void Fs_Invalidate(const char *filename);
+static void Fs_Loaded(void *buffer, const char *filename);
+static _Bool Fs_IndexLookup(const char *path, const char **dir);
+static void Fs_IndexRefresh(const char *path);
+static void Fs_BuildIndex(void);
+static _Bool Fs_IndexEnumerate(const char *dir, const glob_pattern_t *glob, Fs_Enumerator func, void *data);
+
 /**
  * @return The base directory, if running from a bundled application.
  */
@@ -75,7 +244,14 @@ _Bool Fs_Close(file_t *file) {
  * @brief Deletes the file from the configured write directory.
  */
 _Bool Fs_Delete(const char *filename) {
-	return PHYSFS_delete(filename) == 0;
+
+	Fs_Invalidate(filename);
+
+	const _Bool deleted = PHYSFS_delete(filename) == 0;
+
+	Fs_IndexRefresh(filename);
+
+	return deleted;
 }
 
 /**
@@ -89,6 +265,12 @@ _Bool Fs_Eof(file_t *file) {
  * @return True if the specified filename exists on the search path.
  */
 _Bool Fs_Exists(const char *filename) {
+	const char *dir;
+
+	if (Fs_IndexLookup(filename, &dir)) {
+		return dir != NULL;
+	}
+
 	return PHYSFS_exists(filename) ? true : false;
 }
 
@@ -110,7 +292,13 @@ const char *Fs_LastError(void) {
  * @brief Creates the specified directory (and any ancestors) in Fs_WriteDir.
  */
 _Bool Fs_Mkdir(const char *dir) {
-	return PHYSFS_mkdir(dir) ? true : false;
+
+	if (PHYSFS_mkdir(dir)) {
+		Fs_IndexRefresh(dir);
+		return true;
+	}
+
+	return false;
 }
 
 /**
@@ -123,10 +311,13 @@ file_t *Fs_OpenAppend(const char *filename) {
 	Dirname(filename, dir);
 	Fs_Mkdir(dir);
 
+	Fs_Invalidate(filename);
+
 	if ((file = PHYSFS_openAppend(filename))) {
 		if (!PHYSFS_setBuffer(file, FS_FILE_BUFFER)) {
 			Com_Warn("%s: %s\n", filename, Fs_LastError());
 		}
+		Fs_IndexRefresh(filename);
 	}
 
 	return (file_t *) file;
@@ -136,8 +327,13 @@ file_t *Fs_OpenAppend(const char *filename) {
  * @brief Opens the specified file for reading.
  */
 file_t *Fs_OpenRead(const char *filename) {
+	const char *dir;
 	PHYSFS_File *file;
 
+	if (Fs_IndexLookup(filename, &dir) && dir == NULL) {
+		return NULL;
+	}
+
 	if ((file = PHYSFS_openRead(filename))) {
 		if (!PHYSFS_setBuffer(file, FS_FILE_BUFFER)) {
 			Com_Warn("%s: %s\n", filename, Fs_LastError());
@@ -161,10 +357,13 @@ file_t *Fs_OpenWrite(const char *filename) {
 	Dirname(filename, dir);
 	Fs_Mkdir(dir);
 
+	Fs_Invalidate(filename);
+
 	if ((file = PHYSFS_openWrite(filename))) {
 		if (!PHYSFS_setBuffer(file, FS_FILE_BUFFER)) {
 			Com_Warn("%s: %s\n", filename, Fs_LastError());
 		}
+		Fs_IndexRefresh(filename);
 	}
 
 	return (file_t *) file;
@@ -242,240 +441,1757 @@ int64_t Fs_Tell(file_t *file) {
 	return PHYSFS_tell((PHYSFS_File *) file);
 }
 
-/**
- * @brief Writes to the specified file.
- *
- * @return The number of objects read, or -1 on failure.
- */
-int64_t Fs_Write(file_t *file, const void *buffer, size_t size, size_t count) {
-	return PHYSFS_writeBytes((PHYSFS_File *) file, buffer, (PHYSFS_uint64) size * (PHYSFS_uint64) count) / size;
+/**
+ * @brief Writes to the specified file.
+ *
+ * @return The number of objects read, or -1 on failure.
+ */
+int64_t Fs_Write(file_t *file, const void *buffer, size_t size, size_t count) {
+	return PHYSFS_writeBytes((PHYSFS_File *) file, buffer, (PHYSFS_uint64) size * (PHYSFS_uint64) count) / size;
+}
+
+/**
+ * @brief An asynchronous load.
+ */
+typedef struct {
+	char filename[MAX_QPATH];
+	Fs_LoadFunc func;
+	void *data;
+
+	void *buffer;
+	int64_t len;
+	_Bool done;
+} fs_async_t;
+
+/**
+ * @brief Reads the specified file on an I/O worker. Unlike Fs_Load, errors are
+ * not fatal here; the file is simply reported as unreadable.
+ */
+static int64_t Fs_LoadAsync_read(const char *filename, void **buffer) {
+
+	*buffer = NULL;
+
+	file_t *file = Fs_OpenRead(filename);
+	if (file == NULL) {
+		return -1;
+	}
+
+	int64_t len = Fs_FileLength(file);
+
+	if (len > 0) {
+		*buffer = Mem_TagMalloc(len + 1, MEM_TAG_FS);
+
+		if (Fs_Read(file, *buffer, 1, len) != len) {
+			Mem_Free(*buffer);
+			*buffer = NULL;
+			len = -1;
+		}
+	}
+
+	Fs_Close(file);
+	return len;
+}
+
+/**
+ * @brief The I/O worker entry point, which reads queued files until shutdown.
+ */
+static int32_t Fs_LoadAsync_work(void *data) {
+
+	SDL_mutexP(fs_state.async.lock);
+
+	while (true) {
+
+		fs_async_t *load = g_queue_pop_head(&fs_state.async.pending);
+		if (load == NULL) {
+			if (fs_state.async.shutdown) {
+				break;
+			}
+
+			SDL_CondWait(fs_state.async.work_cond, fs_state.async.lock);
+			continue;
+		}
+
+		SDL_mutexV(fs_state.async.lock);
+
+		void *buffer;
+		const int64_t len = Fs_LoadAsync_read(load->filename, &buffer);
+
+		SDL_mutexP(fs_state.async.lock);
+
+		load->buffer = buffer;
+		load->len = len;
+		load->done = true;
+
+		if (load->func) {
+			g_queue_push_tail(&fs_state.async.completed, load);
+		} else {
+			fs_state.async.in_flight--;
+		}
+
+		SDL_CondBroadcast(fs_state.async.done_cond);
+	}
+
+	SDL_mutexV(fs_state.async.lock);
+
+	Mem_ThreadShutdown();
+
+	return 0;
+}
+
+/**
+ * @brief Hands the loaded buffer over to the caller, registering it so that it
+ * may be released with Fs_Free. Files whose length could not be determined in
+ * the background are loaded synchronously.
+ */
+static int64_t Fs_LoadAsync_claim(fs_async_t *load, void **buffer) {
+
+	if (load->len == -1) {
+		return Fs_Load(load->filename, buffer);
+	}
+
+	if (buffer) {
+		*buffer = load->buffer;
+
+		if (load->buffer) {
+			Fs_Loaded(load->buffer, load->filename);
+		}
+	} else {
+		Mem_Free(load->buffer);
+	}
+
+	return load->len;
+}
+
+/**
+ * @brief Runs the callbacks of completed loads on the calling thread.
+ *
+ * @param wait If true, block until all loads with callbacks have completed.
+ *
+ * @return The number of callbacks run.
+ */
+static uint32_t Fs_LoadAsync_complete(_Bool wait) {
+	uint32_t count = 0;
+
+	SDL_mutexP(fs_state.async.lock);
+
+	while (true) {
+		fs_async_t *load = g_queue_pop_head(&fs_state.async.completed);
+		if (load == NULL) {
+			if (wait && fs_state.async.callbacks) {
+				SDL_CondWait(fs_state.async.done_cond, fs_state.async.lock);
+				continue;
+			}
+			break;
+		}
+
+		fs_state.async.in_flight--;
+
+		SDL_mutexV(fs_state.async.lock);
+
+		void *buffer;
+		const int64_t len = Fs_LoadAsync_claim(load, &buffer);
+
+		load->func(load->filename, buffer, len, load->data);
+
+		Mem_Free(load);
+		count++;
+
+		SDL_mutexP(fs_state.async.lock);
+
+		fs_state.async.callbacks--;
+	}
+
+	SDL_mutexV(fs_state.async.lock);
+
+	return count;
+}
+
+/**
+ * @brief Claims the prefetched buffer for the specified file, waiting for it if
+ * it is still being read.
+ *
+ * @return True if the file was prefetched, false otherwise.
+ */
+static _Bool Fs_LoadAsync_prefetched(const char *filename, void **buffer, int64_t *len) {
+
+	if (fs_state.async.lock == NULL) {
+		return false;
+	}
+
+	SDL_mutexP(fs_state.async.lock);
+
+	fs_async_t *load = g_hash_table_lookup(fs_state.async.prefetched, filename);
+	if (load) {
+		while (!load->done) {
+			SDL_CondWait(fs_state.async.done_cond, fs_state.async.lock);
+		}
+
+		g_hash_table_remove(fs_state.async.prefetched, filename);
+	}
+
+	SDL_mutexV(fs_state.async.lock);
+
+	if (load) {
+		*len = Fs_LoadAsync_claim(load, buffer);
+		Mem_Free(load);
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * @brief Discards any prefetched buffer for the specified file, so that it is
+ * read again by Fs_Load.
+ */
+static void Fs_LoadAsync_discard(const char *filename) {
+
+	if (fs_state.async.lock == NULL) {
+		return;
+	}
+
+	SDL_mutexP(fs_state.async.lock);
+
+	fs_async_t *load = g_hash_table_lookup(fs_state.async.prefetched, filename);
+	if (load) {
+		while (!load->done) {
+			SDL_CondWait(fs_state.async.done_cond, fs_state.async.lock);
+		}
+
+		g_hash_table_remove(fs_state.async.prefetched, filename);
+	}
+
+	SDL_mutexV(fs_state.async.lock);
+
+	if (load) {
+		Mem_Free(load->buffer);
+		Mem_Free(load);
+	}
+}
+
+/**
+ * @brief Queues the specified file to be read by the I/O workers. When the read
+ * completes, the callback is invoked with the buffer and its length (or -1 on
+ * error) by the next call to Fs_PollAsync or Fs_WaitAsync. Be sure to free the
+ * buffer with Fs_Free. The number of loads in flight is bounded; when the queue
+ * is full, this function runs completed callbacks, or blocks, until there is
+ * room.
+ *
+ * If the callback is NULL, the file is prefetched instead, and the next call
+ * to Fs_Load for it claims the buffer rather than reading it again.
+ */
+void Fs_LoadAsync(const char *filename, Fs_LoadFunc func, void *data) {
+
+	if (fs_state.async.lock == NULL) {
+		if (func) {
+			void *buffer;
+			const int64_t len = Fs_Load(filename, &buffer);
+			func(filename, buffer, len, data);
+		}
+		return;
+	}
+
+	SDL_mutexP(fs_state.async.lock);
+
+	if (func == NULL && g_hash_table_contains(fs_state.async.prefetched, filename)) {
+		SDL_mutexV(fs_state.async.lock);
+		return;
+	}
+
+	while (fs_state.async.in_flight == FS_ASYNC_QUEUE) {
+		if (g_queue_is_empty(&fs_state.async.completed)) {
+			SDL_CondWait(fs_state.async.done_cond, fs_state.async.lock);
+		} else {
+			SDL_mutexV(fs_state.async.lock);
+			Fs_LoadAsync_complete(false);
+			SDL_mutexP(fs_state.async.lock);
+		}
+	}
+
+	fs_async_t *load = Mem_TagMalloc(sizeof(fs_async_t), MEM_TAG_FS);
+
+	g_strlcpy(load->filename, filename, sizeof(load->filename));
+	load->func = func;
+	load->data = data;
+
+	if (func) {
+		fs_state.async.callbacks++;
+	} else {
+		g_hash_table_insert(fs_state.async.prefetched, load->filename, load);
+	}
+
+	g_queue_push_tail(&fs_state.async.pending, load);
+	fs_state.async.in_flight++;
+
+	SDL_CondSignal(fs_state.async.work_cond);
+
+	SDL_mutexV(fs_state.async.lock);
+}
+
+/**
+ * @brief Queues the specified files to be read by the I/O workers, in order.
+ * This is equivalent to calling Fs_LoadAsync for each file.
+ */
+void Fs_LoadAsyncBatch(const char **filenames, size_t count, Fs_LoadFunc func, void *data) {
+
+	for (size_t i = 0; i < count; i++) {
+		Fs_LoadAsync(filenames[i], func, data);
+	}
+}
+
+/**
+ * @brief Runs the callbacks of any completed asynchronous loads, without
+ * blocking. Callbacks are invoked on the calling thread.
+ *
+ * @return The number of callbacks run.
+ */
+uint32_t Fs_PollAsync(void) {
+	return Fs_LoadAsync_complete(false);
+}
+
+/**
+ * @brief Blocks until all asynchronous loads with callbacks have completed,
+ * running their callbacks on the calling thread as they do.
+ */
+void Fs_WaitAsync(void) {
+	Fs_LoadAsync_complete(true);
+}
+
+/**
+ * @brief Starts the I/O workers.
+ */
+static void Fs_InitAsync(void) {
+
+	fs_state.async.lock = SDL_CreateMutex();
+	fs_state.async.work_cond = SDL_CreateCond();
+	fs_state.async.done_cond = SDL_CreateCond();
+
+	g_queue_init(&fs_state.async.pending);
+	g_queue_init(&fs_state.async.completed);
+
+	fs_state.async.prefetched = g_hash_table_new(g_str_hash, g_str_equal);
+
+	for (size_t i = 0; i < FS_ASYNC_THREADS; i++) {
+		fs_state.async.threads[i] = SDL_CreateThread(Fs_LoadAsync_work, __func__, NULL);
+	}
+}
+
+/**
+ * @brief Frees all prefetched buffers that have not been claimed.
+ */
+static void Fs_FlushAsync(void) {
+
+	if (fs_state.async.lock == NULL) {
+		return;
+	}
+
+	SDL_mutexP(fs_state.async.lock);
+
+	GList *filenames = g_hash_table_get_keys(fs_state.async.prefetched);
+
+	SDL_mutexV(fs_state.async.lock);
+
+	for (GList *f = filenames; f; f = f->next) {
+		char filename[MAX_QPATH];
+		g_strlcpy(filename, f->data, sizeof(filename));
+
+		Fs_LoadAsync_discard(filename);
+	}
+
+	g_list_free(filenames);
+}
+
+/**
+ * @brief Completes all outstanding loads, and stops the I/O workers.
+ */
+static void Fs_ShutdownAsync(void) {
+
+	if (fs_state.async.lock == NULL) {
+		return;
+	}
+
+	Fs_WaitAsync();
+	Fs_FlushAsync();
+
+	SDL_mutexP(fs_state.async.lock);
+	fs_state.async.shutdown = true;
+	SDL_CondBroadcast(fs_state.async.work_cond);
+	SDL_mutexV(fs_state.async.lock);
+
+	for (size_t i = 0; i < FS_ASYNC_THREADS; i++) {
+		SDL_WaitThread(fs_state.async.threads[i], NULL);
+	}
+
+	g_hash_table_destroy(fs_state.async.prefetched);
+
+	SDL_DestroyCond(fs_state.async.work_cond);
+	SDL_DestroyCond(fs_state.async.done_cond);
+	SDL_DestroyMutex(fs_state.async.lock);
+
+	memset(&fs_state.async, 0, sizeof(fs_state.async));
+}
+
+/**
+ * @brief Loads the specified file into the given buffer, which is automatically
+ * allocated if non-NULL. Returns the file length, or -1 if it is unable to be
+ * read. Be sure to free the buffer when finished with Fs_Free.
+ *
+ * @return The file length, or -1 on error.
+ */
+int64_t Fs_Load(const char *filename, void **buffer) {
+	int64_t len;
+
+	if (Fs_LoadAsync_prefetched(filename, buffer, &len)) {
+		return len;
+	}
+
+	typedef struct {
+		byte *data;
+		int64_t len;
+	} fs_block_t;
+
+	file_t *file;
+
+	if ((file = Fs_OpenRead(filename))) {
+		const int64_t buffer_length = Fs_FileLength(file);
+
+		// if we can calculate the length, we can pull it easily
+		if (buffer_length != -1) {
+
+			len = buffer_length;
+
+			if (buffer) {
+				if (len > 0) {
+					byte *buf = *buffer = Mem_TagMalloc(len + 1, MEM_TAG_FS);
+					const int64_t read = Fs_Read(file, buf, 1, len);
+
+					if (read != len) {
+						Com_Error(ERROR_DROP, "%s: %s\n", filename, Fs_LastError());
+					}
+
+					Fs_Loaded(*buffer, filename);
+				} else {
+
+					*buffer = NULL;
+				}
+			}
+		} else {
+
+			GList *list = NULL;
+			len = 0;
+
+			while (!Fs_Eof(file)) {
+				fs_block_t *b = Mem_TagMalloc(sizeof(fs_block_t), MEM_TAG_FS);
+
+				b->data = Mem_LinkMalloc(FS_FILE_BUFFER, b);
+				b->len = Fs_Read(file, b->data, 1, FS_FILE_BUFFER);
+
+				if (b->len == -1) {
+					Com_Error(ERROR_DROP, "%s: %s\n", filename, Fs_LastError());
+				}
+
+				list = g_list_append(list, b);
+				len += b->len;
+			}
+
+			if (buffer) {
+				if (len > 0) {
+					byte *buf = *buffer = Mem_TagMalloc(len + 1, MEM_TAG_FS);
+
+					GList *e = list;
+					while (e) {
+						fs_block_t *b = (fs_block_t *) e->data;
+
+						memcpy(buf, b->data, b->len);
+						buf += (ptrdiff_t) b->len;
+
+						e = e->next;
+					}
+
+					Fs_Loaded(*buffer, filename);
+				} else {
+
+					*buffer = NULL;
+				}
+			}
+
+			g_list_free_full(list, Mem_Free);
+		}
+
+		Fs_Close(file);
+	} else {
+
+		len = -1;
+
+		if (buffer) {
+			*buffer = NULL;
+		}
+	}
+
+	return len;
+}
+
+/**
+ * @brief Tracks the specified buffer, loaded from the given file, until it is
+ * freed with Fs_Free.
+ */
+static void Fs_Loaded(void *buffer, const char *filename) {
+
+	char *copy = Mem_CopyString(filename);
+
+	SDL_mutexP(fs_state.lock);
+
+	g_hash_table_insert(fs_state.loaded_files, buffer, (gpointer) copy);
+
+	SDL_mutexV(fs_state.lock);
+}
+
+/**
+ * @brief Frees the specified buffer allocated by Fs_LoadFile.
+ */
+void Fs_Free(void *buffer) {
+
+	if (buffer) {
+		SDL_mutexP(fs_state.lock);
+
+		const _Bool removed = g_hash_table_remove(fs_state.loaded_files, buffer);
+
+		SDL_mutexV(fs_state.lock);
+
+		if (!removed) {
+			Com_Warn("Invalid buffer\n");
+		}
+		Mem_Free(buffer);
+	}
+}
+
+/**
+ * @brief Reads a little-endian 16 bit integer from an unaligned address.
+ */
+static inline uint16_t Fs_ZipShort(const byte *b) {
+	return (uint16_t) (b[0] | (b[1] << 8));
+}
+
+/**
+ * @brief Reads a little-endian 32 bit integer from an unaligned address.
+ */
+static inline uint32_t Fs_ZipLong(const byte *b) {
+	return (uint32_t) b[0] | ((uint32_t) b[1] << 8) | ((uint32_t) b[2] << 16) | ((uint32_t) b[3] << 24);
+}
+
+#define ZIP_LOCAL_HEADER_SIG   0x04034b50
+#define ZIP_CENTRAL_HEADER_SIG 0x02014b50
+#define ZIP_END_SIG            0x06054b50
+
+#define ZIP_LOCAL_HEADER_LEN   30
+#define ZIP_CENTRAL_HEADER_LEN 46
+#define ZIP_END_LEN            22
+
+/**
+ * @brief Finds the end of central directory record, which precedes the
+ * archive comment, within the trailing bytes of a zip archive.
+ *
+ * @return The record, or NULL if none was found.
+ */
+static const byte *Fs_ZipEnd(const byte *zip, size_t zip_len) {
+
+	if (zip_len < ZIP_END_LEN) {
+		return NULL;
+	}
+
+	const size_t min = zip_len > ZIP_END_LEN + 0xffff ? zip_len - ZIP_END_LEN - 0xffff : 0;
+	for (size_t i = zip_len - ZIP_END_LEN + 1; i > min; i--) {
+		if (Fs_ZipLong(zip + i - 1) == ZIP_END_SIG) {
+			return zip + i - 1;
+		}
+	}
+
+	return NULL;
+}
+
+#if HAVE_MMAP
+
+/**
+ * @brief Resolves the specified entry within the mapped zip archive. Only
+ * entries that are stored (not deflated) and unencrypted can be used in place.
+ *
+ * @return The entry's data, or NULL if it is unsuitable for mapping.
+ */
+static const byte *Fs_MapZipEntry(const byte *zip, size_t zip_len, const char *filename, size_t *len) {
+
+	const byte *end = Fs_ZipEnd(zip, zip_len);
+	if (end == NULL) {
+		return NULL;
+	}
+
+	const uint16_t num_entries = Fs_ZipShort(end + 10);
+	const size_t directory_ofs = Fs_ZipLong(end + 16);
+
+	if (directory_ofs > zip_len) {
+		return NULL;
+	}
+
+	const size_t filename_len = strlen(filename);
+
+	size_t entry_ofs = directory_ofs;
+	for (uint16_t i = 0; i < num_entries; i++) {
+
+		if (entry_ofs + ZIP_CENTRAL_HEADER_LEN > zip_len) {
+			return NULL;
+		}
+
+		const byte *entry = zip + entry_ofs;
+
+		if (Fs_ZipLong(entry) != ZIP_CENTRAL_HEADER_SIG) {
+			return NULL;
+		}
+
+		const uint16_t name_len = Fs_ZipShort(entry + 28);
+		const uint16_t extra_len = Fs_ZipShort(entry + 30);
+		const uint16_t comment_len = Fs_ZipShort(entry + 32);
+
+		const size_t entry_len = ZIP_CENTRAL_HEADER_LEN + name_len + extra_len + comment_len;
+
+		if (entry_ofs + entry_len > zip_len) {
+			return NULL;
+		}
+
+		if (name_len == filename_len && !strncmp((const char *) entry + ZIP_CENTRAL_HEADER_LEN, filename, name_len)) {
+
+			const uint16_t flags = Fs_ZipShort(entry + 8);
+			const uint16_t method = Fs_ZipShort(entry + 10);
+
+			const size_t size = Fs_ZipLong(entry + 20);
+			const size_t local_ofs = Fs_ZipLong(entry + 42);
+
+			if ((flags & 1) || method != 0 || size != Fs_ZipLong(entry + 24)) {
+				return NULL;
+			}
+
+			if (local_ofs + ZIP_LOCAL_HEADER_LEN > zip_len) {
+				return NULL;
+			}
+
+			const byte *local = zip + local_ofs;
+
+			if (Fs_ZipLong(local) != ZIP_LOCAL_HEADER_SIG) {
+				return NULL;
+			}
+
+			const size_t data_ofs = local_ofs + ZIP_LOCAL_HEADER_LEN + Fs_ZipShort(local + 26) + Fs_ZipShort(local + 28);
+
+			if (data_ofs + size > zip_len) {
+				return NULL;
+			}
+
+			const byte *data = zip + data_ofs;
+
+			// callers cast the buffer to structures, so unaligned entries are copied
+			if ((uintptr_t) data & 3) {
+				return NULL;
+			}
+
+			*len = size;
+			return data;
+		}
+
+		entry_ofs += entry_len;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Attempts to memory-map the specified file, resolving it to a loose
+ * file or to a stored entry within a zip archive.
+ *
+ * @return The file length, or -1 if the file can not be mapped.
+ */
+static int64_t Fs_MapFile(const char *filename, fs_cache_entry_t *entry) {
+
+	const char *dir = Fs_RealDir(filename);
+	if (dir == NULL) {
+		return -1;
+	}
+
+	const _Bool is_dir = g_file_test(dir, G_FILE_TEST_IS_DIR);
+
+	if (!is_dir && !g_str_has_suffix(dir, ".pk3")) {
+		return -1;
+	}
+
+	char *path = is_dir ? g_build_filename(dir, filename, NULL) : g_strdup(dir);
+
+	const int32_t fd = open(path, O_RDONLY);
+
+	g_free(path);
+
+	if (fd == -1) {
+		return -1;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1 || st.st_size <= 0 || (uint64_t) st.st_size > SIZE_MAX) {
+		close(fd);
+		return -1;
+	}
+
+	const size_t len = (size_t) st.st_size;
+
+	void *base = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	close(fd);
+
+	if (base == MAP_FAILED) {
+		return -1;
+	}
+
+	const byte *data = base;
+	size_t data_len = len;
+
+	if (!is_dir) {
+		data = Fs_MapZipEntry(base, len, filename, &data_len);
+		if (data == NULL) {
+			munmap(base, len);
+			return -1;
+		}
+	}
+
+	entry->buffer = data;
+	entry->len = (int64_t) data_len;
+
+	entry->base = base;
+	entry->base_len = len;
+
+	return entry->len;
+}
+
+#endif
+
+/**
+ * @brief Releases the entry's buffer, and the entry itself. The lock must be
+ * held.
+ */
+static void Fs_FreeCacheEntry(fs_cache_entry_t *entry) {
+
+	g_hash_table_remove(fs_state.cache.buffers, entry->buffer);
+
+#if HAVE_MMAP
+	if (entry->base) {
+		munmap(entry->base, entry->base_len);
+	} else {
+		Fs_Free((void *) entry->buffer);
+	}
+#else
+	Fs_Free((void *) entry->buffer);
+#endif
+
+	Mem_Free(entry);
+}
+
+/**
+ * @brief Removes the cache entry for the specified file, so that subsequent
+ * calls to Fs_Map reload it. Entries still referenced are freed once they are
+ * released. The lock must be held.
+ */
+static void Fs_EvictCacheEntry(const char *filename) {
+
+	if (fs_state.cache.files == NULL) {
+		return;
+	}
+
+	fs_cache_entry_t *entry = g_hash_table_lookup(fs_state.cache.files, filename);
+	if (entry) {
+		g_hash_table_remove(fs_state.cache.files, filename);
+
+		if (entry->unused) {
+			g_queue_delete_link(&fs_state.cache.unused, entry->unused);
+			fs_state.cache.unused_size -= entry->len;
+
+			Fs_FreeCacheEntry(entry);
+		}
+	}
+}
+
+/**
+ * @brief Frees the least recently used, unreferenced entries until the cache
+ * fits within the specified size. The lock must be held.
+ */
+static void Fs_TrimCache(size_t size) {
+
+	while (fs_state.cache.unused_size > size) {
+		const fs_cache_entry_t *entry = g_queue_peek_head(&fs_state.cache.unused);
+		Fs_EvictCacheEntry(entry->filename);
+	}
+}
+
+/**
+ * @return The current cache entry for the specified file, referenced for the
+ * caller, or NULL if the file is not cached. Stale entries are evicted. The
+ * lock must be held.
+ */
+static fs_cache_entry_t *Fs_CacheEntry(const char *filename, int64_t mod_time) {
+
+	fs_cache_entry_t *entry = g_hash_table_lookup(fs_state.cache.files, filename);
+	if (entry) {
+		if (entry->mod_time == mod_time) {
+
+			if (entry->unused) {
+				g_queue_delete_link(&fs_state.cache.unused, entry->unused);
+				fs_state.cache.unused_size -= entry->len;
+				entry->unused = NULL;
+			}
+
+			entry->refs++;
+			return entry;
+		}
+
+		Fs_EvictCacheEntry(filename);
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Maps the specified file into memory, returning a read-only view of
+ * its contents. Loose files and stored (uncompressed) archive entries are
+ * memory-mapped, so that their pages are read lazily and shared with the page
+ * cache. Other files fall back to Fs_Load. Unlike Fs_Load, the buffer is not
+ * null-terminated. Be sure to release the buffer with Fs_Unmap.
+ *
+ * Buffers are reference counted and cached by filename and modification time,
+ * so that consumers of the same file (e.g. the collision model and renderer
+ * on a listen server) share a single copy. The buffer must not be modified.
+ *
+ * @return The file length, or -1 on error.
+ */
+int64_t Fs_Map(const char *filename, const void **buffer) {
+
+	const int64_t mod_time = Fs_LastModTime(filename);
+
+	SDL_mutexP(fs_state.lock);
+
+	fs_cache_entry_t *entry = Fs_CacheEntry(filename, mod_time);
+	if (entry) {
+		fs_state.cache.hits++;
+	} else {
+		fs_state.cache.misses++;
+	}
+
+	SDL_mutexV(fs_state.lock);
+
+	if (entry) {
+		*buffer = entry->buffer;
+		return entry->len;
+	}
+
+	// the file is read without holding the lock
+	entry = Mem_TagMalloc(sizeof(fs_cache_entry_t), MEM_TAG_FS);
+
+	int64_t len = -1;
+
+#if HAVE_MMAP
+	len = Fs_MapFile(filename, entry);
+#endif
+
+	if (len == -1) {
+		len = Fs_Load(filename, (void **) &entry->buffer);
+		entry->len = len;
+	}
+
+	if (entry->buffer == NULL) {
+		Mem_Free(entry);
+
+		*buffer = NULL;
+		return len;
+	}
+
+	entry->filename = Mem_Link(Mem_CopyString(filename), entry);
+	entry->mod_time = mod_time;
+	entry->refs = 1;
+
+	SDL_mutexP(fs_state.lock);
+
+	// another thread may have mapped the same file while we were reading it
+	fs_cache_entry_t *mapped = Fs_CacheEntry(filename, mod_time);
+	if (mapped) {
+		Fs_FreeCacheEntry(entry);
+		entry = mapped;
+	} else {
+		g_hash_table_insert(fs_state.cache.files, entry->filename, entry);
+		g_hash_table_insert(fs_state.cache.buffers, (gpointer) entry->buffer, entry);
+	}
+
+	SDL_mutexV(fs_state.lock);
+
+	*buffer = entry->buffer;
+	return entry->len;
+}
+
+/**
+ * @brief Releases the specified buffer returned by Fs_Map. Memory-mapped
+ * buffers remain cached for subsequent calls to Fs_Map until they are evicted,
+ * while loaded buffers are freed once they are no longer referenced.
+ */
+void Fs_Unmap(const void *buffer) {
+
+	if (buffer) {
+		SDL_mutexP(fs_state.lock);
+
+		fs_cache_entry_t *entry = g_hash_table_lookup(fs_state.cache.buffers, buffer);
+		if (entry == NULL) {
+			SDL_mutexV(fs_state.lock);
+			Com_Warn("Invalid buffer\n");
+			return;
+		}
+
+		if (--entry->refs == 0) {
+			if (entry->base && g_hash_table_lookup(fs_state.cache.files, entry->filename) == entry) {
+				g_queue_push_tail(&fs_state.cache.unused, entry);
+				entry->unused = g_queue_peek_tail_link(&fs_state.cache.unused);
+				fs_state.cache.unused_size += entry->len;
+
+				Fs_TrimCache(FS_CACHE_SIZE);
+			} else {
+				if (g_hash_table_lookup(fs_state.cache.files, entry->filename) == entry) {
+					g_hash_table_remove(fs_state.cache.files, entry->filename);
+				}
+
+				Fs_FreeCacheEntry(entry);
+			}
+		}
+
+		SDL_mutexV(fs_state.lock);
+	}
+}
+
+/**
+ * @brief Fetches the file cache statistics.
+ */
+void Fs_CacheStats(fs_cache_stats_t *stats) {
+
+	memset(stats, 0, sizeof(*stats));
+
+	SDL_mutexP(fs_state.lock);
+
+	stats->hits = fs_state.cache.hits;
+	stats->misses = fs_state.cache.misses;
+
+	GHashTableIter it;
+	g_hash_table_iter_init(&it, fs_state.cache.buffers);
+
+	const fs_cache_entry_t *entry;
+	while (g_hash_table_iter_next(&it, NULL, (gpointer *) &entry)) {
+		stats->num_files++;
+		stats->size += entry->len;
+
+		if (entry->refs) {
+			stats->num_referenced++;
+		}
+	}
+
+	SDL_mutexV(fs_state.lock);
+}
+
+/**
+ * @brief Frees all unreferenced file cache entries, and detaches the rest so
+ * that they are freed once released.
+ */
+static void Fs_FlushCache(void) {
+
+	SDL_mutexP(fs_state.lock);
+
+	Fs_TrimCache(0);
+
+	g_hash_table_remove_all(fs_state.cache.files);
+
+	SDL_mutexV(fs_state.lock);
+}
+
+/**
+ * @brief Discards any cached or prefetched contents of the specified file,
+ * which is about to be modified.
+ */
+static void Fs_Invalidate(const char *filename) {
+
+	SDL_mutexP(fs_state.lock);
+
+	Fs_EvictCacheEntry(filename);
+
+	SDL_mutexV(fs_state.lock);
+
+	Fs_LoadAsync_discard(filename);
+}
+
+/**
+ * @brief Renames the specified source to the given destination.
+ */
+_Bool Fs_Rename(const char *source, const char *dest) {
+	const char *dir = Fs_WriteDir();
+
+	const char *src = va("%s"G_DIR_SEPARATOR_S"%s", dir, source);
+	const char *dst = va("%s"G_DIR_SEPARATOR_S"%s", dir, dest);
+
+	Fs_Invalidate(source);
+	Fs_Invalidate(dest);
+
+	const _Bool renamed = rename(src, dst) == 0;
+
+	if (renamed && g_file_test(dst, G_FILE_TEST_IS_DIR)) {
+		Fs_BuildIndex();
+	} else {
+		Fs_IndexRefresh(source);
+		Fs_IndexRefresh(dest);
+	}
+
+	return renamed;
+}
+
+/**
+ * @brief Fetch the "last modified" time for the specified file.
+ */
+int64_t Fs_LastModTime(const char *filename) {
+	const char *dir;
+	PHYSFS_Stat stat;
+
+	if (Fs_IndexLookup(filename, &dir) && dir == NULL) {
+		return -1;
+	}
+
+	if (PHYSFS_stat(filename, &stat) == 0) {
+		return -1;
+	}
+
+	return stat.modtime;
+}
+
+
+/**
+ * @brief Unlinks (deletes) the specified file.
+ */
+_Bool Fs_Unlink(const char *filename) {
+
+	if (!g_strcmp0(Fs_WriteDir(), Fs_RealDir(filename))) {
+		Fs_Invalidate(filename);
+
+		const _Bool unlinked = unlink(filename) == 0;
+
+		Fs_IndexRefresh(filename);
+
+		return unlinked;
+	}
+
+	return false;
+}
+
+typedef struct {
+	char dir[MAX_QPATH];
+	glob_pattern_t glob;
+	Fs_Enumerator function;
+	void *data;
+} fs_enumerate_t;
+
+/**
+ * @brief Enumeration helper for Fs_Enumerate.
+ */
+static int32_t Fs_Enumerate_(void *data, const char *dir, const char *filename) {
+	char path[MAX_QPATH];
+	const fs_enumerate_t *en = data;
+
+	g_snprintf(path, sizeof(path), "%s%s", dir, filename);
+
+	if (GlobMatchCompiled(&en->glob, path)) {
+		en->function(path, en->data);
+	}
+
+	return 1;
+}
+
+/**
+ * @brief Enumerates files matching `pattern`, calling the given function. The
+ * paths are borrowed, and valid only for the duration of each call. No memory
+ * is allocated while walking the path index.
+ */
+void Fs_Enumerate(const char *pattern, Fs_Enumerator func, void *data) {
+	fs_enumerate_t en = {
+		.function = func,
+		.data = data,
+	};
+
+	GlobCompile(pattern, GLOB_FLAGS_NONE, &en.glob);
+
+	if (strchr(pattern, '/')) {
+		Dirname(pattern, en.dir);
+	} else {
+		g_strlcpy(en.dir, "/", sizeof(en.dir));
+	}
+
+	if (!Fs_IndexEnumerate(en.dir, &en.glob, func, data)) {
+		PHYSFS_enumerate(en.dir, Fs_Enumerate_, &en);
+	}
+}
+
+/**
+ * @brief OS compare, wee.
+ */
+static int32_t Fs_CompleteFile_compare(const void *a, const void *b) {
+	const com_autocomplete_match_t *ma = (const com_autocomplete_match_t *) a;
+	const com_autocomplete_match_t *mb = (const com_autocomplete_match_t *) b;
+
+#if defined(WIN32)
+	return stricmp(ma->name, mb->name);
+#else
+	return g_strcmp0(ma->name, mb->name);
+#endif
+}
+
+/**
+ * @brief Fs_Enumerator for Fs_CompleteFile.
+ */
+static void Fs_CompleteFile_enumerate(const char *path, void *data) {
+	GList **matches = (GList **) data;
+	char match[MAX_OS_PATH];
+
+	StripExtension(Basename(path), match);
+
+	*matches = g_list_prepend(*matches, Com_AllocMatch(match, NULL));
+}
+
+/**
+ * @brief Console completion for file names. Matches are gathered and sorted
+ * once, rather than inserted in order one at a time.
+ */
+void Fs_CompleteFile(const char *pattern, GList **matches) {
+	GList *found = NULL;
+
+	Fs_Enumerate(pattern, Fs_CompleteFile_enumerate, (void *) &found);
+
+	found = g_list_sort(found, Fs_CompleteFile_compare);
+
+	// omit duplicates, both among the files found and of existing matches
+	GList *m = *matches;
+
+	for (GList *e = found, *next; e; e = next) {
+		next = e->next;
+
+		while (m && Fs_CompleteFile_compare(m->data, e->data) < 0) {
+			m = m->next;
+		}
+
+		if ((m && Fs_CompleteFile_compare(m->data, e->data) == 0) ||
+			(e->prev && Fs_CompleteFile_compare(e->prev->data, e->data) == 0)) {
+			Mem_Free(e->data);
+			found = g_list_delete_link(found, e);
+		}
+	}
+
+	*matches = g_list_sort(g_list_concat(*matches, found), Fs_CompleteFile_compare);
+}
+
+/**
+ * @brief Normalizes the specified path to an index key, stripping redundant
+ * separators.
+ *
+ * @return True on success, false if the path must be resolved by PhysFS.
+ */
+static _Bool Fs_IndexKey(const char *path, char *key, size_t len) {
+
+	const char *in = path;
+	char *out = key;
+
+	while (*in == '/') {
+		in++;
+	}
+
+	while (*in) {
+
+		if ((size_t) (out - key) == len - 1) {
+			return false;
+		}
+
+		if (*in == '\\' || *in == ':') {
+			return false;
+		}
+
+		if (*in == '/') {
+			while (*(in + 1) == '/') {
+				in++;
+			}
+			if (*(in + 1) == '\0') {
+				break;
+			}
+		} else if (*in == '.' && (out == key || *(out - 1) == '/')) {
+			const char *c = in + (*(in + 1) == '.' ? 2 : 1);
+			if (*c == '/' || *c == '\0') {
+				return false;
+			}
+		}
+
+		*out++ = *in++;
+	}
+
+	*out = '\0';
+	return out > key;
+}
+
+#if defined(_WIN32) || defined(__APPLE__)
+
+/**
+ * @brief Case-insensitive GHashFunc for index keys, matching the filesystems
+ * of these platforms.
+ */
+static guint Fs_IndexHash(gconstpointer key) {
+	guint hash = 5381;
+
+	for (const char *c = key; *c; c++) {
+		hash = (hash << 5) + hash + (guint) g_ascii_tolower(*c);
+	}
+
+	return hash;
+}
+
+/**
+ * @brief Case-insensitive GEqualFunc for index keys.
+ */
+static gboolean Fs_IndexEqual(gconstpointer a, gconstpointer b) {
+	return g_ascii_strcasecmp(a, b) == 0;
+}
+
+#else
+	#define Fs_IndexHash g_str_hash
+	#define Fs_IndexEqual g_str_equal
+#endif
+
+/**
+ * @brief Allocates an empty index.
+ */
+static fs_index_t *Fs_IndexNew(void) {
+
+	fs_index_t *index = g_new0(fs_index_t, 1);
+
+	index->paths = g_hash_table_new_full(Fs_IndexHash, Fs_IndexEqual, NULL, g_free);
+	index->root = g_malloc0(sizeof(fs_index_entry_t) + 1);
+	index->strings = g_string_chunk_new(4096);
+	index->complete = true;
+
+	return index;
+}
+
+/**
+ * @brief Frees the specified index and all of its entries.
+ */
+static void Fs_IndexFree(fs_index_t *index) {
+
+	if (index) {
+		g_hash_table_destroy(index->paths);
+		g_free(index->root);
+		g_string_chunk_free(index->strings);
+		g_free(index);
+	}
+}
+
+/**
+ * @brief Allocates an entry for the specified key, linking it to its parent.
+ */
+static fs_index_entry_t *Fs_IndexInsert(fs_index_t *index, fs_index_entry_t *parent, const char *key, const char *dir) {
+
+	const size_t len = strlen(key);
+	fs_index_entry_t *entry = g_malloc0(sizeof(fs_index_entry_t) + len + 1);
+
+	memcpy(entry->path, key, len + 1);
+
+	const char *c = strrchr(entry->path, '/');
+	entry->name = c ? c + 1 : entry->path;
+
+	entry->dir = dir;
+
+	entry->parent = parent;
+	entry->next = parent->children;
+	parent->children = entry;
+
+	g_hash_table_insert(index->paths, entry->path, entry);
+	return entry;
+}
+
+/**
+ * @brief Unlinks and frees the specified childless entry of the current index.
+ * The index lock must be held.
+ */
+static void Fs_IndexRemove(fs_index_entry_t *entry) {
+
+	fs_index_entry_t **e = &entry->parent->children;
+	while (*e != entry) {
+		e = &(*e)->next;
+	}
+	*e = entry->next;
+
+	g_hash_table_remove(fs_state.index.current->paths, entry->path);
+	fs_state.index.removals++;
+}
+
+/**
+ * @brief Indexes the specified path, and its ancestor directories, as provided
+ * by the search path entry `dir`. Entries that are mounted ahead of those
+ * already indexed replace them.
+ */
+static void Fs_IndexPath(fs_index_t *index, const char *path, const char *dir, _Bool replace) {
+	char key[MAX_OS_PATH];
+
+	if (!Fs_IndexKey(path, key, sizeof(key))) {
+		return;
+	}
+
+	if (!replace && g_hash_table_contains(index->paths, key)) {
+		return; // the ancestors are indexed as well
+	}
+
+	fs_index_entry_t *parent = index->root;
+	char *c = key;
+
+	while (true) {
+
+		if ((c = strchr(c, '/'))) {
+			*c = '\0';
+		}
+
+		fs_index_entry_t *entry = g_hash_table_lookup(index->paths, key);
+		if (entry == NULL) {
+			entry = Fs_IndexInsert(index, parent, key, dir);
+		} else if (replace) {
+			entry->dir = dir;
+		}
+
+		if (c == NULL) {
+			break;
+		}
+
+		*c++ = '/';
+		parent = entry;
+	}
+}
+
+/**
+ * @brief Recursively indexes the contents of the specified directory mount.
+ */
+static void Fs_IndexDir(fs_index_t *index, const char *dir, const char *path, int32_t depth) {
+
+	gchar *real_path = g_build_filename(dir, path, NULL);
+
+	GDir *d = g_dir_open(real_path, 0, NULL);
+	if (d) {
+		const gchar *name;
+		while ((name = g_dir_read_name(d))) {
+			char child[MAX_OS_PATH];
+
+			if (*path) {
+				g_snprintf(child, sizeof(child), "%s/%s", path, name);
+			} else {
+				g_strlcpy(child, name, sizeof(child));
+			}
+
+			Fs_IndexPath(index, child, dir, false);
+
+			gchar *real_child = g_build_filename(real_path, name, NULL);
+
+			if (depth < FS_INDEX_DEPTH && g_file_test(real_child, G_FILE_TEST_IS_DIR)) {
+				Fs_IndexDir(index, dir, child, depth + 1);
+			}
+
+			g_free(real_child);
+		}
+		g_dir_close(d);
+	}
+
+	g_free(real_path);
 }
 
 /**
- * @brief Loads the specified file into the given buffer, which is automatically
- * allocated if non-NULL. Returns the file length, or -1 if it is unable to be
- * read. Be sure to free the buffer when finished with Fs_Free.
+ * @brief Indexes the central directory of the specified zip archive.
  *
- * @return The file length, or -1 on error.
+ * @return True on success, false if the archive could not be parsed.
  */
-int64_t Fs_Load(const char *filename, void **buffer) {
-	int64_t len;
+static _Bool Fs_IndexZip(fs_index_t *index, FILE *file, const char *dir) {
 
-	typedef struct {
-		byte *data;
-		int64_t len;
-	} fs_block_t;
+	if (fseek(file, 0, SEEK_END)) {
+		return false;
+	}
 
-	file_t *file;
+	const long file_len = ftell(file);
+	if (file_len < ZIP_END_LEN) {
+		return false;
+	}
 
-	if ((file = Fs_OpenRead(filename))) {
-		const int64_t buffer_length = Fs_FileLength(file);
+	const size_t tail_len = MIN((size_t) file_len, ZIP_END_LEN + 0xffff);
+	byte *tail = Mem_Malloc(tail_len);
 
-		// if we can calculate the length, we can pull it easily
-		if (buffer_length != -1) {
+	_Bool indexed = false;
 
-			len = buffer_length;
+	if (fseek(file, file_len - tail_len, SEEK_SET) == 0 && fread(tail, 1, tail_len, file) == tail_len) {
 
-			if (buffer) {
-				if (len > 0) {
-					byte *buf = *buffer = Mem_TagMalloc(len + 1, MEM_TAG_FS);
-					const int64_t read = Fs_Read(file, buf, 1, len);
+		const byte *end = Fs_ZipEnd(tail, tail_len);
+		if (end) {
+			const uint16_t num_entries = Fs_ZipShort(end + 10);
+			const size_t directory_len = Fs_ZipLong(end + 12);
+			const size_t directory_ofs = Fs_ZipLong(end + 16);
 
-					if (read != len) {
-						Com_Error(ERROR_DROP, "%s: %s\n", filename, Fs_LastError());
-					}
+			// zip64 archives are left to PhysFS
+			if (num_entries != 0xffff && directory_ofs + directory_len <= (size_t) file_len) {
+				byte *directory = Mem_LinkMalloc(directory_len + 1, tail);
 
-					g_hash_table_insert(fs_state.loaded_files, *buffer,
-										(gpointer) Mem_CopyString(filename));
-				} else {
+				if (fseek(file, directory_ofs, SEEK_SET) == 0 && fread(directory, 1, directory_len, file) == directory_len) {
 
-					*buffer = NULL;
-				}
-			}
-		} else {
+					const byte *entry = directory;
+					uint16_t i;
 
-			GList *list = NULL;
-			len = 0;
+					for (i = 0; i < num_entries; i++) {
 
-			while (!Fs_Eof(file)) {
-				fs_block_t *b = Mem_TagMalloc(sizeof(fs_block_t), MEM_TAG_FS);
+						if (entry + ZIP_CENTRAL_HEADER_LEN > directory + directory_len || Fs_ZipLong(entry) != ZIP_CENTRAL_HEADER_SIG) {
+							break;
+						}
 
-				b->data = Mem_LinkMalloc(FS_FILE_BUFFER, b);
-				b->len = Fs_Read(file, b->data, 1, FS_FILE_BUFFER);
+						const uint16_t name_len = Fs_ZipShort(entry + 28);
+						const uint16_t extra_len = Fs_ZipShort(entry + 30);
+						const uint16_t comment_len = Fs_ZipShort(entry + 32);
 
-				if (b->len == -1) {
-					Com_Error(ERROR_DROP, "%s: %s\n", filename, Fs_LastError());
-				}
+						if (entry + ZIP_CENTRAL_HEADER_LEN + name_len > directory + directory_len || name_len >= MAX_OS_PATH) {
+							break;
+						}
 
-				list = g_list_append(list, b);
-				len += b->len;
+						char name[MAX_OS_PATH];
+						memcpy(name, entry + ZIP_CENTRAL_HEADER_LEN, name_len);
+						name[name_len] = '\0';
+
+						Fs_IndexPath(index, name, dir, false);
+
+						entry += ZIP_CENTRAL_HEADER_LEN + name_len + extra_len + comment_len;
+					}
+
+					indexed = i == num_entries;
+				}
 			}
+		}
+	}
 
-			if (buffer) {
-				if (len > 0) {
-					byte *buf = *buffer = Mem_TagMalloc(len + 1, MEM_TAG_FS);
+	Mem_Free(tail);
+	return indexed;
+}
 
-					GList *e = list;
-					while (e) {
-						fs_block_t *b = (fs_block_t *) e->data;
+#define PAK_HEADER_LEN 12
+#define PAK_ENTRY_LEN  64
+#define PAK_NAME_LEN   56
 
-						memcpy(buf, b->data, b->len);
-						buf += (ptrdiff_t) b->len;
+/**
+ * @brief Indexes the directory of the specified Quake pak archive.
+ *
+ * @return True on success, false if the archive could not be parsed.
+ */
+static _Bool Fs_IndexPak(fs_index_t *index, FILE *file, const char *dir) {
+	byte header[PAK_HEADER_LEN];
 
-						e = e->next;
-					}
+	if (fseek(file, 0, SEEK_SET) || fread(header, 1, sizeof(header), file) != sizeof(header)) {
+		return false;
+	}
 
-					g_hash_table_insert(fs_state.loaded_files, *buffer,
-										(gpointer) Mem_CopyString(filename));
-				} else {
+	const size_t directory_ofs = Fs_ZipLong(header + 4);
+	const size_t directory_len = Fs_ZipLong(header + 8);
 
-					*buffer = NULL;
-				}
-			}
+	if (directory_len % PAK_ENTRY_LEN) {
+		return false;
+	}
 
-			g_list_free_full(list, Mem_Free);
-		}
+	byte *directory = Mem_Malloc(directory_len + 1);
 
-		Fs_Close(file);
-	} else {
+	_Bool indexed = false;
 
-		len = -1;
+	if (fseek(file, directory_ofs, SEEK_SET) == 0 && fread(directory, 1, directory_len, file) == directory_len) {
 
-		if (buffer) {
-			*buffer = NULL;
+		for (size_t i = 0; i < directory_len; i += PAK_ENTRY_LEN) {
+			char name[PAK_NAME_LEN + 1];
+
+			memcpy(name, directory + i, PAK_NAME_LEN);
+			name[PAK_NAME_LEN] = '\0';
+
+			Fs_IndexPath(index, name, dir, false);
 		}
+
+		indexed = true;
 	}
 
-	return len;
+	Mem_Free(directory);
+	return indexed;
 }
 
 /**
- * @brief Frees the specified buffer allocated by Fs_LoadFile.
+ * @brief Indexes the specified search path entry behind those already in the
+ * given index. The index must not be the current one.
  */
-void Fs_Free(void *buffer) {
+static void Fs_IndexMount(fs_index_t *index, const char *dir, _Bool is_dir) {
 
-	if (buffer) {
-		if (!g_hash_table_remove(fs_state.loaded_files, buffer)) {
-			Com_Warn("Invalid buffer\n");
+	dir = g_string_chunk_insert_const(index->strings, dir);
+
+	if (is_dir) {
+		Fs_IndexDir(index, dir, "", 0);
+		return;
+	}
+
+	_Bool indexed = false;
+
+	FILE *file = fopen(dir, "rb");
+	if (file) {
+		byte magic[4];
+
+		if (fread(magic, 1, sizeof(magic), file) == sizeof(magic)) {
+			if (!memcmp(magic, "PACK", sizeof(magic))) {
+				indexed = Fs_IndexPak(index, file, dir);
+			} else {
+				indexed = Fs_IndexZip(index, file, dir);
+			}
 		}
-		Mem_Free(buffer);
+
+		fclose(file);
+	}
+
+	if (!indexed) {
+		Com_Debug(DEBUG_FILESYSTEM, "Failed to index %s, lookups will defer to PhysFS\n", dir);
+		index->complete = false;
 	}
 }
 
 /**
- * @brief Renames the specified source to the given destination.
+ * @brief Indexes the specified search path entry into the current index.
+ * Directories are mounted ahead of existing entries, and so replace them,
+ * while archives are mounted behind. The entry is indexed on its own first,
+ * so that the index lock is only held while merging it.
  */
-_Bool Fs_Rename(const char *source, const char *dest) {
-	const char *dir = Fs_WriteDir();
+static void Fs_IndexAddMount(const char *dir, _Bool is_dir) {
 
-	const char *src = va("%s"G_DIR_SEPARATOR_S"%s", dir, source);
-	const char *dst = va("%s"G_DIR_SEPARATOR_S"%s", dir, dest);
+	fs_index_t *mount = Fs_IndexNew();
 
-	return rename(src, dst) == 0;
-}
+	Fs_IndexMount(mount, dir, is_dir);
 
-/**
- * @brief Fetch the "last modified" time for the specified file.
- */
-int64_t Fs_LastModTime(const char *filename) {
-	PHYSFS_Stat stat;
-	PHYSFS_stat(filename, &stat);
-	return stat.modtime;
-}
+	SDL_mutexP(fs_state.index.lock);
 
+	fs_index_t *index = fs_state.index.current;
 
-/**
- * @brief Unlinks (deletes) the specified file.
- */
-_Bool Fs_Unlink(const char *filename) {
+	dir = g_string_chunk_insert_const(index->strings, dir);
 
-	if (!g_strcmp0(Fs_WriteDir(), Fs_RealDir(filename))) {
-		return unlink(filename) == 0;
+	GHashTableIter it;
+	gpointer key;
+
+	g_hash_table_iter_init(&it, mount->paths);
+	while (g_hash_table_iter_next(&it, &key, NULL)) {
+		Fs_IndexPath(index, (const char *) key, dir, is_dir);
 	}
 
-	return false;
-}
+	if (!mount->complete) {
+		index->complete = false;
+	}
 
-typedef struct {
-	char dir[MAX_QPATH];
-	const char *pattern;
-	Fs_Enumerator function;
-	void *data;
-} fs_enumerate_t;
+	SDL_mutexV(fs_state.index.lock);
+
+	Fs_IndexFree(mount);
+}
 
 /**
- * @brief Enumeration helper for Fs_Enumerate.
+ * @brief Rebuilds the path index from the current search path. The new index
+ * is built without holding the index lock, and then swapped in.
  */
-static int32_t Fs_Enumerate_(void *data, const char *dir, const char *filename) {
-	char path[MAX_QPATH];
-	const fs_enumerate_t *en = data;
+static void Fs_BuildIndex(void) {
 
-	g_snprintf(path, sizeof(path), "%s%s", dir, filename);
+	fs_index_t *index = Fs_IndexNew();
 
-	if (GlobMatch(en->pattern, path, GLOB_FLAGS_NONE)) {
-		en->function(path, en->data);
+	char **paths = PHYSFS_getSearchPath();
+	for (char **path = paths; *path; path++) {
+		Fs_IndexMount(index, *path, g_file_test(*path, G_FILE_TEST_IS_DIR));
 	}
+	PHYSFS_freeList(paths);
 
-	return 1;
+	Com_Debug(DEBUG_FILESYSTEM, "Indexed %u paths\n", g_hash_table_size(index->paths));
+
+	SDL_mutexP(fs_state.index.lock);
+
+	fs_index_t *old = fs_state.index.current;
+
+	fs_state.index.current = index;
+	fs_state.index.removals++;
+
+	SDL_mutexV(fs_state.index.lock);
+
+	Fs_IndexFree(old);
 }
 
 /**
- * @brief Enumerates files matching `pattern`, calling the given function.
+ * @brief Resolves the search path entry providing the specified path through
+ * the index.
+ *
+ * @return True if the index is authoritative, in which case `dir` is set to the
+ * providing entry, or NULL if the path does not exist. False if the caller must
+ * consult PhysFS.
  */
-void Fs_Enumerate(const char *pattern, Fs_Enumerator func, void *data) {
-	fs_enumerate_t en = {
-		.pattern = pattern,
-		.function = func,
-		.data = data,
-	};
+static _Bool Fs_IndexLookup(const char *path, const char **dir) {
+	char key[MAX_OS_PATH];
 
-	if (strchr(pattern, '/')) {
-		Dirname(pattern, en.dir);
-	} else {
-		g_strlcpy(en.dir, "/", sizeof(en.dir));
+	if (!Fs_IndexKey(path, key, sizeof(key))) {
+		return false;
 	}
 
-	PHYSFS_enumerate(en.dir, Fs_Enumerate_, &en);
-}
+	SDL_mutexP(fs_state.index.lock);
 
-/**
- * @brief OS compare, wee.
- */
-static int32_t Fs_CompleteFile_compare(const void *a, const void *b) {
-	const com_autocomplete_match_t *ma = (const com_autocomplete_match_t *) a;
-	const com_autocomplete_match_t *mb = (const com_autocomplete_match_t *) b;
+	const fs_index_t *index = fs_state.index.current;
 
-#if defined(WIN32)
-	return stricmp(ma->name, mb->name);
-#else
-	return g_strcmp0(ma->name, mb->name);
-#endif
+	const _Bool complete = index && index->complete;
+	if (complete) {
+		const fs_index_entry_t *entry = g_hash_table_lookup(index->paths, key);
+		*dir = entry ? entry->dir : NULL;
+	}
+
+	SDL_mutexV(fs_state.index.lock);
+
+	return complete;
 }
 
 /**
- * @brief GHFunc for Fs_CompleteFile.
+ * @brief Updates the index for the specified path, and its ancestors, after it
+ * has been created or removed through the write directory. The providing
+ * search path entries are resolved before the index lock is taken.
  */
-static void Fs_CompleteFile_enumerate(const char *path, void *data) {
-	GList **matches = (GList **) data;
-	char match[MAX_OS_PATH];
+static void Fs_IndexRefresh(const char *path) {
+	char key[MAX_OS_PATH];
+	const char *dirs[MAX_OS_PATH / 2];
+	size_t num_dirs = 0;
 
-	StripExtension(Basename(path), match);
-	com_autocomplete_match_t temp_match = {
-		.name = match,
-		.description = NULL
-	};
+	if (!Fs_IndexKey(path, key, sizeof(key))) {
+		return;
+	}
+
+	// resolve the path and its ancestors, up to the first that does not exist
+	for (char *c = key; ; c++) {
+
+		if ((c = strchr(c, '/'))) {
+			*c = '\0';
+		}
+
+		dirs[num_dirs] = PHYSFS_getRealDir(key);
+
+		if (c) {
+			*c = '/';
+		}
+
+		if (dirs[num_dirs++] == NULL || c == NULL) {
+			break;
+		}
+	}
+
+	SDL_mutexP(fs_state.index.lock);
+
+	fs_index_t *index = fs_state.index.current;
+
+	fs_index_entry_t *parent = index ? index->root : NULL;
+	char *c = key;
+
+	for (size_t i = 0; parent && i < num_dirs; i++) {
 
-	if (!g_list_find_custom(*matches, &temp_match, Fs_CompleteFile_compare)) {
-		*matches = g_list_insert_sorted(*matches, Com_AllocMatch(match, NULL), Fs_CompleteFile_compare);
+		if ((c = strchr(c, '/'))) {
+			*c = '\0';
+		}
+
+		fs_index_entry_t *entry = g_hash_table_lookup(index->paths, key);
+
+		const char *dir = dirs[i];
+		if (dir == NULL) {
+			if (entry && entry->children == NULL) {
+				Fs_IndexRemove(entry);
+			}
+			break;
+		}
+
+		dir = g_string_chunk_insert_const(index->strings, dir);
+
+		if (entry == NULL) {
+			entry = Fs_IndexInsert(index, parent, key, dir);
+		} else {
+			entry->dir = dir;
+		}
+
+		if (c == NULL) {
+			break;
+		}
+
+		*c++ = '/';
+		parent = entry;
 	}
+
+	SDL_mutexV(fs_state.index.lock);
 }
 
 /**
- * @brief Console completion for file names.
+ * @brief Enumerates the children of the specified directory through the index,
+ * calling the given function for each path matching the glob. The index lock is
+ * released while the function runs, so it may use the filesystem freely.
+ *
+ * @return True if the index is authoritative, false if the caller must consult
+ * PhysFS.
  */
-void Fs_CompleteFile(const char *pattern, GList **matches) {
+static _Bool Fs_IndexEnumerate(const char *dir, const glob_pattern_t *glob, Fs_Enumerator func, void *data) {
+	char key[MAX_OS_PATH], path[MAX_OS_PATH];
+
+	const char *d = dir;
+	while (*d == '/') {
+		d++;
+	}
+
+	if (*d == '\0') {
+		key[0] = '\0';
+	} else if (!Fs_IndexKey(d, key, sizeof(key))) {
+		return false;
+	}
+
+	const size_t dir_len = g_strlcpy(path, dir, sizeof(path));
+	if (dir_len >= sizeof(path)) {
+		return false;
+	}
+
+	SDL_mutexP(fs_state.index.lock);
+
+	const fs_index_t *index = fs_state.index.current;
+
+	const _Bool complete = index && index->complete;
+	if (complete) {
+		const fs_index_entry_t *parent;
+
+		if (*key) {
+			parent = g_hash_table_lookup(index->paths, key);
+		} else {
+			parent = index->root;
+		}
+
+		const uint32_t removals = fs_state.index.removals;
+
+		for (const fs_index_entry_t *e = parent ? parent->children : NULL; e; e = e->next) {
 
-	Fs_Enumerate(pattern, Fs_CompleteFile_enumerate, (void *) matches);
+			g_strlcpy(path + dir_len, e->name, sizeof(path) - dir_len);
+
+			if (GlobMatchCompiled(glob, path)) {
+
+				SDL_mutexV(fs_state.index.lock);
+
+				func(path, data);
+
+				SDL_mutexP(fs_state.index.lock);
+
+				// siblings are only ever prepended, so our position remains valid
+				// unless entries were freed
+				if (fs_state.index.removals != removals) {
+					Com_Debug(DEBUG_FILESYSTEM, "%s modified during enumeration\n", dir);
+					break;
+				}
+			}
+		}
+	}
+
+	SDL_mutexV(fs_state.index.lock);
+
+	return complete;
 }
 
 static void Fs_AddToSearchPath_enumerate(const char *path, void *data);
@@ -490,12 +2206,17 @@ void Fs_AddToSearchPath(const char *dir) {
 		Com_Print("Adding path %s..\n", dir);
 
 		const _Bool is_dir = g_file_test(dir, G_FILE_TEST_IS_DIR);
+		const _Bool is_mounted = PHYSFS_getMountPoint(dir) != NULL;
 
 		if (PHYSFS_mount(dir, NULL, !is_dir) == 0) {
 			Com_Warn("%s: %s\n", dir, Fs_LastError());
 			return;
 		}
 
+		if (!is_mounted) {
+			Fs_IndexAddMount(dir, is_dir);
+		}
+
 		if ((fs_state.flags & FS_AUTO_LOAD_ARCHIVES) && is_dir) {
 			Fs_Enumerate("*.pak", Fs_AddToSearchPath_enumerate, (void *) dir);
 			Fs_Enumerate("*.pk3", Fs_AddToSearchPath_enumerate, (void *) dir);
@@ -553,6 +2274,9 @@ void Fs_SetGame(const char *dir) {
 
 	Com_Debug(DEBUG_FILESYSTEM, "Setting game: %s\n", dir);
 
+	Fs_FlushAsync();
+	Fs_FlushCache();
+
 	// iterate the current search path, removing those which are not base paths
 	char **paths = PHYSFS_getSearchPath();
 	char **path = paths;
@@ -576,6 +2300,8 @@ void Fs_SetGame(const char *dir) {
 
 	PHYSFS_freeList(paths);
 
+	Fs_BuildIndex();
+
 	// now add new entries for the new game
 	Fs_AddToSearchPath(va(PKGLIBDIR G_DIR_SEPARATOR_S "%s", dir));
 	Fs_AddToSearchPath(va(PKGDATADIR G_DIR_SEPARATOR_S "%s", dir));
@@ -616,6 +2342,12 @@ const char *Fs_WriteDir(void) {
  * @brief Returns the real directory name of the specified file.
  */
 const char *Fs_RealDir(const char *filename) {
+	const char *dir;
+
+	if (Fs_IndexLookup(filename, &dir)) {
+		return dir;
+	}
+
 	return PHYSFS_getRealDir(filename);
 }
 
@@ -651,6 +2383,11 @@ void Fs_Init(const uint32_t flags) {
 
 	memset(&fs_state, 0, sizeof(fs_state_t));
 
+	fs_state.lock = SDL_CreateMutex();
+
+	fs_state.index.current = Fs_IndexNew();
+	fs_state.index.lock = SDL_CreateMutex();
+
 	PHYSFS_Version physfs_version;
 	PHYSFS_getLinkedVersion(&physfs_version);
 
@@ -738,6 +2475,11 @@ void Fs_Init(const uint32_t flags) {
 	fs_state.base_search_paths = PHYSFS_getSearchPath();
 
 	fs_state.loaded_files = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, Mem_Free);
+
+	fs_state.cache.files = g_hash_table_new(g_str_hash, g_str_equal);
+	fs_state.cache.buffers = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	Fs_InitAsync();
 }
 
 /**
@@ -747,6 +2489,13 @@ static void Fs_LoadedFiles_(gpointer key, gpointer value, gpointer data) {
 	Com_Print("Fs_PrintLoadedFiles: %s @ %p\n", (char *) value, key);
 }
 
+/**
+ * @brief Prints the names of mapped (i.e. yet-to-be-unmapped) files.
+ */
+static void Fs_MappedFiles_(gpointer key, gpointer value, gpointer data) {
+	Com_Print("Fs_PrintMappedFiles: %s @ %p\n", ((fs_cache_entry_t *) value)->filename, key);
+}
+
 /**
  * @brief Shuts down the filesystem.
  */
@@ -756,9 +2505,26 @@ void Fs_Shutdown(void) {
 		return;
 	}
 
+	Fs_ShutdownAsync();
+
+	Fs_FlushCache();
+
+	g_hash_table_foreach(fs_state.cache.buffers, Fs_MappedFiles_, NULL);
+	g_hash_table_destroy(fs_state.cache.buffers);
+	g_hash_table_destroy(fs_state.cache.files);
+
 	g_hash_table_foreach(fs_state.loaded_files, Fs_LoadedFiles_, NULL);
 	g_hash_table_destroy(fs_state.loaded_files);
 
+	SDL_DestroyMutex(fs_state.lock);
+	fs_state.lock = NULL;
+
+	Fs_IndexFree(fs_state.index.current);
+	fs_state.index.current = NULL;
+
+	SDL_DestroyMutex(fs_state.index.lock);
+	fs_state.index.lock = NULL;
+
 	PHYSFS_freeList(fs_state.base_search_paths);
 
 	PHYSFS_deinit();
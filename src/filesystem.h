@@ -41,8 +41,24 @@ typedef struct {
 	void *opaque;
 } file_t;
 
+/**
+ * @brief File cache statistics, for profiling.
+ */
+typedef struct {
+	uint32_t hits, misses;
+	uint32_t num_files; // files cached, including those no longer current
+	uint32_t num_referenced; // files currently mapped by callers
+	size_t size; // total size of cached files, in bytes
+} fs_cache_stats_t;
+
 typedef void (*Fs_Enumerator)(const char *path, void *data);
 
+/**
+ * @brief Asynchronous load callbacks are given the loaded buffer, which must be
+ * freed with Fs_Free, and its length, or -1 on error.
+ */
+typedef void (*Fs_LoadFunc)(const char *filename, void *buffer, int64_t len, void *data);
+
 const char *Fs_BaseDir(void);
 _Bool Fs_Close(file_t *file);
 _Bool Fs_Delete(const char *filename);
@@ -62,8 +78,15 @@ int64_t Fs_FileLength(file_t *file);
 int64_t Fs_Tell(file_t *file);
 int64_t Fs_Write(file_t *file, const void *buffer, size_t size, size_t count);
 int64_t Fs_Load(const char *filename, void **buffer);
+void Fs_LoadAsync(const char *filename, Fs_LoadFunc func, void *data);
+void Fs_LoadAsyncBatch(const char **filenames, size_t count, Fs_LoadFunc func, void *data);
+uint32_t Fs_PollAsync(void);
+void Fs_WaitAsync(void);
 int64_t Fs_LastModTime(const char *filename);
 void Fs_Free(void *buffer);
+int64_t Fs_Map(const char *filename, const void **buffer);
+void Fs_Unmap(const void *buffer);
+void Fs_CacheStats(fs_cache_stats_t *stats);
 _Bool Fs_Rename(const char *source, const char *dest);
 _Bool Fs_Unlink(const char *filename);
 void Fs_Enumerate(const char *pattern, Fs_Enumerator, void *data);
@@ -124,6 +124,30 @@ static _Bool Img_LoadTypedImage(const char *name, const char *type, SDL_Surface
 	return *surf != NULL;
 }
 
+/**
+ * @brief Resolves the file backing the specified image, trying image formats
+ * in the same order as Img_LoadImage.
+ *
+ * @return The filename, or NULL if the image can not be found.
+ */
+const char *Img_ResolveImage(const char *name) {
+	static char path[MAX_QPATH];
+
+	char basename[MAX_QPATH];
+	StripExtension(name, basename);
+
+	for (int32_t i = 0; img_formats[i]; i++) {
+
+		g_snprintf(path, sizeof(path), "%s.%s", basename, img_formats[i]);
+
+		if (Fs_Exists(path)) {
+			return path;
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * @brief Loads the specified image from the game filesystem and populates
  * the provided SDL_Surface. Image formats are tried in the order they appear
@@ -34,6 +34,11 @@ typedef uint32_t img_palette_t[IMG_PALETTE_SIZE];
  */
 extern img_palette_t img_palette;
 
+/**
+ * @brief Resolves the file backing the image by the specified Quake path.
+ */
+const char *Img_ResolveImage(const char *name);
+
 /**
  * @brief Loads an image by the specified Quake path to the given surface.
  */
@@ -34,6 +34,7 @@ quetoo_t quetoo;
 
 static cvar_t *verbose;
 static cvar_t *version;
+static cvar_t *vis_budget;
 
 cvar_t *dedicated;
 cvar_t *game;
@@ -290,6 +291,22 @@ static void MemStats_f(void) {
 	g_array_free(stats, true);
 }
 
+/**
+ * @brief
+ */
+static void FsStats_f(void) {
+
+	fs_cache_stats_t stats;
+	Fs_CacheStats(&stats);
+
+	const uint32_t lookups = stats.hits + stats.misses;
+
+	Com_Print("File cache stats:\n");
+	Com_Print(" %u hits, %u misses (%.1f%% hit rate)\n", stats.hits, stats.misses,
+	          lookups ? stats.hits * 100.0 / lookups : 0.0);
+	Com_Print(" %u files (%u referenced) - %" PRIuPTR " bytes\n", stats.num_files, stats.num_referenced, stats.size);
+}
+
 /**
  * @brief
  */
@@ -322,6 +339,12 @@ static void Init(void) {
 	threads = Cvar_Add("threads", "0", CVAR_ARCHIVE, "Specifies the number of threads to create");
 	threads->modified = false;
 
+	vis_budget = Cvar_Add("vis_budget", va("%d", CM_VIS_BUDGET >> 20), CVAR_ARCHIVE,
+	                      "The memory budget, in megabytes, for decompressed map visibility");
+	vis_budget->modified = false;
+
+	cm_vis_budget = (size_t) Max(vis_budget->integer, 0) << 20;
+
 	time_demo = Cvar_Add("time_demo", "0", CVAR_DEVELOPER, "Benchmark and stress test");
 	time_scale = Cvar_Add("time_scale", "1.0", CVAR_DEVELOPER, "Controls time lapse");
 
@@ -338,6 +361,7 @@ static void Init(void) {
 	Con_Init();
 
 	Cmd_Add("mem_stats", MemStats_f, CMD_SYSTEM, "Print memory stats");
+	Cmd_Add("fs_stats", FsStats_f, CMD_SYSTEM, "Print file cache stats");
 	Cmd_Add("debug", Debug_f, CMD_SYSTEM, "Control debugging output");
 	Cmd_Add("quit", Quit_f, CMD_SYSTEM, "Quit Quetoo");
 
@@ -410,6 +434,13 @@ static void Frame(const uint32_t msec) {
 		Thread_Init(threads->integer);
 	}
 
+	if (vis_budget->modified) {
+		vis_budget->modified = false;
+
+		// applied when the next map is loaded
+		cm_vis_budget = (size_t) Max(vis_budget->integer, 0) << 20;
+	}
+
 	if (game->modified) {
 		game->modified = false;
 
@@ -20,6 +20,14 @@
 
 #include "matrix.h"
 
+#if defined(__SSE2__) || defined(_M_X64)
+ #define MATRIX4x4_SSE 1
+ #include <emmintrin.h>
+#elif defined(__ARM_NEON)
+ #define MATRIX4x4_NEON 1
+ #include <arm_neon.h>
+#endif
+
 const matrix4x4_t matrix4x4_identity = {
 	{
 		{1, 0, 0, 0},
@@ -2059,3 +2067,210 @@ void Matrix4x4_FromOrtho (matrix4x4_t *out, double left, double right, double bo
 	out->m[3][2] = (farval + nearval) * nf;
 	out->m[3][3] = 1.0;
 }
+
+void Matrix4x4_CreateFromEntityf(matrix4x4_t *out, const vec3_t origin, const vec3_t angles, vec_t scale) {
+	vec_t sr = 0.0f, sp = 0.0f, sy = 0.0f, cr = 1.0f, cp = 1.0f, cy = 1.0f;
+
+	if (angles[YAW]) {
+		const vec_t angle = angles[YAW] * (vec_t) (M_PI * 2 / 360);
+		sy = sinf(angle);
+		cy = cosf(angle);
+	}
+	if (angles[PITCH]) {
+		const vec_t angle = angles[PITCH] * (vec_t) (M_PI * 2 / 360);
+		sp = sinf(angle);
+		cp = cosf(angle);
+	}
+	if (angles[ROLL]) {
+		const vec_t angle = angles[ROLL] * (vec_t) (M_PI * 2 / 360);
+		sr = sinf(angle);
+		cr = cosf(angle);
+	}
+
+#if MATRIX4x4_OPENGLORIENTATION
+	out->m[0][0] = (cp * cy) * scale;
+	out->m[1][0] = (sr * sp * cy + cr * -sy) * scale;
+	out->m[2][0] = (cr * sp * cy + -sr * -sy) * scale;
+	out->m[3][0] = origin[0];
+	out->m[0][1] = (cp * sy) * scale;
+	out->m[1][1] = (sr * sp * sy + cr * cy) * scale;
+	out->m[2][1] = (cr * sp * sy + -sr * cy) * scale;
+	out->m[3][1] = origin[1];
+	out->m[0][2] = (-sp) * scale;
+	out->m[1][2] = (sr * cp) * scale;
+	out->m[2][2] = (cr * cp) * scale;
+	out->m[3][2] = origin[2];
+	out->m[0][3] = 0.0f;
+	out->m[1][3] = 0.0f;
+	out->m[2][3] = 0.0f;
+	out->m[3][3] = 1.0f;
+#else
+	out->m[0][0] = (cp * cy) * scale;
+	out->m[0][1] = (sr * sp * cy + cr * -sy) * scale;
+	out->m[0][2] = (cr * sp * cy + -sr * -sy) * scale;
+	out->m[0][3] = origin[0];
+	out->m[1][0] = (cp * sy) * scale;
+	out->m[1][1] = (sr * sp * sy + cr * cy) * scale;
+	out->m[1][2] = (cr * sp * sy + -sr * cy) * scale;
+	out->m[1][3] = origin[1];
+	out->m[2][0] = (-sp) * scale;
+	out->m[2][1] = (sr * cp) * scale;
+	out->m[2][2] = (cr * cp) * scale;
+	out->m[2][3] = origin[2];
+	out->m[3][0] = 0.0f;
+	out->m[3][1] = 0.0f;
+	out->m[3][2] = 0.0f;
+	out->m[3][3] = 1.0f;
+#endif
+}
+
+void Matrix4x4_Concatf(matrix4x4_t *out, const matrix4x4_t *in1, const matrix4x4_t *in2) {
+	// each row of the output is a combination of the rows of b, weighted by
+	// the corresponding row of a, summed in the same order as Matrix4x4_Concat
+#if MATRIX4x4_OPENGLORIENTATION
+	const matrix4x4_t *a = in2, *b = in1;
+#else
+	const matrix4x4_t *a = in1, *b = in2;
+#endif
+
+#if MATRIX4x4_SSE
+	const __m128 b0 = _mm_loadu_ps(b->m[0]);
+	const __m128 b1 = _mm_loadu_ps(b->m[1]);
+	const __m128 b2 = _mm_loadu_ps(b->m[2]);
+	const __m128 b3 = _mm_loadu_ps(b->m[3]);
+
+	__m128 r[4];
+	for (int32_t i = 0; i < 4; i++) {
+		const __m128 ai = _mm_loadu_ps(a->m[i]);
+
+		r[i] = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+		                      _mm_mul_ps(_mm_shuffle_ps(ai, ai, _MM_SHUFFLE(0, 0, 0, 0)), b0),
+		                      _mm_mul_ps(_mm_shuffle_ps(ai, ai, _MM_SHUFFLE(1, 1, 1, 1)), b1)),
+		                      _mm_mul_ps(_mm_shuffle_ps(ai, ai, _MM_SHUFFLE(2, 2, 2, 2)), b2)),
+		                  _mm_mul_ps(_mm_shuffle_ps(ai, ai, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+	}
+
+	for (int32_t i = 0; i < 4; i++) {
+		_mm_storeu_ps(out->m[i], r[i]);
+	}
+#elif MATRIX4x4_NEON
+	const float32x4_t b0 = vld1q_f32(b->m[0]);
+	const float32x4_t b1 = vld1q_f32(b->m[1]);
+	const float32x4_t b2 = vld1q_f32(b->m[2]);
+	const float32x4_t b3 = vld1q_f32(b->m[3]);
+
+	float32x4_t r[4];
+	for (int32_t i = 0; i < 4; i++) {
+		r[i] = vaddq_f32(vaddq_f32(vaddq_f32(
+		                     vmulq_n_f32(b0, a->m[i][0]),
+		                     vmulq_n_f32(b1, a->m[i][1])),
+		                     vmulq_n_f32(b2, a->m[i][2])),
+		                 vmulq_n_f32(b3, a->m[i][3]));
+	}
+
+	for (int32_t i = 0; i < 4; i++) {
+		vst1q_f32(out->m[i], r[i]);
+	}
+#else
+	matrix4x4_t r;
+	for (int32_t i = 0; i < 4; i++) {
+		for (int32_t j = 0; j < 4; j++) {
+			r.m[i][j] = a->m[i][0] * b->m[0][j] + a->m[i][1] * b->m[1][j] + a->m[i][2] * b->m[2][j] + a->m[i][3] * b->m[3][j];
+		}
+	}
+	*out = r;
+#endif
+}
+
+void Matrix4x4_Invert_Simplef(matrix4x4_t *out, const matrix4x4_t *in1) {
+	// see Matrix4x4_Invert_Simple
+	const vec_t scale = 1.0f / (in1->m[0][0] * in1->m[0][0] + in1->m[0][1] * in1->m[0][1] + in1->m[0][2] * in1->m[0][2]);
+
+#if MATRIX4x4_SSE && MATRIX4x4_OPENGLORIENTATION
+	__m128 r0 = _mm_loadu_ps(in1->m[0]);
+	__m128 r1 = _mm_loadu_ps(in1->m[1]);
+	__m128 r2 = _mm_loadu_ps(in1->m[2]);
+	__m128 r3 = _mm_loadu_ps(in1->m[3]);
+
+	const __m128 t0 = _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(0, 0, 0, 0));
+	const __m128 t1 = _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(1, 1, 1, 1));
+	const __m128 t2 = _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(2, 2, 2, 2));
+
+	// transpose the rotation, clearing the fourth column
+	r3 = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+	const __m128 s = _mm_set1_ps(scale);
+	r0 = _mm_mul_ps(r0, s);
+	r1 = _mm_mul_ps(r1, s);
+	r2 = _mm_mul_ps(r2, s);
+
+	// invert the translate, and set the fourth column to 1
+	r3 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(t0, r0), _mm_mul_ps(t1, r1)), _mm_mul_ps(t2, r2));
+	r3 = _mm_xor_ps(r3, _mm_set1_ps(-0.0f));
+	r3 = _mm_or_ps(_mm_and_ps(r3, _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1))), _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f));
+
+	_mm_storeu_ps(out->m[0], r0);
+	_mm_storeu_ps(out->m[1], r1);
+	_mm_storeu_ps(out->m[2], r2);
+	_mm_storeu_ps(out->m[3], r3);
+#else
+	matrix4x4_t r;
+
+	r.m[0][0] = in1->m[0][0] * scale;
+	r.m[0][1] = in1->m[1][0] * scale;
+	r.m[0][2] = in1->m[2][0] * scale;
+	r.m[1][0] = in1->m[0][1] * scale;
+	r.m[1][1] = in1->m[1][1] * scale;
+	r.m[1][2] = in1->m[2][1] * scale;
+	r.m[2][0] = in1->m[0][2] * scale;
+	r.m[2][1] = in1->m[1][2] * scale;
+	r.m[2][2] = in1->m[2][2] * scale;
+
+#if MATRIX4x4_OPENGLORIENTATION
+	r.m[3][0] = -(in1->m[3][0] * r.m[0][0] + in1->m[3][1] * r.m[1][0] + in1->m[3][2] * r.m[2][0]);
+	r.m[3][1] = -(in1->m[3][0] * r.m[0][1] + in1->m[3][1] * r.m[1][1] + in1->m[3][2] * r.m[2][1]);
+	r.m[3][2] = -(in1->m[3][0] * r.m[0][2] + in1->m[3][1] * r.m[1][2] + in1->m[3][2] * r.m[2][2]);
+
+	r.m[0][3] = 0.0f;
+	r.m[1][3] = 0.0f;
+	r.m[2][3] = 0.0f;
+	r.m[3][3] = 1.0f;
+#else
+	r.m[0][3] = -(in1->m[0][3] * r.m[0][0] + in1->m[1][3] * r.m[0][1] + in1->m[2][3] * r.m[0][2]);
+	r.m[1][3] = -(in1->m[0][3] * r.m[1][0] + in1->m[1][3] * r.m[1][1] + in1->m[2][3] * r.m[1][2]);
+	r.m[2][3] = -(in1->m[0][3] * r.m[2][0] + in1->m[1][3] * r.m[2][1] + in1->m[2][3] * r.m[2][2]);
+
+	r.m[3][0] = 0.0f;
+	r.m[3][1] = 0.0f;
+	r.m[3][2] = 0.0f;
+	r.m[3][3] = 1.0f;
+#endif
+
+	*out = r;
+#endif
+}
+
+void Matrix4x4_Transformf(const matrix4x4_t *in, const vec3_t v, vec3_t out) {
+#if MATRIX4x4_SSE && MATRIX4x4_OPENGLORIENTATION
+	const __m128 r = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+	                                _mm_mul_ps(_mm_set1_ps(v[0]), _mm_loadu_ps(in->m[0])),
+	                                _mm_mul_ps(_mm_set1_ps(v[1]), _mm_loadu_ps(in->m[1]))),
+	                                _mm_mul_ps(_mm_set1_ps(v[2]), _mm_loadu_ps(in->m[2]))),
+	                            _mm_loadu_ps(in->m[3]));
+
+	_mm_storel_pi((__m64 *) out, r);
+	_mm_store_ss(out + 2, _mm_movehl_ps(r, r));
+#elif MATRIX4x4_NEON && MATRIX4x4_OPENGLORIENTATION
+	const float32x4_t r = vaddq_f32(vaddq_f32(vaddq_f32(
+	                                    vmulq_n_f32(vld1q_f32(in->m[0]), v[0]),
+	                                    vmulq_n_f32(vld1q_f32(in->m[1]), v[1])),
+	                                    vmulq_n_f32(vld1q_f32(in->m[2]), v[2])),
+	                                vld1q_f32(in->m[3]));
+
+	vst1_f32(out, vget_low_f32(r));
+	vst1q_lane_f32(out + 2, r, 2);
+#else
+	Matrix4x4_Transform(in, v, out);
+#endif
+}
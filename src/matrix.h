@@ -200,3 +200,18 @@ void Matrix4x4_FromFrustum (matrix4x4_t *out, double left, double right, double
 // generate an orthogonal projection matrix from bounds
 void Matrix4x4_FromOrtho (matrix4x4_t *out, double left, double right, double bottom, double top, double nearval,
                           double farval);
+
+// single precision fast paths, for callers that rebuild matrices every frame
+// (these avoid the double precision intermediates of their counterparts above,
+// and use SSE or NEON where available; they are also safe to call from any thread,
+// as they do not use static temporaries when the output is also an input)
+
+// creates a matrix for a quake entity
+void Matrix4x4_CreateFromEntityf(matrix4x4_t *out, const vec3_t origin, const vec3_t angles, vec_t scale);
+// multiply two matrix4x4 together, combining their transformations
+void Matrix4x4_Concatf(matrix4x4_t *out, const matrix4x4_t *in1, const matrix4x4_t *in2);
+// creates a matrix that does the opposite of the matrix provided
+// only supports translate, rotate, scale (not scale3) matrices
+void Matrix4x4_Invert_Simplef(matrix4x4_t *out, const matrix4x4_t *in1);
+// transforms a 3D vector through a matrix4x4
+void Matrix4x4_Transformf(const matrix4x4_t *in, const vec3_t v, vec3_t out);
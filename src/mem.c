@@ -20,6 +20,7 @@
  */
 
 #include <signal.h>
+#include <SDL_atomic.h>
 #include <SDL_thread.h>
 
 #include "mem.h"
@@ -35,11 +36,17 @@
 #define MEM_MAGIC 0x69696969
 typedef uint32_t mem_magic_t;
 
+struct mem_region_chunk_s;
+struct mem_heap_s;
+
 typedef struct mem_block_s {
 	mem_magic_t magic;
 	mem_tag_t tag; // for group free
+	struct mem_heap_s *heap; // the heap of our root block
 	struct mem_block_s *parent;
-	GSList *children;
+	struct mem_block_s *children; // the first child
+	struct mem_block_s *prev, *next; // siblings in our parent or our tag's list
+	struct mem_region_chunk_s *chunk; // the region chunk, if region allocated
 	size_t size;
 #if defined(SUPER_MEMORY_CHECKS)
 	void *stack[MAX_MEMORY_STACK];
@@ -50,14 +57,127 @@ typedef struct {
 	mem_magic_t magic;
 } mem_footer_t;
 
+/**
+ * @brief Each tag keeps its own list of root blocks, so that Mem_FreeTag need
+ * only visit the blocks it actually releases.
+ */
 typedef struct {
-	GHashTable *blocks;
-	size_t size;
+	mem_tag_t tag;
+	mem_block_t *blocks;
+} mem_tag_state_t;
+
+/**
+ * @brief Heaps hold the block lists and size accounting for the threads they
+ * are assigned to, so that allocating threads contend only with the few that
+ * share their heap. Every block belongs to the heap of its root block, and is
+ * guarded by that heap's lock. Region blocks share a single heap, whose lock
+ * also guards the region chunks.
+ */
+#define MEM_HEAPS 64
+
+typedef struct mem_heap_s {
 	SDL_mutex *lock;
+	GHashTable *tags;
+	size_t size;
+} mem_heap_t;
+
+/**
+ * @brief Regions serve level-lifetime tags from contiguous chunks. Allocation
+ * is a pointer bump, individual frees only release oversized blocks, and
+ * Mem_FreeTag releases the whole region by freeing its chunks.
+ */
+#define MEM_REGION_CHUNK_SIZE 0x100000
+#define MEM_REGION_DEDICATED_SIZE (MEM_REGION_CHUNK_SIZE / 4)
+#define MAX_MEM_REGIONS 8
+
+typedef struct {
+	mem_tag_t tag;
+	struct mem_region_chunk_s *chunks; // the head chunk is the one we bump from
+	size_t size; // user bytes in live region blocks
+	_Bool linked; // foreign blocks have been linked to region blocks
+} mem_region_t;
+
+typedef struct mem_region_chunk_s {
+	mem_region_t *region;
+	struct mem_region_chunk_s *prev, *next;
+	size_t size;
+	size_t used;
+	_Bool dedicated; // holds a single oversized block
+} mem_region_chunk_t;
+
+typedef struct {
+	SDL_mutex *lock; // serializes operations spanning heaps
+
+	mem_heap_t heaps[MEM_HEAPS + 1]; // the last heap holds the region blocks
+	SDL_atomic_t next_heap;
+
+	mem_region_t regions[MAX_MEM_REGIONS];
+	size_t num_regions;
 } mem_state_t;
 
 static mem_state_t mem_state;
 
+/**
+ * @brief Small blocks are served from size-classed arenas rather than calloc.
+ * Each thread keeps its own free list per size class, and refills or drains
+ * it in batches from a shared pool, so that the common allocation path never
+ * touches a contended lock. Blocks larger than MEM_ARENA_MAX_SIZE go through
+ * the system allocator.
+ */
+#define MEM_ARENA_GRANULARITY 16
+#define MEM_ARENA_MAX_SIZE 2048
+#define MEM_ARENA_CLASSES (MEM_ARENA_MAX_SIZE / MEM_ARENA_GRANULARITY)
+#define MEM_ARENA_BATCH 32
+#define MEM_ARENA_SLAB_SIZE 0x10000
+
+/**
+ * @brief Free arena blocks are chained through their first bytes.
+ */
+typedef struct mem_arena_free_s {
+	struct mem_arena_free_s *next;
+} mem_arena_free_t;
+
+/**
+ * @brief Slabs are carved into blocks of a single size class.
+ */
+typedef struct mem_arena_slab_s {
+	struct mem_arena_slab_s *next;
+} mem_arena_slab_t;
+
+/**
+ * @brief The shared pool for a size class, from which threads refill in batch.
+ */
+typedef struct {
+	SDL_SpinLock lock;
+	mem_arena_free_t *free;
+	mem_arena_slab_t *slabs;
+} mem_arena_pool_t;
+
+static mem_arena_pool_t mem_arena_pools[MEM_ARENA_CLASSES];
+
+/**
+ * @brief A thread's private free list for a size class.
+ */
+typedef struct {
+	mem_arena_free_t *free;
+	uint32_t count;
+} mem_arena_list_t;
+
+/**
+ * @brief The thread-local arena cache, and the heap the thread is assigned to.
+ * The generation is compared against mem_arena_generation so that stale caches
+ * are discarded across Mem_Shutdown.
+ */
+typedef struct {
+	int32_t generation;
+	mem_arena_list_t lists[MEM_ARENA_CLASSES];
+	mem_heap_t *heap;
+} mem_arena_cache_t;
+
+static __thread mem_arena_cache_t mem_arena_cache;
+
+static SDL_atomic_t mem_arena_generation;
+
 #if defined(SUPER_MEMORY_CHECKS)
 /**
  * @brief
@@ -94,6 +214,447 @@ static void Mem_Print(const mem_block_t *block, const char *why) {
 }
 #endif
 
+/**
+ * @brief Returns the total size of a memory block.
+ */
+static size_t Mem_BlockSize(const size_t size) {
+	return size + sizeof(mem_block_t) + sizeof(mem_footer_t);
+}
+
+/**
+ * @return The size class index for the given block size, or -1 if the block
+ * should be allocated by the system allocator.
+ */
+static int32_t Mem_ArenaClass(const size_t block_size) {
+
+	if (block_size > MEM_ARENA_MAX_SIZE) {
+		return -1;
+	}
+
+	return (int32_t) ((block_size + MEM_ARENA_GRANULARITY - 1) / MEM_ARENA_GRANULARITY) - 1;
+}
+
+/**
+ * @return The calling thread's arena cache, reset if it predates Mem_Init.
+ */
+static mem_arena_cache_t *Mem_ArenaCache(void) {
+
+	const int32_t generation = SDL_AtomicGet(&mem_arena_generation);
+
+	if (mem_arena_cache.generation != generation) {
+		memset(&mem_arena_cache, 0, sizeof(mem_arena_cache));
+		mem_arena_cache.generation = generation;
+	}
+
+	return &mem_arena_cache;
+}
+
+/**
+ * @brief Refills the thread's free list for the given class with a batch of
+ * blocks from the shared pool, carving a new slab if the pool is empty.
+ */
+static void Mem_ArenaRefill(mem_arena_list_t *list, const int32_t c) {
+
+	mem_arena_pool_t *pool = &mem_arena_pools[c];
+	const size_t block_size = (c + 1) * MEM_ARENA_GRANULARITY;
+
+	SDL_AtomicLock(&pool->lock);
+
+	if (pool->free == NULL) {
+		mem_arena_slab_t *slab = malloc(MEM_ARENA_SLAB_SIZE);
+		if (slab == NULL) {
+			SDL_AtomicUnlock(&pool->lock);
+			fprintf(stderr, "Failed to allocate %u bytes\n", (uint32_t) MEM_ARENA_SLAB_SIZE);
+			raise(SIGABRT);
+			return;
+		}
+
+		slab->next = pool->slabs;
+		pool->slabs = slab;
+
+		byte *b = ((byte *) slab) + MEM_ARENA_GRANULARITY;
+		const byte *end = ((byte *) slab) + MEM_ARENA_SLAB_SIZE;
+
+		for (; b + block_size <= end; b += block_size) {
+			mem_arena_free_t *f = (mem_arena_free_t *) b;
+			f->next = pool->free;
+			pool->free = f;
+		}
+	}
+
+	while (pool->free && list->count < MEM_ARENA_BATCH) {
+		mem_arena_free_t *f = pool->free;
+		pool->free = f->next;
+
+		f->next = list->free;
+		list->free = f;
+		list->count++;
+	}
+
+	SDL_AtomicUnlock(&pool->lock);
+}
+
+/**
+ * @brief Returns a batch of blocks from the thread's free list to the shared
+ * pool, so that blocks freed by one thread may be reused by others.
+ */
+static void Mem_ArenaDrain(mem_arena_list_t *list, const int32_t c) {
+
+	mem_arena_pool_t *pool = &mem_arena_pools[c];
+
+	SDL_AtomicLock(&pool->lock);
+
+	for (uint32_t i = 0; i < MEM_ARENA_BATCH && list->free; i++) {
+		mem_arena_free_t *f = list->free;
+		list->free = f->next;
+		list->count--;
+
+		f->next = pool->free;
+		pool->free = f;
+	}
+
+	SDL_AtomicUnlock(&pool->lock);
+}
+
+/**
+ * @brief Allocates a zeroed block of the given total size, from the calling
+ * thread's arena when possible.
+ */
+static mem_block_t *Mem_ArenaAlloc(const size_t block_size) {
+
+	const int32_t c = Mem_ArenaClass(block_size);
+	if (c == -1) {
+		return calloc(block_size, 1);
+	}
+
+	mem_arena_list_t *list = &Mem_ArenaCache()->lists[c];
+
+	if (list->free == NULL) {
+		Mem_ArenaRefill(list, c);
+	}
+
+	mem_arena_free_t *f = list->free;
+	if (f) {
+		list->free = f->next;
+		list->count--;
+
+		memset(f, 0, block_size);
+	}
+
+	return (mem_block_t *) f;
+}
+
+/**
+ * @brief Releases a block of the given total size to the calling thread's
+ * arena, or to the system allocator.
+ */
+static void Mem_ArenaFree(mem_block_t *b, const size_t block_size) {
+
+	const int32_t c = Mem_ArenaClass(block_size);
+	if (c == -1) {
+		free(b);
+		return;
+	}
+
+	mem_arena_list_t *list = &Mem_ArenaCache()->lists[c];
+
+	mem_arena_free_t *f = (mem_arena_free_t *) b;
+	f->next = list->free;
+	list->free = f;
+	list->count++;
+
+	if (list->count > MEM_ARENA_BATCH * 2) {
+		Mem_ArenaDrain(list, c);
+	}
+}
+
+/**
+ * @brief Returns the calling thread's cached arena blocks to the shared pools,
+ * so that they are not stranded when the thread exits. Threads which allocate
+ * managed memory should call this on their way out.
+ */
+void Mem_ThreadShutdown(void) {
+
+	mem_arena_cache_t *cache = Mem_ArenaCache();
+
+	for (int32_t c = 0; c < MEM_ARENA_CLASSES; c++) {
+		mem_arena_list_t *list = &cache->lists[c];
+
+		while (list->free) {
+			Mem_ArenaDrain(list, c);
+		}
+	}
+}
+
+/**
+ * @brief Releases all arena slabs back to the system.
+ */
+static void Mem_ArenaShutdown(void) {
+
+	SDL_AtomicAdd(&mem_arena_generation, 1);
+
+	for (int32_t c = 0; c < MEM_ARENA_CLASSES; c++) {
+		mem_arena_pool_t *pool = &mem_arena_pools[c];
+
+		SDL_AtomicLock(&pool->lock);
+
+		mem_arena_slab_t *slab = pool->slabs;
+		while (slab) {
+			mem_arena_slab_t *next = slab->next;
+			free(slab);
+			slab = next;
+		}
+
+		pool->slabs = NULL;
+		pool->free = NULL;
+
+		SDL_AtomicUnlock(&pool->lock);
+	}
+}
+
+/**
+ * @return The heap the calling thread allocates root blocks in. Threads are
+ * assigned heaps round-robin on their first allocation.
+ */
+static mem_heap_t *Mem_Heap(void) {
+
+	mem_arena_cache_t *cache = Mem_ArenaCache();
+
+	if (cache->heap == NULL) {
+		const uint32_t i = (uint32_t) SDL_AtomicAdd(&mem_state.next_heap, 1);
+		cache->heap = &mem_state.heaps[i % MEM_HEAPS];
+	}
+
+	return cache->heap;
+}
+
+/**
+ * @return The heap holding all region blocks.
+ */
+static mem_heap_t *Mem_RegionHeap(void) {
+	return &mem_state.heaps[MEM_HEAPS];
+}
+
+/**
+ * @brief Locks and returns the given heap.
+ */
+static mem_heap_t *Mem_LockHeap(mem_heap_t *heap) {
+
+	SDL_mutexP(heap->lock);
+
+	return heap;
+}
+
+/**
+ * @brief Locks and returns the heap of the given block. Mem_Link may move the
+ * block to another heap while we wait, so the heap is checked once locked.
+ */
+static mem_heap_t *Mem_LockBlockHeap(const mem_block_t *b) {
+
+	while (true) {
+		mem_heap_t *heap = SDL_AtomicGetPtr((void **) &b->heap);
+
+		SDL_mutexP(heap->lock);
+
+		if (heap == SDL_AtomicGetPtr((void **) &b->heap)) {
+			return heap;
+		}
+
+		SDL_mutexV(heap->lock);
+	}
+}
+
+/**
+ * @brief Region chunks are followed by their data, aligned like arena blocks.
+ */
+#define MEM_REGION_CHUNK_HEADER \
+	((sizeof(mem_region_chunk_t) + MEM_ARENA_GRANULARITY - 1) & ~(MEM_ARENA_GRANULARITY - 1))
+
+/**
+ * @return The region serving the given tag, or NULL if the tag is not region
+ * allocated. Regions are established in Mem_Init and immutable thereafter, so
+ * this is safe to call without holding the memory lock.
+ */
+static mem_region_t *Mem_Region(const mem_tag_t tag) {
+
+	for (size_t i = 0; i < mem_state.num_regions; i++) {
+		if (mem_state.regions[i].tag == tag) {
+			return &mem_state.regions[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Allocates a zeroed block of the given total size by bumping the
+ * region's head chunk. Oversized blocks receive a dedicated chunk, so that
+ * they may be released individually. The region heap must be locked.
+ */
+static mem_block_t *Mem_RegionAlloc(mem_region_t *region, size_t block_size) {
+
+	block_size = (block_size + MEM_ARENA_GRANULARITY - 1) & ~(MEM_ARENA_GRANULARITY - 1);
+
+	const _Bool dedicated = block_size > MEM_REGION_DEDICATED_SIZE;
+
+	mem_region_chunk_t *chunk = region->chunks;
+
+	if (dedicated || chunk == NULL || chunk->size - chunk->used < block_size) {
+		const size_t size = dedicated ? block_size : MEM_REGION_CHUNK_SIZE;
+
+		if (!(chunk = malloc(MEM_REGION_CHUNK_HEADER + size))) {
+			return NULL;
+		}
+
+		chunk->region = region;
+		chunk->size = size;
+		chunk->used = 0;
+		chunk->dedicated = dedicated;
+
+		// dedicated chunks go behind the head, which remains the one we bump from
+		if (dedicated && region->chunks) {
+			chunk->prev = region->chunks;
+			chunk->next = region->chunks->next;
+			region->chunks->next = chunk;
+		} else {
+			chunk->prev = NULL;
+			chunk->next = region->chunks;
+			region->chunks = chunk;
+		}
+
+		if (chunk->next) {
+			chunk->next->prev = chunk;
+		}
+	}
+
+	mem_block_t *b = (mem_block_t *) (((byte *) chunk) + MEM_REGION_CHUNK_HEADER + chunk->used);
+	chunk->used += block_size;
+
+	memset(b, 0, block_size);
+	b->chunk = chunk;
+
+	return b;
+}
+
+/**
+ * @brief Releases the given region chunk. The region heap must be locked.
+ */
+static void Mem_RegionFreeChunk(mem_region_chunk_t *chunk) {
+
+	if (chunk->prev) {
+		chunk->prev->next = chunk->next;
+	} else {
+		chunk->region->chunks = chunk->next;
+	}
+
+	if (chunk->next) {
+		chunk->next->prev = chunk->prev;
+	}
+
+	free(chunk);
+}
+
+/**
+ * @brief Allocates a zeroed block of the given total size, from the region if
+ * one is specified, or from the calling thread's arena.
+ */
+static mem_block_t *Mem_AllocBlock(mem_region_t *region, const size_t block_size) {
+
+	if (region) {
+		return Mem_RegionAlloc(region, block_size);
+	}
+
+	return Mem_ArenaAlloc(block_size);
+}
+
+/**
+ * @brief Releases the memory backing the given block. Blocks bumped from a
+ * region chunk are reclaimed only when their tag is freed. The region heap
+ * must be locked for region blocks.
+ */
+static void Mem_FreeBlock(mem_block_t *b) {
+
+	mem_region_chunk_t *chunk = b->chunk;
+
+	if (chunk) {
+		chunk->region->size -= b->size;
+
+		if (chunk->dedicated) {
+			Mem_RegionFreeChunk(chunk);
+		}
+	} else {
+		Mem_ArenaFree(b, Mem_BlockSize(b->size));
+	}
+}
+
+/**
+ * @return The heap's state for the given tag, created if necessary. The heap
+ * must be locked.
+ */
+static mem_tag_state_t *Mem_TagState(mem_heap_t *heap, const mem_tag_t tag) {
+
+	mem_tag_state_t *state = g_hash_table_lookup(heap->tags, GINT_TO_POINTER(tag));
+	if (state == NULL) {
+		state = g_new0(mem_tag_state_t, 1);
+		state->tag = tag;
+
+		g_hash_table_insert(heap->tags, GINT_TO_POINTER(tag), state);
+	}
+
+	return state;
+}
+
+/**
+ * @return The head of the sibling list the given block belongs to: its
+ * parent's children, or its tag's root blocks. The block's heap must be
+ * locked.
+ */
+static mem_block_t **Mem_Siblings(const mem_block_t *b) {
+
+	if (b->parent) {
+		return &b->parent->children;
+	}
+
+	return &Mem_TagState(b->heap, b->tag)->blocks;
+}
+
+/**
+ * @brief Inserts the given block into its parent's children, or into its
+ * tag's list if it has no parent. The block's heap must be locked.
+ */
+static void Mem_InsertBlock(mem_block_t *b) {
+
+	mem_block_t **head = Mem_Siblings(b);
+
+	b->prev = NULL;
+	b->next = *head;
+
+	if (b->next) {
+		b->next->prev = b;
+	}
+
+	*head = b;
+}
+
+/**
+ * @brief Removes the given block from its sibling list in constant time. The
+ * block's heap must be locked.
+ */
+static void Mem_RemoveBlock(mem_block_t *b) {
+
+	if (b->prev) {
+		b->prev->next = b->next;
+	} else {
+		*Mem_Siblings(b) = b->next;
+	}
+
+	if (b->next) {
+		b->next->prev = b->prev;
+	}
+
+	b->prev = b->next = NULL;
+}
+
 /**
  * @brief Throws a fatal error if the specified memory block is non-NULL but
  * not owned by the memory subsystem.
@@ -137,14 +698,17 @@ static void Mem_Free_(mem_block_t *b) {
 #endif
 
 	// recurse down the tree, freeing children
-	if (b->children) {
-		g_slist_free_full(b->children, (GDestroyNotify) Mem_Free_);
+	mem_block_t *child = b->children;
+	while (child) {
+		mem_block_t *next = child->next;
+		Mem_Free_(child);
+		child = next;
 	}
 
-	// decrement the pool size and free the memory
-	mem_state.size -= b->size;
+	// decrement the heap size and free the memory
+	b->heap->size -= b->size;
 
-	free(b);
+	Mem_FreeBlock(b);
 }
 
 /**
@@ -155,48 +719,103 @@ void Mem_Free(void *p) {
 	if (p) {
 		mem_block_t *b = Mem_CheckMagic(p);
 
-		SDL_mutexP(mem_state.lock);
+		mem_heap_t *heap = Mem_LockBlockHeap(b);
 
-		if (b->parent) {
-			b->parent->children = g_slist_remove(b->parent->children, b);
-		} else {
-			g_hash_table_remove(mem_state.blocks, (gconstpointer) b);
-		}
+		Mem_RemoveBlock(b);
 
 		Mem_Free_(b);
 
-		SDL_mutexV(mem_state.lock);
+		SDL_mutexV(heap->lock);
 	}
 }
 
 /**
- * @brief Free all managed items allocated with the specified tag.
+ * @brief Frees any foreign blocks linked beneath the given region block.
  */
-void Mem_FreeTag(mem_tag_t tag) {
-	GHashTableIter it;
-	gpointer key, value;
+static void Mem_FreeRegionChildren(const mem_region_t *region, mem_block_t *b) {
 
-	SDL_mutexP(mem_state.lock);
+	mem_block_t *child = b->children;
+	while (child) {
+		mem_block_t *next = child->next;
 
-	g_hash_table_iter_init(&it, mem_state.blocks);
+		if (child->chunk && child->chunk->region == region) {
+			Mem_FreeRegionChildren(region, child);
+		} else {
+			Mem_Free_(child);
+		}
 
-	while (g_hash_table_iter_next(&it, &key, &value)) {
-		mem_block_t *b = (mem_block_t *) key;
+		child = next;
+	}
 
-		if (tag == MEM_TAG_ALL || b->tag == tag) {
-			g_hash_table_iter_remove(&it);
+	b->children = NULL;
+}
+
+/**
+ * @brief Frees all blocks in the given tag of the given heap. Region tags
+ * simply release their chunks, visiting their blocks only if foreign blocks
+ * were linked to them. The heap must be locked.
+ */
+static void Mem_FreeTag_(mem_heap_t *heap, mem_tag_state_t *state) {
+
+	mem_region_t *region = Mem_Region(state->tag);
+	if (region) {
+
+		if (region->linked) {
+			for (mem_block_t *b = state->blocks; b; b = b->next) {
+				Mem_FreeRegionChildren(region, b);
+			}
+		}
+
+		while (region->chunks) {
+			Mem_RegionFreeChunk(region->chunks);
+		}
+
+		heap->size -= region->size;
+
+		region->size = 0;
+		region->linked = false;
+	} else {
+		mem_block_t *b = state->blocks;
+		while (b) {
+			mem_block_t *next = b->next;
 			Mem_Free_(b);
+			b = next;
 		}
 	}
 
-	SDL_mutexV(mem_state.lock);
+	state->blocks = NULL;
 }
 
 /**
- * @brief Returns the total size of a memory block.
+ * @brief Free all managed items allocated with the specified tag.
  */
-static size_t Mem_BlockSize(const size_t size) {
-	return size + sizeof(mem_block_t) + sizeof(mem_footer_t);
+void Mem_FreeTag(mem_tag_t tag) {
+
+	SDL_mutexP(mem_state.lock);
+
+	for (size_t i = 0; i < lengthof(mem_state.heaps); i++) {
+		mem_heap_t *heap = Mem_LockHeap(&mem_state.heaps[i]);
+
+		if (tag == MEM_TAG_ALL) {
+			GHashTableIter it;
+			gpointer key, value;
+
+			g_hash_table_iter_init(&it, heap->tags);
+
+			while (g_hash_table_iter_next(&it, &key, &value)) {
+				Mem_FreeTag_(heap, (mem_tag_state_t *) value);
+			}
+		} else {
+			mem_tag_state_t *state = g_hash_table_lookup(heap->tags, GINT_TO_POINTER(tag));
+			if (state) {
+				Mem_FreeTag_(heap, state);
+			}
+		}
+
+		SDL_mutexV(heap->lock);
+	}
+
+	SDL_mutexV(mem_state.lock);
 }
 
 /**
@@ -216,7 +835,23 @@ static void *Mem_Malloc_(size_t size, mem_tag_t tag, void *parent) {
 	// allocate the block plus the desired size
 	const size_t s = Mem_BlockSize(size);
 
-	if (!(b = calloc(s, 1))) {
+	// children of region blocks share their parent's region
+	mem_region_t *region = p ? (p->chunk ? p->chunk->region : NULL) : Mem_Region(tag);
+
+	// children share their parent's heap, and root blocks use the thread's heap
+	mem_heap_t *heap;
+
+	// region allocations require the region heap lock, arena allocations do not
+	if (region) {
+		heap = p ? Mem_LockBlockHeap(p) : Mem_LockHeap(Mem_RegionHeap());
+		b = Mem_RegionAlloc(region, s);
+	} else {
+		b = Mem_ArenaAlloc(s);
+		heap = p ? Mem_LockBlockHeap(p) : Mem_LockHeap(Mem_Heap());
+	}
+
+	if (!b) {
+		SDL_mutexV(heap->lock);
 		fprintf(stderr, "Failed to allocate %u bytes\n", (uint32_t) s);
 		raise(SIGABRT);
 		return NULL;
@@ -224,6 +859,7 @@ static void *Mem_Malloc_(size_t size, mem_tag_t tag, void *parent) {
 
 	b->magic = MEM_MAGIC;
 	b->tag = tag;
+	b->heap = heap;
 	b->parent = p;
 	b->size = size;
 
@@ -233,21 +869,19 @@ static void *Mem_Malloc_(size_t size, mem_tag_t tag, void *parent) {
 	footer->magic = (mem_magic_t) (MEM_MAGIC + b->size);
 
 	// insert it into the managed memory structures
-	SDL_mutexP(mem_state.lock);
+	Mem_InsertBlock(b);
 
-	if (b->parent) {
-		b->parent->children = g_slist_prepend(b->parent->children, b);
-	} else {
-		g_hash_table_add(mem_state.blocks, b);
+	heap->size += size;
+
+	if (region) {
+		region->size += size;
 	}
 
-	mem_state.size += size;
-	
 #if defined(SUPER_MEMORY_CHECKS)
 	Mem_SetStack(b);
 #endif
 
-	SDL_mutexV(mem_state.lock);
+	SDL_mutexV(heap->lock);
 
 	// return the address in front of the block
 	return data;
@@ -313,13 +947,37 @@ void *Mem_Realloc(void *p, size_t size) {
 	const size_t old_size = b->size;
 	const size_t s = Mem_BlockSize(size);
 
-	b->size = size;
-
 #if defined(SUPER_MEMORY_PRINTS)
 	Mem_Print(b, "Reallocating");
 #endif
 
-	if (!(new_b = realloc(b, s))) {
+	mem_heap_t *heap = Mem_LockBlockHeap(b);
+
+	mem_region_t *region = b->chunk ? b->chunk->region : NULL;
+
+	// large blocks are resized by the system allocator, while arena and region
+	// blocks must be copied to a new block matching their new size
+	const _Bool copy = region || Mem_ArenaClass(Mem_BlockSize(old_size)) != -1 || Mem_ArenaClass(s) != -1;
+
+	if (!copy) {
+		b->size = size;
+
+		new_b = realloc(b, s);
+	} else {
+		new_b = Mem_AllocBlock(region, s);
+
+		if (new_b) {
+			mem_region_chunk_t *chunk = new_b->chunk;
+
+			memcpy(new_b, b, sizeof(mem_block_t) + MIN(old_size, size));
+
+			new_b->chunk = chunk;
+			new_b->size = size;
+		}
+	}
+
+	if (!new_b) {
+		SDL_mutexV(heap->lock);
 		fprintf(stderr, "Failed to re-allocate %u bytes\n", (uint32_t) s);
 		raise(SIGABRT);
 		return NULL;
@@ -330,28 +988,33 @@ void *Mem_Realloc(void *p, size_t size) {
 	mem_footer_t *footer = (mem_footer_t *) (((byte *) data) + size);
 	footer->magic = (mem_magic_t) (MEM_MAGIC + new_b->size);
 
-	SDL_mutexP(mem_state.lock);
-
-	// re-seat us in our parent or in global hash list
-	if (new_b->parent) {
-		new_b->parent->children = g_slist_remove(new_b->parent->children, b);
-		new_b->parent->children = g_slist_prepend(new_b->parent->children, new_b);
+	// re-seat us in our parent or in our tag's list
+	if (new_b->prev) {
+		new_b->prev->next = new_b;
 	} else {
-		g_hash_table_remove(mem_state.blocks, b);
-		g_hash_table_add(mem_state.blocks, new_b);
+		*Mem_Siblings(new_b) = new_b;
+	}
+
+	if (new_b->next) {
+		new_b->next->prev = new_b;
 	}
 
 	// change our childrens' parent pointers
-	if (new_b->children) {
-		for (GSList *children = new_b->children; children; children = children->next) {
-			mem_block_t *child = (mem_block_t *) children->data;
-			child->parent = new_b;
+	for (mem_block_t *child = new_b->children; child; child = child->next) {
+		child->parent = new_b;
+	}
+
+	heap->size -= old_size;
+	heap->size += size;
+
+	if (copy) {
+		if (region) {
+			region->size += size;
 		}
+
+		Mem_FreeBlock(b);
 	}
 
-	mem_state.size -= old_size;
-	mem_state.size += size;
-	
 #if defined(SUPER_MEMORY_CHECKS)
 	Mem_SetStack(new_b);
 
@@ -360,14 +1023,33 @@ void *Mem_Realloc(void *p, size_t size) {
 #endif
 #endif
 
-	SDL_mutexV(mem_state.lock);
+	SDL_mutexV(heap->lock);
 
 	return data;
 }
 
+/**
+ * @brief Moves the given block and its descendants to the specified heap.
+ *
+ * @return The size of the moved blocks.
+ */
+static size_t Mem_SetHeap(mem_block_t *b, mem_heap_t *heap) {
+
+	size_t size = b->size;
+
+	SDL_AtomicSetPtr((void **) &b->heap, heap);
+
+	for (mem_block_t *child = b->children; child; child = child->next) {
+		size += Mem_SetHeap(child, heap);
+	}
+
+	return size;
+}
+
 /**
  * @brief Links the specified child to the given parent. The child will
- * subsequently be freed with the parent.
+ * subsequently be freed with the parent. Blocks allocated from a region may
+ * only be linked to parents within that same region.
  *
  * @param child The child object, previously allocated with Mem_Malloc.
  * @param parent The parent object, previously allocated with Mem_Malloc.
@@ -378,16 +1060,37 @@ void *Mem_Link(void *child, void *parent) {
 	mem_block_t *c = Mem_CheckMagic(child);
 	mem_block_t *p = Mem_CheckMagic(parent);
 
+	if (c->chunk && (p->chunk == NULL || p->chunk->region != c->chunk->region)) {
+		fprintf(stderr, "Invalid link of region block %p to %p\n", child, parent);
+		raise(SIGABRT);
+	}
+
+	// only Mem_Link holds two heaps at once, and it holds the memory lock
 	SDL_mutexP(mem_state.lock);
 
-	if (c->parent) {
-		c->parent->children = g_slist_remove(c->parent->children, c);
-	} else {
-		g_hash_table_remove(mem_state.blocks, c);
-	}
+	mem_heap_t *from = Mem_LockBlockHeap(c);
+	mem_heap_t *to = Mem_LockBlockHeap(p);
+
+	Mem_RemoveBlock(c);
 
 	c->parent = p;
-	p->children = g_slist_prepend(p->children, c);
+
+	// the child and its descendants move to the parent's heap
+	if (from != to) {
+		const size_t size = Mem_SetHeap(c, to);
+
+		from->size -= size;
+		to->size += size;
+	}
+
+	Mem_InsertBlock(c);
+
+	if (p->chunk && c->chunk == NULL) {
+		p->chunk->region->linked = true;
+	}
+
+	SDL_mutexV(to->lock);
+	SDL_mutexV(from->lock);
 
 	SDL_mutexV(mem_state.lock);
 
@@ -398,7 +1101,21 @@ void *Mem_Link(void *child, void *parent) {
  * @return The current size (user bytes) of the zone allocation pool.
  */
 size_t Mem_Size(void) {
-	return mem_state.size;
+	size_t size = 0;
+
+	SDL_mutexP(mem_state.lock);
+
+	for (size_t i = 0; i < lengthof(mem_state.heaps); i++) {
+		mem_heap_t *heap = Mem_LockHeap(&mem_state.heaps[i]);
+
+		size += heap->size;
+
+		SDL_mutexV(heap->lock);
+	}
+
+	SDL_mutexV(mem_state.lock);
+
+	return size;
 }
 
 /**
@@ -435,8 +1152,8 @@ static size_t Mem_CalculateBlockSize(const mem_block_t *b) {
 
 	size_t size = b->size;
 
-	for (GSList *child = b->children; child; child = child->next) {
-		size += Mem_CalculateBlockSize((const mem_block_t *) child->data);
+	for (const mem_block_t *child = b->children; child; child = child->next) {
+		size += Mem_CalculateBlockSize(child);
 	}
 
 	return size;
@@ -456,36 +1173,47 @@ GArray *Mem_Stats(void) {
 
 	stat_array = g_array_append_vals(stat_array, &(const mem_stat_t) {
 		.tag = -1,
-		 .size = mem_state.size,
+		 .size = 0,
 		  .count = 0
 	}, 1);
 
-	g_hash_table_iter_init(&it, mem_state.blocks);
+	// merge each heap's tags into a single stat per tag
+	for (size_t i = 0; i < lengthof(mem_state.heaps); i++) {
+		mem_heap_t *heap = Mem_LockHeap(&mem_state.heaps[i]);
 
-	while (g_hash_table_iter_next(&it, &key, &value)) {
-		const mem_block_t *b = (const mem_block_t *) key;
-		mem_stat_t *stats = NULL;
+		g_array_index(stat_array, mem_stat_t, 0).size += heap->size;
 
-		for (size_t i = 0; i < stat_array->len; i++) {
+		g_hash_table_iter_init(&it, heap->tags);
 
-			mem_stat_t *stat_i = &g_array_index(stat_array, mem_stat_t, i);
+		while (g_hash_table_iter_next(&it, &key, &value)) {
+			const mem_tag_state_t *state = (const mem_tag_state_t *) value;
 
-			if (stat_i->tag == b->tag) {
-				stats = stat_i;
-				break;
+			if (state->blocks == NULL) {
+				continue;
 			}
-		}
 
-		if (stats == NULL) {
-			stat_array = g_array_append_vals(stat_array, &(const mem_stat_t) {
-				.tag = b->tag,
-				 .size = Mem_CalculateBlockSize(b),
-				  .count = 1
-			}, 1);
-		} else {
-			stats->size += Mem_CalculateBlockSize(b);
-			stats->count++;
+			guint j;
+			for (j = 1; j < stat_array->len; j++) {
+				if (g_array_index(stat_array, mem_stat_t, j).tag == state->tag) {
+					break;
+				}
+			}
+
+			if (j == stat_array->len) {
+				stat_array = g_array_append_vals(stat_array, &(const mem_stat_t) {
+					.tag = state->tag
+				}, 1);
+			}
+
+			mem_stat_t *stat = &g_array_index(stat_array, mem_stat_t, j);
+
+			for (const mem_block_t *b = state->blocks; b; b = b->next) {
+				stat->size += Mem_CalculateBlockSize(b);
+				stat->count++;
+			}
 		}
+
+		SDL_mutexV(heap->lock);
 	}
 
 	SDL_mutexV(mem_state.lock);
@@ -495,6 +1223,16 @@ GArray *Mem_Stats(void) {
 	return stat_array;
 }
 
+/**
+ * @brief Establishes a region for the specified tag.
+ */
+static void Mem_InitRegion(mem_tag_t tag) {
+
+	assert(mem_state.num_regions < MAX_MEM_REGIONS);
+
+	mem_state.regions[mem_state.num_regions++].tag = tag;
+}
+
 /**
  * @brief Initializes the managed memory subsystem. This should be one of the first
  * subsystems initialized by Quetoo.
@@ -503,9 +1241,17 @@ void Mem_Init(void) {
 
 	memset(&mem_state, 0, sizeof(mem_state));
 
-	mem_state.blocks = g_hash_table_new(g_direct_hash, g_direct_equal);
-
 	mem_state.lock = SDL_CreateMutex();
+
+	for (size_t i = 0; i < lengthof(mem_state.heaps); i++) {
+		mem_state.heaps[i].lock = SDL_CreateMutex();
+		mem_state.heaps[i].tags = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+	}
+
+	// level-lifetime tags are freed in bulk on every map change
+	Mem_InitRegion(MEM_TAG_GAME_LEVEL);
+	Mem_InitRegion(MEM_TAG_CGAME_LEVEL);
+	Mem_InitRegion(MEM_TAG_CMODEL);
 }
 
 /**
@@ -516,7 +1262,12 @@ void Mem_Shutdown(void) {
 
 	Mem_FreeTag(MEM_TAG_ALL);
 
-	g_hash_table_destroy(mem_state.blocks);
+	for (size_t i = 0; i < lengthof(mem_state.heaps); i++) {
+		g_hash_table_destroy(mem_state.heaps[i].tags);
+		SDL_DestroyMutex(mem_state.heaps[i].lock);
+	}
 
 	SDL_DestroyMutex(mem_state.lock);
+
+	Mem_ArenaShutdown();
 }
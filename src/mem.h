@@ -46,5 +46,6 @@ typedef struct {
 
 GArray *Mem_Stats(void);
 
+void Mem_ThreadShutdown(void);
 void Mem_Init(void);
 void Mem_Shutdown(void);
@@ -37,7 +37,8 @@
 
 #include "net.h"
 
-in_addr_t net_lo;
+struct in6_addr net_lo;
+static struct in6_addr net_broadcast;
 
 int32_t Net_GetError(void) {
 #if defined(_WIN32)
@@ -66,43 +67,110 @@ const char *Net_GetErrorString(void) {
 }
 
 /**
- * @brief Initializes the specified sockaddr_in according to the net_addr_t.
+ * @brief Initializes the specified socket address according to the net_addr_t,
+ * for a socket of the specified address family. Dual-stack IPv6 sockets reach
+ * IPv4 hosts through their v4-mapped addresses, while IPv4 sockets can not
+ * reach IPv6 hosts at all.
+ *
+ * @return The length of the socket address, or 0 if the address can not be
+ * reached from a socket of the specified family.
  */
-void Net_NetAddrToSockaddr(const net_addr_t *a, net_sockaddr *s) {
+socklen_t Net_NetAddrToSockaddr(const net_addr_t *a, int32_t family, net_sockaddr *s) {
 
 	memset(s, 0, sizeof(*s));
-	s->sin_family = AF_INET;
+
+	struct in6_addr addr = a->addr;
 
 	if (a->type == NA_BROADCAST) {
-		*(uint32_t *) &s->sin_addr = -1;
-	} else if (a->type == NA_DATAGRAM) {
-		*(in_addr_t *) &s->sin_addr = a->addr;
+		addr = net_broadcast;
+	}
+
+	if (family == AF_INET6) {
+		struct sockaddr_in6 *s6 = (struct sockaddr_in6 *) s;
+
+		s6->sin6_family = AF_INET6;
+		s6->sin6_addr = addr;
+		s6->sin6_scope_id = a->scope_id;
+		s6->sin6_port = a->port;
+
+		return sizeof(*s6);
+	}
+
+	if (!IN6_IS_ADDR_V4MAPPED(&addr)) {
+		return 0;
 	}
 
-	s->sin_port = a->port;
+	struct sockaddr_in *s4 = (struct sockaddr_in *) s;
+
+	s4->sin_family = AF_INET;
+	memcpy(&s4->sin_addr, &addr.s6_addr[12], sizeof(s4->sin_addr));
+	s4->sin_port = a->port;
+
+	return sizeof(*s4);
 }
 
 /**
- * @return True if the addresses share the same base and port.
+ * @brief Initializes the address and port of the specified net_addr_t from the
+ * IPv4 or IPv6 socket address. IPv4 addresses are stored v4-mapped, so that
+ * a host compares equal regardless of the family of the socket it arrived on.
+ */
+void Net_SockaddrToNetaddr(const net_sockaddr *s, net_addr_t *a) {
+
+	memset(&a->addr, 0, sizeof(a->addr));
+	a->scope_id = 0;
+
+	if (s->ss_family == AF_INET6) {
+		const struct sockaddr_in6 *s6 = (const struct sockaddr_in6 *) s;
+
+		a->addr = s6->sin6_addr;
+		a->scope_id = s6->sin6_scope_id;
+		a->port = s6->sin6_port;
+	} else if (s->ss_family == AF_INET) {
+		const struct sockaddr_in *s4 = (const struct sockaddr_in *) s;
+
+		a->addr.s6_addr[10] = a->addr.s6_addr[11] = 0xff;
+		memcpy(&a->addr.s6_addr[12], &s4->sin_addr, sizeof(s4->sin_addr));
+		a->port = s4->sin_port;
+	} else {
+		a->port = 0;
+	}
+}
+
+/**
+ * @return True if the addresses share the same base, scope and port.
  */
 _Bool Net_CompareNetaddr(const net_addr_t *a, const net_addr_t *b) {
-	return a->addr == b->addr && a->port == b->port;
+	return memcmp(&a->addr, &b->addr, sizeof(a->addr)) == 0 && a->scope_id == b->scope_id && a->port == b->port;
 }
 
 /**
- * @return True if the addresses share the same type and base.
+ * @return True if the addresses share the same type, base and scope.
  */
 _Bool Net_CompareClientNetaddr(const net_addr_t *a, const net_addr_t *b) {
-	return a->type == b->type && a->addr == b->addr;
+	return a->type == b->type && memcmp(&a->addr, &b->addr, sizeof(a->addr)) == 0 && a->scope_id == b->scope_id;
 }
 
 /**
- * @brief
+ * @return The printable form of the address: `a.b.c.d:port` for IPv4 hosts,
+ * `[a:b::c]:port` for IPv6 hosts, and `[fe80::c%scope]:port` for link-local
+ * IPv6 hosts.
  */
 const char *Net_NetaddrToString(const net_addr_t *a) {
-	static char s[64];
+	static char s[80];
+	char addr[INET6_ADDRSTRLEN];
 
-	g_snprintf(s, sizeof(s), "%s:%i", inet_ntoa(*(const struct in_addr *) &a->addr), ntohs(a->port));
+	if (IN6_IS_ADDR_V4MAPPED(&a->addr)) {
+		inet_ntop(AF_INET, (const void *) &a->addr.s6_addr[12], addr, sizeof(addr));
+		g_snprintf(s, sizeof(s), "%s:%i", addr, ntohs(a->port));
+	} else {
+		inet_ntop(AF_INET6, (const void *) &a->addr, addr, sizeof(addr));
+
+		if (a->scope_id) {
+			g_snprintf(s, sizeof(s), "[%s%%%u]:%i", addr, a->scope_id, ntohs(a->port));
+		} else {
+			g_snprintf(s, sizeof(s), "[%s]:%i", addr, ntohs(a->port));
+		}
+	}
 
 	return s;
 }
@@ -115,32 +183,70 @@ const char *Net_NetaddrToString(const net_addr_t *a) {
  * idnewt:28000
  * 192.246.40.70
  * 192.246.40.70:28000
+ * ::1
+ * [::1]:28000
+ * [fe80::1%2]:28000
  */
 _Bool Net_StringToSockaddr(const char *s, net_sockaddr *saddr) {
 
 	memset(saddr, 0, sizeof(*saddr));
 
-	char *node = g_strdup(s);
+	char *node = g_strdup(s), *service = NULL;
 
-	char *service = strchr(node, ':');
-	if (service) {
-		*service++ = '\0';
+	if (*node == '[') { // bracketed IPv6 address, with optional port
+		char *end = strchr(node, ']');
+		if (end) {
+			*end = '\0';
+			if (*(end + 1) == ':') {
+				service = end + 2;
+			}
+		}
+		memmove(node, node + 1, strlen(node));
+	} else if (strchr(node, ':') == strrchr(node, ':')) { // bare IPv6 addresses have no port
+		service = strchr(node, ':');
+		if (service) {
+			*service++ = '\0';
+		}
 	}
 
-	const struct addrinfo hints = {
-		.ai_family = AF_INET,
+	// prefer the address families the host has configured, but allow explicit
+	// addresses such as ::1 on hosts with only loopback IPv6
+	struct addrinfo hints = {
+		.ai_family = AF_UNSPEC,
 		.ai_socktype = SOCK_DGRAM,
+		.ai_flags = AI_ADDRCONFIG,
 	};
 
 	struct addrinfo *info;
-	if (getaddrinfo(node, service, &hints, &info) == 0) {
-		memcpy(saddr, info->ai_addr, sizeof(*saddr));
+	int32_t err = getaddrinfo(node, service, &hints, &info);
+	if (err) {
+		hints.ai_flags = 0;
+		err = getaddrinfo(node, service, &hints, &info);
+	}
+
+	if (err == 0) {
+		// prefer IPv4 results, which every socket can reach, over IPv6 results
+		const struct addrinfo *ai = info;
+		for (const struct addrinfo *i = info; i; i = i->ai_next) {
+			if (i->ai_family == AF_INET) {
+				ai = i;
+				break;
+			}
+		}
+
+		memcpy(saddr, ai->ai_addr, Min(ai->ai_addrlen, sizeof(*saddr)));
 		freeaddrinfo(info);
 	}
 
 	g_free(node);
 
-	return saddr->sin_addr.s_addr != 0;
+	if (saddr->ss_family == AF_INET6) {
+		return !IN6_IS_ADDR_UNSPECIFIED(&((struct sockaddr_in6 *) saddr)->sin6_addr);
+	} else if (saddr->ss_family == AF_INET) {
+		return ((struct sockaddr_in *) saddr)->sin_addr.s_addr != 0;
+	}
+
+	return false;
 }
 
 /**
@@ -153,21 +259,59 @@ _Bool Net_StringToNetaddr(const char *s, net_addr_t *a) {
 		return false;
 	}
 
-	a->addr = saddr.sin_addr.s_addr;
+	Net_SockaddrToNetaddr(&saddr, a);
 
 	if (g_strcmp0(s, "localhost") == 0) {
 		a->port = 0;
 		a->type = NA_LOOP;
 	} else {
-		a->port = saddr.sin_port;
 		a->type = NA_DATAGRAM;
 	}
 
 	return true;
 }
 
+/**
+ * @brief Creates a socket of the specified type, preferring a dual-stack IPv6
+ * socket, which also serves IPv4 hosts through v4-mapped addresses. Hosts
+ * without IPv6 support fall back to IPv4.
+ */
+static int32_t Net_DualStackSocket(int32_t type, int32_t protocol) {
+
+	int32_t sock = socket(PF_INET6, type, protocol);
+	if (sock != -1) {
+		const int32_t v6only = 0;
+
+		if (setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, (const void *) &v6only, sizeof(v6only)) == 0) {
+			return sock;
+		}
+
+		Net_CloseSocket(sock);
+	}
+
+	return socket(PF_INET, type, protocol);
+}
+
+/**
+ * @return The address family, `AF_INET6` or `AF_INET`, of the specified socket.
+ */
+int32_t Net_SocketFamily(int32_t sock) {
+	net_sockaddr addr;
+	socklen_t len = sizeof(addr);
+
+	memset(&addr, 0, sizeof(addr));
+
+	if (getsockname(sock, (struct sockaddr *) &addr, &len) == -1) {
+		Com_Error(ERROR_DROP, "getsockname: %s\n", Net_GetErrorString());
+	}
+
+	return addr.ss_family;
+}
+
 /**
  * @brief Creates and binds a new network socket for the specified protocol.
+ * Datagram and stream sockets are dual-stack where supported, while broadcast
+ * sockets are always IPv4.
  */
 int32_t Net_Socket(net_addr_type_t type, const char *iface, in_port_t port) {
 	int32_t sock, i = 1;
@@ -175,7 +319,13 @@ int32_t Net_Socket(net_addr_type_t type, const char *iface, in_port_t port) {
 	switch (type) {
 		case NA_BROADCAST:
 		case NA_DATAGRAM:
-			if ((sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP)) == -1) {
+			if (type == NA_BROADCAST) { // IPv6 has no broadcast, so this is always IPv4
+				sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+			} else {
+				sock = Net_DualStackSocket(SOCK_DGRAM, IPPROTO_UDP);
+			}
+
+			if (sock == -1) {
 				Com_Error(ERROR_DROP, "socket: %s\n", Net_GetErrorString());
 			}
 
@@ -187,7 +337,7 @@ int32_t Net_Socket(net_addr_type_t type, const char *iface, in_port_t port) {
 			break;
 
 		case NA_STREAM:
-			if ((sock = socket(PF_INET, SOCK_STREAM, 0)) == -1) {
+			if ((sock = Net_DualStackSocket(SOCK_STREAM, 0)) == -1) {
 				Com_Error(ERROR_DROP, "socket: %s\n", Net_GetErrorString());
 			}
 
@@ -200,19 +350,29 @@ int32_t Net_Socket(net_addr_type_t type, const char *iface, in_port_t port) {
 			Com_Error(ERROR_DROP, "Invalid socket type: %d", type);
 	}
 
-	net_sockaddr addr;
+	net_addr_t addr;
 	memset(&addr, 0, sizeof(addr));
 
-	if (iface) {
-		Net_StringToSockaddr(iface, &addr);
-	} else {
-		addr.sin_family = AF_INET;
-		addr.sin_addr.s_addr = INADDR_ANY;
+	addr.type = NA_DATAGRAM;
+
+	const int32_t family = Net_SocketFamily(sock);
+
+	if (iface == NULL || !Net_StringToNetaddr(iface, &addr)) {
+		if (family == AF_INET) {
+			addr.addr.s6_addr[10] = addr.addr.s6_addr[11] = 0xff; // INADDR_ANY, v4-mapped
+		}
 	}
 
-	addr.sin_port = htons(port);
+	addr.port = htons(port);
+
+	net_sockaddr saddr;
+	const socklen_t len = Net_NetAddrToSockaddr(&addr, family, &saddr);
+
+	if (len == 0) {
+		Com_Error(ERROR_DROP, "%s requires IPv6\n", iface);
+	}
 
-	if (bind(sock, (void *) &addr, sizeof(addr)) == -1) {
+	if (bind(sock, (void *) &saddr, len) == -1) {
 		Com_Error(ERROR_DROP, "bind: %s\n", Net_GetErrorString());
 	}
 
@@ -254,7 +414,8 @@ void Net_Init(void) {
 	WSAStartup(v, &d);
 #endif
 
-	net_lo = inet_addr("127.0.0.1");
+	inet_pton(AF_INET6, "::ffff:127.0.0.1", &net_lo);
+	inet_pton(AF_INET6, "::ffff:255.255.255.255", &net_broadcast);
 }
 
 /**
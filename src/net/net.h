@@ -23,7 +23,7 @@
 
 #include "net_types.h"
 
-extern in_addr_t net_lo;
+extern struct in6_addr net_lo;
 
 int32_t Net_GetError(void);
 const char *Net_GetErrorString(void);
@@ -31,12 +31,14 @@ const char *Net_GetErrorString(void);
 _Bool Net_CompareNetaddr(const net_addr_t *a, const net_addr_t *b);
 _Bool Net_CompareClientNetaddr(const net_addr_t *a, const net_addr_t *b);
 
-void Net_NetAddrToSockaddr(const net_addr_t *a, net_sockaddr *s);
+socklen_t Net_NetAddrToSockaddr(const net_addr_t *a, int32_t family, net_sockaddr *s);
+void Net_SockaddrToNetaddr(const net_sockaddr *s, net_addr_t *a);
 const char *Net_NetaddrToString(const net_addr_t *a);
 _Bool Net_StringToSockaddr(const char *s, net_sockaddr *saddr);
 _Bool Net_StringToNetaddr(const char *s, net_addr_t *a);
 
 int32_t Net_Socket(net_addr_type_t type, const char *iface, in_port_t port);
+int32_t Net_SocketFamily(int32_t sock);
 void Net_SetNonBlocking(int32_t sock, _Bool non_blocking);
 void Net_CloseSocket(int32_t sock);
 
@@ -26,12 +26,18 @@
  *
  * packet header
  * -------------
- * 31	sequence
+ * 30	sequence
+ * 1	is this packet a fragment of a larger message
  * 1	does this message contain a reliable payload
  * 31	acknowledge sequence
  * 1	acknowledge receipt of even/odd message
  * 8	qport
  *
+ * fragment header
+ * ---------------
+ * 8	fragment index
+ * 8	fragment count
+ *
  * The remote connection never knows if it missed a reliable message, the
  * local side detects that it has been dropped by seeing a sequence acknowledge
  * higher than the last reliable sequence, but without the correct even/odd
@@ -53,6 +59,12 @@
  * Reliable messages are always placed first in a packet, then the unreliable
  * message is included if there is sufficient room.
  *
+ * Messages larger than NET_FRAGMENT_SIZE are split into fragments, which share
+ * the message's sequence number. The receiver reassembles them, in any order,
+ * and processes the message once all of its fragments have arrived. A message
+ * missing any fragment is dropped as a whole; if it contained a reliable
+ * payload, that is retransmitted as usual.
+ *
  * To the receiver, there is no distinction between the reliable and unreliable
  * parts of the message, they are just processed out as a single larger message.
  *
@@ -74,12 +86,15 @@
  * unacknowledged reliable
  */
 
+#define NET_FRAGMENT_BIT (1u << 30)
+#define NET_RELIABLE_BIT (1u << 31)
+
 static cvar_t *net_show_packets;
 static cvar_t *net_show_drop;
 
 net_addr_t net_from;
 mem_buf_t net_message;
-static byte net_message_buffer[MAX_MSG_SIZE];
+static byte net_message_buffer[MAX_FRAGMENTED_MSG_SIZE];
 
 /**
  * @brief Sends an out-of-band datagram
@@ -119,6 +134,8 @@ void Netchan_OutOfBandPrint(int32_t sock, const net_addr_t *addr, const char *fo
  */
 void Netchan_Setup(net_src_t source, net_chan_t *chan, net_addr_t *addr, uint8_t qport) {
 
+	Netchan_Close(chan);
+
 	memset(chan, 0, sizeof(*chan));
 
 	chan->source = source;
@@ -131,6 +148,22 @@ void Netchan_Setup(net_src_t source, net_chan_t *chan, net_addr_t *addr, uint8_t
 
 	Mem_InitBuffer(&chan->message, chan->message_buffer, sizeof(chan->message_buffer));
 	chan->message.allow_overflow = true;
+
+	// remote sides which can not reassemble fragments must clear this
+	chan->fragment = true;
+}
+
+/**
+ * @brief Called to close a channel, releasing its fragment buffer.
+ */
+void Netchan_Close(net_chan_t *chan) {
+
+	if (chan->fragment_buffer) {
+		Mem_Free(chan->fragment_buffer);
+		chan->fragment_buffer = NULL;
+	}
+
+	chan->fragment_mask = 0;
 }
 
 /**
@@ -148,9 +181,57 @@ static _Bool Netchan_CheckRetransmit(net_chan_t *chan) {
 	return false;
 }
 
+/**
+ * @brief Sends the reliable and unreliable message payload as a series of
+ * fragments, each preceded by the packet header, with the fragment bit set,
+ * and the fragment header. The fragments are copied directly from the payload.
+ */
+static void Netchan_TransmitFragments(net_chan_t *chan, uint32_t w1, uint32_t w2,
+                                      const byte *reliable, size_t reliable_len,
+                                      const byte *data, size_t len) {
+	mem_buf_t send;
+	byte send_buffer[NET_FRAGMENT_SIZE + 16];
+
+	const size_t total = reliable_len + len;
+	const uint8_t count = (total + NET_FRAGMENT_SIZE - 1) / NET_FRAGMENT_SIZE;
+
+	for (uint8_t i = 0; i < count; i++) {
+		const size_t offset = i * NET_FRAGMENT_SIZE;
+		const size_t size = Min(total - offset, (size_t) NET_FRAGMENT_SIZE);
+
+		Mem_InitBuffer(&send, send_buffer, sizeof(send_buffer));
+
+		Net_WriteLong(&send, w1 | NET_FRAGMENT_BIT);
+		Net_WriteLong(&send, w2);
+
+		if (chan->source == NS_UDP_CLIENT) {
+			Net_WriteByte(&send, chan->qport);
+		}
+
+		Net_WriteByte(&send, i);
+		Net_WriteByte(&send, count);
+
+		// a fragment may span the reliable and unreliable parts of the payload
+		if (offset < reliable_len) {
+			const size_t n = Min(reliable_len - offset, size);
+
+			Mem_WriteBuffer(&send, reliable + offset, n);
+
+			if (size > n) {
+				Mem_WriteBuffer(&send, data, size - n);
+			}
+		} else {
+			Mem_WriteBuffer(&send, data + (offset - reliable_len), size);
+		}
+
+		Net_SendDatagram(chan->source, &chan->remote_address, send.data, send.size);
+	}
+}
+
 /**
  * @brief Tries to send an unreliable message to a connection, and handles the
- * transmission / retransmission of the reliable messages.
+ * transmission / retransmission of the reliable messages. Messages too large
+ * for a single datagram are fragmented, if the remote side supports it.
  *
  * A 0 size will still generate a packet and deal with the reliable messages.
  */
@@ -178,8 +259,8 @@ void Netchan_Transmit(net_chan_t *chan, byte *data, size_t len) {
 	// write the packet header
 	Mem_InitBuffer(&send, send_buffer, sizeof(send_buffer));
 
-	const uint32_t w1 = (chan->outgoing_sequence & ~(1u << 31)) | (send_reliable << 31);
-	const uint32_t w2 = (chan->incoming_sequence & ~(1u << 31)) | (chan->reliable_incoming << 31);
+	const uint32_t w1 = (chan->outgoing_sequence & ~(NET_RELIABLE_BIT | NET_FRAGMENT_BIT)) | (send_reliable << 31);
+	const uint32_t w2 = (chan->incoming_sequence & ~NET_RELIABLE_BIT) | (chan->reliable_incoming << 31);
 
 	chan->outgoing_sequence++;
 	chan->last_sent = quetoo.ticks;
@@ -192,33 +273,111 @@ void Netchan_Transmit(net_chan_t *chan, byte *data, size_t len) {
 		Net_WriteByte(&send, chan->qport);
 	}
 
-	// copy the reliable message to the packet first
+	const size_t header_len = send.size;
+
+	// the reliable message is placed first
+	size_t reliable_len = 0;
 	if (send_reliable) {
-		Mem_WriteBuffer(&send, chan->reliable_buffer, chan->reliable_size);
+		reliable_len = chan->reliable_size;
 		chan->reliable_outgoing = chan->outgoing_sequence;
 	}
 
 	// add the unreliable part if space is available
-	if (send.max_size - send.size >= len) {
-		Mem_WriteBuffer(&send, data, len);
-	} else {
+	const size_t max_size = chan->fragment ? MAX_FRAGMENTED_MSG_SIZE : MAX_MSG_SIZE;
+	if (header_len + reliable_len + len > max_size) {
 		Com_Warn("Netchan_Transmit: dumped unreliable\n");
+		len = 0;
 	}
 
-	// send the datagram
-	Net_SendDatagram(chan->source, &chan->remote_address, send.data, send.size);
+	const size_t size = header_len + reliable_len + len;
+
+	// send the datagram, or its fragments
+	if (chan->fragment && reliable_len + len > NET_FRAGMENT_SIZE) {
+		Netchan_TransmitFragments(chan, w1, w2, chan->reliable_buffer, reliable_len, data, len);
+	} else {
+		Mem_WriteBuffer(&send, chan->reliable_buffer, reliable_len);
+		Mem_WriteBuffer(&send, data, len);
+
+		Net_SendDatagram(chan->source, &chan->remote_address, send.data, send.size);
+	}
 
 	if (net_show_packets->value) {
 		if (send_reliable)
-			Com_Print("Send %u bytes: s=%i reliable=%i ack=%i rack=%i\n", (uint32_t) send.size,
+			Com_Print("Send %u bytes: s=%i reliable=%i ack=%i rack=%i\n", (uint32_t) size,
 			          chan->outgoing_sequence - 1, chan->reliable_sequence, chan->incoming_sequence,
 			          chan->reliable_incoming);
 		else
-			Com_Print("Send %u bytes : s=%i ack=%i rack=%i\n", (uint32_t) send.size,
+			Com_Print("Send %u bytes : s=%i ack=%i rack=%i\n", (uint32_t) size,
 			          chan->outgoing_sequence - 1, chan->incoming_sequence, chan->reliable_incoming);
 	}
 }
 
+/**
+ * @brief Accumulates the fragment in `msg`, whose header has been read. Once
+ * all of the message's fragments have arrived, `msg` is rewritten to contain
+ * the reassembled message, positioned after its header.
+ * @return True if the message is complete, false otherwise.
+ */
+static _Bool Netchan_Reassemble(net_chan_t *chan, mem_buf_t *msg, uint32_t sequence) {
+
+	const size_t header_len = msg->read;
+
+	const uint8_t index = Net_ReadByte(msg);
+	const uint8_t count = Net_ReadByte(msg);
+
+	if (msg->read > msg->size || count == 0 || count > NET_MAX_FRAGMENTS || index >= count) {
+		Com_Debug(DEBUG_NET, "%s: Bad fragment %u of %u\n",
+		          Net_NetaddrToString(&chan->remote_address), index, count);
+		return false;
+	}
+
+	// a fragment of a newer message abandons the message being reassembled
+	if (sequence < chan->fragment_sequence) {
+		return false;
+	} else if (sequence > chan->fragment_sequence || count != chan->fragment_count) {
+		chan->fragment_sequence = sequence;
+		chan->fragment_count = count;
+		chan->fragment_mask = 0;
+		chan->fragment_size = 0;
+	}
+
+	const size_t len = msg->size - msg->read;
+
+	// all but the last fragment are full
+	if (index < count - 1 ? len != NET_FRAGMENT_SIZE : len > NET_FRAGMENT_SIZE) {
+		Com_Debug(DEBUG_NET, "%s: Bad fragment length %u\n",
+		          Net_NetaddrToString(&chan->remote_address), (uint32_t) len);
+		return false;
+	}
+
+	if (!chan->fragment_buffer) {
+		chan->fragment_buffer = Mem_Malloc(MAX_FRAGMENTED_MSG_SIZE);
+	}
+
+	memcpy(chan->fragment_buffer + index * NET_FRAGMENT_SIZE, msg->data + msg->read, len);
+	chan->fragment_mask |= 1ull << index;
+
+	if (index == count - 1) {
+		chan->fragment_size = index * NET_FRAGMENT_SIZE + len;
+	}
+
+	if (chan->fragment_mask != (count == 64 ? ~0ull : (1ull << count) - 1)) {
+		return false;
+	}
+
+	if (header_len + chan->fragment_size > msg->max_size) {
+		Com_Warn("%s: Oversized message\n", Net_NetaddrToString(&chan->remote_address));
+		return false;
+	}
+
+	msg->size = header_len;
+	Mem_WriteBuffer(msg, chan->fragment_buffer, chan->fragment_size);
+	msg->read = header_len;
+
+	chan->fragment_mask = 0;
+	return true;
+}
+
 /**
  * @brief Called when the current net_message is from remote_address
  * modifies net_message so that it points to the packet payload
@@ -241,8 +400,10 @@ _Bool Netchan_Process(net_chan_t *chan, mem_buf_t *msg) {
 	reliable_message = sequence >> 31u;
 	reliable_ack = sequence_ack >> 31u;
 
-	sequence &= ~(1u << 31);
-	sequence_ack &= ~(1u << 31);
+	const _Bool fragment = (sequence & NET_FRAGMENT_BIT) != 0;
+
+	sequence &= ~(NET_RELIABLE_BIT | NET_FRAGMENT_BIT);
+	sequence_ack &= ~NET_RELIABLE_BIT;
 
 	if (net_show_packets->value) {
 		if (reliable_message)
@@ -261,6 +422,11 @@ _Bool Netchan_Process(net_chan_t *chan, mem_buf_t *msg) {
 		return false;
 	}
 
+	// fragments are held until their message is complete
+	if (fragment && !Netchan_Reassemble(chan, msg, sequence)) {
+		return false;
+	}
+
 	// dropped packets don't keep the message from being used
 	chan->dropped = sequence - (chan->incoming_sequence + 1);
 	if (chan->dropped > 0) {
@@ -77,6 +77,87 @@ void Net_WriteLong(mem_buf_t *msg, const int32_t c) {
 	buf[3] = c >> 24;
 }
 
+/**
+ * @brief Writes a signed integer in as few bytes as its magnitude allows:
+ * zig-zag encoded, seven bits per byte, least significant first.
+ */
+void Net_WriteVarInt(mem_buf_t *msg, const int32_t c) {
+
+	uint32_t v = ((uint32_t) c << 1) ^ (uint32_t) (c >> 31);
+
+	while (v > 0x7f) {
+		Net_WriteByte(msg, (v & 0x7f) | 0x80);
+		v >>= 7;
+	}
+
+	Net_WriteByte(msg, v);
+}
+
+/**
+ * @brief Begins writing a bit stream to the message.
+ */
+void Net_BeginWritingBits(net_bits_t *bits, mem_buf_t *msg) {
+
+	bits->msg = msg;
+	bits->value = 0;
+	bits->count = 0;
+}
+
+/**
+ * @brief Writes the low `count` bits of `value`, where `count` is at most 32.
+ */
+void Net_WriteBits(net_bits_t *bits, uint32_t value, int32_t count) {
+
+	if (count < 32) {
+		value &= (1u << count) - 1;
+	}
+
+	bits->value |= (uint64_t) value << bits->count;
+	bits->count += count;
+
+	while (bits->count >= 8) {
+		Net_WriteByte(bits->msg, bits->value & 0xff);
+		bits->value >>= 8;
+		bits->count -= 8;
+	}
+}
+
+/**
+ * @brief Writes a signed integer as a five bit width, followed by that many bits
+ * of its zig-zag encoding. Zero costs five bits; widths of 31 and 32 bits are
+ * both sent as 32.
+ */
+void Net_WriteBitsVarInt(net_bits_t *bits, int32_t value) {
+
+	const uint32_t v = ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+
+	int32_t width = 0;
+	while (width < 32 && (v >> width)) {
+		width++;
+	}
+
+	if (width >= 31) {
+		Net_WriteBits(bits, 31, 5);
+		Net_WriteBits(bits, v, 32);
+	} else {
+		Net_WriteBits(bits, width, 5);
+		Net_WriteBits(bits, v, width);
+	}
+}
+
+/**
+ * @brief Writes any pending bits to the message, padding them to a whole byte.
+ */
+void Net_FlushBits(net_bits_t *bits) {
+
+	if (bits->count) {
+		Net_WriteByte(bits->msg, bits->value & 0xff);
+	}
+
+	bits->value = 0;
+	bits->count = 0;
+}
+
 /**
  * @brief
  */
@@ -126,21 +207,196 @@ void Net_WriteAngles(mem_buf_t *msg, const vec3_t angles) {
 }
 
 /**
- * @brief
+ * @brief The cube map of cells through which directions are quantized.
  */
-void Net_WriteDir(mem_buf_t *msg, const vec3_t dir) {
-	int32_t i, best = 0;
+#define NET_DIR_GRID 32
+#define NET_DIR_CELLS (6 * NET_DIR_GRID * NET_DIR_GRID)
+#define NET_DIR_MAX_CANDIDATES (NET_DIR_CELLS * 8)
+
+/**
+ * @brief Directions with components beyond this range may lose precision in
+ * their dot products, and so are resolved with a full search.
+ */
+#define NET_DIR_MIN_COMPONENT 1e-15f
+#define NET_DIR_MAX_COMPONENT 1e15f
+
+static struct {
+	gsize initialized;
+
+	uint16_t cells[NET_DIR_CELLS + 1];
+	byte candidates[NET_DIR_MAX_CANDIDATES];
+} net_dir;
+
+/**
+ * @return The cube map cell for the specified direction, or -1 if it must be
+ * resolved with a full search.
+ */
+static int32_t Net_DirCell(const vec3_t dir) {
+	const vec_t x = fabsf(dir[0]), y = fabsf(dir[1]), z = fabsf(dir[2]);
+	int32_t face;
+	vec_t max, u, v;
+
+	if (x >= y && x >= z) {
+		face = dir[0] < 0.0;
+		max = x, u = dir[1], v = dir[2];
+	} else if (y >= z) {
+		face = 2 + (dir[1] < 0.0);
+		max = y, u = dir[0], v = dir[2];
+	} else {
+		face = 4 + (dir[2] < 0.0);
+		max = z, u = dir[0], v = dir[1];
+	}
+
+	if (!(max > NET_DIR_MIN_COMPONENT && max < NET_DIR_MAX_COMPONENT)) {
+		return -1;
+	}
+
+	if (!(fabsf(u) <= max && fabsf(v) <= max)) {
+		return -1;
+	}
+
+	const vec_t scale = NET_DIR_GRID * 0.5 / max;
+
+	const int32_t i = Clamp((int32_t) (u * scale + NET_DIR_GRID * 0.5), 0, NET_DIR_GRID - 1);
+	const int32_t j = Clamp((int32_t) (v * scale + NET_DIR_GRID * 0.5), 0, NET_DIR_GRID - 1);
+
+	return (face * NET_DIR_GRID + i) * NET_DIR_GRID + j;
+}
+
+/**
+ * @brief Resolves the direction of the specified cell corner, or center.
+ */
+static void Net_DirCellPoint(int32_t face, double u, double v, double out[3]) {
+
+	u = u / NET_DIR_GRID * 2.0 - 1.0;
+	v = v / NET_DIR_GRID * 2.0 - 1.0;
+
+	const double s = (face & 1) ? -1.0 : 1.0;
+
+	switch (face >> 1) {
+		case 0:
+			out[0] = s, out[1] = u, out[2] = v;
+			break;
+		case 1:
+			out[0] = u, out[1] = s, out[2] = v;
+			break;
+		default:
+			out[0] = u, out[1] = v, out[2] = s;
+			break;
+	}
+
+	const double len = sqrt(out[0] * out[0] + out[1] * out[1] + out[2] * out[2]);
+
+	out[0] /= len;
+	out[1] /= len;
+	out[2] /= len;
+}
+
+/**
+ * @brief Builds the candidate lists of each cell. For a cell of angular radius
+ * `r` about its center `c`, the dot product of any direction within it with a
+ * normal `n` at angle `a` from `c` lies within `|n| * [cos(a + r), cos(a - r)]`.
+ * Normals whose greatest possible dot product is less than the least possible
+ * dot product of another can never be nearest, and are excluded.
+ */
+static void Net_InitDir(void) {
+	double lower[NUM_APPROXIMATE_NORMALS], upper[NUM_APPROXIMATE_NORMALS];
+	size_t count = 0;
+
+	for (int32_t cell = 0; cell < NET_DIR_CELLS; cell++) {
+		const int32_t face = cell / (NET_DIR_GRID * NET_DIR_GRID);
+		const int32_t i = (cell / NET_DIR_GRID) % NET_DIR_GRID;
+		const int32_t j = cell % NET_DIR_GRID;
+
+		double center[3], corner[3];
+		Net_DirCellPoint(face, i + 0.5, j + 0.5, center);
+
+		double radius = 0.0;
+		for (int32_t k = 0; k < 4; k++) {
+			Net_DirCellPoint(face, i + (k & 1), j + (k >> 1), corner);
+
+			const double d = center[0] * corner[0] + center[1] * corner[1] + center[2] * corner[2];
+			radius = MAX(radius, acos(Clamp(d, -1.0, 1.0)));
+		}
+
+		radius += 1e-4; // for directions rounded into a neighboring cell
+
+		double best = -DBL_MAX;
+		for (int32_t k = 0; k < NUM_APPROXIMATE_NORMALS; k++) {
+			const vec_t *n = approximate_normals[k];
+
+			const double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			const double d = (center[0] * n[0] + center[1] * n[1] + center[2] * n[2]) / len;
+			const double angle = acos(Clamp(d, -1.0, 1.0));
+
+			lower[k] = len * cos(MIN(angle + radius, M_PI));
+			upper[k] = len * cos(MAX(angle - radius, 0.0));
+
+			best = MAX(best, lower[k]);
+		}
+
+		const size_t start = count;
+		for (int32_t k = 0; k < NUM_APPROXIMATE_NORMALS; k++) {
+			if (upper[k] >= best - 1e-5) {
+				if (count == NET_DIR_MAX_CANDIDATES) {
+					count = start; // fall back to a full search for this cell
+					break;
+				}
+				net_dir.candidates[count++] = k;
+			}
+		}
+
+		net_dir.cells[cell] = start;
+		net_dir.cells[cell + 1] = count;
+	}
+}
+
+/**
+ * @return The index of the approximate normal nearest to the specified direction.
+ */
+int32_t Net_DirIndex(const vec3_t dir) {
+
+	if (g_once_init_enter(&net_dir.initialized)) {
+		Net_InitDir();
+		g_once_init_leave(&net_dir.initialized, 1);
+	}
+
+	int32_t best = 0;
 	vec_t best_d = 0.0;
 
-	for (i = 0; i < NUM_APPROXIMATE_NORMALS; i++) {
-		const vec_t d = DotProduct(dir, approximate_normals[i]);
-		if (d > best_d) {
-			best_d = d;
-			best = i;
+	const int32_t cell = Net_DirCell(dir);
+	if (cell != -1 && net_dir.cells[cell] < net_dir.cells[cell + 1]) {
+
+		const byte *c = net_dir.candidates + net_dir.cells[cell];
+		const byte *end = net_dir.candidates + net_dir.cells[cell + 1];
+
+		for (; c < end; c++) {
+			const vec_t d = DotProduct(dir, approximate_normals[*c]);
+			if (d > best_d) {
+				best_d = d;
+				best = *c;
+			}
+		}
+	} else {
+		for (int32_t i = 0; i < NUM_APPROXIMATE_NORMALS; i++) {
+			const vec_t d = DotProduct(dir, approximate_normals[i]);
+			if (d > best_d) {
+				best_d = d;
+				best = i;
+			}
 		}
 	}
 
-	Net_WriteByte(msg, best);
+	return best;
+}
+
+/**
+ * @brief Writes the index of the approximate normal nearest to the direction.
+ * Each cube map cell lists the normals that could be nearest to any direction
+ * within it, so only those are tested.
+ */
+void Net_WriteDir(mem_buf_t *msg, const vec3_t dir) {
+	Net_WriteByte(msg, Net_DirIndex(dir));
 }
 
 /**
@@ -203,10 +459,101 @@ void Net_WriteDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, const pm_cmd_t
 	Net_WriteByte(msg, to->msec);
 }
 
+/**
+ * @brief Writes a full precision vector to the bit stream.
+ */
+static void Net_WriteBitsPosition(net_bits_t *stream, const vec3_t pos) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		const net_vec_t vec = {
+			.v = pos[i]
+		};
+
+		Net_WriteBits(stream, vec.i, 32);
+	}
+}
+
+/**
+ * @brief Writes the player state fields flagged in `bits` to a bit stream. The
+ * origin, velocity and hook position remain full precision, as the client
+ * predicts from them. Changed stats are sent as a list of indices and deltas.
+ */
+static void Net_WriteDeltaPlayerStateBits(mem_buf_t *msg, const player_state_t *from, const player_state_t *to,
+                                          uint16_t bits) {
+	net_bits_t stream;
+
+	Net_BeginWritingBits(&stream, msg);
+
+	Net_WriteBitsVarInt(&stream, bits);
+
+	if (bits & PS_PM_TYPE) {
+		Net_WriteBits(&stream, to->pm_state.type, 8);
+	}
+
+	if (bits & PS_PM_ORIGIN) {
+		Net_WriteBitsPosition(&stream, to->pm_state.origin);
+	}
+
+	if (bits & PS_PM_VELOCITY) {
+		Net_WriteBitsPosition(&stream, to->pm_state.velocity);
+	}
+
+	if (bits & PS_PM_FLAGS) {
+		Net_WriteBits(&stream, to->pm_state.flags, 16);
+	}
+
+	if (bits & PS_PM_TIME) {
+		Net_WriteBitsVarInt(&stream, to->pm_state.time);
+	}
+
+	if (bits & PS_PM_GRAVITY) {
+		Net_WriteBitsVarInt(&stream, to->pm_state.gravity);
+	}
+
+	if (bits & PS_PM_VIEW_OFFSET) {
+		for (int32_t i = 0; i < 3; i++) {
+			Net_WriteBitsVarInt(&stream, to->pm_state.view_offset[i]);
+		}
+	}
+
+	if (bits & PS_PM_VIEW_ANGLES) {
+		for (int32_t i = 0; i < 3; i++) {
+			Net_WriteBitsVarInt(&stream, (int16_t) (to->pm_state.view_angles[i] - from->pm_state.view_angles[i]));
+		}
+	}
+
+	if (bits & PS_PM_DELTA_ANGLES) {
+		for (int32_t i = 0; i < 3; i++) {
+			Net_WriteBitsVarInt(&stream, (int16_t) (to->pm_state.delta_angles[i] - from->pm_state.delta_angles[i]));
+		}
+	}
+
+	if (bits & PS_PM_HOOK_POSITION) {
+		Net_WriteBitsPosition(&stream, to->pm_state.hook_position);
+	}
+
+	if (bits & PS_PM_HOOK_LENGTH) {
+		Net_WriteBitsVarInt(&stream, to->pm_state.hook_length);
+	}
+
+	for (int32_t i = 0; i < MAX_STATS; i++) {
+		if (to->stats[i] != from->stats[i]) {
+			Net_WriteBits(&stream, 1, 1);
+			Net_WriteBits(&stream, i, 5);
+			Net_WriteBitsVarInt(&stream, (int16_t) (to->stats[i] - from->stats[i]));
+		}
+	}
+
+	Net_WriteBits(&stream, 0, 1);
+
+	Net_FlushBits(&stream);
+}
+
 /**
  * @brief
  */
-void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to) {
+void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to,
+                               uint16_t protocol) {
 
 	uint16_t bits = 0;
 
@@ -254,6 +601,11 @@ void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const
 		bits |= PS_PM_HOOK_LENGTH;
 	}
 
+	if (protocol >= PROTOCOL_MAJOR_BITS) {
+		Net_WriteDeltaPlayerStateBits(msg, from, to, bits);
+		return;
+	}
+
 	Net_WriteShort(msg, bits);
 
 	if (bits & PS_PM_TYPE) {
@@ -323,12 +675,227 @@ void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const
 	}
 }
 
+/**
+ * @brief Under PROTOCOL_MAJOR_QUANTIZED and later, entity positions are sent as
+ * deltas of fixed point values in 1/NET_POSITION_SCALE units, and angles as
+ * deltas of 1/65536 turns. Both sides decode positions from the same integers,
+ * and dequantized values quantize back to those integers exactly, so the
+ * client's copy of an entity never drifts from the server's quantization of it.
+ * Solid boxes and inline models, which the client clips against, are exempt:
+ * their positions are sent at full precision, after their solid type.
+ */
+#define NET_POSITION_SCALE 16.0
+#define NET_POSITION_MAX (MAX_WORLD_COORD * 8.0)
+
+/**
+ * @return The fixed point quantization of the specified coordinate.
+ */
+static int32_t Net_QuantizePosition(const vec_t v) {
+
+	if (isnan(v)) {
+		return 0;
+	}
+
+	return (int32_t) lrint(Clamp(v, -NET_POSITION_MAX, NET_POSITION_MAX) * NET_POSITION_SCALE);
+}
+
+/**
+ * @return True if the specified entity's positions are quantized.
+ */
+static _Bool Net_QuantizeEntity(const entity_state_t *s) {
+	return s->solid != SOLID_BOX && s->solid != SOLID_BSP;
+}
+
+/**
+ * @return The fixed point quantization of the specified angle.
+ */
+static int32_t Net_QuantizeAngle(const vec_t a) {
+
+	if (!isfinite(a)) {
+		return 0;
+	}
+
+	return (int32_t) lrint(ClampAngle(a) * (65536.0 / 360.0)) & 0xffff;
+}
+
+/**
+ * @return True if the specified vectors quantize to the same positions.
+ */
+static _Bool Net_ComparePositions(const vec3_t a, const vec3_t b) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		if (Net_QuantizePosition(a[i]) != Net_QuantizePosition(b[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @return True if the specified vectors quantize to the same angles.
+ */
+static _Bool Net_CompareAngles(const vec3_t a, const vec3_t b) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		if (Net_QuantizeAngle(a[i]) != Net_QuantizeAngle(b[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Writes the quantized delta from one position to another.
+ */
+static void Net_WriteDeltaPosition(mem_buf_t *msg, const vec3_t from, const vec3_t to) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		Net_WriteVarInt(msg, Net_QuantizePosition(to[i]) - Net_QuantizePosition(from[i]));
+	}
+}
+
+/**
+ * @brief Reads a quantized position delta written by Net_WriteDeltaPosition.
+ */
+static void Net_ReadDeltaPosition(mem_buf_t *msg, const vec3_t from, vec3_t to) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		const int32_t q = Net_QuantizePosition(from[i]) + Net_ReadVarInt(msg);
+		to[i] = q / NET_POSITION_SCALE;
+	}
+}
+
+/**
+ * @brief Writes the quantized delta from one set of angles to another, taking
+ * the shorter way around.
+ */
+static void Net_WriteDeltaAngles(mem_buf_t *msg, const vec3_t from, const vec3_t to) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		Net_WriteVarInt(msg, (int16_t) (Net_QuantizeAngle(to[i]) - Net_QuantizeAngle(from[i])));
+	}
+}
+
+/**
+ * @brief Reads a quantized angles delta written by Net_WriteDeltaAngles.
+ */
+static void Net_ReadDeltaAngles(mem_buf_t *msg, const vec3_t from, vec3_t to) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		const int32_t q = (Net_QuantizeAngle(from[i]) + Net_ReadVarInt(msg)) & 0xffff;
+		to[i] = UnclampAngle(q * (360.0 / 65536.0));
+	}
+}
+
+/**
+ * @brief Writes the entity fields flagged in `bits` to a bit stream, with
+ * positions and angles quantized as for PROTOCOL_MAJOR_QUANTIZED.
+ */
+static void Net_WriteDeltaEntityBits(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to,
+                                     uint16_t bits) {
+	net_bits_t stream;
+
+	Net_BeginWritingBits(&stream, msg);
+
+	// the solid type precedes the positions, as it determines their encoding
+	if (bits & U_SOLID) {
+		Net_WriteBits(&stream, to->solid, 8);
+	}
+
+	const _Bool quantize = Net_QuantizeEntity(to);
+
+	if (bits & U_ORIGIN) {
+		if (quantize) {
+			for (int32_t i = 0; i < 3; i++) {
+				Net_WriteBitsVarInt(&stream, Net_QuantizePosition(to->origin[i]) - Net_QuantizePosition(from->origin[i]));
+			}
+		} else {
+			Net_WriteBitsPosition(&stream, to->origin);
+		}
+	}
+
+	if (bits & U_TERMINATION) {
+		if (quantize) {
+			for (int32_t i = 0; i < 3; i++) {
+				Net_WriteBitsVarInt(&stream, Net_QuantizePosition(to->termination[i]) -
+				                    Net_QuantizePosition(from->termination[i]));
+			}
+		} else {
+			Net_WriteBitsPosition(&stream, to->termination);
+		}
+	}
+
+	if (bits & U_ANGLES) {
+		for (int32_t i = 0; i < 3; i++) {
+			Net_WriteBitsVarInt(&stream, (int16_t) (Net_QuantizeAngle(to->angles[i]) - Net_QuantizeAngle(from->angles[i])));
+		}
+	}
+
+	if (bits & U_ANIMATIONS) {
+		Net_WriteBits(&stream, to->animation1, 8);
+		Net_WriteBits(&stream, to->animation2, 8);
+	}
+
+	if (bits & U_EVENT) {
+		Net_WriteBits(&stream, to->event, 8);
+	}
+
+	if (bits & U_EFFECTS) {
+		Net_WriteBits(&stream, to->effects, 16);
+	}
+
+	if (bits & U_TRAIL) {
+		Net_WriteBits(&stream, to->trail, 8);
+	}
+
+	if (bits & U_MODELS) {
+		Net_WriteBits(&stream, to->model1, 8);
+		Net_WriteBits(&stream, to->model2, 8);
+		Net_WriteBits(&stream, to->model3, 8);
+		Net_WriteBits(&stream, to->model4, 8);
+	}
+
+	if (bits & U_CLIENT) {
+		Net_WriteBits(&stream, to->client, 8);
+	}
+
+	if (bits & U_SOUND) {
+		Net_WriteBits(&stream, to->sound, 8);
+	}
+
+	if (bits & U_BOUNDS) {
+		Net_WriteBits(&stream, to->bounds, 32);
+	}
+
+	Net_FlushBits(&stream);
+}
+
+/**
+ * @brief Writes the delta compression flags of an entity. Under
+ * PROTOCOL_MAJOR_BITS they are varint encoded, so that the common updates of
+ * origin, angles, animations and events cost a single byte.
+ */
+void Net_WriteEntityFlags(mem_buf_t *msg, uint16_t bits, uint16_t protocol) {
+
+	if (protocol >= PROTOCOL_MAJOR_BITS) {
+		Net_WriteVarInt(msg, bits);
+	} else {
+		Net_WriteShort(msg, bits);
+	}
+}
+
 /**
  * @brief Writes an entity's state changes to a net message. Can delta from
- * either a baseline or a previous packet_entity
+ * either a baseline or a previous packet_entity, under the specified protocol
+ * major version.
  */
 void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to,
-                          _Bool force) {
+                          _Bool force, uint16_t protocol) {
+
+	const _Bool quantized = protocol >= PROTOCOL_MAJOR_QUANTIZED;
+	const _Bool quantize = quantized && Net_QuantizeEntity(to);
 
 	uint16_t bits = 0;
 
@@ -340,16 +907,32 @@ void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const enti
 		Com_Error(ERROR_FATAL, "Entity number >= MAX_ENTITIES\n");
 	}
 
-	if (!VectorCompare(to->origin, from->origin)) {
-		bits |= U_ORIGIN;
-	}
+	if (quantize) {
+		if (!Net_ComparePositions(to->origin, from->origin)) {
+			bits |= U_ORIGIN;
+		}
 
-	if (!VectorCompare(from->termination, to->termination)) {
-		bits |= U_TERMINATION;
+		if (!Net_ComparePositions(to->termination, from->termination)) {
+			bits |= U_TERMINATION;
+		}
+	} else {
+		if (!VectorCompare(to->origin, from->origin)) {
+			bits |= U_ORIGIN;
+		}
+
+		if (!VectorCompare(from->termination, to->termination)) {
+			bits |= U_TERMINATION;
+		}
 	}
 
-	if (!VectorCompare(to->angles, from->angles)) {
-		bits |= U_ANGLES;
+	if (quantized) {
+		if (!Net_CompareAngles(to->angles, from->angles)) {
+			bits |= U_ANGLES;
+		}
+	} else {
+		if (!VectorCompare(to->angles, from->angles)) {
+			bits |= U_ANGLES;
+		}
 	}
 
 	if (to->animation1 != from->animation1 || to->animation2 != from->animation2) {
@@ -396,18 +979,41 @@ void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const enti
 	// write the message
 
 	Net_WriteShort(msg, to->number);
-	Net_WriteShort(msg, bits);
+	Net_WriteEntityFlags(msg, bits, protocol);
+
+	if (protocol >= PROTOCOL_MAJOR_BITS) {
+		Net_WriteDeltaEntityBits(msg, from, to, bits);
+		return;
+	}
+
+	// quantized protocols send the solid type first, as it determines the
+	// encoding of the positions
+	if (quantized && (bits & U_SOLID)) {
+		Net_WriteByte(msg, to->solid);
+	}
 
 	if (bits & U_ORIGIN) {
-		Net_WritePosition(msg, to->origin);
+		if (quantize) {
+			Net_WriteDeltaPosition(msg, from->origin, to->origin);
+		} else {
+			Net_WritePosition(msg, to->origin);
+		}
 	}
 
 	if (bits & U_TERMINATION) {
-		Net_WritePosition(msg, to->termination);
+		if (quantize) {
+			Net_WriteDeltaPosition(msg, from->termination, to->termination);
+		} else {
+			Net_WritePosition(msg, to->termination);
+		}
 	}
 
 	if (bits & U_ANGLES) {
-		Net_WriteAngles(msg, to->angles);
+		if (quantized) {
+			Net_WriteDeltaAngles(msg, from->angles, to->angles);
+		} else {
+			Net_WriteAngles(msg, to->angles);
+		}
 	}
 
 	if (bits & U_ANIMATIONS) {
@@ -442,7 +1048,7 @@ void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const enti
 		Net_WriteByte(msg, to->sound);
 	}
 
-	if (bits & U_SOLID) {
+	if (!quantized && (bits & U_SOLID)) {
 		Net_WriteByte(msg, to->solid);
 	}
 
@@ -535,6 +1141,91 @@ int32_t Net_ReadLong(mem_buf_t *msg) {
 	return c;
 }
 
+/**
+ * @brief Reads an integer written by Net_WriteVarInt. As every value is valid,
+ * truncation is not signaled by the return value. Reading beyond the end of
+ * the message yields zero, and advances the message's read offset beyond its
+ * size, which callers must check.
+ */
+int32_t Net_ReadVarInt(mem_buf_t *msg) {
+	uint32_t v = 0;
+
+	for (int32_t shift = 0; shift < 35; shift += 7) {
+		const int32_t b = Net_ReadByte(msg);
+		if (b == -1) {
+			return 0;
+		}
+
+		v |= (uint32_t) (b & 0x7f) << shift;
+
+		if (!(b & 0x80)) {
+			break;
+		}
+	}
+
+	return (int32_t) (v >> 1) ^ -(int32_t) (v & 1);
+}
+
+/**
+ * @brief Begins reading a bit stream from the message.
+ */
+void Net_BeginReadingBits(net_bits_t *bits, mem_buf_t *msg) {
+
+	bits->msg = msg;
+	bits->value = 0;
+	bits->count = 0;
+}
+
+/**
+ * @brief Reads `count` bits, where `count` is at most 32. Reading beyond the end
+ * of the message yields zeros, and advances the message's read offset beyond
+ * its size, as the byte-aligned functions do.
+ */
+uint32_t Net_ReadBits(net_bits_t *bits, int32_t count) {
+
+	while (bits->count < count) {
+		const int32_t b = Net_ReadByte(bits->msg);
+		if (b != -1) {
+			bits->value |= (uint64_t) b << bits->count;
+		}
+		bits->count += 8;
+	}
+
+	uint32_t value = (uint32_t) bits->value;
+	if (count < 32) {
+		value &= (1u << count) - 1;
+	}
+
+	bits->value >>= count;
+	bits->count -= count;
+
+	return value;
+}
+
+/**
+ * @brief Reads an integer written by Net_WriteBitsVarInt.
+ */
+int32_t Net_ReadBitsVarInt(net_bits_t *bits) {
+
+	int32_t width = Net_ReadBits(bits, 5);
+	if (width == 31) {
+		width = 32;
+	}
+
+	const uint32_t v = Net_ReadBits(bits, width);
+
+	return (int32_t) (v >> 1) ^ -(int32_t) (v & 1);
+}
+
+/**
+ * @brief Ends reading a bit stream, discarding the padding of its last byte.
+ */
+void Net_EndReadingBits(net_bits_t *bits) {
+
+	bits->value = 0;
+	bits->count = 0;
+}
+
 /**
  * @brief
  */
@@ -664,13 +1355,101 @@ void Net_ReadDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, pm_cmd_t *to) {
 	to->msec = Net_ReadByte(msg);
 }
 
+/**
+ * @brief Reads a full precision vector from the bit stream.
+ */
+static void Net_ReadBitsPosition(net_bits_t *stream, vec3_t pos) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		const net_vec_t vec = {
+			.i = Net_ReadBits(stream, 32)
+		};
+
+		pos[i] = vec.v;
+	}
+}
+
+/**
+ * @brief Reads the player state fields written by Net_WriteDeltaPlayerStateBits.
+ */
+static void Net_ReadDeltaPlayerStateBits(mem_buf_t *msg, const player_state_t *from, player_state_t *to) {
+	net_bits_t stream;
+
+	Net_BeginReadingBits(&stream, msg);
+
+	const int32_t bits = Net_ReadBitsVarInt(&stream);
+
+	if (bits & PS_PM_TYPE) {
+		to->pm_state.type = Net_ReadBits(&stream, 8);
+	}
+
+	if (bits & PS_PM_ORIGIN) {
+		Net_ReadBitsPosition(&stream, to->pm_state.origin);
+	}
+
+	if (bits & PS_PM_VELOCITY) {
+		Net_ReadBitsPosition(&stream, to->pm_state.velocity);
+	}
+
+	if (bits & PS_PM_FLAGS) {
+		to->pm_state.flags = Net_ReadBits(&stream, 16);
+	}
+
+	if (bits & PS_PM_TIME) {
+		to->pm_state.time = Net_ReadBitsVarInt(&stream);
+	}
+
+	if (bits & PS_PM_GRAVITY) {
+		to->pm_state.gravity = Net_ReadBitsVarInt(&stream);
+	}
+
+	if (bits & PS_PM_VIEW_OFFSET) {
+		for (int32_t i = 0; i < 3; i++) {
+			to->pm_state.view_offset[i] = Net_ReadBitsVarInt(&stream);
+		}
+	}
+
+	if (bits & PS_PM_VIEW_ANGLES) {
+		for (int32_t i = 0; i < 3; i++) {
+			to->pm_state.view_angles[i] = from->pm_state.view_angles[i] + Net_ReadBitsVarInt(&stream);
+		}
+	}
+
+	if (bits & PS_PM_DELTA_ANGLES) {
+		for (int32_t i = 0; i < 3; i++) {
+			to->pm_state.delta_angles[i] = from->pm_state.delta_angles[i] + Net_ReadBitsVarInt(&stream);
+		}
+	}
+
+	if (bits & PS_PM_HOOK_POSITION) {
+		Net_ReadBitsPosition(&stream, to->pm_state.hook_position);
+	}
+
+	if (bits & PS_PM_HOOK_LENGTH) {
+		to->pm_state.hook_length = Net_ReadBitsVarInt(&stream);
+	}
+
+	while (Net_ReadBits(&stream, 1)) {
+		const int32_t i = Net_ReadBits(&stream, 5);
+		to->stats[i] = from->stats[i] + Net_ReadBitsVarInt(&stream);
+	}
+
+	Net_EndReadingBits(&stream);
+}
+
 /**
  * @brief
  */
-void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player_state_t *to) {
+void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player_state_t *to,
+                              uint16_t protocol) {
 
 	*to = *from;
 
+	if (protocol >= PROTOCOL_MAJOR_BITS) {
+		Net_ReadDeltaPlayerStateBits(msg, from, to);
+		return;
+	}
+
 	const int32_t bits = Net_ReadShort(msg);
 
 	if (bits & PS_PM_TYPE) {
@@ -732,26 +1511,148 @@ void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player
 	}
 }
 
+/**
+ * @brief Reads the entity fields written by Net_WriteDeltaEntityBits.
+ */
+static void Net_ReadDeltaEntityBits(mem_buf_t *msg, const entity_state_t *from, entity_state_t *to,
+                                    uint16_t bits) {
+	net_bits_t stream;
+
+	Net_BeginReadingBits(&stream, msg);
+
+	if (bits & U_SOLID) {
+		to->solid = Net_ReadBits(&stream, 8);
+	}
+
+	const _Bool quantize = Net_QuantizeEntity(to);
+
+	if (bits & U_ORIGIN) {
+		if (quantize) {
+			for (int32_t i = 0; i < 3; i++) {
+				const int32_t q = Net_QuantizePosition(from->origin[i]) + Net_ReadBitsVarInt(&stream);
+				to->origin[i] = q / NET_POSITION_SCALE;
+			}
+		} else {
+			Net_ReadBitsPosition(&stream, to->origin);
+		}
+	}
+
+	if (bits & U_TERMINATION) {
+		if (quantize) {
+			for (int32_t i = 0; i < 3; i++) {
+				const int32_t q = Net_QuantizePosition(from->termination[i]) + Net_ReadBitsVarInt(&stream);
+				to->termination[i] = q / NET_POSITION_SCALE;
+			}
+		} else {
+			Net_ReadBitsPosition(&stream, to->termination);
+		}
+	}
+
+	if (bits & U_ANGLES) {
+		for (int32_t i = 0; i < 3; i++) {
+			const int32_t q = (Net_QuantizeAngle(from->angles[i]) + Net_ReadBitsVarInt(&stream)) & 0xffff;
+			to->angles[i] = UnclampAngle(q * (360.0 / 65536.0));
+		}
+	}
+
+	if (bits & U_ANIMATIONS) {
+		to->animation1 = Net_ReadBits(&stream, 8);
+		to->animation2 = Net_ReadBits(&stream, 8);
+	}
+
+	if (bits & U_EVENT) {
+		to->event = Net_ReadBits(&stream, 8);
+	} else {
+		to->event = 0;
+	}
+
+	if (bits & U_EFFECTS) {
+		to->effects = Net_ReadBits(&stream, 16);
+	}
+
+	if (bits & U_TRAIL) {
+		to->trail = Net_ReadBits(&stream, 8);
+	}
+
+	if (bits & U_MODELS) {
+		to->model1 = Net_ReadBits(&stream, 8);
+		to->model2 = Net_ReadBits(&stream, 8);
+		to->model3 = Net_ReadBits(&stream, 8);
+		to->model4 = Net_ReadBits(&stream, 8);
+	}
+
+	if (bits & U_CLIENT) {
+		to->client = Net_ReadBits(&stream, 8);
+	}
+
+	if (bits & U_SOUND) {
+		to->sound = Net_ReadBits(&stream, 8);
+	}
+
+	if (bits & U_BOUNDS) {
+		to->bounds = Net_ReadBits(&stream, 32);
+	}
+
+	Net_EndReadingBits(&stream);
+}
+
+/**
+ * @brief Reads the delta compression flags written by Net_WriteEntityFlags.
+ */
+uint16_t Net_ReadEntityFlags(mem_buf_t *msg, uint16_t protocol) {
+
+	if (protocol >= PROTOCOL_MAJOR_BITS) {
+		return Net_ReadVarInt(msg);
+	} else {
+		return Net_ReadShort(msg);
+	}
+}
+
 /**
  * @brief
  */
 void Net_ReadDeltaEntity(mem_buf_t *msg, const entity_state_t *from, entity_state_t *to,
-                         uint16_t number, uint16_t bits) {
+                         uint16_t number, uint16_t bits, uint16_t protocol) {
+
+	const _Bool quantized = protocol >= PROTOCOL_MAJOR_QUANTIZED;
 
 	*to = *from;
 
 	to->number = number;
 
+	if (protocol >= PROTOCOL_MAJOR_BITS) {
+		Net_ReadDeltaEntityBits(msg, from, to, bits);
+		return;
+	}
+
+	if (quantized && (bits & U_SOLID)) {
+		to->solid = Net_ReadByte(msg);
+	}
+
+	const _Bool quantize = quantized && Net_QuantizeEntity(to);
+
 	if (bits & U_ORIGIN) {
-		Net_ReadPosition(msg, to->origin);
+		if (quantize) {
+			Net_ReadDeltaPosition(msg, from->origin, to->origin);
+		} else {
+			Net_ReadPosition(msg, to->origin);
+		}
 	}
 
 	if (bits & U_TERMINATION) {
-		Net_ReadPosition(msg, to->termination);
+		if (quantize) {
+			Net_ReadDeltaPosition(msg, from->termination, to->termination);
+		} else {
+			Net_ReadPosition(msg, to->termination);
+		}
 	}
 
 	if (bits & U_ANGLES) {
-		Net_ReadAngles(msg, to->angles);
+		if (quantized) {
+			Net_ReadDeltaAngles(msg, from->angles, to->angles);
+		} else {
+			Net_ReadAngles(msg, to->angles);
+		}
 	}
 
 	if (bits & U_ANIMATIONS) {
@@ -788,7 +1689,7 @@ void Net_ReadDeltaEntity(mem_buf_t *msg, const entity_state_t *from, entity_stat
 		to->sound = Net_ReadByte(msg);
 	}
 
-	if (bits & U_SOLID) {
+	if (!quantized && (bits & U_SOLID)) {
 		to->solid = Net_ReadByte(msg);
 	}
 
@@ -75,6 +75,18 @@
 #define S_ENTITY				(1 << 2)
 #define S_PITCH					(1 << 3)
 
+/**
+ * @brief A bit-level view of a message, for writing or reading fields that are
+ * narrower than a byte. Bits are accumulated least significant first and
+ * moved to the message a byte at a time. Net_FlushBits pads the stream to a
+ * byte boundary, so that byte-aligned fields may follow it.
+ */
+typedef struct {
+	mem_buf_t *msg;
+	uint64_t value; // the pending bits
+	int32_t count; // the number of pending bits
+} net_bits_t;
+
 /**
  * @brief Message writing and reading facilities.
  */
@@ -83,15 +95,24 @@ void Net_WriteChar(mem_buf_t *msg, const int32_t c);
 void Net_WriteByte(mem_buf_t *msg, const int32_t c);
 void Net_WriteShort(mem_buf_t *msg, const int32_t c);
 void Net_WriteLong(mem_buf_t *msg, const int32_t c);
+void Net_WriteVarInt(mem_buf_t *msg, const int32_t c);
+void Net_BeginWritingBits(net_bits_t *bits, mem_buf_t *msg);
+void Net_WriteBits(net_bits_t *bits, uint32_t value, int32_t count);
+void Net_WriteBitsVarInt(net_bits_t *bits, int32_t value);
+void Net_FlushBits(net_bits_t *bits);
 void Net_WriteString(mem_buf_t *msg, const char *s);
 void Net_WriteVector(mem_buf_t *msg, const vec_t f);
 void Net_WritePosition(mem_buf_t *msg, const vec3_t pos);
 void Net_WriteAngle(mem_buf_t *msg, const vec_t f);
 void Net_WriteAngles(mem_buf_t *msg, const vec3_t angles);
+int32_t Net_DirIndex(const vec3_t dir);
 void Net_WriteDir(mem_buf_t *msg, const vec3_t dir);
 void Net_WriteDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, const pm_cmd_t *to);
-void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to);
-void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to, _Bool force);
+void Net_WriteDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, const player_state_t *to,
+                               uint16_t protocol);
+void Net_WriteEntityFlags(mem_buf_t *msg, uint16_t bits, uint16_t protocol);
+void Net_WriteDeltaEntity(mem_buf_t *msg, const entity_state_t *from, const entity_state_t *to,
+                          _Bool force, uint16_t protocol);
 
 void Net_BeginReading(mem_buf_t *msg);
 void Net_ReadData(mem_buf_t *msg, void *data, size_t len);
@@ -99,6 +120,11 @@ int32_t Net_ReadChar(mem_buf_t *msg);
 int32_t Net_ReadByte(mem_buf_t *msg);
 int32_t Net_ReadShort(mem_buf_t *msg);
 int32_t Net_ReadLong(mem_buf_t *msg);
+int32_t Net_ReadVarInt(mem_buf_t *msg);
+void Net_BeginReadingBits(net_bits_t *bits, mem_buf_t *msg);
+uint32_t Net_ReadBits(net_bits_t *bits, int32_t count);
+int32_t Net_ReadBitsVarInt(net_bits_t *bits);
+void Net_EndReadingBits(net_bits_t *bits);
 char *Net_ReadString(mem_buf_t *msg);
 char *Net_ReadStringLine(mem_buf_t *msg);
 vec_t Net_ReadVector(mem_buf_t *msg);
@@ -107,6 +133,8 @@ vec_t Net_ReadAngle(mem_buf_t *msg);
 void Net_ReadAngles(mem_buf_t *msg, vec3_t angles);
 void Net_ReadDir(mem_buf_t *msg, vec3_t vector);
 void Net_ReadDeltaMoveCmd(mem_buf_t *msg, const pm_cmd_t *from, pm_cmd_t *to);
-void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player_state_t *to);
+void Net_ReadDeltaPlayerState(mem_buf_t *msg, const player_state_t *from, player_state_t *to,
+                              uint16_t protocol);
+uint16_t Net_ReadEntityFlags(mem_buf_t *msg, uint16_t protocol);
 void Net_ReadDeltaEntity(mem_buf_t *msg, const entity_state_t *from, entity_state_t *to,
-                         uint16_t number, uint16_t bits);
+                         uint16_t number, uint16_t bits, uint16_t protocol);
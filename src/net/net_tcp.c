@@ -37,9 +37,14 @@ int32_t Net_Connect(const char *host, struct timeval *timeout) {
 	int32_t sock = Net_Socket(NA_STREAM, NULL, 0);
 
 	net_sockaddr to;
+	net_addr_t addr = { .type = NA_STREAM };
+
 	Net_StringToSockaddr(host, &to);
+	Net_SockaddrToNetaddr(&to, &addr);
+
+	const socklen_t to_len = Net_NetAddrToSockaddr(&addr, Net_SocketFamily(sock), &to);
 
-	if (connect(sock, (const struct sockaddr *) &to, sizeof(to)) == -1) {
+	if (connect(sock, (const struct sockaddr *) &to, to_len) == -1) {
 
 		if (Net_GetError() == EINPROGRESS) {
 			fd_set w_set;
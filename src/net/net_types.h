@@ -22,6 +22,8 @@
 #pragma once
 
 #if defined(_WIN32)
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
 	#include <inttypes.h>
 
 	typedef uint32_t in_addr_t;
@@ -39,6 +41,7 @@
 	#include <errno.h>
 	#include <sys/select.h>
 	#include <netinet/in.h>
+	#include <sys/socket.h>
 
 #endif
 
@@ -51,8 +54,19 @@
  */
 #define MAX_MSG_SIZE 4096 * 8
 
+/**
+ * @brief Net channel messages larger than NET_FRAGMENT_SIZE are transmitted
+ * as a series of fragments, each in its own datagram, and reassembled by the
+ * remote side. This bounds the size of a reassembled message.
+ */
+#define NET_FRAGMENT_SIZE 1300
+#define NET_MAX_FRAGMENTS 64
+
+#define MAX_FRAGMENTED_MSG_SIZE (NET_FRAGMENT_SIZE * NET_MAX_FRAGMENTS)
+
 // A typedef for net_sockaddr, to reduce "struct" everywhere and silence Windows warning.
-typedef struct sockaddr_in net_sockaddr;
+// It is large enough to hold both IPv4 and IPv6 socket addresses.
+typedef struct sockaddr_storage net_sockaddr;
 
 typedef enum {
 	NA_LOOP,
@@ -63,7 +77,8 @@ typedef enum {
 
 typedef struct {
 	net_addr_type_t type;
-	in_addr_t addr;
+	struct in6_addr addr; // IPv4 addresses are v4-mapped, e.g. ::ffff:127.0.0.1
+	uint32_t scope_id; // the interface index of link-local IPv6 addresses
 	in_port_t port;
 } net_addr_t;
 
@@ -106,4 +121,13 @@ typedef struct {
 	// message is copied to this buffer when it is first transfered
 	size_t reliable_size;
 	byte reliable_buffer[MAX_MSG_SIZE - 10]; // un-acked reliable message
+
+	_Bool fragment; // true if the remote side reassembles fragmented messages
+
+	// fragments are reassembled in this buffer, allocated on the first fragment
+	uint32_t fragment_sequence; // the sequence of the message being reassembled
+	uint64_t fragment_mask; // the fragments received
+	uint8_t fragment_count; // the number of fragments in the message
+	size_t fragment_size; // the message size, known once its last fragment arrives
+	byte *fragment_buffer; // MAX_FRAGMENTED_MSG_SIZE, released by Netchan_Close
 } net_chan_t;
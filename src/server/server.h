@@ -38,4 +38,5 @@
 #include "sv_master.h"
 #include "sv_send.h"
 #include "sv_types.h"
+#include "sv_vis.h"
 #include "sv_world.h"
@@ -41,7 +41,7 @@ static void Sv_New_f(void) {
 
 	// send the server data
 	Net_WriteByte(&sv_client->net_chan.message, SV_CMD_SERVER_DATA);
-	Net_WriteShort(&sv_client->net_chan.message, PROTOCOL_MAJOR);
+	Net_WriteShort(&sv_client->net_chan.message, sv_client->protocol);
 	Net_WriteShort(&sv_client->net_chan.message, svs.game->protocol);
 	Net_WriteByte(&sv_client->net_chan.message, 0);
 	Net_WriteString(&sv_client->net_chan.message, Cvar_GetString("game"));
@@ -144,7 +144,8 @@ static void Sv_Baselines_f(void) {
 		base = &sv.baselines[start];
 		if (base->model1 || base->sound || base->effects) {
 			Net_WriteByte(&sv_client->net_chan.message, SV_CMD_BASELINE);
-			Net_WriteDeltaEntity(&sv_client->net_chan.message, &null_state, base, true);
+			Net_WriteDeltaEntity(&sv_client->net_chan.message, &null_state, base, true,
+			                     sv_client->protocol);
 		}
 		start++;
 	}
@@ -442,6 +443,21 @@ void Sv_ParseClientMessage(sv_client_t *cl) {
 					}
 				}
 
+				// the client echoes the pending frame once it has cached it
+				if (cl->protocol >= PROTOCOL_MAJOR_CACHE) {
+					const int32_t cached_frame = Net_ReadLong(&net_message);
+					if (cached_frame > 0 && cached_frame == cl->pending_frame.frame_num) {
+						cl->acked_frame = cl->pending_frame;
+						cl->pending_frame.frame_num = 0;
+					}
+				}
+
+				// a client asking for a retransmit, e.g. to record a demo, starts over
+				if (last_frame < 0) {
+					cl->acked_frame.frame_num = 0;
+					cl->pending_frame.frame_num = 0;
+				}
+
 				static pm_cmd_t null_cmd;
 				pm_cmd_t oldest_cmd, old_cmd, new_cmd;
 				Net_ReadDeltaMoveCmd(&net_message, &null_cmd, &oldest_cmd);
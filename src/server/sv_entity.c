@@ -22,10 +22,21 @@
 #include "sv_local.h"
 
 /**
- * @brief Writes a delta update of an entity_state_t list to the message.
+ * @return The client's partition of svs.entity_states.
  */
-static void Sv_WriteEntities(sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg) {
-	entity_state_t *old_state = NULL, *new_state = NULL;
+static entity_state_t *Sv_ClientEntityStates(const sv_client_t *client) {
+	return svs.entity_states + (client - svs.clients) * SV_CLIENT_ENTITY_STATES;
+}
+
+/**
+ * @brief Writes a delta update of an entity_state_t list to the message. The
+ * entity states of `from` are resolved in `from_states`, which is either the
+ * client's partition of svs.entity_states or the entity states of a cached frame.
+ */
+static void Sv_WriteEntities(const sv_frame_t *from, const entity_state_t *from_states,
+                             uint32_t from_num_states, const sv_frame_t *to, const entity_state_t *to_states,
+                             mem_buf_t *msg, uint16_t protocol) {
+	const entity_state_t *old_state = NULL, *new_state = NULL;
 	uint32_t old_index, new_index;
 	uint16_t old_num, new_num;
 	uint16_t from_num_entities;
@@ -42,36 +53,33 @@ static void Sv_WriteEntities(sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg) {
 		if (new_index >= to->num_entities) {
 			new_num = 0xffff;
 		} else {
-			new_state = &svs.entity_states[(to->entity_state + new_index) % svs.num_entity_states];
+			new_state = &to_states[(to->entity_state + new_index) % SV_CLIENT_ENTITY_STATES];
 			new_num = new_state->number;
 		}
 
 		if (old_index >= from_num_entities) {
 			old_num = 0xffff;
 		} else {
-			old_state
-			    = &svs.entity_states[(from->entity_state + old_index) % svs.num_entity_states];
+			old_state = &from_states[(from->entity_state + old_index) % from_num_states];
 			old_num = old_state->number;
 		}
 
 		if (new_num == old_num) { // delta update from old position
-			Net_WriteDeltaEntity(msg, old_state, new_state, false);
+			Net_WriteDeltaEntity(msg, old_state, new_state, false, protocol);
 			old_index++;
 			new_index++;
 			continue;
 		}
 
 		if (new_num < old_num) { // this is a new entity, send it from the baseline
-			Net_WriteDeltaEntity(msg, &sv.baselines[new_num], new_state, true);
+			Net_WriteDeltaEntity(msg, &sv.baselines[new_num], new_state, true, protocol);
 			new_index++;
 			continue;
 		}
 
 		if (new_num > old_num) { // the old entity isn't present in the new message
-			const int16_t bits = U_REMOVE;
-
 			Net_WriteShort(msg, old_num);
-			Net_WriteShort(msg, bits);
+			Net_WriteEntityFlags(msg, U_REMOVE, protocol);
 
 			old_index++;
 			continue;
@@ -84,21 +92,67 @@ static void Sv_WriteEntities(sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg) {
 /**
  * @brief
  */
-static void Sv_WritePlayerState(sv_frame_t *from, sv_frame_t *to, mem_buf_t *msg) {
+static void Sv_WritePlayerState(const sv_frame_t *from, const sv_frame_t *to, mem_buf_t *msg, uint16_t protocol) {
 	static player_state_t null_state;
 
 	if (from) {
-		Net_WriteDeltaPlayerState(msg, &from->ps, &to->ps);
+		Net_WriteDeltaPlayerState(msg, &from->ps, &to->ps, protocol);
 	} else {
-		Net_WriteDeltaPlayerState(msg, &null_state, &to->ps);
+		Net_WriteDeltaPlayerState(msg, &null_state, &to->ps, protocol);
+	}
+}
+
+/**
+ * @brief Copies the client's frame into the specified cached frame, so that it
+ * may outlive the client's frame backup.
+ */
+static void Sv_CacheFrame(const sv_frame_t *frame, const entity_state_t *states, int32_t frame_num,
+                          sv_cached_frame_t *cached) {
+
+	cached->frame_num = frame_num;
+	cached->frame = *frame;
+	cached->frame.entity_state = 0;
+
+	for (uint16_t i = 0; i < frame->num_entities; i++) {
+		cached->entity_states[i] = states[(frame->entity_state + i) % SV_CLIENT_ENTITY_STATES];
+	}
+}
+
+/**
+ * @brief Asks the client to cache the frame it last acknowledged, at most once
+ * every SV_CACHED_FRAME_INTERVAL frames. The client echoes the pending frame
+ * with its movement commands, which promotes it to the acknowledged frame. A
+ * pending frame that is not echoed within PACKET_BACKUP frames is abandoned.
+ */
+static void Sv_UpdatePendingFrame(sv_client_t *client) {
+
+	const sv_frame_t *frame = &client->frames[client->last_frame & PACKET_MASK];
+
+	if (frame->num_entities > MAX_PACKET_ENTITIES) {
+		return;
+	}
+
+	if (client->last_frame - client->acked_frame.frame_num < SV_CACHED_FRAME_INTERVAL) {
+		return;
+	}
+
+	if (client->pending_frame.frame_num > 0) {
+		if (sv.frame_num - client->pending_frame.frame_num < PACKET_BACKUP) {
+			return;
+		}
 	}
+
+	Sv_CacheFrame(frame, Sv_ClientEntityStates(client), client->last_frame, &client->pending_frame);
 }
 
 /**
  * @brief
  */
 void Sv_WriteClientFrame(sv_client_t *client, mem_buf_t *msg) {
-	sv_frame_t *frame, *delta_frame;
+	const sv_frame_t *frame, *delta_frame;
+	const entity_state_t *states = Sv_ClientEntityStates(client);
+	const entity_state_t *delta_states = states;
+	uint32_t delta_num_states = SV_CLIENT_ENTITY_STATES;
 	int32_t delta_frame_num;
 
 	// this is the frame we are creating
@@ -110,100 +164,90 @@ void Sv_WriteClientFrame(sv_client_t *client, mem_buf_t *msg) {
 		delta_frame_num = -1;
 	} else if (sv.frame_num - client->last_frame >= (PACKET_BACKUP - 3)) {
 		// client hasn't gotten a good message through in a long time
-		delta_frame = NULL;
-		delta_frame_num = -1;
+		if (client->acked_frame.frame_num > 0) {
+			// but it has cached a frame that we can delta from
+			delta_frame = &client->acked_frame.frame;
+			delta_frame_num = client->acked_frame.frame_num;
+			delta_states = client->acked_frame.entity_states;
+			delta_num_states = MAX_PACKET_ENTITIES;
+		} else {
+			delta_frame = NULL;
+			delta_frame_num = -1;
+		}
 	} else {
 		// we have a valid message to delta from
 		delta_frame = &client->frames[client->last_frame & PACKET_MASK];
 		delta_frame_num = client->last_frame;
+
+		if (client->protocol >= PROTOCOL_MAJOR_CACHE) {
+			Sv_UpdatePendingFrame(client);
+		}
 	}
 
 	Net_WriteByte(msg, SV_CMD_FRAME);
 	Net_WriteLong(msg, sv.frame_num);
-	Net_WriteLong(msg, delta_frame_num); // what we are delta'ing from
-	Net_WriteByte(msg, client->suppress_count); // rate dropped packets
+
+	if (client->protocol >= PROTOCOL_MAJOR_BITS) {
+		net_bits_t bits;
+
+		// the delta frame is sent as an offset, with 0 requesting no delta
+		Net_BeginWritingBits(&bits, msg);
+		Net_WriteBitsVarInt(&bits, delta_frame_num == -1 ? 0 : sv.frame_num - delta_frame_num);
+		Net_WriteBitsVarInt(&bits, client->suppress_count);
+		Net_WriteBits(&bits, frame->area_bytes, 8);
+
+		// as are the cached frames, so that the client knows which to retain
+		if (client->protocol >= PROTOCOL_MAJOR_CACHE) {
+			const int32_t acked = client->acked_frame.frame_num;
+			const int32_t pending = client->pending_frame.frame_num;
+
+			Net_WriteBitsVarInt(&bits, acked > 0 ? sv.frame_num - acked : 0);
+			Net_WriteBitsVarInt(&bits, pending > 0 ? sv.frame_num - pending : 0);
+		}
+
+		Net_FlushBits(&bits);
+	} else {
+		Net_WriteLong(msg, delta_frame_num); // what we are delta'ing from
+		Net_WriteByte(msg, client->suppress_count); // rate dropped packets
+		Net_WriteByte(msg, frame->area_bytes);
+	}
+
 	client->suppress_count = 0;
 
 	// send over the area bits
-	Net_WriteByte(msg, frame->area_bytes);
 	Net_WriteData(msg, frame->area_bits, frame->area_bytes);
 
 	// delta encode the player state
-	Sv_WritePlayerState(delta_frame, frame, msg);
+	Sv_WritePlayerState(delta_frame, frame, msg, client->protocol);
 
 	// delta encode the entities
-	Sv_WriteEntities(delta_frame, frame, msg);
+	Sv_WriteEntities(delta_frame, delta_states, delta_num_states, frame, states, msg, client->protocol);
 }
 
 /**
- * @brief Resolve the visibility data for the bounding box around the client. The
- * bounding box provides some leniency because the client's actual view origin
- * is likely slightly different than what we think it is.
+ * @return True if the entity may be sent to clients, false if it is local to
+ * the server, or has no visible presence or effect.
  */
-static void Sv_ClientVisibility(const vec3_t org, byte *pvs, byte *phs) {
-	int32_t leafs[MAX_ENT_LEAFS];
-	int32_t clusters[MAX_ENT_CLUSTERS];
-	size_t num_clusters = 0;
-	vec3_t mins, maxs;
-
-	// spread the bounds to account for view offset
-	for (int32_t i = 0; i < 3; i++) {
-		mins[i] = org[i] - 16.0;
-		maxs[i] = org[i] + 16.0;
-	}
+static _Bool Sv_IsClientEntity(const g_entity_t *ent) {
 
-	const size_t len = Cm_BoxLeafnums(mins, maxs, leafs, lengthof(leafs), NULL, 0);
-	if (len == 0) {
-		Com_Error(ERROR_DROP, "Bad leaf count for client @ %s\n", vtos(org));
-	} else if (len == lengthof(leafs)) {
-		Com_Warn("MAX_ENT_LEAFS for client @ %s\n", vtos(org));
+	if (ent->sv_flags & SVF_NO_CLIENT) {
+		return false;
 	}
 
-	memset(pvs, 0, MAX_BSP_LEAFS >> 3);
-	memset(phs, 0, MAX_BSP_LEAFS >> 3);
-
-	// convert leafs to clusters and combine their visibility data
-	for (size_t i = 0; i < len; i++) {
-
-		const int32_t cluster = Cm_LeafCluster(leafs[i]);
-
-		size_t j;
-		for (j = 0; j < num_clusters; j++) {
-			if (clusters[j] == cluster) {
-				break;
-			}
-		}
-
-		if (j < num_clusters) { // already got it
-			continue;
-		}
-
-		clusters[num_clusters++] = cluster;
-
-		byte cluster_pvs[MAX_BSP_LEAFS >> 3];
-		byte cluster_phs[MAX_BSP_LEAFS >> 3];
-
-		Cm_ClusterPVS(cluster, cluster_pvs);
-		Cm_ClusterPHS(cluster, cluster_phs);
-
-		for (size_t n = 0; n < sizeof(cluster_pvs); n++) {
-			pvs[n] |= cluster_pvs[n];
-			phs[n] |= cluster_phs[n];
-		}
-
-		if (num_clusters == lengthof(clusters)) {
-			Com_Warn("MAX_ENT_CLUSTERS for client @ %s\n", vtos(org));
-			break;
-		}
+	if (!ent->s.event && !ent->s.effects && !ent->s.trail && !ent->s.model1 && !ent->s.sound) {
+		return false;
 	}
+
+	return true;
 }
 
 /**
  * @brief Decides which entities are going to be visible to the client, and
- * copies off the player state and area_bits.
+ * copies off the player state and area_bits. Clients' frames may be built
+ * concurrently, as each writes only to its own partition of svs.entity_states,
+ * and reads the visibility resolved for it by Sv_ClientVis.
  */
 void Sv_BuildClientFrame(sv_client_t *client) {
-	vec3_t org, off;
 
 	g_entity_t *cent = client->entity;
 	if (!cent->client) {
@@ -217,35 +261,23 @@ void Sv_BuildClientFrame(sv_client_t *client) {
 	// grab the current player_state_t
 	frame->ps = cent->client->ps;
 
-	// find the client's PVS
-	const pm_state_t *pm = &cent->client->ps.pm_state;
-	UnpackVector(pm->view_offset, off);
-	VectorAdd(pm->origin, off, org);
-
-	const int32_t leaf = Cm_PointLeafnum(org, 0);
-	const int32_t area = Cm_LeafArea(leaf);
+	// the client's visibility is resolved by Sv_WriteClientFrames
+	const sv_client_vis_t *vis = &client->vis;
+	const int32_t area = vis->area;
 
 	// calculate the visible areas
 	frame->area_bytes = Cm_WriteAreaBits(area, frame->area_bits);
 
-	// resolve the visibility data
-	byte pvs[MAX_BSP_LEAFS >> 3], phs[MAX_BSP_LEAFS >> 3];
-	Sv_ClientVisibility(org, pvs, phs);
-
 	// build up the list of relevant entities
 	frame->num_entities = 0;
-	frame->entity_state = svs.next_entity_state;
+	frame->entity_state = client->next_entity_state;
+
+	entity_state_t *states = Sv_ClientEntityStates(client);
 
 	for (uint16_t e = 1; e < svs.game->num_entities; e++) {
 		g_entity_t *ent = ENTITY_FOR_NUM(e);
 
-		// ignore entities that are local to the server
-		if (ent->sv_flags & SVF_NO_CLIENT) {
-			continue;
-		}
-
-		// ignore entities without visible presence unless they have an effect
-		if (!ent->s.event && !ent->s.effects && !ent->s.trail && !ent->s.model1 && !ent->s.sound) {
+		if (!Sv_IsClientEntity(ent)) {
 			continue;
 		}
 
@@ -260,17 +292,17 @@ void Sv_BuildClientFrame(sv_client_t *client) {
 				}
 			}
 
-			const byte *vis = ent->s.sound || ent->s.event ? phs : pvs;
+			const byte *bits = ent->s.sound || ent->s.event ? vis->phs : vis->pvs;
 
 			if (sent->num_clusters == -1) { // use top_node
-				if (!Cm_HeadnodeVisible(sent->top_node, vis)) {
+				if (!Cm_HeadnodeVisible(sent->top_node, bits)) {
 					continue;
 				}
 			} else { // or check individual leafs
 				int32_t i;
 				for (i = 0; i < sent->num_clusters; i++) {
 					const int32_t c = sent->clusters[i];
-					if (vis[c >> 3] & (1 << (c & 7))) {
+					if (bits[c >> 3] & (1 << (c & 7))) {
 						break;
 					}
 				}
@@ -280,12 +312,8 @@ void Sv_BuildClientFrame(sv_client_t *client) {
 			}
 		}
 
-		// copy it to the circular entity_state_t array
-		entity_state_t *s = &svs.entity_states[svs.next_entity_state % svs.num_entity_states];
-		if (ent->s.number != e) {
-			Com_Warn("Fixing entity number: %d -> %d\n", ent->s.number, e);
-			ent->s.number = e;
-		}
+		// copy it to the client's circular entity_state_t array
+		entity_state_t *s = &states[client->next_entity_state % SV_CLIENT_ENTITY_STATES];
 		*s = ent->s;
 
 		// don't mark our own missiles as solid for prediction
@@ -293,7 +321,62 @@ void Sv_BuildClientFrame(sv_client_t *client) {
 			s->solid = SOLID_NOT;
 		}
 
-		svs.next_entity_state++;
+		client->next_entity_state++;
 		frame->num_entities++;
 	}
 }
+
+/**
+ * @brief ThreadForFunc for Sv_WriteClientFrames.
+ */
+static void Sv_WriteClientFrames_(int32_t begin, int32_t end, void *data) {
+	sv_client_t **clients = (sv_client_t **) data;
+
+	for (int32_t i = begin; i < end; i++) {
+		sv_client_t *client = clients[i];
+
+		Sv_BuildClientFrame(client);
+
+		// clients which can not reassemble fragments are limited to a single datagram
+		if (client->net_chan.fragment) {
+			Mem_InitBuffer(&client->frame_message, client->frame_message_data, sizeof(client->frame_message_data));
+		} else {
+			Mem_InitBuffer(&client->frame_message, client->frame_message_data, MAX_MSG_SIZE);
+		}
+
+		client->frame_message.allow_overflow = true;
+
+		Sv_WriteClientFrame(client, &client->frame_message);
+	}
+}
+
+/**
+ * @brief Builds and writes the frames of the specified clients to their frame
+ * messages, across the thread pool. The caller is responsible for sending them.
+ */
+void Sv_WriteClientFrames(sv_client_t **clients, size_t count) {
+
+	if (count == 0) {
+		return;
+	}
+
+	// the clients' visibility is resolved before the frames are built, as is
+	// the visibility cache it is resolved from
+	for (size_t i = 0; i < count; i++) {
+		if (clients[i]->entity->client) {
+			Sv_ClientVis(clients[i]);
+		}
+	}
+
+	// entity numbers are fixed before the frames are built, rather than by each client
+	for (uint16_t e = 1; e < svs.game->num_entities; e++) {
+		g_entity_t *ent = ENTITY_FOR_NUM(e);
+
+		if (Sv_IsClientEntity(ent) && ent->s.number != e) {
+			Com_Warn("Fixing entity number: %d -> %d\n", ent->s.number, e);
+			ent->s.number = e;
+		}
+	}
+
+	Thread_ParallelFor((int32_t) count, 1, Sv_WriteClientFrames_, clients);
+}
@@ -26,4 +26,5 @@
 #ifdef __SV_LOCAL_H__
 void Sv_WriteClientFrame(sv_client_t *client, mem_buf_t *msg);
 void Sv_BuildClientFrame(sv_client_t *client);
+void Sv_WriteClientFrames(sv_client_t **clients, size_t count);
 #endif /* __SV_LOCAL_H__ */
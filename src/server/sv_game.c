@@ -182,7 +182,6 @@ static void Sv_WriteAngles(const vec3_t angles) {
  * @brief Also checks areas so that doors block sight.
  */
 static _Bool Sv_InPVS(const vec3_t p1, const vec3_t p2) {
-	byte pvs[MAX_BSP_LEAFS >> 3];
 
 	const int32_t leaf1 = Cm_PointLeafnum(p1, 0);
 	const int32_t leaf2 = Cm_PointLeafnum(p2, 0);
@@ -197,7 +196,7 @@ static _Bool Sv_InPVS(const vec3_t p1, const vec3_t p2) {
 	const int32_t cluster1 = Cm_LeafCluster(leaf1);
 	const int32_t cluster2 = Cm_LeafCluster(leaf2);
 
-	Cm_ClusterPVS(cluster1, pvs);
+	const byte *pvs = Sv_ClusterPVS(cluster1);
 
 	if ((pvs[cluster2 >> 3] & (1 << (cluster2 & 7))) == 0) {
 		return false;
@@ -210,7 +209,6 @@ static _Bool Sv_InPVS(const vec3_t p1, const vec3_t p2) {
  * @brief Also checks areas so that doors block sound.
  */
 static _Bool Sv_InPHS(const vec3_t p1, const vec3_t p2) {
-	byte phs[MAX_BSP_LEAFS >> 3];
 
 	const int32_t leaf1 = Cm_PointLeafnum(p1, 0);
 
@@ -226,7 +224,7 @@ static _Bool Sv_InPHS(const vec3_t p1, const vec3_t p2) {
 	const int32_t cluster1 = Cm_LeafCluster(leaf1);
 	const int32_t cluster2 = Cm_LeafCluster(leaf2);
 
-	Cm_ClusterPHS(cluster1, phs);
+	const byte *phs = Sv_ClusterPHS(cluster1);
 
 	if ((phs[cluster2 >> 3] & (1 << (cluster2 & 7))) == 0) {
 		return false;
@@ -177,6 +177,8 @@ static void Sv_ShutdownClients(void) {
 		if (cl->download.buffer) {
 			Fs_Free(cl->download.buffer);
 		}
+
+		Netchan_Close(&cl->net_chan);
 	}
 
 	Mem_Free(svs.clients);
@@ -205,7 +207,7 @@ static void Sv_InitEntities(sv_state_t state) {
 		svs.clients = Mem_TagMalloc(sizeof(sv_client_t) * sv_max_clients->integer, MEM_TAG_SERVER);
 
 		// and the entity states array
-		svs.num_entity_states = sv_max_clients->integer * PACKET_BACKUP * MAX_PACKET_ENTITIES;
+		svs.num_entity_states = sv_max_clients->integer * SV_CLIENT_ENTITY_STATES;
 		svs.entity_states = Mem_TagMalloc(sizeof(entity_state_t) * svs.num_entity_states, MEM_TAG_SERVER);
 
 		svs.spawn_count = Random();
@@ -237,7 +239,12 @@ static void Sv_InitClients(sv_state_t state) {
 
 		// invalidate last frame to force a baseline
 		svs.clients[i].last_frame = -1;
+		svs.clients[i].acked_frame.frame_num = 0;
+		svs.clients[i].pending_frame.frame_num = 0;
 		svs.clients[i].last_message = quetoo.ticks;
+
+		// and their visibility, which was resolved for the previous level
+		svs.clients[i].vis.resolved = false;
 	}
 }
 
@@ -284,6 +291,8 @@ static void Sv_LoadMedia(const char *server, sv_state_t state) {
 
 		Sv_InitWorld();
 
+		Sv_InitVis();
+
 		svs.game->SpawnEntities(sv.name, Cm_EntityString());
 
 		/*
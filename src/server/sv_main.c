@@ -69,6 +69,8 @@ void Sv_DropClient(sv_client_t *cl) {
 		Fs_Free(cl->download.buffer);
 	}
 
+	Netchan_Close(&cl->net_chan);
+
 	ent = cl->entity;
 
 	memset(cl, 0, sizeof(*cl));
@@ -136,7 +138,7 @@ static void Sv_Info_f(void) {
 	}
 
 	const int32_t p = atoi(Cmd_Argv(1));
-	if (p != PROTOCOL_MAJOR) {
+	if (p < PROTOCOL_MAJOR_LEGACY || p > PROTOCOL_MAJOR) {
 		g_snprintf(string, sizeof(string), "%s: Wrong protocol: %d != %d", sv_hostname->string, p,
 		           PROTOCOL_MAJOR);
 	} else {
@@ -215,7 +217,7 @@ static void Sv_Connect_f(void) {
 	const int32_t version = (int32_t) strtol(Cmd_Argv(1), NULL, 0);
 
 	// resolve protocol
-	if (version != PROTOCOL_MAJOR) {
+	if (version < PROTOCOL_MAJOR_LEGACY || version > PROTOCOL_MAJOR) {
 		Netchan_OutOfBandPrint(NS_UDP_SERVER, addr, "print\nServer is version %d.\n",
 		                       PROTOCOL_MAJOR);
 		return;
@@ -339,10 +341,17 @@ static void Sv_Connect_f(void) {
 	g_strlcpy(client->user_info, user_info, sizeof(client->user_info));
 	Sv_UserInfoChanged(client);
 
+	client->protocol = version;
+
+	// frames cached by a previous connection are not held by this one
+	client->acked_frame.frame_num = 0;
+	client->pending_frame.frame_num = 0;
+
 	// send the connect packet to the client
 	Netchan_OutOfBandPrint(NS_UDP_SERVER, addr, "client_connect %s", sv_download_url->string);
 
 	Netchan_Setup(NS_UDP_SERVER, &client->net_chan, addr, qport);
+	client->net_chan.fragment = version >= PROTOCOL_MAJOR_FRAGMENT;
 
 	Mem_InitBuffer(&client->datagram.buffer, client->datagram.data, sizeof(client->datagram.data));
 	client->datagram.buffer.allow_overflow = true;
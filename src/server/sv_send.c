@@ -178,8 +178,8 @@ void Sv_Unicast(const g_entity_t *ent, const _Bool reliable) {
  * then clears sv.multicast.
  */
 void Sv_Multicast(const vec3_t origin, multicast_t to, EntityFilterFunc filter) {
-	byte vis[MAX_BSP_LEAFS >> 3];
-	int32_t area;
+	int32_t cluster = -1, area = 0;
+	_Bool phs = false;
 
 	if (!origin) {
 		origin = vec3_origin;
@@ -192,31 +192,19 @@ void Sv_Multicast(const vec3_t origin, multicast_t to, EntityFilterFunc filter)
 			reliable = true;
                         /* FALLTHRU */
 		case MULTICAST_ALL:
-			memset(vis, 1, sizeof(vis));
-			area = 0;
 			break;
 
 		case MULTICAST_PHS_R:
 			reliable = true;
                         /* FALLTHRU */
-		case MULTICAST_PHS: {
-				const int32_t leaf = Cm_PointLeafnum(origin, 0);
-				const int32_t cluster = Cm_LeafCluster(leaf);
-				Cm_ClusterPHS(cluster, vis);
-				area = Cm_LeafArea(leaf);
-			}
-
+		case MULTICAST_PHS:
+			phs = true;
 			break;
 
 		case MULTICAST_PVS_R:
 			reliable = true;
                         /* FALLTHRU */
-		case MULTICAST_PVS: {
-				const int32_t leaf = Cm_PointLeafnum(origin, 0);
-				const int32_t cluster = Cm_LeafCluster(leaf);
-				Cm_ClusterPVS(cluster, vis);
-				area = Cm_LeafArea(leaf);
-			}
+		case MULTICAST_PVS:
 			break;
 
 		default:
@@ -225,6 +213,13 @@ void Sv_Multicast(const vec3_t origin, multicast_t to, EntityFilterFunc filter)
 			return;
 	}
 
+	if (to != MULTICAST_ALL && to != MULTICAST_ALL_R) {
+		const int32_t leaf = Cm_PointLeafnum(origin, 0);
+
+		cluster = Cm_LeafCluster(leaf);
+		area = Cm_LeafArea(leaf);
+	}
+
 	// send the data to all relevant clients
 	sv_client_t *cl = svs.clients;
 	for (int32_t j = 0; j < sv_max_clients->integer; j++, cl++) {
@@ -242,21 +237,17 @@ void Sv_Multicast(const vec3_t origin, multicast_t to, EntityFilterFunc filter)
 		}
 
 		if (to != MULTICAST_ALL && to != MULTICAST_ALL_R) {
-			const pm_state_t *pm = &cl->entity->client->ps.pm_state;
-			vec3_t org, off;
-
-			UnpackVector(pm->view_offset, off);
-			VectorAdd(pm->origin, off, org);
-
-			const int32_t leaf = Cm_PointLeafnum(org, 0);
+			const sv_client_vis_t *client_vis = Sv_ClientVis(cl);
 
-			const int32_t client_area = Cm_LeafArea(leaf);
-			if (!Cm_AreasConnected(area, client_area)) {
+			if (!Cm_AreasConnected(area, client_vis->area)) {
 				continue;
 			}
 
-			const int32_t cluster = Cm_LeafCluster(leaf);
-			if (!(vis[cluster >> 3] & (1 << (cluster & 7)))) {
+			// rows are valid until the next lookup, which resolving the client may make
+			const byte *vis = phs ? Sv_ClusterPHS(cluster) : Sv_ClusterPVS(cluster);
+
+			const int32_t c = client_vis->cluster;
+			if (!(vis[c >> 3] & (1 << (c & 7)))) {
 				continue;
 			}
 		}
@@ -350,27 +341,24 @@ void Sv_PositionedSound(const vec3_t origin, const g_entity_t *ent, const uint16
 }
 
 /**
- * @brief
+ * @brief Sends the client's frame, which has been written by Sv_WriteClientFrames,
+ * and its datagram.
  */
 static void Sv_SendClientDatagram(sv_client_t *cl) {
-	byte buffer[MAX_MSG_SIZE];
-	mem_buf_t buf;
 
-	Sv_BuildClientFrame(cl);
-
-	Mem_InitBuffer(&buf, buffer, sizeof(buffer));
-	buf.allow_overflow = true;
+	// the datagram messages follow the frame
+	mem_buf_t buf = cl->frame_message;
 
 	// accumulate the total size for rate throttling
 	size_t frame_size = 0;
 
-	// send over all the relevant entity_state_t and the player_state_t
-	Sv_WriteClientFrame(cl, &buf);
-
 	// the frame itself (player state and delta entities) must fit into a single message,
-	// since it is parsed as a single command by the client
-	if (buf.overflowed || buf.size > MAX_MSG_SIZE - 16) {
-		Com_Error(ERROR_DROP, "Frame exceeds MAX_MSG_SIZE (%u)\n", (uint32_t) buf.size);
+	// since it is parsed as a single command by the client, but the net channel will
+	// fragment that message if the client supports it
+	const size_t max_size = buf.max_size - 16;
+
+	if (buf.overflowed || buf.size > max_size) {
+		Com_Error(ERROR_DROP, "Frame exceeds %u bytes (%u)\n", (uint32_t) max_size, (uint32_t) buf.size);
 	}
 
 	// but we can packetize the remaining datagram messages, which are parsed individually
@@ -379,7 +367,7 @@ static void Sv_SendClientDatagram(sv_client_t *cl) {
 		const sv_client_message_t *msg = (sv_client_message_t *) e->data;
 
 		// if we would overflow the packet, flush it first
-		if (buf.size + msg->len > (MAX_MSG_SIZE - 16)) {
+		if (buf.size + msg->len > max_size) {
 			Com_Debug(DEBUG_SERVER, "Fragmenting datagram @ %u bytes\n", (uint32_t) buf.size);
 
 			Netchan_Transmit(&cl->net_chan, buf.data, buf.size);
@@ -499,8 +487,8 @@ static size_t Sv_GetDemoMessage(byte *buffer) {
 		return 0;
 	}
 
-	if (size > MAX_MSG_SIZE) { // corrupt demo file
-		Com_Warn("%d > MAX_MSG_SIZE\n", size);
+	if (size > MAX_FRAGMENTED_MSG_SIZE) { // corrupt demo file
+		Com_Warn("%d > MAX_FRAGMENTED_MSG_SIZE\n", size);
 		Sv_DemoCompleted();
 		return 0;
 	}
@@ -516,10 +504,28 @@ static size_t Sv_GetDemoMessage(byte *buffer) {
 	return size;
 }
 
+/**
+ * @brief Clears the client's datagram for the next frame.
+ */
+static void Sv_ClearClientDatagram(sv_client_t *cl) {
+
+	Mem_ClearBuffer(&cl->datagram.buffer);
+
+	if (cl->datagram.messages) {
+		g_list_free_full(cl->datagram.messages, g_free);
+	}
+
+	cl->datagram.messages = NULL;
+}
+
 /**
  * @brief Send the frame and all pending datagram messages since the last frame.
+ * The frames of active clients are built and written across the thread pool,
+ * and then sent in client order.
  */
 void Sv_SendClientPackets(void) {
+	sv_client_t *clients[MAX_CLIENTS];
+	size_t num_clients = 0;
 	sv_client_t *cl;
 	int32_t i;
 
@@ -527,6 +533,9 @@ void Sv_SendClientPackets(void) {
 		return;
 	}
 
+	// queue the datagrams, so that they are sent in as few system calls as possible
+	Net_BeginBatch(NS_UDP_SERVER);
+
 	// send a message to each connected client
 	for (i = 0, cl = svs.clients; i < sv_max_clients->integer; i++, cl++) {
 
@@ -542,7 +551,7 @@ void Sv_SendClientPackets(void) {
 		}
 
 		if (sv.state == SV_ACTIVE_DEMO) { // send the demo packet
-			byte buffer[MAX_MSG_SIZE];
+			byte buffer[MAX_FRAGMENTED_MSG_SIZE];
 			size_t size;
 
 			if ((size = Sv_GetDemoMessage(buffer))) {
@@ -554,23 +563,26 @@ void Sv_SendClientPackets(void) {
 
 			if (Sv_RateDrop(cl)) { // enforce rate throttle
 				cl->frame_size[sv.frame_num % lengthof(cl->frame_size)] = 0;
+				Sv_ClearClientDatagram(cl);
 			} else {
-				Sv_SendClientDatagram(cl);
+				clients[num_clients++] = cl;
 			}
 
-			// clean up for the next frame
-			Mem_ClearBuffer(&cl->datagram.buffer);
-
-			if (cl->datagram.messages) {
-				g_list_free_full(cl->datagram.messages, g_free);
-			}
-
-			cl->datagram.messages = NULL;
-
 		} else if (cl->net_chan.message.size) { // update reliable
 			Netchan_Transmit(&cl->net_chan, NULL, 0);
 		} else if (quetoo.ticks - cl->net_chan.last_sent > 1000) { // or just don't timeout
 			Netchan_Transmit(&cl->net_chan, NULL, 0);
 		}
 	}
+
+	// build and write the frames concurrently
+	Sv_WriteClientFrames(clients, num_clients);
+
+	// and send them, along with their datagrams
+	for (size_t j = 0; j < num_clients; j++) {
+		Sv_SendClientDatagram(clients[j]);
+		Sv_ClearClientDatagram(clients[j]);
+	}
+
+	Net_FlushBatch(NS_UDP_SERVER);
 }
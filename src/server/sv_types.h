@@ -53,7 +53,7 @@ typedef struct {
 	int32_t num_clusters; // if -1, use top_node
 
 	int32_t areas[2];
-	struct sv_sector_s *sector;
+	struct sv_world_node_s *node;
 
 	matrix4x4_t matrix;
 	matrix4x4_t inverse_matrix;
@@ -101,10 +101,33 @@ typedef struct {
 	byte area_bits[MAX_BSP_AREAS >> 3]; // portal area visibility bits
 	player_state_t ps;
 	uint16_t num_entities;
-	uint32_t entity_state; // index into svs.entity_states array
+	uint32_t entity_state; // index into the client's partition of svs.entity_states
 	uint32_t sent_time; // for ping calculations
 } sv_frame_t;
 
+/**
+ * @brief A frame retained beyond PACKET_BACKUP, once the client has confirmed
+ * that it holds a copy of it. A client that falls too far behind is delta'd
+ * from its acknowledged frame rather than from the baselines. The frame's
+ * entity_state indexes entity_states, rather than svs.entity_states.
+ */
+typedef struct {
+	int32_t frame_num; // 0 if unset
+	sv_frame_t frame;
+	entity_state_t entity_states[MAX_PACKET_ENTITIES];
+} sv_cached_frame_t;
+
+/**
+ * @brief Each client's frames are built concurrently, so each client is given
+ * its own partition of svs.entity_states, large enough for its frame backup.
+ */
+#define SV_CLIENT_ENTITY_STATES (PACKET_BACKUP * MAX_PACKET_ENTITIES)
+
+/**
+ * @brief The minimum number of frames between cached frames.
+ */
+#define SV_CACHED_FRAME_INTERVAL (PACKET_BACKUP >> 2)
+
 /**
  * @brief Clients are dropped after 20 seconds without receiving a packet.
  */
@@ -169,6 +192,21 @@ typedef struct {
 	int32_t count;
 } sv_client_download_t;
 
+/**
+ * @brief The client's visibility, resolved from its view origin by Sv_ClientVis.
+ * It is resolved again only when the view origin changes.
+ */
+typedef struct {
+	_Bool resolved; // false until resolved for the current level
+	vec3_t origin; // the view origin the visibility was resolved for
+
+	int32_t leaf, cluster, area; // at the view origin
+
+	// the combined visibility of the clusters around the view origin
+	byte pvs[MAX_BSP_LEAFS >> 3];
+	byte phs[MAX_BSP_LEAFS >> 3];
+} sv_client_vis_t;
+
 /**
  * @brief Per-client accounting for protocol flow control and low-level
  * connection state management.
@@ -176,6 +214,8 @@ typedef struct {
 typedef struct {
 	sv_client_state_t state;
 
+	uint16_t protocol; // the protocol major version the client connected with
+
 	char user_info[MAX_USER_INFO_STRING]; // name, skin, etc
 
 	int32_t last_frame; // for delta compression
@@ -191,6 +231,7 @@ typedef struct {
 	uint32_t suppress_count; // number of messages rate suppressed
 
 	g_entity_t *entity; // the g_entity_t for this client
+	sv_client_vis_t vis; // the client's visibility, see Sv_ClientVis
 	char name[32]; // extracted from user_info, high bits masked
 	int32_t message_level; // for filtering printed messages
 
@@ -200,6 +241,15 @@ typedef struct {
 	sv_client_datagram_t datagram;
 
 	sv_frame_t frames[PACKET_BACKUP]; // updates can be delta'd from here
+	uint32_t next_entity_state; // the next entity state in this client's partition
+
+	// the frame is built and written concurrently with other clients' frames,
+	// and then sent serially along with the datagram, fragmented if necessary
+	mem_buf_t frame_message;
+	byte frame_message_data[MAX_FRAGMENTED_MSG_SIZE];
+
+	sv_cached_frame_t acked_frame; // cached by the client, delta'd from when frames are too old
+	sv_cached_frame_t pending_frame; // the client has been asked to cache this frame
 
 	sv_client_download_t download; // UDP file downloads
 
@@ -245,11 +295,10 @@ typedef struct {
 	// the server maintains an array of entity states it uses to calculate
 	// delta compression from frame to frame
 
-	// the size of this array is based on the number of clients we might be
-	// asked to support at any point in time during the current game
+	// the array is partitioned by client, so that each client's frames may be
+	// built without contending for the next entity state
 
-	uint32_t num_entity_states; // sv_max_clients->integer * UPDATE_BACKUP * MAX_PACKET_ENTITIES
-	uint32_t next_entity_state; // next entity_state to use for newly spawned entities
+	uint32_t num_entity_states; // sv_max_clients->integer * SV_CLIENT_ENTITY_STATES
 	entity_state_t *entity_states; // entity states array used for delta compression
 
 	net_addr_t masters[MAX_MASTERS];
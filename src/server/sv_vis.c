@@ -0,0 +1,230 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "sv_local.h"
+
+/**
+ * @brief The size, in bytes, of the decompressed visibility row cache.
+ */
+#define SV_VIS_CACHE_SIZE (MAX_BSP_LEAFS * 32)
+
+/**
+ * @brief A decompressed visibility row within the cache.
+ */
+typedef struct {
+	uint32_t generation; // the generation the row was decompressed in
+	uint32_t offset; // the offset of the row within the cache
+} sv_vis_row_t;
+
+/**
+ * @brief Decompressed PVS and PHS rows, shared by client frames, multicasts
+ * and the game's visibility tests. The cache is emptied each frame, so that
+ * its size is bounded by the clusters actually referenced in a frame, and
+ * each row is decompressed at most once per frame while the cache has room.
+ */
+typedef struct {
+	size_t row_size; // the size of a decompressed row, in bytes
+
+	uint32_t frame_num; // the frame the cache was populated in
+	uint32_t generation; // incremented when the cache is emptied
+
+	sv_vis_row_t rows[MAX_BSP_LEAFS][DVIS_PHS + 1];
+
+	byte cache[SV_VIS_CACHE_SIZE];
+	size_t cache_size; // the used size of the cache
+
+	byte scratch[DVIS_PHS + 1][MAX_BSP_LEAFS >> 3]; // used once the cache is full
+	byte empty[MAX_BSP_LEAFS >> 3]; // for invalid clusters
+
+	uint32_t lookups; // the rows requested this frame
+	uint32_t decompressions; // the rows decompressed this frame
+} sv_vis_t;
+
+static sv_vis_t sv_vis;
+
+/**
+ * @brief Empties the visibility cache for a newly loaded level. This is called
+ * after the collision model is loaded, and before any entities are spawned.
+ */
+void Sv_InitVis(void) {
+
+	memset(&sv_vis, 0, sizeof(sv_vis));
+
+	sv_vis.row_size = Cm_ClusterPVS(-1, sv_vis.empty);
+
+	sv_vis.frame_num = sv.frame_num;
+	sv_vis.generation = 1;
+}
+
+/**
+ * @return The decompressed row for the specified cluster and visibility type,
+ * from the cache if possible. The row is valid until the next lookup.
+ */
+static const byte *Sv_ClusterVis(const int32_t cluster, const int32_t type) {
+
+	if (sv_vis.frame_num != sv.frame_num) {
+		sv_vis.frame_num = sv.frame_num;
+		sv_vis.generation++;
+
+		sv_vis.cache_size = 0;
+
+		sv_vis.lookups = 0;
+		sv_vis.decompressions = 0;
+	}
+
+	sv_vis.lookups++;
+
+	if (cluster < 0 || cluster >= MAX_BSP_LEAFS) {
+		return sv_vis.empty;
+	}
+
+	// if the collision model has decompressed every row, simply use those
+	const byte *matrix_row = type == DVIS_PVS ? Cm_ClusterPVSRow(cluster) : Cm_ClusterPHSRow(cluster);
+	if (matrix_row) {
+		return matrix_row;
+	}
+
+	sv_vis_row_t *row = &sv_vis.rows[cluster][type];
+
+	if (row->generation == sv_vis.generation) {
+		return sv_vis.cache + row->offset;
+	}
+
+	byte *out;
+
+	if (sv_vis.cache_size + sv_vis.row_size <= sizeof(sv_vis.cache)) {
+		row->generation = sv_vis.generation;
+		row->offset = (uint32_t) sv_vis.cache_size;
+
+		out = sv_vis.cache + sv_vis.cache_size;
+		sv_vis.cache_size += sv_vis.row_size;
+	} else {
+		out = sv_vis.scratch[type];
+	}
+
+	if (type == DVIS_PVS) {
+		Cm_ClusterPVS(cluster, out);
+	} else {
+		Cm_ClusterPHS(cluster, out);
+	}
+
+	sv_vis.decompressions++;
+	return out;
+}
+
+/**
+ * @return The PVS row for the specified cluster. The row is valid until the next
+ * lookup, and must not be modified.
+ */
+const byte *Sv_ClusterPVS(const int32_t cluster) {
+	return Sv_ClusterVis(cluster, DVIS_PVS);
+}
+
+/**
+ * @return The PHS row for the specified cluster. The row is valid until the next
+ * lookup, and must not be modified.
+ */
+const byte *Sv_ClusterPHS(const int32_t cluster) {
+	return Sv_ClusterVis(cluster, DVIS_PHS);
+}
+
+/**
+ * @brief Resolves the visibility for the bounding box around the client's view
+ * origin. The bounding box provides some leniency because the client's actual
+ * view origin is likely slightly different than what we think it is. Clients
+ * are resolved again only when their view origin changes, and never concurrently.
+ */
+const sv_client_vis_t *Sv_ClientVis(sv_client_t *client) {
+	int32_t leafs[MAX_ENT_LEAFS];
+	int32_t clusters[MAX_ENT_CLUSTERS];
+	size_t num_clusters = 0;
+	vec3_t org, off, mins, maxs;
+
+	sv_client_vis_t *vis = &client->vis;
+
+	const pm_state_t *pm = &client->entity->client->ps.pm_state;
+	UnpackVector(pm->view_offset, off);
+	VectorAdd(pm->origin, off, org);
+
+	if (vis->resolved && VectorCompare(org, vis->origin)) {
+		return vis;
+	}
+
+	vis->resolved = true;
+	VectorCopy(org, vis->origin);
+
+	vis->leaf = Cm_PointLeafnum(org, 0);
+	vis->cluster = Cm_LeafCluster(vis->leaf);
+	vis->area = Cm_LeafArea(vis->leaf);
+
+	memset(vis->pvs, 0, sv_vis.row_size);
+	memset(vis->phs, 0, sv_vis.row_size);
+
+	// spread the bounds to account for view offset
+	for (int32_t i = 0; i < 3; i++) {
+		mins[i] = org[i] - 16.0;
+		maxs[i] = org[i] + 16.0;
+	}
+
+	const size_t len = Cm_BoxLeafnums(mins, maxs, leafs, lengthof(leafs), NULL, 0);
+	if (len == 0) {
+		Com_Warn("Bad leaf count for client @ %s\n", vtos(org));
+		return vis;
+	} else if (len == lengthof(leafs)) {
+		Com_Warn("MAX_ENT_LEAFS for client @ %s\n", vtos(org));
+	}
+
+	// convert leafs to clusters and combine their visibility data
+	for (size_t i = 0; i < len; i++) {
+
+		const int32_t cluster = Cm_LeafCluster(leafs[i]);
+
+		size_t j;
+		for (j = 0; j < num_clusters; j++) {
+			if (clusters[j] == cluster) {
+				break;
+			}
+		}
+
+		if (j < num_clusters) { // already got it
+			continue;
+		}
+
+		clusters[num_clusters++] = cluster;
+
+		const byte *pvs = Sv_ClusterPVS(cluster);
+		for (size_t n = 0; n < sv_vis.row_size; n++) {
+			vis->pvs[n] |= pvs[n];
+		}
+
+		const byte *phs = Sv_ClusterPHS(cluster);
+		for (size_t n = 0; n < sv_vis.row_size; n++) {
+			vis->phs[n] |= phs[n];
+		}
+
+		if (num_clusters == lengthof(clusters)) {
+			Com_Warn("MAX_ENT_CLUSTERS for client @ %s\n", vtos(org));
+			break;
+		}
+	}
+
+	return vis;
+}
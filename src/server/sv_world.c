@@ -22,87 +22,301 @@
 #include "sv_local.h"
 
 /**
- * @brief The world is divided into evenly sized sectors to aid in entity
- * management. This works like a meta-BSP tree, providing fast searches via
- * recursion to find entities within an arbitrary box.
+ * @brief Solid entities are kept in a dynamic bounding volume hierarchy: a
+ * binary tree of axis-aligned boxes, whose leafs are entities, and whose nodes
+ * bound their children. Leafs are fattened so that entities may move a little
+ * without the tree being updated, and the tree is kept balanced by rotating
+ * nodes as leafs are inserted and removed.
  */
-typedef struct sv_sector_s {
-	int32_t axis; // -1 = leaf
-	vec_t dist;
-	struct sv_sector_s *children[2];
-	GList *entities;
-} sv_sector_t;
+typedef struct sv_world_node_s {
+	vec3_t mins, maxs;
+	struct sv_world_node_s *parent; // the next free node, for free nodes
+	struct sv_world_node_s *children[2];
+	int32_t height; // 0 for leafs
+	g_entity_t *ent; // leafs only
+} sv_world_node_t;
+
+#define WORLD_NODES			(MAX_ENTITIES * 2)
+#define WORLD_NODE_MARGIN	8.0
+#define WORLD_NODE_MAX_DISPLACEMENT	64.0
 
-#define SECTOR_DEPTH	4
-#define SECTOR_NODES	32
+/**
+ * @brief The world structure contains all nodes.
+ */
+typedef struct {
+	sv_world_node_t nodes[WORLD_NODES];
+	sv_world_node_t *free_nodes;
+	sv_world_node_t *root;
+} sv_world_t;
+
+static sv_world_t sv_world;
 
 /**
- * @brief The world structure contains all sectors and also the current query
- * context issued to Sv_BoxEntities.
+ * @brief A query issued to Sv_BoxEntities. Queries are passed explicitly, rather
+ * than through the world, so that Sv_BoxEntities, Sv_PointContents and Sv_Trace
+ * are reentrant. They may run concurrently from any number of threads, but not
+ * concurrently with Sv_LinkEntity or Sv_UnlinkEntity.
  */
 typedef struct {
-	sv_sector_t sectors[SECTOR_NODES];
-	uint16_t num_sectors;
+	const vec_t *mins, *maxs;
 
-	const vec_t *box_mins, *box_maxs;
+	g_entity_t **entities;
+	size_t num_entities, max_entities;
 
-	g_entity_t **box_entities;
-	size_t num_box_entities, max_box_entities;
+	uint32_t type; // BOX_SOLID, BOX_TRIGGER, ..
 
-	uint32_t box_type; // BOX_SOLID, BOX_TRIGGER, ..
-} sv_world_t;
+	_Bool full; // true once max_entities is reached, ending the query
+} sv_box_query_t;
 
-static sv_world_t sv_world;
+/**
+ * @brief Clears the world and its free list for a newly loaded level. This is
+ * called prior to linking any entities.
+ */
+void Sv_InitWorld(void) {
+
+	memset(&sv_world, 0, sizeof(sv_world));
+
+	for (int32_t i = 0; i < WORLD_NODES - 1; i++) {
+		sv_world.nodes[i].parent = &sv_world.nodes[i + 1];
+	}
+
+	sv_world.free_nodes = sv_world.nodes;
+}
+
+/**
+ * @return A node from the free list.
+ */
+static sv_world_node_t *Sv_AllocWorldNode(void) {
+
+	sv_world_node_t *node = sv_world.free_nodes;
+	if (!node) {
+		Com_Error(ERROR_DROP, "WORLD_NODES\n");
+	}
+
+	sv_world.free_nodes = node->parent;
+
+	memset(node, 0, sizeof(*node));
+	return node;
+}
 
 /**
- * @brief Builds a uniformly subdivided tree for the given world size.
+ * @brief Returns the node to the free list.
  */
-static sv_sector_t *Sv_CreateSector(int32_t depth, vec3_t mins, vec3_t maxs) {
-	vec3_t size, mins1, maxs1, mins2, maxs2;
+static void Sv_FreeWorldNode(sv_world_node_t *node) {
+
+	memset(node, 0, sizeof(*node));
 
-	sv_sector_t *sector = &sv_world.sectors[sv_world.num_sectors];
-	sv_world.num_sectors++;
+	node->parent = sv_world.free_nodes;
+	sv_world.free_nodes = node;
+}
 
-	if (depth == SECTOR_DEPTH) {
-		sector->axis = -1;
-		sector->children[0] = sector->children[1] = NULL;
-		return sector;
+/**
+ * @brief Calculates the union of the specified bounds.
+ */
+static void Sv_UnionBounds(const vec3_t mins0, const vec3_t maxs0, const vec3_t mins1, const vec3_t maxs1,
+                           vec3_t mins, vec3_t maxs) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		mins[i] = MIN(mins0[i], mins1[i]);
+		maxs[i] = MAX(maxs0[i], maxs1[i]);
 	}
+}
+
+/**
+ * @return True if the inner bounds are contained by the outer bounds.
+ */
+static _Bool Sv_BoundsContain(const vec3_t outer_mins, const vec3_t outer_maxs, const vec3_t inner_mins,
+                              const vec3_t inner_maxs) {
+
+	for (int32_t i = 0; i < 3; i++) {
+		if (inner_mins[i] < outer_mins[i] || inner_maxs[i] > outer_maxs[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @return The cost of a node with the specified bounds, which is half of its
+ * surface area. The likelihood of a query visiting a node is proportional to it.
+ */
+static vec_t Sv_WorldNodeCost(const vec3_t mins, const vec3_t maxs) {
+	vec3_t size;
 
 	VectorSubtract(maxs, mins, size);
-	if (size[0] > size[1]) {
-		sector->axis = 0;
+
+	return size[0] * size[1] + size[1] * size[2] + size[2] * size[0];
+}
+
+/**
+ * @return The cost of the union of the specified node and bounds.
+ */
+static vec_t Sv_WorldNodeUnionCost(const sv_world_node_t *node, const vec3_t mins, const vec3_t maxs) {
+	vec3_t union_mins, union_maxs;
+
+	Sv_UnionBounds(node->mins, node->maxs, mins, maxs, union_mins, union_maxs);
+
+	return Sv_WorldNodeCost(union_mins, union_maxs);
+}
+
+/**
+ * @brief Updates the bounds and height of the specified node from its children.
+ */
+static void Sv_RefitWorldNode(sv_world_node_t *node) {
+	const sv_world_node_t *a = node->children[0], *b = node->children[1];
+
+	Sv_UnionBounds(a->mins, a->maxs, b->mins, b->maxs, node->mins, node->maxs);
+
+	node->height = 1 + MAX(a->height, b->height);
+}
+
+/**
+ * @brief Replaces the child of the specified node's parent, or the root, with the
+ * specified node.
+ */
+static void Sv_ReplaceWorldNode(sv_world_node_t *parent, const sv_world_node_t *child, sv_world_node_t *node) {
+
+	node->parent = parent;
+
+	if (parent) {
+		if (parent->children[0] == child) {
+			parent->children[0] = node;
+		} else {
+			parent->children[1] = node;
+		}
+	} else {
+		sv_world.root = node;
+	}
+}
+
+/**
+ * @brief Promotes the taller grandchild of an unbalanced node, so that the
+ * heights of its children differ by at most one.
+ *
+ * @return The root of the balanced subtree.
+ */
+static sv_world_node_t *Sv_BalanceWorldNode(sv_world_node_t *node) {
+
+	if (node->height < 2) {
+		return node;
+	}
+
+	const int32_t balance = node->children[1]->height - node->children[0]->height;
+	if (balance >= -1 && balance <= 1) {
+		return node;
+	}
+
+	// the taller child takes the node's place, and the node takes its shorter child
+	const int32_t i = balance > 1 ? 1 : 0;
+
+	sv_world_node_t *child = node->children[i];
+	sv_world_node_t *a = child->children[0], *b = child->children[1];
+
+	Sv_ReplaceWorldNode(node->parent, node, child);
+
+	child->children[i ^ 1] = node;
+	node->parent = child;
+
+	if (a->height > b->height) {
+		child->children[i] = a;
+		node->children[i] = b;
+		b->parent = node;
 	} else {
-		sector->axis = 1;
+		child->children[i] = b;
+		node->children[i] = a;
+		a->parent = node;
 	}
 
-	sector->dist = 0.5 * (maxs[sector->axis] + mins[sector->axis]);
-	VectorCopy(mins, mins1);
-	VectorCopy(mins, mins2);
-	VectorCopy(maxs, maxs1);
-	VectorCopy(maxs, maxs2);
+	Sv_RefitWorldNode(node);
+	Sv_RefitWorldNode(child);
+
+	return child;
+}
 
-	maxs1[sector->axis] = mins2[sector->axis] = sector->dist;
+/**
+ * @brief Refits and balances the ancestors of a node that has changed.
+ */
+static void Sv_RefitWorldNodes(sv_world_node_t *node) {
 
-	sector->children[0] = Sv_CreateSector(depth + 1, mins2, maxs2);
-	sector->children[1] = Sv_CreateSector(depth + 1, mins1, maxs1);
+	while (node) {
+		node = Sv_BalanceWorldNode(node);
+		Sv_RefitWorldNode(node);
 
-	return sector;
+		node = node->parent;
+	}
 }
 
 /**
- * @brief Resolve our area nodes for a newly loaded level. This is called prior to
- * linking any entities.
+ * @brief Inserts the specified leaf, pairing it with the sibling which least
+ * increases the total cost of the tree.
  */
-void Sv_InitWorld(void) {
+static void Sv_InsertWorldNode(sv_world_node_t *leaf) {
 
-	for (uint16_t i = 0; i < sv_world.num_sectors; i++) {
-		g_list_free(sv_world.sectors[i].entities);
+	if (!sv_world.root) {
+		sv_world.root = leaf;
+		leaf->parent = NULL;
+		return;
 	}
 
-	memset(&sv_world, 0, sizeof(sv_world));
+	sv_world_node_t *sibling = sv_world.root;
+	while (sibling->height) {
+
+		const vec_t cost = Sv_WorldNodeCost(sibling->mins, sibling->maxs);
+		const vec_t union_cost = Sv_WorldNodeUnionCost(sibling, leaf->mins, leaf->maxs);
+
+		// pairing with this node creates a parent of the union cost, while
+		// descending further grows this node by the difference
+		const vec_t inherited_cost = union_cost - cost;
+
+		vec_t child_cost[2];
+		for (int32_t i = 0; i < 2; i++) {
+			const sv_world_node_t *child = sibling->children[i];
+
+			child_cost[i] = Sv_WorldNodeUnionCost(child, leaf->mins, leaf->maxs) + inherited_cost;
+
+			if (child->height) {
+				child_cost[i] -= Sv_WorldNodeCost(child->mins, child->maxs);
+			}
+		}
 
-	Sv_CreateSector(0, sv.cm_models[0]->mins, sv.cm_models[0]->maxs);
+		if (union_cost < child_cost[0] && union_cost < child_cost[1]) {
+			break;
+		}
+
+		sibling = sibling->children[child_cost[0] < child_cost[1] ? 0 : 1];
+	}
+
+	sv_world_node_t *parent = Sv_AllocWorldNode();
+
+	Sv_ReplaceWorldNode(sibling->parent, sibling, parent);
+
+	parent->children[0] = sibling;
+	parent->children[1] = leaf;
+
+	sibling->parent = leaf->parent = parent;
+
+	Sv_RefitWorldNodes(parent);
+}
+
+/**
+ * @brief Removes the specified leaf, promoting its sibling to its parent's place.
+ */
+static void Sv_RemoveWorldNode(sv_world_node_t *leaf) {
+
+	if (leaf == sv_world.root) {
+		sv_world.root = NULL;
+		return;
+	}
+
+	sv_world_node_t *parent = leaf->parent;
+	sv_world_node_t *sibling = parent->children[parent->children[0] == leaf ? 1 : 0];
+
+	Sv_ReplaceWorldNode(parent->parent, parent, sibling);
+
+	Sv_FreeWorldNode(parent);
+
+	Sv_RefitWorldNodes(sibling->parent);
 }
 
 /**
@@ -113,9 +327,9 @@ void Sv_UnlinkEntity(g_entity_t *ent) {
 
 	sv_entity_t *sent = &sv.entities[NUM_FOR_ENTITY(ent)];
 
-	if (sent->sector) {
-		sv_sector_t *sector = (sv_sector_t *) sent->sector;
-		sector->entities = g_list_remove(sector->entities, ent);
+	if (sent->node) {
+		Sv_RemoveWorldNode(sent->node);
+		Sv_FreeWorldNode(sent->node);
 
 		memset(sent, 0, sizeof(*sent));
 	}
@@ -133,11 +347,13 @@ void Sv_LinkEntity(g_entity_t *ent) {
 		return;
 	}
 
-	// remove it from its current sector
-	Sv_UnlinkEntity(ent);
+	// remove it from the world if it's no longer solid
+	if (!ent->in_use || ent->solid == SOLID_NOT) {
+		Sv_UnlinkEntity(ent);
 
-	if (!ent->in_use) { // and if its free, we're done
-		return;
+		if (!ent->in_use) { // and if its free, we're done
+			return;
+		}
 	}
 
 	// set the size
@@ -157,10 +373,15 @@ void Sv_LinkEntity(g_entity_t *ent) {
 			break;
 	}
 
+	sv_entity_t *sent = &sv.entities[NUM_FOR_ENTITY(ent)];
+
 	// set the absolute bounding box; ensure it is symmetrical
+	vec3_t displacement;
+	VectorCopy(ent->abs_mins, displacement);
+
 	Cm_EntityBounds(ent->solid, ent->s.origin, ent->s.angles, ent->mins, ent->maxs, ent->abs_mins, ent->abs_maxs);
 
-	sv_entity_t *sent = &sv.entities[NUM_FOR_ENTITY(ent)];
+	VectorSubtract(ent->abs_mins, displacement, displacement);
 
 	// link to PVS leafs
 	sent->num_clusters = 0;
@@ -219,43 +440,67 @@ void Sv_LinkEntity(g_entity_t *ent) {
 		return;
 	}
 
-	// find the first sector that the ent's box crosses
-	sv_sector_t *sector = sv_world.sectors;
-	while (true) {
+	// fatten its bounds, anticipating its next move from its last
+	vec3_t mins, maxs;
+	for (int32_t i = 0; i < 3; i++) {
+		mins[i] = ent->abs_mins[i] - WORLD_NODE_MARGIN;
+		maxs[i] = ent->abs_maxs[i] + WORLD_NODE_MARGIN;
 
-		if (sector->axis == -1) {
-			break;
+		if (sent->node) {
+			const vec_t d = Clamp(displacement[i], -WORLD_NODE_MAX_DISPLACEMENT, WORLD_NODE_MAX_DISPLACEMENT);
+			if (d < 0.0) {
+				mins[i] += d;
+			} else {
+				maxs[i] += d;
+			}
+		}
+	}
+
+	// and if it has outgrown its leaf, or its leaf is now far too loose, reinsert it
+	sv_world_node_t *leaf = sent->node;
+
+	if (leaf) {
+		vec3_t loose_mins, loose_maxs;
+
+		for (int32_t i = 0; i < 3; i++) {
+			loose_mins[i] = mins[i] - WORLD_NODE_MARGIN * 4.0;
+			loose_maxs[i] = maxs[i] + WORLD_NODE_MARGIN * 4.0;
 		}
 
-		if (ent->abs_mins[sector->axis] > sector->dist) {
-			sector = sector->children[0];
-		} else if (ent->abs_maxs[sector->axis] < sector->dist) {
-			sector = sector->children[1];
+		if (Sv_BoundsContain(leaf->mins, leaf->maxs, ent->abs_mins, ent->abs_maxs) &&
+		        Sv_BoundsContain(loose_mins, loose_maxs, leaf->mins, leaf->maxs)) {
+			leaf = NULL;
 		} else {
-			break;    // crosses the node
+			Sv_RemoveWorldNode(leaf);
 		}
+	} else {
+		leaf = sent->node = Sv_AllocWorldNode();
+		leaf->ent = ent;
 	}
 
-	// add it to the sector
-	sent->sector = sector;
-	sector->entities = g_list_prepend(sector->entities, ent);
+	if (leaf) {
+		VectorCopy(mins, leaf->mins);
+		VectorCopy(maxs, leaf->maxs);
+
+		Sv_InsertWorldNode(leaf);
+	}
 
 	// and update its clipping matrices
 	const vec_t *angles = ent->solid == SOLID_BSP ? ent->s.angles : vec3_origin;
 
-	Matrix4x4_CreateFromEntity(&sent->matrix, ent->s.origin, angles, 1.0);
-	Matrix4x4_Invert_Simple(&sent->inverse_matrix, &sent->matrix);
+	Matrix4x4_CreateFromEntityf(&sent->matrix, ent->s.origin, angles, 1.0);
+	Matrix4x4_Invert_Simplef(&sent->inverse_matrix, &sent->matrix);
 }
 
 /**
- * @return True if the entity matches the current world filter, false otherwise.
+ * @return True if the entity matches the query filter, false otherwise.
  */
-static _Bool Sv_BoxEntities_Filter(const g_entity_t *ent) {
+static _Bool Sv_BoxEntities_Filter(const sv_box_query_t *query, const g_entity_t *ent) {
 
 	switch (ent->solid) {
 		case SOLID_TRIGGER:
 		case SOLID_PROJECTILE:
-			if (sv_world.box_type & BOX_OCCUPY) {
+			if (query->type & BOX_OCCUPY) {
 				return true;
 			}
 			break;
@@ -263,7 +508,7 @@ static _Bool Sv_BoxEntities_Filter(const g_entity_t *ent) {
 		case SOLID_DEAD:
 		case SOLID_BOX:
 		case SOLID_BSP:
-			if (sv_world.box_type & BOX_COLLIDE) {
+			if (query->type & BOX_COLLIDE) {
 				return true;
 			}
 			break;
@@ -276,42 +521,42 @@ static _Bool Sv_BoxEntities_Filter(const g_entity_t *ent) {
 }
 
 /**
- * @brief
+ * @brief Descends the world, appending the entities of any leafs that the query
+ * intersects.
  */
-static void Sv_BoxEntities_r(sv_sector_t *sector) {
-
-	GList *e = sector->entities;
-	while (e) {
-		g_entity_t *ent = (g_entity_t *) e->data;
+static void Sv_BoxEntities_r(sv_box_query_t *query, const sv_world_node_t *node) {
 
-		if (Sv_BoxEntities_Filter(ent)) {
-
-			if (BoxIntersect(ent->abs_mins, ent->abs_maxs, sv_world.box_mins, sv_world.box_maxs)) {
-
-				sv_world.box_entities[sv_world.num_box_entities] = ent;
-				sv_world.num_box_entities++;
+	if (query->full) {
+		return;
+	}
 
-				if (sv_world.num_box_entities == sv_world.max_box_entities) {
-					Com_Warn("sv_world.max_box_entities reached\n");
-					return;
-				}
-			}
+	for (int32_t i = 0; i < 3; i++) {
+		if (query->mins[i] > node->maxs[i] || query->maxs[i] < node->mins[i]) {
+			return;
 		}
-
-		e = e->next;
 	}
 
-	if (sector->axis == -1) {
-		return;    // terminal node
+	if (node->height) { // recurse down both sides
+		Sv_BoxEntities_r(query, node->children[0]);
+		Sv_BoxEntities_r(query, node->children[1]);
+		return;
 	}
 
-	// recurse down both sides
-	if (sv_world.box_maxs[sector->axis] > sector->dist) {
-		Sv_BoxEntities_r(sector->children[0]);
-	}
+	g_entity_t *ent = node->ent;
+
+	if (Sv_BoxEntities_Filter(query, ent)) {
+
+		if (BoxIntersect(ent->abs_mins, ent->abs_maxs, query->mins, query->maxs)) {
+
+			if (query->num_entities == query->max_entities) {
+				Com_Warn("max_entities reached\n");
+				query->full = true;
+				return;
+			}
 
-	if (sv_world.box_mins[sector->axis] < sector->dist) {
-		Sv_BoxEntities_r(sector->children[1]);
+			query->entities[query->num_entities] = ent;
+			query->num_entities++;
+		}
 	}
 }
 
@@ -325,25 +570,26 @@ static void Sv_BoxEntities_r(sv_sector_t *sector) {
 size_t Sv_BoxEntities(const vec3_t mins, const vec3_t maxs, g_entity_t **list, const size_t len,
                       const uint32_t type) {
 
-	sv_world.box_mins = mins;
-	sv_world.box_maxs = maxs;
-	sv_world.box_entities = list;
-	sv_world.num_box_entities = 0;
-	sv_world.max_box_entities = len;
-	sv_world.box_type = type;
-
-	Sv_BoxEntities_r(sv_world.sectors);
-
-	sv_world.box_mins = vec3_origin;
-	sv_world.box_maxs = vec3_origin;
-	sv_world.box_entities = NULL;
+	sv_box_query_t query = {
+		.mins = mins,
+		.maxs = maxs,
+		.entities = list,
+		.num_entities = 0,
+		.max_entities = len,
+		.type = type
+	};
+
+	if (sv_world.root) {
+		Sv_BoxEntities_r(&query, sv_world.root);
+	}
 
-	return sv_world.num_box_entities;
+	return query.num_entities;
 }
 
 /**
  * @brief Prepares the collision model to clip to the specified entity. For
- * mesh models, the box hull must be set to reflect the bounds of the entity.
+ * mesh models, the calling thread's box hull is set to reflect the bounds of
+ * the entity.
  */
 static int32_t Sv_HullForEntity(const g_entity_t *ent) {
 
@@ -378,7 +624,7 @@ static int32_t Sv_HullForEntity(const g_entity_t *ent) {
  * contents as well as contents for any solid entities this point intersects.
  */
 int32_t Sv_PointContents(const vec3_t point) {
-	g_entity_t *entities[MAX_ENTITIES];
+	static __thread g_entity_t *entities[MAX_ENTITIES];
 
 	// get base contents from world
 	int32_t contents = Cm_PointContents(point, 0);
@@ -416,7 +662,7 @@ typedef struct {
  * collision and interaction for the server. Tread carefully.
  */
 static void Sv_ClipTraceToEntities(sv_trace_t *trace) {
-	g_entity_t *e[MAX_ENTITIES];
+	static __thread g_entity_t *e[MAX_ENTITIES];
 
 	const size_t len = Sv_BoxEntities(trace->box_mins, trace->box_maxs, e, lengthof(e), BOX_COLLIDE);
 
@@ -836,6 +836,72 @@ match:
 	return *t == '\0';
 }
 
+/**
+ * @brief Compiles the specified glob pattern for repeated matching.
+ */
+void GlobCompile(const char *pattern, const glob_flags_t flags, glob_pattern_t *glob) {
+
+	memset(glob, 0, sizeof(*glob));
+
+	glob->pattern = pattern;
+	glob->flags = flags;
+
+	const char *wildcard = strpbrk(pattern, "*?[\\");
+	if (wildcard == NULL) {
+		glob->type = GLOB_LITERAL;
+		glob->prefix_len = strlen(pattern);
+		return;
+	}
+
+	glob->prefix_len = wildcard - pattern;
+
+	if (*wildcard == '*' && strpbrk(wildcard + 1, "*?[\\") == NULL) {
+		glob->type = GLOB_STAR;
+		glob->suffix = wildcard + 1;
+		glob->suffix_len = strlen(glob->suffix);
+	} else {
+		glob->type = GLOB_PATTERN;
+	}
+}
+
+/**
+ * @brief Compares the literal text of a compiled glob.
+ */
+static inline _Bool GlobMatchLiteral(const glob_pattern_t *glob, const char *a, const char *b, size_t len) {
+
+	if (glob->flags & GLOB_CASE_INSENSITIVE) {
+		return g_ascii_strncasecmp(a, b, len) == 0;
+	}
+
+	return strncmp(a, b, len) == 0;
+}
+
+/**
+ * @brief Matches the compiled glob against the specified text.
+ */
+_Bool GlobMatchCompiled(const glob_pattern_t *glob, const char *text) {
+
+	if (!GlobMatchLiteral(glob, glob->pattern, text, glob->prefix_len)) {
+		return false;
+	}
+
+	switch (glob->type) {
+		case GLOB_LITERAL:
+			return text[glob->prefix_len] == '\0';
+
+		case GLOB_STAR: {
+				const size_t len = glob->prefix_len + strlen(text + glob->prefix_len);
+				if (len < glob->prefix_len + glob->suffix_len) {
+					return false;
+				}
+				return GlobMatchLiteral(glob, glob->suffix, text + len - glob->suffix_len, glob->suffix_len);
+			}
+
+		default:
+			return GlobMatch(glob->pattern + glob->prefix_len, text + glob->prefix_len, glob->flags);
+	}
+}
+
 /**
  * @brief Returns the base name for the given file or path.
  */
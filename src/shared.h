@@ -206,7 +206,36 @@ typedef enum {
 	GLOB_CASE_INSENSITIVE = (1 << 0)
 } glob_flags_t;
 
+/**
+ * @brief A glob pattern, analyzed once by GlobCompile so that the common forms
+ * (`name`, `prefix*` and `*suffix`) match without backtracking. The pattern is
+ * borrowed, and must outlive the glob.
+ */
+typedef struct {
+	const char *pattern;
+	glob_flags_t flags;
+
+	enum {
+		GLOB_LITERAL, // no wildcards
+		GLOB_STAR, // a single `*`, and no other wildcards
+		GLOB_PATTERN // anything else, matched with GlobMatch
+	} type;
+
+	/**
+	 * @brief The length of the literal text preceding the first wildcard.
+	 */
+	size_t prefix_len;
+
+	/**
+	 * @brief The literal text following the `*` of GLOB_STAR patterns.
+	 */
+	const char *suffix;
+	size_t suffix_len;
+} glob_pattern_t;
+
 _Bool GlobMatch(const char *pattern, const char *text, const glob_flags_t flags);
+void GlobCompile(const char *pattern, const glob_flags_t flags, glob_pattern_t *glob);
+_Bool GlobMatchCompiled(const glob_pattern_t *glob, const char *text);
 const char *Basename(const char *path);
 void Dirname(const char *in, char *out);
 void StripNewline(const char *in, char *out);
@@ -0,0 +1,775 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include <SDL_cpuinfo.h>
+
+#include "simd.h"
+#include "shared.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+ #define SIMD_X86 1
+ #include <immintrin.h>
+#elif defined(__aarch64__)
+ #define SIMD_ARM 1
+ #include <arm_neon.h>
+#endif
+
+/**
+ * @brief The matrix coefficients, one row of { x, y, z, translate } per output
+ * component, regardless of the matrix orientation.
+ */
+typedef vec_t simd_matrix_t[3][4];
+
+/**
+ * @brief Each kernel processes as many elements as its vector width allows,
+ * and returns the number it processed. The remainder is finished by the
+ * scalar kernel.
+ */
+typedef struct {
+	size_t (*TransformPoints)(const simd_matrix_t m, const vec3_t *in, vec3_t *out, size_t count);
+	size_t (*NormalizeVectors)(const vec3_t *in, vec3_t *out, vec_t *lengths, size_t count);
+	size_t (*DotProducts)(const vec3_t *a, const vec3_t *b, vec_t *out, size_t count);
+	size_t (*AddPointsToBounds)(const vec3_t *points, size_t count, vec3_t mins, vec3_t maxs);
+} simd_kernels_t;
+
+static struct {
+	simd_level_t level;
+	const simd_kernels_t *kernels;
+} simd_state;
+
+/**
+ * @brief Resolves the coefficients of the specified matrix.
+ */
+static void Simd_Matrix(const matrix4x4_t *in, simd_matrix_t m) {
+
+	for (int32_t i = 0; i < 3; i++) {
+#if MATRIX4x4_OPENGLORIENTATION
+		m[i][0] = in->m[0][i];
+		m[i][1] = in->m[1][i];
+		m[i][2] = in->m[2][i];
+		m[i][3] = in->m[3][i];
+#else
+		m[i][0] = in->m[i][0];
+		m[i][1] = in->m[i][1];
+		m[i][2] = in->m[i][2];
+		m[i][3] = in->m[i][3];
+#endif
+	}
+}
+
+/**
+ * @brief Transforms the specified points, as Matrix4x4_Transform.
+ */
+static size_t Simd_TransformPoints_Scalar(const simd_matrix_t m, const vec3_t *in, vec3_t *out, size_t count) {
+
+	for (size_t i = 0; i < count; i++) {
+		const vec_t x = in[i][0], y = in[i][1], z = in[i][2];
+
+		out[i][0] = x * m[0][0] + y * m[0][1] + z * m[0][2] + m[0][3];
+		out[i][1] = x * m[1][0] + y * m[1][1] + z * m[1][2] + m[1][3];
+		out[i][2] = x * m[2][0] + y * m[2][1] + z * m[2][2] + m[2][3];
+	}
+
+	return count;
+}
+
+/**
+ * @brief Normalizes the specified vectors, as VectorNormalize2.
+ */
+static size_t Simd_NormalizeVectors_Scalar(const vec3_t *in, vec3_t *out, vec_t *lengths, size_t count) {
+
+	for (size_t i = 0; i < count; i++) {
+		const vec_t x = in[i][0], y = in[i][1], z = in[i][2];
+
+		const vec_t length = sqrtf(x * x + y * y + z * z);
+		if (length) {
+			const vec_t ilength = 1.0f / length;
+			out[i][0] = x * ilength;
+			out[i][1] = y * ilength;
+			out[i][2] = z * ilength;
+		} else {
+			out[i][0] = x;
+			out[i][1] = y;
+			out[i][2] = z;
+		}
+
+		if (lengths) {
+			lengths[i] = length;
+		}
+	}
+
+	return count;
+}
+
+/**
+ * @brief Calculates the dot products of the specified vectors, as DotProduct.
+ */
+static size_t Simd_DotProducts_Scalar(const vec3_t *a, const vec3_t *b, vec_t *out, size_t count) {
+
+	for (size_t i = 0; i < count; i++) {
+		out[i] = a[i][0] * b[i][0] + a[i][1] * b[i][1] + a[i][2] * b[i][2];
+	}
+
+	return count;
+}
+
+/**
+ * @brief Accumulates the specified points into the bounds, as AddPointToBounds.
+ */
+static size_t Simd_AddPointsToBounds_Scalar(const vec3_t *points, size_t count, vec3_t mins, vec3_t maxs) {
+
+	for (size_t i = 0; i < count; i++) {
+		AddPointToBounds(points[i], mins, maxs);
+	}
+
+	return count;
+}
+
+static const simd_kernels_t simd_kernels_scalar = {
+	.TransformPoints = Simd_TransformPoints_Scalar,
+	.NormalizeVectors = Simd_NormalizeVectors_Scalar,
+	.DotProducts = Simd_DotProducts_Scalar,
+	.AddPointsToBounds = Simd_AddPointsToBounds_Scalar,
+};
+
+#if SIMD_X86
+
+/**
+ * @brief Loads four packed vectors as their x, y and z components.
+ */
+static inline void Simd_Load_SSE2(const vec3_t *in, __m128 *x, __m128 *y, __m128 *z) {
+
+	const __m128 a = _mm_loadu_ps(in[0]); // x0 y0 z0 x1
+	const __m128 b = _mm_loadu_ps(in[1] + 1); // y1 z1 x2 y2
+	const __m128 c = _mm_loadu_ps(in[2] + 2); // z2 x3 y3 z3
+
+	const __m128 xa = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 0, 0));
+	const __m128 xb = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+	*x = _mm_shuffle_ps(xa, xb, _MM_SHUFFLE(2, 0, 2, 0));
+
+	const __m128 ya = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+	const __m128 yb = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+	*y = _mm_shuffle_ps(ya, yb, _MM_SHUFFLE(2, 0, 2, 0));
+
+	const __m128 za = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+	const __m128 zb = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+	*z = _mm_shuffle_ps(za, zb, _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+/**
+ * @brief Stores the x, y and z components of four vectors as packed vectors.
+ */
+static inline void Simd_Store_SSE2(vec3_t *out, __m128 x, __m128 y, __m128 z) {
+
+	const __m128 xy_lo = _mm_unpacklo_ps(x, y); // x0 y0 x1 y1
+	const __m128 xy_hi = _mm_unpackhi_ps(x, y); // x2 y2 x3 y3
+	const __m128 yz_lo = _mm_unpacklo_ps(y, z); // y0 z0 y1 z1
+	const __m128 yz_hi = _mm_unpackhi_ps(y, z); // y2 z2 y3 z3
+	const __m128 zx_lo = _mm_unpacklo_ps(z, x); // z0 x0 z1 x1
+	const __m128 zx_hi = _mm_unpackhi_ps(z, x); // z2 x2 z3 x3
+
+	_mm_storeu_ps(out[0], _mm_shuffle_ps(xy_lo, zx_lo, _MM_SHUFFLE(3, 0, 1, 0)));
+	_mm_storeu_ps(out[1] + 1, _mm_shuffle_ps(yz_lo, xy_hi, _MM_SHUFFLE(1, 0, 3, 2)));
+	_mm_storeu_ps(out[2] + 2, _mm_shuffle_ps(zx_hi, yz_hi, _MM_SHUFFLE(3, 2, 3, 0)));
+}
+
+/**
+ * @brief Writes the lanes of the specified registers to the bounds.
+ */
+static inline void Simd_StoreBounds_SSE2(const __m128 mins[3], const __m128 maxs[3], vec3_t out_mins, vec3_t out_maxs) {
+	vec_t lanes[4];
+
+	for (int32_t i = 0; i < 3; i++) {
+
+		_mm_storeu_ps(lanes, mins[i]);
+		for (int32_t j = 0; j < 4; j++) {
+			if (lanes[j] < out_mins[i]) {
+				out_mins[i] = lanes[j];
+			}
+		}
+
+		_mm_storeu_ps(lanes, maxs[i]);
+		for (int32_t j = 0; j < 4; j++) {
+			if (lanes[j] > out_maxs[i]) {
+				out_maxs[i] = lanes[j];
+			}
+		}
+	}
+}
+
+/**
+ * @brief SSE2 TransformPoints kernel. Multiplies and adds are issued in the
+ * scalar order, without fused multiply-add, so that results are identical.
+ */
+static size_t Simd_TransformPoints_SSE2(const simd_matrix_t m, const vec3_t *in, vec3_t *out, size_t count) {
+	__m128 c[3][4];
+
+	for (int32_t i = 0; i < 3; i++) {
+		for (int32_t j = 0; j < 4; j++) {
+			c[i][j] = _mm_set1_ps(m[i][j]);
+		}
+	}
+
+	count &= ~(size_t) 3;
+
+	for (size_t i = 0; i < count; i += 4) {
+		__m128 x, y, z, r[3];
+
+		Simd_Load_SSE2(in + i, &x, &y, &z);
+
+		for (int32_t j = 0; j < 3; j++) {
+			r[j] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, c[j][0]), _mm_mul_ps(y, c[j][1])),
+			                             _mm_mul_ps(z, c[j][2])), c[j][3]);
+		}
+
+		Simd_Store_SSE2(out + i, r[0], r[1], r[2]);
+	}
+
+	return count;
+}
+
+/**
+ * @brief SSE2 NormalizeVectors kernel.
+ */
+static size_t Simd_NormalizeVectors_SSE2(const vec3_t *in, vec3_t *out, vec_t *lengths, size_t count) {
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	count &= ~(size_t) 3;
+
+	for (size_t i = 0; i < count; i += 4) {
+		__m128 x, y, z;
+
+		Simd_Load_SSE2(in + i, &x, &y, &z);
+
+		const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+		const __m128 ilength = _mm_div_ps(one, length);
+		const __m128 mask = _mm_cmpneq_ps(length, zero);
+
+		x = _mm_or_ps(_mm_and_ps(mask, _mm_mul_ps(x, ilength)), _mm_andnot_ps(mask, x));
+		y = _mm_or_ps(_mm_and_ps(mask, _mm_mul_ps(y, ilength)), _mm_andnot_ps(mask, y));
+		z = _mm_or_ps(_mm_and_ps(mask, _mm_mul_ps(z, ilength)), _mm_andnot_ps(mask, z));
+
+		Simd_Store_SSE2(out + i, x, y, z);
+
+		if (lengths) {
+			_mm_storeu_ps(lengths + i, length);
+		}
+	}
+
+	return count;
+}
+
+/**
+ * @brief SSE2 DotProducts kernel.
+ */
+static size_t Simd_DotProducts_SSE2(const vec3_t *a, const vec3_t *b, vec_t *out, size_t count) {
+
+	count &= ~(size_t) 3;
+
+	for (size_t i = 0; i < count; i += 4) {
+		__m128 ax, ay, az, bx, by, bz;
+
+		Simd_Load_SSE2(a + i, &ax, &ay, &az);
+		Simd_Load_SSE2(b + i, &bx, &by, &bz);
+
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz)));
+	}
+
+	return count;
+}
+
+/**
+ * @brief SSE2 AddPointsToBounds kernel. The point is the first operand of
+ * min and max, so that NaN components are ignored, as in AddPointToBounds.
+ */
+static size_t Simd_AddPointsToBounds_SSE2(const vec3_t *points, size_t count, vec3_t mins, vec3_t maxs) {
+	__m128 min[3], max[3];
+
+	count &= ~(size_t) 3;
+
+	if (count == 0) {
+		return 0;
+	}
+
+	for (int32_t i = 0; i < 3; i++) {
+		min[i] = _mm_set1_ps(mins[i]);
+		max[i] = _mm_set1_ps(maxs[i]);
+	}
+
+	for (size_t i = 0; i < count; i += 4) {
+		__m128 p[3];
+
+		Simd_Load_SSE2(points + i, &p[0], &p[1], &p[2]);
+
+		for (int32_t j = 0; j < 3; j++) {
+			min[j] = _mm_min_ps(p[j], min[j]);
+			max[j] = _mm_max_ps(p[j], max[j]);
+		}
+	}
+
+	Simd_StoreBounds_SSE2(min, max, mins, maxs);
+	return count;
+}
+
+static const simd_kernels_t simd_kernels_sse2 = {
+	.TransformPoints = Simd_TransformPoints_SSE2,
+	.NormalizeVectors = Simd_NormalizeVectors_SSE2,
+	.DotProducts = Simd_DotProducts_SSE2,
+	.AddPointsToBounds = Simd_AddPointsToBounds_SSE2,
+};
+
+#define SIMD_AVX_TARGET __attribute__((target("avx")))
+
+/**
+ * @brief Loads eight packed vectors as their x, y and z components.
+ */
+static inline SIMD_AVX_TARGET void Simd_Load_AVX(const vec3_t *in, __m256 *x, __m256 *y, __m256 *z) {
+	__m128 lo[3], hi[3];
+
+	Simd_Load_SSE2(in + 0, &lo[0], &lo[1], &lo[2]);
+	Simd_Load_SSE2(in + 4, &hi[0], &hi[1], &hi[2]);
+
+	*x = _mm256_insertf128_ps(_mm256_castps128_ps256(lo[0]), hi[0], 1);
+	*y = _mm256_insertf128_ps(_mm256_castps128_ps256(lo[1]), hi[1], 1);
+	*z = _mm256_insertf128_ps(_mm256_castps128_ps256(lo[2]), hi[2], 1);
+}
+
+/**
+ * @brief Stores the x, y and z components of eight vectors as packed vectors.
+ */
+static inline SIMD_AVX_TARGET void Simd_Store_AVX(vec3_t *out, __m256 x, __m256 y, __m256 z) {
+
+	Simd_Store_SSE2(out + 0, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z));
+	Simd_Store_SSE2(out + 4, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1));
+}
+
+/**
+ * @brief AVX TransformPoints kernel.
+ */
+static SIMD_AVX_TARGET size_t Simd_TransformPoints_AVX(const simd_matrix_t m, const vec3_t *in, vec3_t *out, size_t count) {
+	__m256 c[3][4];
+
+	for (int32_t i = 0; i < 3; i++) {
+		for (int32_t j = 0; j < 4; j++) {
+			c[i][j] = _mm256_set1_ps(m[i][j]);
+		}
+	}
+
+	count &= ~(size_t) 7;
+
+	for (size_t i = 0; i < count; i += 8) {
+		__m256 x, y, z, r[3];
+
+		Simd_Load_AVX(in + i, &x, &y, &z);
+
+		for (int32_t j = 0; j < 3; j++) {
+			r[j] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, c[j][0]), _mm256_mul_ps(y, c[j][1])),
+			                                   _mm256_mul_ps(z, c[j][2])), c[j][3]);
+		}
+
+		Simd_Store_AVX(out + i, r[0], r[1], r[2]);
+	}
+
+	return count;
+}
+
+/**
+ * @brief AVX NormalizeVectors kernel.
+ */
+static SIMD_AVX_TARGET size_t Simd_NormalizeVectors_AVX(const vec3_t *in, vec3_t *out, vec_t *lengths, size_t count) {
+
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	count &= ~(size_t) 7;
+
+	for (size_t i = 0; i < count; i += 8) {
+		__m256 x, y, z;
+
+		Simd_Load_AVX(in + i, &x, &y, &z);
+
+		const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+		const __m256 ilength = _mm256_div_ps(one, length);
+		const __m256 mask = _mm256_cmp_ps(length, zero, _CMP_NEQ_UQ);
+
+		x = _mm256_or_ps(_mm256_and_ps(mask, _mm256_mul_ps(x, ilength)), _mm256_andnot_ps(mask, x));
+		y = _mm256_or_ps(_mm256_and_ps(mask, _mm256_mul_ps(y, ilength)), _mm256_andnot_ps(mask, y));
+		z = _mm256_or_ps(_mm256_and_ps(mask, _mm256_mul_ps(z, ilength)), _mm256_andnot_ps(mask, z));
+
+		Simd_Store_AVX(out + i, x, y, z);
+
+		if (lengths) {
+			_mm256_storeu_ps(lengths + i, length);
+		}
+	}
+
+	return count;
+}
+
+/**
+ * @brief AVX DotProducts kernel.
+ */
+static SIMD_AVX_TARGET size_t Simd_DotProducts_AVX(const vec3_t *a, const vec3_t *b, vec_t *out, size_t count) {
+
+	count &= ~(size_t) 7;
+
+	for (size_t i = 0; i < count; i += 8) {
+		__m256 ax, ay, az, bx, by, bz;
+
+		Simd_Load_AVX(a + i, &ax, &ay, &az);
+		Simd_Load_AVX(b + i, &bx, &by, &bz);
+
+		_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz)));
+	}
+
+	return count;
+}
+
+/**
+ * @brief AVX AddPointsToBounds kernel.
+ */
+static SIMD_AVX_TARGET size_t Simd_AddPointsToBounds_AVX(const vec3_t *points, size_t count, vec3_t mins, vec3_t maxs) {
+	__m256 min[3], max[3];
+
+	count &= ~(size_t) 7;
+
+	if (count == 0) {
+		return 0;
+	}
+
+	for (int32_t i = 0; i < 3; i++) {
+		min[i] = _mm256_set1_ps(mins[i]);
+		max[i] = _mm256_set1_ps(maxs[i]);
+	}
+
+	for (size_t i = 0; i < count; i += 8) {
+		__m256 p[3];
+
+		Simd_Load_AVX(points + i, &p[0], &p[1], &p[2]);
+
+		for (int32_t j = 0; j < 3; j++) {
+			min[j] = _mm256_min_ps(p[j], min[j]);
+			max[j] = _mm256_max_ps(p[j], max[j]);
+		}
+	}
+
+	__m128 min_lo[3], max_lo[3], min_hi[3], max_hi[3];
+	for (int32_t i = 0; i < 3; i++) {
+		min_lo[i] = _mm256_castps256_ps128(min[i]);
+		max_lo[i] = _mm256_castps256_ps128(max[i]);
+		min_hi[i] = _mm256_extractf128_ps(min[i], 1);
+		max_hi[i] = _mm256_extractf128_ps(max[i], 1);
+	}
+
+	Simd_StoreBounds_SSE2(min_lo, max_lo, mins, maxs);
+	Simd_StoreBounds_SSE2(min_hi, max_hi, mins, maxs);
+
+	return count;
+}
+
+static const simd_kernels_t simd_kernels_avx = {
+	.TransformPoints = Simd_TransformPoints_AVX,
+	.NormalizeVectors = Simd_NormalizeVectors_AVX,
+	.DotProducts = Simd_DotProducts_AVX,
+	.AddPointsToBounds = Simd_AddPointsToBounds_AVX,
+};
+
+#endif
+
+#if SIMD_ARM
+
+/**
+ * @brief NEON TransformPoints kernel. The interleaved loads and stores
+ * transpose the packed vectors for free.
+ */
+static size_t Simd_TransformPoints_NEON(const simd_matrix_t m, const vec3_t *in, vec3_t *out, size_t count) {
+	float32x4_t c[3][4];
+
+	for (int32_t i = 0; i < 3; i++) {
+		for (int32_t j = 0; j < 4; j++) {
+			c[i][j] = vdupq_n_f32(m[i][j]);
+		}
+	}
+
+	count &= ~(size_t) 3;
+
+	for (size_t i = 0; i < count; i += 4) {
+		const float32x4x3_t v = vld3q_f32(in[i]);
+		float32x4x3_t r;
+
+		for (int32_t j = 0; j < 3; j++) {
+			r.val[j] = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(v.val[0], c[j][0]), vmulq_f32(v.val[1], c[j][1])),
+			                               vmulq_f32(v.val[2], c[j][2])), c[j][3]);
+		}
+
+		vst3q_f32(out[i], r);
+	}
+
+	return count;
+}
+
+/**
+ * @brief NEON NormalizeVectors kernel.
+ */
+static size_t Simd_NormalizeVectors_NEON(const vec3_t *in, vec3_t *out, vec_t *lengths, size_t count) {
+
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const float32x4_t one = vdupq_n_f32(1.0f);
+
+	count &= ~(size_t) 3;
+
+	for (size_t i = 0; i < count; i += 4) {
+		float32x4x3_t v = vld3q_f32(in[i]);
+
+		const float32x4_t length = vsqrtq_f32(vaddq_f32(vaddq_f32(vmulq_f32(v.val[0], v.val[0]),
+		                                      vmulq_f32(v.val[1], v.val[1])), vmulq_f32(v.val[2], v.val[2])));
+		const float32x4_t ilength = vdivq_f32(one, length);
+		const uint32x4_t mask = vceqq_f32(length, zero);
+
+		for (int32_t j = 0; j < 3; j++) {
+			v.val[j] = vbslq_f32(mask, v.val[j], vmulq_f32(v.val[j], ilength));
+		}
+
+		vst3q_f32(out[i], v);
+
+		if (lengths) {
+			vst1q_f32(lengths + i, length);
+		}
+	}
+
+	return count;
+}
+
+/**
+ * @brief NEON DotProducts kernel.
+ */
+static size_t Simd_DotProducts_NEON(const vec3_t *a, const vec3_t *b, vec_t *out, size_t count) {
+
+	count &= ~(size_t) 3;
+
+	for (size_t i = 0; i < count; i += 4) {
+		const float32x4x3_t va = vld3q_f32(a[i]);
+		const float32x4x3_t vb = vld3q_f32(b[i]);
+
+		vst1q_f32(out + i, vaddq_f32(vaddq_f32(vmulq_f32(va.val[0], vb.val[0]), vmulq_f32(va.val[1], vb.val[1])),
+		                             vmulq_f32(va.val[2], vb.val[2])));
+	}
+
+	return count;
+}
+
+/**
+ * @brief NEON AddPointsToBounds kernel. Unlike vminq_f32, the compare and
+ * select ignores NaN components, as in AddPointToBounds.
+ */
+static size_t Simd_AddPointsToBounds_NEON(const vec3_t *points, size_t count, vec3_t mins, vec3_t maxs) {
+	float32x4_t min[3], max[3];
+
+	count &= ~(size_t) 3;
+
+	if (count == 0) {
+		return 0;
+	}
+
+	for (int32_t i = 0; i < 3; i++) {
+		min[i] = vdupq_n_f32(mins[i]);
+		max[i] = vdupq_n_f32(maxs[i]);
+	}
+
+	for (size_t i = 0; i < count; i += 4) {
+		const float32x4x3_t p = vld3q_f32(points[i]);
+
+		for (int32_t j = 0; j < 3; j++) {
+			min[j] = vbslq_f32(vcltq_f32(p.val[j], min[j]), p.val[j], min[j]);
+			max[j] = vbslq_f32(vcgtq_f32(p.val[j], max[j]), p.val[j], max[j]);
+		}
+	}
+
+	vec_t lanes[4];
+	for (int32_t i = 0; i < 3; i++) {
+
+		vst1q_f32(lanes, min[i]);
+		for (int32_t j = 0; j < 4; j++) {
+			if (lanes[j] < mins[i]) {
+				mins[i] = lanes[j];
+			}
+		}
+
+		vst1q_f32(lanes, max[i]);
+		for (int32_t j = 0; j < 4; j++) {
+			if (lanes[j] > maxs[i]) {
+				maxs[i] = lanes[j];
+			}
+		}
+	}
+
+	return count;
+}
+
+static const simd_kernels_t simd_kernels_neon = {
+	.TransformPoints = Simd_TransformPoints_NEON,
+	.NormalizeVectors = Simd_NormalizeVectors_NEON,
+	.DotProducts = Simd_DotProducts_NEON,
+	.AddPointsToBounds = Simd_AddPointsToBounds_NEON,
+};
+
+#endif
+
+/**
+ * @return The kernels for the specified level, if the host CPU supports them.
+ */
+static const simd_kernels_t *Simd_Kernels(simd_level_t level) {
+
+	switch (level) {
+		case SIMD_SCALAR:
+			return &simd_kernels_scalar;
+#if SIMD_X86
+		case SIMD_SSE2:
+			return SDL_HasSSE2() ? &simd_kernels_sse2 : NULL;
+		case SIMD_AVX:
+			return SDL_HasAVX() ? &simd_kernels_avx : NULL;
+#endif
+#if SIMD_ARM
+		case SIMD_NEON:
+			return &simd_kernels_neon;
+#endif
+		default:
+			return NULL;
+	}
+}
+
+/**
+ * @brief Selects the kernels for the specified level, if the host CPU supports them.
+ * @return True if the level was selected, false otherwise.
+ */
+_Bool Simd_SetLevel(simd_level_t level) {
+
+	const simd_kernels_t *kernels = Simd_Kernels(level);
+	if (kernels) {
+		simd_state.level = level;
+		simd_state.kernels = kernels;
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * @brief Selects the best kernels for the host CPU.
+ * @return The selected level.
+ */
+simd_level_t Simd_Init(void) {
+
+	for (simd_level_t level = SIMD_LEVELS - 1; level > SIMD_SCALAR; level--) {
+		if (Simd_SetLevel(level)) {
+			return level;
+		}
+	}
+
+	Simd_SetLevel(SIMD_SCALAR);
+	return SIMD_SCALAR;
+}
+
+/**
+ * @return The selected level.
+ */
+simd_level_t Simd_Level(void) {
+
+	if (simd_state.kernels == NULL) {
+		Simd_Init();
+	}
+
+	return simd_state.level;
+}
+
+/**
+ * @return The name of the specified level.
+ */
+const char *Simd_LevelName(simd_level_t level) {
+
+	switch (level) {
+		case SIMD_SCALAR:
+			return "scalar";
+		case SIMD_SSE2:
+			return "SSE2";
+		case SIMD_AVX:
+			return "AVX";
+		case SIMD_NEON:
+			return "NEON";
+		default:
+			return "unknown";
+	}
+}
+
+/**
+ * @return The selected kernels.
+ */
+static inline const simd_kernels_t *Simd_SelectedKernels(void) {
+
+	if (simd_state.kernels == NULL) {
+		Simd_Init();
+	}
+
+	return simd_state.kernels;
+}
+
+/**
+ * @brief Transforms `count` points by the specified matrix.
+ */
+void Simd_TransformPoints(const matrix4x4_t *m, const vec3_t *in, vec3_t *out, size_t count) {
+	simd_matrix_t matrix;
+
+	Simd_Matrix(m, matrix);
+
+	const size_t i = Simd_SelectedKernels()->TransformPoints(matrix, in, out, count);
+	Simd_TransformPoints_Scalar(matrix, in + i, out + i, count - i);
+}
+
+/**
+ * @brief Normalizes `count` vectors to unit length, writing their original
+ * lengths to `lengths` if it is not NULL.
+ */
+void Simd_NormalizeVectors(const vec3_t *in, vec3_t *out, vec_t *lengths, size_t count) {
+
+	const size_t i = Simd_SelectedKernels()->NormalizeVectors(in, out, lengths, count);
+	Simd_NormalizeVectors_Scalar(in + i, out + i, lengths ? lengths + i : NULL, count - i);
+}
+
+/**
+ * @brief Calculates the dot products of `count` pairs of vectors.
+ */
+void Simd_DotProducts(const vec3_t *a, const vec3_t *b, vec_t *out, size_t count) {
+
+	const size_t i = Simd_SelectedKernels()->DotProducts(a, b, out, count);
+	Simd_DotProducts_Scalar(a + i, b + i, out + i, count - i);
+}
+
+/**
+ * @brief Accumulates `count` points into the specified bounds. Use ClearBounds
+ * to initialize the bounds of a new set of points.
+ */
+void Simd_AddPointsToBounds(const vec3_t *points, size_t count, vec3_t mins, vec3_t maxs) {
+
+	const size_t i = Simd_SelectedKernels()->AddPointsToBounds(points, count, mins, maxs);
+	Simd_AddPointsToBounds_Scalar(points + i, count - i, mins, maxs);
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#pragma once
+
+#include "matrix.h"
+
+/**
+ * @brief The instruction sets the batched vector kernels are available for.
+ */
+typedef enum {
+	SIMD_SCALAR,
+	SIMD_SSE2,
+	SIMD_AVX,
+	SIMD_NEON,
+	SIMD_LEVELS
+} simd_level_t;
+
+/**
+ * @brief The batched vector functions operate on packed arrays of `vec3_t`,
+ * and produce the same results as their scalar counterparts in shared.c and
+ * matrix.c. The best kernels for the host CPU are selected on first use, or
+ * by Simd_Init; input and output arrays may alias, but must not overlap
+ * partially.
+ */
+void Simd_TransformPoints(const matrix4x4_t *m, const vec3_t *in, vec3_t *out, size_t count);
+void Simd_NormalizeVectors(const vec3_t *in, vec3_t *out, vec_t *lengths, size_t count);
+void Simd_DotProducts(const vec3_t *a, const vec3_t *b, vec_t *out, size_t count);
+void Simd_AddPointsToBounds(const vec3_t *points, size_t count, vec3_t mins, vec3_t maxs);
+
+simd_level_t Simd_Init(void);
+simd_level_t Simd_Level(void);
+_Bool Simd_SetLevel(simd_level_t level);
+const char *Simd_LevelName(simd_level_t level);
@@ -19,6 +19,8 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include <SDL_timer.h>
+
 #include "tests.h"
 #include "cmd.h"
 
@@ -71,6 +73,91 @@ START_TEST(check_Cmd_RemoveAll) {
 
 } END_TEST
 
+static GString *record;
+
+/**
+ * @brief Records the first argument.
+ */
+static void Cmd_Record(void) {
+	g_string_append(record, Cmd_Argv(1));
+}
+
+/**
+ * @brief Inserts commands ahead of those pending.
+ */
+static void Cmd_Insert(void) {
+	Cbuf_InsertText("record b\nrecord c\n");
+}
+
+START_TEST(check_Cbuf_Execute) {
+	record = g_string_new(NULL);
+
+	Cmd_Add("record", Cmd_Record, 0, NULL);
+	Cmd_Add("insert", Cmd_Insert, 0, NULL);
+
+	Cbuf_AddText("record a; insert; record d\n");
+	Cbuf_Execute();
+
+	ck_assert_str_eq(record->str, "abcd");
+
+	// wait defers the remainder of the buffer to the next frame
+	g_string_truncate(record, 0);
+
+	Cbuf_AddText("record e; wait; record \"f;g\"\n");
+	Cbuf_Execute();
+
+	ck_assert_str_eq(record->str, "e");
+
+	Cbuf_InsertText("record h\n");
+	Cbuf_Execute();
+
+	ck_assert_str_eq(record->str, "ehf;g");
+
+	g_string_free(record, true);
+
+} END_TEST
+
+#define CBUF_BENCH_LINES 10000
+
+static int32_t count;
+
+/**
+ * @brief Counts executions.
+ */
+static void Cmd_Count(void) {
+	count++;
+}
+
+START_TEST(check_Cbuf_Execute_large) {
+
+	Cmd_Add("count", Cmd_Count, 0, NULL);
+
+	file_t *file = Fs_OpenWrite("check_cmd.cfg");
+	ck_assert(file != NULL);
+
+	for (int32_t i = 0; i < CBUF_BENCH_LINES; i++) {
+		Fs_Print(file, "count %d // a comment to pad the line\n", i);
+	}
+
+	Fs_Close(file);
+
+	count = 0;
+
+	const uint64_t start = SDL_GetPerformanceCounter();
+
+	Cbuf_AddText("exec check_cmd\n");
+	Cbuf_Execute();
+
+	const double seconds = (SDL_GetPerformanceCounter() - start) / (double) SDL_GetPerformanceFrequency();
+
+	ck_assert_int_eq(count, CBUF_BENCH_LINES);
+
+	printf("Cbuf_Execute: %d lines in %.3fms\n", CBUF_BENCH_LINES, seconds * 1000.0);
+
+	Fs_Delete("check_cmd.cfg");
+
+} END_TEST
+
 /**
  * @brief Test entry point.
  */
@@ -82,6 +169,8 @@ int32_t main(int32_t argc, char **argv) {
 	tcase_add_checked_fixture(tcase, setup, teardown);
 
 	tcase_add_test(tcase, check_Cmd_RemoveAll);
+	tcase_add_test(tcase, check_Cbuf_Execute);
+	tcase_add_test(tcase, check_Cbuf_Execute_large);
 
 	Suite *suite = suite_create("check_cmd");
 	suite_add_tcase(suite, tcase);
@@ -19,11 +19,64 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include <glib/gstdio.h>
+#include <physfs.h>
+#include <SDL_thread.h>
+#include <SDL_timer.h>
+
 #include "tests.h"
 #include "filesystem.h"
 
 quetoo_t quetoo;
 
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+
+#define CHECK_MALLOCS 1
+
+extern void *__libc_malloc(size_t size);
+
+static uint32_t check_mallocs;
+
+/**
+ * @brief Counts heap allocations, so that allocation-free paths can be verified.
+ */
+void *malloc(size_t size) {
+	__atomic_add_fetch(&check_mallocs, 1, __ATOMIC_RELAXED);
+	return __libc_malloc(size);
+}
+
+#endif
+
+/**
+ * @brief The temporary directory written by check_Fs_Index_tree, if any.
+ */
+static gchar *index_root;
+
+/**
+ * @brief Recursively removes the specified directory.
+ */
+static void check_Fs_RemoveTree(const char *path) {
+
+	GDir *dir = g_dir_open(path, 0, NULL);
+	if (dir) {
+		const gchar *name;
+		while ((name = g_dir_read_name(dir))) {
+			gchar *child = g_build_filename(path, name, NULL);
+
+			if (g_file_test(child, G_FILE_TEST_IS_DIR)) {
+				check_Fs_RemoveTree(child);
+			} else {
+				g_unlink(child);
+			}
+
+			g_free(child);
+		}
+		g_dir_close(dir);
+	}
+
+	g_rmdir(path);
+}
+
 /**
  * @brief Setup fixture.
  */
@@ -42,6 +95,13 @@ void teardown(void) {
 	Fs_Shutdown();
 
 	Mem_Shutdown();
+
+	if (index_root) {
+		check_Fs_RemoveTree(index_root);
+
+		g_free(index_root);
+		index_root = NULL;
+	}
 }
 
 START_TEST(check_Fs_OpenRead) {
@@ -86,6 +146,411 @@ START_TEST(check_Fs_LoadFile) {
 
 } END_TEST
 
+START_TEST(check_Fs_Map) {
+	const char *filenames[] = { "quetoo.cfg", "maps/torn.bsp", NULL };
+
+	const char **filename = filenames;
+	while (*filename) {
+		void *buffer;
+		const int64_t len = Fs_Load(*filename, &buffer);
+
+		ck_assert_msg(len > 0, "Failed to load %s", *filename);
+
+		const void *mapped;
+		ck_assert_msg(Fs_Map(*filename, &mapped) == len, "Failed to map %s", *filename);
+
+		ck_assert(memcmp(buffer, mapped, len) == 0);
+
+		Fs_Unmap(mapped);
+		Fs_Free(buffer);
+
+		filename++;
+	}
+
+} END_TEST
+
+START_TEST(check_Fs_CacheStats) {
+	fs_cache_stats_t before, after;
+
+	Fs_CacheStats(&before);
+
+	const void *a, *b;
+	ck_assert(Fs_Map("maps/torn.bsp", &a) > 0);
+	ck_assert(Fs_Map("maps/torn.bsp", &b) > 0);
+
+	ck_assert_msg(a == b, "Cached file was loaded twice");
+
+	Fs_Unmap(a);
+	Fs_Unmap(b);
+
+#if HAVE_MMAP
+	// unreferenced, memory-mapped files remain cached
+	ck_assert(Fs_Map("maps/torn.bsp", &a) > 0);
+	ck_assert(a == b);
+
+	Fs_Unmap(a);
+
+	Fs_CacheStats(&after);
+
+	ck_assert_int_eq(after.hits - before.hits + after.misses - before.misses, 3);
+	ck_assert(after.hits - before.hits >= 2);
+#else
+	// while loaded files are freed
+	Fs_CacheStats(&after);
+
+	ck_assert_int_eq(after.num_files, before.num_files);
+#endif
+
+	ck_assert_int_eq(after.num_referenced, 0);
+
+} END_TEST
+
+#define CACHE_THREADS 4
+#define CACHE_ITERATIONS 200
+
+/**
+ * @brief Maps and writes files from a worker thread, as e.g. the screenshot
+ * job does, racing the other threads through the cache.
+ */
+static int32_t check_Fs_Cache_thread(void *data) {
+	char filename[MAX_QPATH];
+
+	g_snprintf(filename, sizeof(filename), "check_Fs_Cache%d.tmp", *(int32_t *) data);
+
+	for (int32_t i = 0; i < CACHE_ITERATIONS; i++) {
+		const void *mapped;
+
+		ck_assert(Fs_Map("maps/torn.bsp", &mapped) > 0);
+		Fs_Unmap(mapped);
+
+		file_t *file = Fs_OpenWrite(filename);
+		ck_assert(file != NULL);
+		Fs_Write(file, &i, sizeof(i), 1);
+		Fs_Close(file);
+
+		ck_assert(Fs_Map(filename, &mapped) > 0);
+		Fs_Unmap(mapped);
+	}
+
+	Fs_Delete(filename);
+	return 0;
+}
+
+START_TEST(check_Fs_Cache_Threads) {
+	SDL_Thread *threads[CACHE_THREADS];
+	int32_t ids[CACHE_THREADS];
+
+	for (int32_t i = 0; i < CACHE_THREADS; i++) {
+		ids[i] = i;
+		threads[i] = SDL_CreateThread(check_Fs_Cache_thread, __func__, &ids[i]);
+	}
+
+	for (int32_t i = 0; i < CACHE_THREADS; i++) {
+		SDL_WaitThread(threads[i], NULL);
+	}
+
+	fs_cache_stats_t stats;
+	Fs_CacheStats(&stats);
+
+	ck_assert_int_eq(stats.num_referenced, 0);
+
+} END_TEST
+
+/**
+ * @brief Fs_LoadFunc for check_Fs_LoadAsync, which compares the asynchronously
+ * loaded file to a synchronous load of it.
+ */
+static void check_Fs_LoadAsync_load(const char *filename, void *buffer, int64_t len, void *data) {
+
+	void *expected;
+	ck_assert_int_eq(len, Fs_Load(filename, &expected));
+
+	if (len > 0) {
+		ck_assert(memcmp(buffer, expected, len) == 0);
+	}
+
+	Fs_Free(expected);
+	Fs_Free(buffer);
+
+	(*(int32_t *) data)++;
+}
+
+START_TEST(check_Fs_LoadAsync) {
+	const char *filenames[] = { "quetoo.cfg", "maps/torn.bsp", "does/not/exist" };
+
+	int32_t count = 0;
+
+	for (int32_t i = 0; i < 100; i++) {
+		Fs_LoadAsyncBatch(filenames, lengthof(filenames), check_Fs_LoadAsync_load, &count);
+	}
+
+	Fs_WaitAsync();
+
+	ck_assert_int_eq(count, 100 * lengthof(filenames));
+
+	// prefetched files are claimed by Fs_Load
+	Fs_LoadAsync("quetoo.cfg", NULL, NULL);
+
+	void *buffer;
+	const int64_t len = Fs_Load("quetoo.cfg", &buffer);
+
+	ck_assert(len > 0);
+	ck_assert(g_str_has_prefix((const char *) buffer, "// generated by Quetoo"));
+
+	Fs_Free(buffer);
+
+} END_TEST
+
+#define INDEX_DIRS 100
+#define INDEX_FILES 500
+#define INDEX_LOOKUPS 200000
+
+/**
+ * @brief Writes a little-endian integer of the specified width.
+ */
+static void check_Fs_Index_write(FILE *file, uint32_t value, size_t width) {
+
+	for (size_t i = 0; i < width; i++) {
+		fputc((value >> (i * 8)) & 0xff, file);
+	}
+}
+
+/**
+ * @brief Writes a zip archive of empty, stored entries.
+ */
+static void check_Fs_Index_zip(const char *path, const char **names, size_t count) {
+
+	FILE *file = fopen(path, "wb");
+	ck_assert(file != NULL);
+
+	uint32_t offsets[count];
+
+	for (size_t i = 0; i < count; i++) {
+		offsets[i] = (uint32_t) ftell(file);
+
+		check_Fs_Index_write(file, 0x04034b50, 4);
+		check_Fs_Index_write(file, 10, 2);
+		for (size_t j = 0; j < 7; j++) { // flags, method, time, date, crc, sizes
+			check_Fs_Index_write(file, 0, j < 4 ? 2 : 4);
+		}
+		check_Fs_Index_write(file, (uint32_t) strlen(names[i]), 2);
+		check_Fs_Index_write(file, 0, 2);
+		fputs(names[i], file);
+	}
+
+	const uint32_t directory_ofs = (uint32_t) ftell(file);
+
+	for (size_t i = 0; i < count; i++) {
+		check_Fs_Index_write(file, 0x02014b50, 4);
+		check_Fs_Index_write(file, 20, 2);
+		check_Fs_Index_write(file, 10, 2);
+		for (size_t j = 0; j < 7; j++) { // flags, method, time, date, crc, sizes
+			check_Fs_Index_write(file, 0, j < 4 ? 2 : 4);
+		}
+		check_Fs_Index_write(file, (uint32_t) strlen(names[i]), 2);
+		check_Fs_Index_write(file, 0, 2); // extra
+		check_Fs_Index_write(file, 0, 2); // comment
+		check_Fs_Index_write(file, 0, 2); // disk
+		check_Fs_Index_write(file, 0, 2); // internal attributes
+		check_Fs_Index_write(file, 0, 4); // external attributes
+		check_Fs_Index_write(file, offsets[i], 4);
+		fputs(names[i], file);
+	}
+
+	const uint32_t directory_len = (uint32_t) ftell(file) - directory_ofs;
+
+	check_Fs_Index_write(file, 0x06054b50, 4);
+	check_Fs_Index_write(file, 0, 4);
+	check_Fs_Index_write(file, (uint32_t) count, 2);
+	check_Fs_Index_write(file, (uint32_t) count, 2);
+	check_Fs_Index_write(file, directory_len, 4);
+	check_Fs_Index_write(file, directory_ofs, 4);
+	check_Fs_Index_write(file, 0, 2);
+
+	fclose(file);
+}
+
+/**
+ * @brief Writes a synthetic tree of loose files, and a pk3, to a temporary
+ * directory, and adds it to the search path. The teardown fixture removes it.
+ */
+static const char *check_Fs_Index_tree(void) {
+	char path[MAX_OS_PATH];
+
+	index_root = g_dir_make_tmp("check_Fs_Index-XXXXXX", NULL);
+	ck_assert(index_root != NULL);
+
+	const char *root = index_root;
+
+	for (int32_t i = 0; i < INDEX_DIRS; i++) {
+		g_snprintf(path, sizeof(path), "%s/d%03d", root, i);
+
+		ck_assert(g_mkdir_with_parents(path, 0755) == 0);
+
+		for (int32_t j = 0; j < INDEX_FILES; j++) {
+			g_snprintf(path, sizeof(path), "%s/d%03d/f%03d.tga", root, i, j);
+
+			FILE *file = fopen(path, "wb");
+			ck_assert(file != NULL);
+			fclose(file);
+		}
+	}
+
+	const char *entries[] = { "pk3/a.txt", "pk3/b/c.txt" };
+	check_Fs_Index_zip(va("%s/index.pk3", root), entries, lengthof(entries));
+
+	Fs_AddToSearchPath(root);
+
+	return root;
+}
+
+START_TEST(check_Fs_Index) {
+
+	const char *root = check_Fs_Index_tree();
+
+	ck_assert(Fs_Exists("d042/f042.tga"));
+	ck_assert(Fs_Exists("d042"));
+	ck_assert(Fs_Exists("/d042//f042.tga"));
+	ck_assert(!Fs_Exists("d042/f042.png"));
+	ck_assert_str_eq(Fs_RealDir("d042/f042.tga"), root);
+
+	ck_assert(Fs_Exists("pk3/a.txt"));
+	ck_assert(Fs_Exists("pk3/b"));
+	ck_assert(!Fs_Exists("pk3/d.txt"));
+	ck_assert(g_str_has_suffix(Fs_RealDir("pk3/b/c.txt"), "index.pk3"));
+
+	// writes are reflected in the index
+	file_t *file = Fs_OpenWrite("check_Fs_Index.tmp");
+	ck_assert(file != NULL);
+	Fs_Close(file);
+
+	ck_assert(Fs_Exists("check_Fs_Index.tmp"));
+	Fs_Delete("check_Fs_Index.tmp");
+	ck_assert(!Fs_Exists("check_Fs_Index.tmp"));
+
+	// benchmark lookups, half of which miss, against PhysFS
+	char (*names)[MAX_QPATH] = g_malloc(INDEX_LOOKUPS * MAX_QPATH);
+
+	for (int32_t i = 0; i < INDEX_LOOKUPS; i++) {
+		const int32_t j = (i * 7919) % (INDEX_DIRS * INDEX_FILES);
+		g_snprintf(names[i], MAX_QPATH, "d%03d/f%03d.%s", j / INDEX_FILES, j % INDEX_FILES, (i & 1) ? "png" : "tga");
+	}
+
+	const double freq = SDL_GetPerformanceFrequency();
+	double rates[2];
+
+	for (int32_t pass = 0; pass < 2; pass++) {
+		int32_t found = 0;
+
+		const uint64_t start = SDL_GetPerformanceCounter();
+
+		for (int32_t i = 0; i < INDEX_LOOKUPS; i++) {
+			found += pass ? Fs_Exists(names[i]) : (PHYSFS_exists(names[i]) ? 1 : 0);
+		}
+
+		const double seconds = (SDL_GetPerformanceCounter() - start) / freq;
+
+		ck_assert_int_eq(found, INDEX_LOOKUPS / 2);
+		rates[pass] = INDEX_LOOKUPS / seconds;
+	}
+
+	printf("%d files: PhysFS %.0f lookups/s, index %.0f lookups/s\n", INDEX_DIRS * INDEX_FILES, rates[0], rates[1]);
+
+	g_free(names);
+
+} END_TEST
+
+#define ENUMERATE_ITERATIONS 100
+
+/**
+ * @brief Enumeration helper for check_Fs_Enumerate.
+ */
+static int32_t check_Fs_Enumerate_physfs_(void *data, const char *dir, const char *filename) {
+	char path[MAX_QPATH];
+
+	g_snprintf(path, sizeof(path), "%s%s", dir, filename);
+
+	if (GlobMatch("d042/f04*", path, GLOB_FLAGS_NONE)) {
+		(*(int32_t *) data)++;
+	}
+
+	return 1;
+}
+
+/**
+ * @brief Fs_Enumerator for check_Fs_Enumerate.
+ */
+static void check_Fs_Enumerate_(const char *path, void *data) {
+	(*(int32_t *) data)++;
+}
+
+START_TEST(check_Fs_Enumerate) {
+
+	check_Fs_Index_tree();
+
+	int32_t count = 0;
+	Fs_Enumerate("d042/*.tga", check_Fs_Enumerate_, &count);
+	ck_assert_int_eq(count, INDEX_FILES);
+
+	count = 0;
+	Fs_Enumerate("d042/f042.tga", check_Fs_Enumerate_, &count);
+	ck_assert_int_eq(count, 1);
+
+	count = 0;
+	Fs_Enumerate("d042/f0[0-1]?.*", check_Fs_Enumerate_, &count);
+	ck_assert_int_eq(count, 20);
+
+	count = 0;
+	Fs_Enumerate("pk3/*", check_Fs_Enumerate_, &count);
+	ck_assert_int_eq(count, 2);
+
+	GList *matches = NULL;
+	Fs_CompleteFile("d042/f04*", &matches);
+
+	ck_assert_int_eq(g_list_length(matches), 10);
+	ck_assert_str_eq(((com_autocomplete_match_t *) matches->data)->name, "f040");
+	ck_assert_str_eq(((com_autocomplete_match_t *) g_list_last(matches)->data)->name, "f049");
+
+	g_list_free_full(matches, Mem_Free);
+
+	// compare against matching each entry reported by PhysFS
+	const double freq = SDL_GetPerformanceFrequency();
+	double seconds[2];
+	uint32_t mallocs[2] = { 0, 0 };
+
+	for (int32_t pass = 0; pass < 2; pass++) {
+		count = 0;
+
+#if CHECK_MALLOCS
+		const uint32_t start_mallocs = __atomic_load_n(&check_mallocs, __ATOMIC_RELAXED);
+#endif
+		const uint64_t start = SDL_GetPerformanceCounter();
+
+		for (int32_t i = 0; i < ENUMERATE_ITERATIONS; i++) {
+			if (pass) {
+				Fs_Enumerate("d042/f04*", check_Fs_Enumerate_, &count);
+			} else {
+				PHYSFS_enumerate("d042/", check_Fs_Enumerate_physfs_, &count);
+			}
+		}
+
+		seconds[pass] = (SDL_GetPerformanceCounter() - start) / freq;
+#if CHECK_MALLOCS
+		mallocs[pass] = __atomic_load_n(&check_mallocs, __ATOMIC_RELAXED) - start_mallocs;
+#endif
+
+		ck_assert_int_eq(count, ENUMERATE_ITERATIONS * 10);
+	}
+
+#if CHECK_MALLOCS
+	ck_assert_int_eq(mallocs[1], 0);
+#endif
+
+	printf("%d x %d files: PhysFS %.3fms, %u allocations; index %.3fms, %u allocations\n",
+		   ENUMERATE_ITERATIONS, INDEX_FILES, seconds[0] * 1000.0, mallocs[0], seconds[1] * 1000.0, mallocs[1]);
+
+} END_TEST
+
 /**
  * @brief Test entry point.
  */
@@ -99,6 +564,12 @@ int32_t main(int32_t argc, char **argv) {
 	tcase_add_test(tcase, check_Fs_OpenRead);
 	tcase_add_test(tcase, check_Fs_OpenWrite);
 	tcase_add_test(tcase, check_Fs_LoadFile);
+	tcase_add_test(tcase, check_Fs_Map);
+	tcase_add_test(tcase, check_Fs_CacheStats);
+	tcase_add_test(tcase, check_Fs_Cache_Threads);
+	tcase_add_test(tcase, check_Fs_LoadAsync);
+	tcase_add_test(tcase, check_Fs_Index);
+	tcase_add_test(tcase, check_Fs_Enumerate);
 
 	Suite *suite = suite_create("check_filesystem");
 	suite_add_tcase(suite, tcase);
@@ -0,0 +1,317 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#pragma once
+
+#include "collision/cmodel.h"
+#include "filesystem.h"
+
+/**
+ * @brief The test map is a floor with a grid of pillars, and a platform as its
+ * only inline model. It is written with Bsp_Write and loaded like any other.
+ */
+#define WORLD_MAP "maps/check_map.bsp"
+
+#define WORLD_SIZE 1024.0
+#define WORLD_PILLARS 4
+
+/**
+ * @brief Clusters see this many clusters to either side, and hear twice as many.
+ */
+#define WORLD_PVS_RANGE 24
+
+static bsp_file_t bsp;
+
+static bsp_plane_t planes[256];
+static bsp_node_t nodes[128];
+static bsp_leaf_t leafs[128];
+static uint16_t leaf_brushes[32];
+static bsp_brush_t brushes[32];
+static bsp_brush_side_t brush_sides[32 * 6];
+static bsp_model_t models[2];
+static bsp_area_t areas[2];
+static byte vis_data[0x4000];
+
+/**
+ * @return The index of the positive plane of the pair for the specified axis.
+ */
+static int32_t check_Plane(int32_t axis, vec_t dist) {
+
+	bsp_plane_t *p = &planes[bsp.num_planes];
+
+	VectorClear(p->normal);
+	p->normal[axis] = 1.0;
+	p->dist = dist;
+	p->type = axis;
+
+	p++;
+
+	VectorClear(p->normal);
+	p->normal[axis] = -1.0;
+	p->dist = -dist;
+	p->type = PLANE_ANY_X + axis;
+
+	bsp.num_planes += 2;
+	return bsp.num_planes - 2;
+}
+
+/**
+ * @return The index of a new leaf, optionally containing the specified brush.
+ */
+static int32_t check_Leaf(int32_t contents, int32_t brush) {
+
+	bsp_leaf_t *leaf = &leafs[bsp.num_leafs];
+
+	leaf->contents = contents;
+
+	if (contents & MASK_SOLID) {
+		leaf->cluster = -1;
+	} else { // every empty leaf is a cluster, in the only area
+		leaf->cluster = bsp.vis_data.vis->num_clusters++;
+		leaf->area = 1;
+	}
+
+	if (brush != -1) {
+		leaf->first_leaf_brush = bsp.num_leaf_brushes;
+		leaf->num_leaf_brushes = 1;
+
+		leaf_brushes[bsp.num_leaf_brushes++] = brush;
+	}
+
+	return bsp.num_leafs++;
+}
+
+/**
+ * @return The index of a new axis-aligned brush, with its sides in the order
+ * that Cm_SetupBspBrushes expects.
+ */
+static int32_t check_Brush(const vec3_t mins, const vec3_t maxs, int32_t contents) {
+
+	bsp_brush_t *brush = &brushes[bsp.num_brushes];
+
+	brush->first_brush_side = bsp.num_brush_sides;
+	brush->num_sides = 6;
+	brush->contents = contents;
+
+	for (int32_t i = 0; i < 3; i++) {
+		bsp_brush_side_t *side = &brush_sides[bsp.num_brush_sides];
+
+		side[0].plane_num = check_Plane(i, mins[i]) + 1;
+		side[0].surf_num = USHRT_MAX;
+
+		side[1].plane_num = check_Plane(i, maxs[i]);
+		side[1].surf_num = USHRT_MAX;
+
+		bsp.num_brush_sides += 2;
+	}
+
+	return bsp.num_brushes++;
+}
+
+/**
+ * @return The index of a new node on the specified plane.
+ */
+static int32_t check_Node(int32_t plane_num, int32_t front, int32_t back) {
+
+	bsp_node_t *node = &nodes[bsp.num_nodes];
+
+	node->plane_num = plane_num;
+	node->children[0] = front;
+	node->children[1] = back;
+
+	return bsp.num_nodes++;
+}
+
+/**
+ * @return The head node of a subtree that carves the specified brush out of
+ * empty space.
+ */
+static int32_t check_BrushTree(int32_t brush_num) {
+
+	const bsp_brush_t *brush = &brushes[brush_num];
+	int32_t child = -1 - check_Leaf(brush->contents, brush_num);
+
+	for (int32_t i = 5; i >= 0; i--) {
+		const int32_t plane_num = brush_sides[brush->first_brush_side + i].plane_num;
+		const int32_t empty = -1 - check_Leaf(0, -1);
+
+		if (plane_num & 1) { // the brush is in front of the positive plane
+			child = check_Node(plane_num & ~1, child, empty);
+		} else {
+			child = check_Node(plane_num, empty, child);
+		}
+	}
+
+	return child;
+}
+
+/**
+ * @return The head node of a subtree for the specified pillars, separating
+ * them along alternating axes.
+ */
+static int32_t check_PillarTree(const int32_t *pillars, int32_t count, int32_t axis) {
+
+	if (count == 1) {
+		return check_BrushTree(pillars[0]);
+	}
+
+	const bsp_brush_t *a = &brushes[pillars[0]];
+	const bsp_brush_t *b = &brushes[pillars[count - 1]];
+
+	const vec_t a_max = planes[brush_sides[a->first_brush_side + axis * 2 + 1].plane_num].dist;
+	const vec_t b_min = -planes[brush_sides[b->first_brush_side + axis * 2].plane_num].dist;
+
+	if (a_max >= b_min) { // not separable on this axis
+		return check_PillarTree(pillars, count, axis ^ 1);
+	}
+
+	// the pillars are sorted, so split them in half
+	int32_t half = count / 2;
+	const int32_t plane_num = check_Plane(axis, 0.0);
+
+	const bsp_brush_t *c = &brushes[pillars[half]];
+	while (half > 0) {
+		const vec_t max = planes[brush_sides[brushes[pillars[half - 1]].first_brush_side + axis * 2 + 1].plane_num].dist;
+		const vec_t min = -planes[brush_sides[c->first_brush_side + axis * 2].plane_num].dist;
+
+		if (max < min) {
+			planes[plane_num].dist = 0.5 * (max + min);
+			planes[plane_num + 1].dist = -planes[plane_num].dist;
+			break;
+		}
+
+		c = &brushes[pillars[--half]];
+	}
+
+	const int32_t back = check_PillarTree(pillars, half, axis);
+	const int32_t front = check_PillarTree(pillars + half, count - half, axis);
+
+	return check_Node(plane_num, front, back);
+}
+
+/**
+ * @brief Writes the visibility lump. Clusters are numbered in the order their
+ * leafs were created, so that clusters see their neighbors, mostly leafs of
+ * the same brush, and hear twice as far.
+ */
+static void check_WriteVis(void) {
+	byte row[MAX_BSP_LEAFS >> 3];
+
+	bsp_vis_t *vis = bsp.vis_data.vis;
+	const int32_t num_clusters = vis->num_clusters;
+
+	byte *out = (byte *) &vis->bit_offsets[num_clusters];
+
+	for (int32_t i = 0; i < num_clusters; i++) {
+		for (int32_t j = 0; j < 2; j++) {
+			const int32_t range = (j == DVIS_PVS ? WORLD_PVS_RANGE : WORLD_PVS_RANGE * 2);
+
+			memset(row, 0, sizeof(row));
+
+			for (int32_t k = MAX(0, i - range); k <= MIN(num_clusters - 1, i + range); k++) {
+				row[k >> 3] |= 1 << (k & 7);
+			}
+
+			vis->bit_offsets[i][j] = (int32_t) (out - vis_data);
+			out += Bsp_CompressVis(&bsp, row, out);
+		}
+	}
+
+	bsp.vis_data_size = (int32_t) (out - vis_data);
+}
+
+/**
+ * @brief Writes the test map.
+ */
+static void check_WriteMap(void) {
+
+	memset(&bsp, 0, sizeof(bsp));
+
+	bsp.planes = planes;
+	bsp.nodes = nodes;
+	bsp.leafs = leafs;
+	bsp.leaf_brushes = leaf_brushes;
+	bsp.brushes = brushes;
+	bsp.brush_sides = brush_sides;
+	bsp.models = models;
+	bsp.areas = areas;
+	bsp.vis_data.raw = vis_data;
+
+	memset(vis_data, 0, sizeof(vis_data));
+
+	check_Leaf(CONTENTS_SOLID, -1); // leaf 0 is always solid
+
+	// the floor, beneath the origin
+	const vec3_t floor_mins = { -WORLD_SIZE, -WORLD_SIZE, -64.0 };
+	const vec3_t floor_maxs = { WORLD_SIZE, WORLD_SIZE, 0.0 };
+
+	const int32_t floor = check_Brush(floor_mins, floor_maxs, CONTENTS_SOLID);
+
+	// a grid of pillars, sorted along x, then y
+	int32_t pillars[WORLD_PILLARS * WORLD_PILLARS];
+	for (int32_t i = 0; i < WORLD_PILLARS; i++) {
+		for (int32_t j = 0; j < WORLD_PILLARS; j++) {
+			const vec_t step = 2.0 * WORLD_SIZE / WORLD_PILLARS;
+
+			const vec3_t mins = { -WORLD_SIZE + (i + 0.5) * step - 32.0, -WORLD_SIZE + (j + 0.5) * step - 32.0, 0.0 };
+			const vec3_t maxs = { mins[0] + 64.0, mins[1] + 64.0, 256.0 };
+
+			pillars[i * WORLD_PILLARS + j] = check_Brush(mins, maxs, CONTENTS_SOLID);
+		}
+	}
+
+	// the root splits the floor from the pillars
+	const int32_t root = check_Node(0, 0, 0);
+	const int32_t root_plane = check_Plane(2, 0.0);
+
+	const int32_t back = check_BrushTree(floor);
+	const int32_t front = check_PillarTree(pillars, lengthof(pillars), 0);
+
+	nodes[root].plane_num = root_plane;
+	nodes[root].children[0] = front;
+	nodes[root].children[1] = back;
+
+	VectorSet(models[0].mins, -WORLD_SIZE, -WORLD_SIZE, -64.0);
+	VectorSet(models[0].maxs, WORLD_SIZE, WORLD_SIZE, 256.0);
+	models[0].head_node = root;
+
+	// the platform, an inline model
+	const vec3_t platform_mins = { -64.0, -64.0, -8.0 };
+	const vec3_t platform_maxs = { 64.0, 64.0, 8.0 };
+
+	const int32_t platform = check_Brush(platform_mins, platform_maxs, CONTENTS_SOLID);
+
+	VectorCopy(platform_mins, models[1].mins);
+	VectorCopy(platform_maxs, models[1].maxs);
+	models[1].head_node = check_BrushTree(platform);
+
+	bsp.num_models = lengthof(models);
+	bsp.num_areas = lengthof(areas);
+
+	check_WriteVis();
+
+	file_t *file = Fs_OpenWrite(WORLD_MAP);
+	ck_assert(file != NULL);
+
+	Bsp_Write(file, &bsp, BSP_VERSION_QUETOO);
+
+	ck_assert(Fs_Close(file));
+}
@@ -45,26 +45,53 @@ void teardown(void) {
 	Mem_Shutdown();
 }
 
+/**
+ * @brief Initializes the master address for the specified IPv4 or IPv6 host.
+ */
+static void check_Ms_Address(const char *host, ms_addr_t *addr) {
+	struct sockaddr_storage storage;
+	memset(&storage, 0, sizeof(storage));
+
+	if (strchr(host, ':')) {
+		struct sockaddr_in6 *in6 = (struct sockaddr_in6 *) &storage;
+
+		in6->sin6_family = AF_INET6;
+		in6->sin6_port = htons(PORT_SERVER);
+		ck_assert(inet_pton(AF_INET6, host, &in6->sin6_addr) == 1);
+	} else {
+		struct sockaddr_in *in = (struct sockaddr_in *) &storage;
+
+		in->sin_family = AF_INET;
+		in->sin_port = htons(PORT_SERVER);
+		ck_assert(inet_pton(AF_INET, host, &in->sin_addr) == 1);
+	}
+
+	Ms_Address(&storage, addr);
+}
+
 START_TEST(check_Ms_AddServer) {
 	ck_assert_int_eq(g_list_length(ms_servers), 0);
 
-	struct sockaddr_in addr;
-	memset(&addr, 0, sizeof(addr));
-
-	*(in_addr_t *) &addr.sin_addr = inet_addr("192.168.1.1");
-	addr.sin_family = AF_INET;
-	addr.sin_port = htons(PORT_SERVER);
+	ms_addr_t addr;
+	check_Ms_Address("192.168.1.1", &addr);
 
 	Ms_AddServer(&addr);
 	ck_assert_int_eq(g_list_length(ms_servers), 1);
 
 	ms_server_t *server = g_list_nth_data(ms_servers, 0);
-	ck_assert_msg(server->addr.sin_addr.s_addr == addr.sin_addr.s_addr, "Corrupt server address");
+	ck_assert_msg(IN6_ARE_ADDR_EQUAL(&server->addr.sin6_addr, &addr.sin6_addr), "Corrupt server address");
+	ck_assert_str_eq(atos(&server->addr), va("192.168.1.1:%d", PORT_SERVER));
+
+	Ms_AddServer(&addr);
+	ck_assert_int_eq(g_list_length(ms_servers), 1);
+
+	// the same host, arriving on a dual-stack socket, is the same server
+	check_Ms_Address("::ffff:192.168.1.1", &addr);
 
 	Ms_AddServer(&addr);
 	ck_assert_int_eq(g_list_length(ms_servers), 1);
 
-	*(in_addr_t *) &addr.sin_addr = inet_addr("192.168.1.2");
+	check_Ms_Address("192.168.1.2", &addr);
 
 	Ms_AddServer(&addr);
 	ck_assert_int_eq(g_list_length(ms_servers), 2);
@@ -75,30 +102,47 @@ START_TEST(check_Ms_AddServer) {
 	ms_server_t *s = Ms_GetServer(&addr);
 	ck_assert_msg(!s, "Server was not NULL");
 
+	check_Ms_Address("2001:db8::1", &addr);
+
+	Ms_AddServer(&addr);
+	ck_assert_int_eq(g_list_length(ms_servers), 2);
+
+	s = Ms_GetServer(&addr);
+	ck_assert_msg(s != NULL, "Server was NULL");
+	ck_assert_str_eq(atos(&s->addr), va("[2001:db8::1]:%d", PORT_SERVER));
+
+	Ms_RemoveServer(&addr);
+	Ms_RemoveServer(&server->addr);
+	ck_assert_int_eq(g_list_length(ms_servers), 0);
+
 } END_TEST
 
 START_TEST(check_Ms_BlacklistServer) {
 	file_t *f = Fs_OpenAppend("servers-blacklist");
 	ck_assert_msg(f != NULL, "Failed to open servers-blacklist");
 
-	const char *test = "192.168.0.*\n";
+	const char *test = "192.168.0.*\n2001:db8:*\n";
 	int64_t len = Fs_Write(f, (void *) test, 1, strlen(test));
 
 	ck_assert_msg((size_t) len == strlen(test), "Failed to write servers-blacklist");
 	ck_assert_msg(Fs_Close(f), "Failed to close servers-blacklist");
 
-	struct sockaddr_in addr;
-	memset(&addr, 0, sizeof(addr));
+	ms_addr_t addr;
+
+	check_Ms_Address("192.168.0.1", &addr);
+	ck_assert_msg(Ms_BlacklistServer(&addr), "Missed %s", atos(&addr));
 
-	*(in_addr_t *) &addr.sin_addr = inet_addr("192.168.0.1");
-	addr.sin_family = AF_INET;
-	addr.sin_port = htons(PORT_SERVER);
+	check_Ms_Address("::ffff:192.168.0.1", &addr);
+	ck_assert_msg(Ms_BlacklistServer(&addr), "Missed %s", atos(&addr));
 
-	ck_assert_msg(Ms_BlacklistServer(&addr), "Missed %s", inet_ntoa(addr.sin_addr));
+	check_Ms_Address("2001:db8::1", &addr);
+	ck_assert_msg(Ms_BlacklistServer(&addr), "Missed %s", atos(&addr));
 
-	*(in_addr_t *) &addr.sin_addr = inet_addr("127.0.0.1");
+	check_Ms_Address("127.0.0.1", &addr);
+	ck_assert_msg(!Ms_BlacklistServer(&addr), "False positive for %s", atos(&addr));
 
-	ck_assert_msg(!Ms_BlacklistServer(&addr), "False positive for %s", inet_ntoa(addr.sin_addr));
+	check_Ms_Address("::1", &addr);
+	ck_assert_msg(!Ms_BlacklistServer(&addr), "False positive for %s", atos(&addr));
 
 } END_TEST
 
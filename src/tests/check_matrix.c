@@ -0,0 +1,261 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include <SDL_timer.h>
+
+#include "tests.h"
+#include "matrix.h"
+
+/**
+ * @brief The tolerance, relative to the magnitude of the largest element, that
+ * the single precision functions must agree with their counterparts to.
+ */
+#define MATRIX_EPSILON 1e-5f
+
+#define MATRIX_COUNT 256
+#define MATRIX_BENCH_ITERATIONS 4000
+
+quetoo_t quetoo;
+
+static vec3_t origins[MATRIX_COUNT], angles[MATRIX_COUNT];
+static vec_t scales[MATRIX_COUNT];
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	for (size_t i = 0; i < MATRIX_COUNT; i++) {
+		for (int32_t j = 0; j < 3; j++) {
+			origins[i][j] = Randomfr(MIN_WORLD_COORD, MAX_WORLD_COORD);
+			angles[i][j] = Randomfr(-360.0, 360.0);
+		}
+
+		scales[i] = Randomfr(0.25, 4.0);
+	}
+
+	// the axial and yaw-only cases of Matrix4x4_CreateFromQuakeEntity
+	VectorClear(angles[0]);
+	angles[1][PITCH] = angles[1][ROLL] = 0.0;
+	angles[2][ROLL] = 0.0;
+	scales[0] = scales[1] = scales[2] = 1.0;
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+	Mem_Shutdown();
+}
+
+/**
+ * @return True if the specified matrices agree within the tolerance, relative
+ * to `max` or the largest element of `b`.
+ */
+static _Bool check_Matrix_Equal(const matrix4x4_t *a, const matrix4x4_t *b, vec_t max) {
+
+	for (int32_t i = 0; i < 4; i++) {
+		for (int32_t j = 0; j < 4; j++) {
+			max = MAX(max, fabsf(b->m[i][j]));
+		}
+	}
+
+	for (int32_t i = 0; i < 4; i++) {
+		for (int32_t j = 0; j < 4; j++) {
+			if (fabsf(a->m[i][j] - b->m[i][j]) > MATRIX_EPSILON * max) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+START_TEST(check_Matrix4x4_CreateFromEntityf) {
+
+	for (size_t i = 0; i < MATRIX_COUNT; i++) {
+		matrix4x4_t a, b;
+
+		Matrix4x4_CreateFromEntityf(&a, origins[i], angles[i], scales[i]);
+		Matrix4x4_CreateFromEntity(&b, origins[i], angles[i], scales[i]);
+
+		ck_assert_msg(check_Matrix_Equal(&a, &b, 1.0), "%zu", i);
+	}
+
+} END_TEST
+
+START_TEST(check_Matrix4x4_Concatf) {
+
+	for (size_t i = 0; i < MATRIX_COUNT - 1; i++) {
+		matrix4x4_t a, b, c, d;
+
+		Matrix4x4_CreateFromEntity(&a, origins[i], angles[i], scales[i]);
+		Matrix4x4_CreateFromEntity(&b, origins[i + 1], angles[i + 1], scales[i + 1]);
+
+		Matrix4x4_Concatf(&c, &a, &b);
+		Matrix4x4_Concat(&d, &a, &b);
+
+		ck_assert_msg(memcmp(&c, &d, sizeof(c)) == 0, "%zu", i);
+
+		// in place, for either operand
+		c = a;
+		Matrix4x4_Concatf(&c, &c, &b);
+		ck_assert(memcmp(&c, &d, sizeof(c)) == 0);
+
+		c = b;
+		Matrix4x4_Concatf(&c, &a, &c);
+		ck_assert(memcmp(&c, &d, sizeof(c)) == 0);
+	}
+
+} END_TEST
+
+START_TEST(check_Matrix4x4_Invert_Simplef) {
+
+	for (size_t i = 0; i < MATRIX_COUNT; i++) {
+		matrix4x4_t m, a, b, c;
+
+		Matrix4x4_CreateFromEntity(&m, origins[i], angles[i], scales[i]);
+
+		Matrix4x4_Invert_Simplef(&a, &m);
+		Matrix4x4_Invert_Simple(&b, &m);
+
+		ck_assert_msg(check_Matrix_Equal(&a, &b, 1.0), "%zu", i);
+
+		// the inverse must undo the transform, to within the precision of its translation
+		Matrix4x4_Concatf(&c, &m, &a);
+		ck_assert(check_Matrix_Equal(&c, &matrix4x4_identity, VectorLength(origins[i])));
+
+		// in place
+		Matrix4x4_Invert_Simplef(&m, &m);
+		ck_assert(memcmp(&m, &a, sizeof(m)) == 0);
+	}
+
+} END_TEST
+
+START_TEST(check_Matrix4x4_Transformf) {
+
+	for (size_t i = 0; i < MATRIX_COUNT; i++) {
+		matrix4x4_t m;
+		vec3_t a, b;
+
+		Matrix4x4_CreateFromEntity(&m, origins[i], angles[i], scales[i]);
+
+		Matrix4x4_Transformf(&m, origins[(i + 1) % MATRIX_COUNT], a);
+		Matrix4x4_Transform(&m, origins[(i + 1) % MATRIX_COUNT], b);
+
+		ck_assert_msg(VectorCompare(a, b), "%zu", i);
+
+		// in place
+		VectorCopy(origins[(i + 1) % MATRIX_COUNT], a);
+		Matrix4x4_Transformf(&m, a, a);
+		ck_assert(VectorCompare(a, b));
+	}
+
+} END_TEST
+
+/**
+ * @brief Reports the throughput of the double and single precision paths for
+ * the per-entity matrix work of a frame: create, invert, concatenate and transform.
+ */
+START_TEST(check_Matrix4x4_Throughput) {
+	static matrix4x4_t matrices[MATRIX_COUNT], inverses[MATRIX_COUNT], modelviews[MATRIX_COUNT];
+	static vec3_t points[MATRIX_COUNT];
+	matrix4x4_t view;
+
+	Matrix4x4_CreateFromEntity(&view, origins[0], angles[3], 1.0);
+
+	const double n = MATRIX_COUNT * (double) MATRIX_BENCH_ITERATIONS / 1000.0;
+	uint32_t start, elapsed;
+
+	start = SDL_GetTicks();
+	for (int32_t i = 0; i < MATRIX_BENCH_ITERATIONS; i++) {
+		for (size_t j = 0; j < MATRIX_COUNT; j++) {
+			Matrix4x4_CreateFromEntity(&matrices[j], origins[j], angles[j], scales[j]);
+			Matrix4x4_Invert_Simple(&inverses[j], &matrices[j]);
+			Matrix4x4_Concat(&modelviews[j], &view, &matrices[j]);
+			Matrix4x4_Transform(&inverses[j], origins[i & (MATRIX_COUNT - 1)], points[j]);
+		}
+	}
+	elapsed = MAX(SDL_GetTicks() - start, 1u);
+
+	printf("double: %.1fM entities/s\n", n / elapsed);
+
+	start = SDL_GetTicks();
+	for (int32_t i = 0; i < MATRIX_BENCH_ITERATIONS; i++) {
+		for (size_t j = 0; j < MATRIX_COUNT; j++) {
+			Matrix4x4_CreateFromEntityf(&matrices[j], origins[j], angles[j], scales[j]);
+			Matrix4x4_Invert_Simplef(&inverses[j], &matrices[j]);
+			Matrix4x4_Concatf(&modelviews[j], &view, &matrices[j]);
+			Matrix4x4_Transformf(&inverses[j], origins[i & (MATRIX_COUNT - 1)], points[j]);
+		}
+	}
+	elapsed = MAX(SDL_GetTicks() - start, 1u);
+
+	printf("single: %.1fM entities/s\n", n / elapsed);
+
+	start = SDL_GetTicks();
+	for (int32_t i = 0; i < MATRIX_BENCH_ITERATIONS * 16; i++) {
+		for (size_t j = 0; j < MATRIX_COUNT; j++) {
+			Matrix4x4_Transform(&inverses[j], origins[i & (MATRIX_COUNT - 1)], points[j]);
+		}
+	}
+	elapsed = MAX(SDL_GetTicks() - start, 1u);
+
+	printf("Matrix4x4_Transform: %.0fM transforms/s\n", n * 16 / elapsed);
+
+	start = SDL_GetTicks();
+	for (int32_t i = 0; i < MATRIX_BENCH_ITERATIONS * 16; i++) {
+		for (size_t j = 0; j < MATRIX_COUNT; j++) {
+			Matrix4x4_Transformf(&inverses[j], origins[i & (MATRIX_COUNT - 1)], points[j]);
+		}
+	}
+	elapsed = MAX(SDL_GetTicks() - start, 1u);
+
+	printf("Matrix4x4_Transformf: %.0fM transforms/s\n", n * 16 / elapsed);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_matrix");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Matrix4x4_CreateFromEntityf);
+	tcase_add_test(tcase, check_Matrix4x4_Concatf);
+	tcase_add_test(tcase, check_Matrix4x4_Invert_Simplef);
+	tcase_add_test(tcase, check_Matrix4x4_Transformf);
+	tcase_add_test(tcase, check_Matrix4x4_Throughput);
+
+	Suite *suite = suite_create("check_matrix");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
@@ -19,9 +19,16 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include <SDL_thread.h>
+#include <SDL_timer.h>
+
 #include "tests.h"
 #include "mem.h"
 
+#define MEM_BENCH_THREADS 8
+#define MEM_BENCH_ITERATIONS 100000
+#define MEM_BENCH_LIVE 64
+
 quetoo_t quetoo;
 
 /**
@@ -62,6 +69,43 @@ START_TEST(check_Mem_LinkMalloc) {
 
 } END_TEST
 
+START_TEST(check_Mem_Free_Siblings) {
+	const int32_t count = 100000;
+
+	byte *parent = Mem_Malloc(1);
+	byte **children = malloc(count * sizeof(byte *));
+
+	for (int32_t i = 0; i < count; i++) {
+		children[i] = Mem_LinkMalloc(1, parent);
+	}
+
+	for (int32_t i = count - 1; i > 0; i--) {
+		const int32_t j = g_random_int_range(0, i + 1);
+		byte *child = children[i];
+		children[i] = children[j];
+		children[j] = child;
+	}
+
+	ck_assert(Mem_Size() == (size_t) count + 1);
+
+	const uint64_t start = SDL_GetPerformanceCounter();
+
+	for (int32_t i = 0; i < count; i++) {
+		Mem_Free(children[i]);
+	}
+
+	const double seconds = (SDL_GetPerformanceCounter() - start) / (double) SDL_GetPerformanceFrequency();
+
+	printf("Mem_Free: %d siblings in %.3fms\n", count, seconds * 1000.0);
+
+	ck_assert(Mem_Size() == 1);
+
+	Mem_Free(parent);
+	free(children);
+
+	ck_assert(Mem_Size() == 0);
+} END_TEST
+
 START_TEST(check_Mem_CopyString) {
 	char *test = Mem_CopyString("test");
 
@@ -72,6 +116,263 @@ START_TEST(check_Mem_CopyString) {
 	ck_assert(Mem_Size() == 0);
 } END_TEST
 
+START_TEST(check_Mem_Realloc) {
+	char *test = Mem_Malloc(8);
+	strcpy(test, "quetoo");
+
+	Mem_LinkMalloc(1, test);
+
+	test = Mem_Realloc(test, 4096);
+	ck_assert_str_eq(test, "quetoo");
+	ck_assert(Mem_Size() == 4097);
+
+	test = Mem_Realloc(test, 16);
+	ck_assert_str_eq(test, "quetoo");
+	ck_assert(Mem_Size() == 17);
+
+	Mem_Free(test);
+
+	ck_assert(Mem_Size() == 0);
+} END_TEST
+
+START_TEST(check_Mem_FreeTag) {
+	byte *level = Mem_TagMalloc(1, MEM_TAG_GAME_LEVEL);
+	byte *large = Mem_TagMalloc(0x100000, MEM_TAG_GAME_LEVEL);
+
+	Mem_LinkMalloc(1, level);
+	Mem_Link(Mem_Malloc(1), level);
+
+	byte *other = Mem_TagMalloc(1, MEM_TAG_GAME);
+
+	ck_assert(Mem_Size() == 0x100004);
+
+	Mem_Free(large);
+
+	ck_assert(Mem_Size() == 4);
+
+	Mem_FreeTag(MEM_TAG_GAME_LEVEL);
+
+	ck_assert(Mem_Size() == 1);
+
+	Mem_Free(other);
+
+	ck_assert(Mem_Size() == 0);
+} END_TEST
+
+START_TEST(check_Mem_FreeTag_Throughput) {
+	const mem_tag_t tags[] = { MEM_TAG_GAME, MEM_TAG_GAME_LEVEL };
+
+	for (size_t i = 0; i < lengthof(tags); i++) {
+
+		for (int32_t j = 0; j < MEM_BENCH_ITERATIONS; j++) {
+			Mem_TagMalloc(8 + (j * 37) % 512, tags[i]);
+		}
+
+		const uint64_t start = SDL_GetPerformanceCounter();
+
+		Mem_FreeTag(tags[i]);
+
+		const double seconds = (SDL_GetPerformanceCounter() - start) / (double) SDL_GetPerformanceFrequency();
+
+		printf("Mem_FreeTag(%d): %d blocks in %.3fms\n", tags[i], MEM_BENCH_ITERATIONS, seconds * 1000.0);
+
+		ck_assert(Mem_Size() == 0);
+	}
+} END_TEST
+
+#define MEM_THREAD_BLOCKS 32
+
+/**
+ * @brief Allocates and frees a batch of blocks, returning them to the shared
+ * pool on exit.
+ */
+static int32_t Mem_FreeThread(void *data) {
+
+	void **blocks = (void **) data;
+
+	for (int32_t i = 0; i < MEM_THREAD_BLOCKS; i++) {
+		blocks[i] = Mem_Malloc(1400);
+	}
+
+	for (int32_t i = 0; i < MEM_THREAD_BLOCKS; i++) {
+		Mem_Free(blocks[i]);
+	}
+
+	Mem_ThreadShutdown();
+	return 0;
+}
+
+START_TEST(check_Mem_ThreadShutdown) {
+	void *blocks[MEM_THREAD_BLOCKS];
+
+	SDL_WaitThread(SDL_CreateThread(Mem_FreeThread, __func__, blocks), NULL);
+
+	// the exited thread's blocks are reused, rather than carved from its slab
+	void *block = Mem_Malloc(1400);
+
+	_Bool reused = false;
+	for (int32_t i = 0; i < MEM_THREAD_BLOCKS; i++) {
+		reused |= block == blocks[i];
+	}
+
+	ck_assert(reused);
+
+	Mem_Free(block);
+} END_TEST
+
+/**
+ * @brief Allocates a tagged block with a child from another thread's heap.
+ */
+static int32_t Mem_AllocThread(void *data) {
+
+	byte **block = (byte **) data;
+
+	*block = Mem_TagMalloc(4, MEM_TAG_GAME);
+	Mem_LinkMalloc(4, *block);
+
+	return 0;
+}
+
+START_TEST(check_Mem_Heaps) {
+	byte *blocks[4];
+
+	for (size_t i = 0; i < lengthof(blocks); i++) {
+		SDL_WaitThread(SDL_CreateThread(Mem_AllocThread, __func__, &blocks[i]), NULL);
+	}
+
+	ck_assert(Mem_Size() == 32);
+
+	GArray *stats = Mem_Stats();
+
+	ck_assert_int_eq(stats->len, 2);
+
+	for (guint i = 0; i < stats->len; i++) {
+		const mem_stat_t *stat = &g_array_index(stats, mem_stat_t, i);
+
+		ck_assert(stat->size == 32);
+
+		if (stat->tag == MEM_TAG_GAME) {
+			ck_assert_int_eq(stat->count, 4);
+		} else {
+			ck_assert_int_eq(stat->tag, -1);
+		}
+	}
+
+	g_array_free(stats, true);
+
+	byte *parent = Mem_Malloc(1);
+
+	Mem_Link(blocks[0], parent);
+	Mem_Link(blocks[1], parent);
+
+	ck_assert(Mem_Size() == 33);
+
+	Mem_Free(parent);
+
+	ck_assert(Mem_Size() == 16);
+
+	Mem_Free(blocks[2]);
+	Mem_FreeTag(MEM_TAG_GAME);
+
+	ck_assert(Mem_Size() == 0);
+
+} END_TEST
+
+typedef struct {
+	_Bool system;
+	SDL_mutex *lock;
+	GHashTable *blocks;
+} mem_bench_t;
+
+/**
+ * @brief Allocates and frees small blocks, keeping a window of live blocks.
+ * The system variant mirrors the previous Mem_ path: calloc plus a global
+ * lock around a hash table insert and removal.
+ */
+static int32_t Mem_Bench(void *data) {
+	mem_bench_t *bench = (mem_bench_t *) data;
+	void *live[MEM_BENCH_LIVE] = { NULL };
+
+	for (int32_t i = 0; i < MEM_BENCH_ITERATIONS; i++) {
+		const size_t size = 8 + (i * 37) % 512;
+		void **slot = &live[i % MEM_BENCH_LIVE];
+
+		if (bench->system) {
+			if (*slot) {
+				SDL_LockMutex(bench->lock);
+				g_hash_table_remove(bench->blocks, *slot);
+				SDL_UnlockMutex(bench->lock);
+				free(*slot);
+			}
+			*slot = calloc(size, 1);
+			SDL_LockMutex(bench->lock);
+			g_hash_table_add(bench->blocks, *slot);
+			SDL_UnlockMutex(bench->lock);
+		} else {
+			Mem_Free(*slot);
+			*slot = Mem_Malloc(size);
+		}
+	}
+
+	for (int32_t i = 0; i < MEM_BENCH_LIVE; i++) {
+		if (bench->system) {
+			SDL_LockMutex(bench->lock);
+			g_hash_table_remove(bench->blocks, live[i]);
+			SDL_UnlockMutex(bench->lock);
+			free(live[i]);
+		} else {
+			Mem_Free(live[i]);
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @return The throughput, in allocations per second, of the given number of
+ * threads running Mem_Bench.
+ */
+static double Mem_BenchThreads(mem_bench_t *bench, int32_t num_threads) {
+	SDL_Thread *threads[MEM_BENCH_THREADS];
+
+	const uint64_t start = SDL_GetPerformanceCounter();
+
+	for (int32_t i = 0; i < num_threads; i++) {
+		threads[i] = SDL_CreateThread(Mem_Bench, __func__, bench);
+	}
+
+	for (int32_t i = 0; i < num_threads; i++) {
+		SDL_WaitThread(threads[i], NULL);
+	}
+
+	const double seconds = (SDL_GetPerformanceCounter() - start) / (double) SDL_GetPerformanceFrequency();
+
+	return (num_threads * MEM_BENCH_ITERATIONS) / seconds;
+}
+
+START_TEST(check_Mem_Throughput) {
+	mem_bench_t bench = {
+		.lock = SDL_CreateMutex(),
+		.blocks = g_hash_table_new(g_direct_hash, g_direct_equal)
+	};
+
+	for (int32_t num_threads = 1; num_threads <= MEM_BENCH_THREADS; num_threads *= 2) {
+
+		bench.system = true;
+		const double system = Mem_BenchThreads(&bench, num_threads);
+
+		bench.system = false;
+		const double arena = Mem_BenchThreads(&bench, num_threads);
+
+		printf("%d threads: system %.0f allocs/s, arena %.0f allocs/s\n", num_threads, system, arena);
+	}
+
+	ck_assert(Mem_Size() == 0);
+
+	g_hash_table_destroy(bench.blocks);
+	SDL_DestroyMutex(bench.lock);
+} END_TEST
+
 /**
  * @brief Test entry point.
  */
@@ -83,7 +384,14 @@ int32_t main(int32_t argc, char **argv) {
 	tcase_add_checked_fixture(tcase, setup, teardown);
 
 	tcase_add_test(tcase, check_Mem_LinkMalloc);
+	tcase_add_test(tcase, check_Mem_Free_Siblings);
 	tcase_add_test(tcase, check_Mem_CopyString);
+	tcase_add_test(tcase, check_Mem_Realloc);
+	tcase_add_test(tcase, check_Mem_FreeTag);
+	tcase_add_test(tcase, check_Mem_FreeTag_Throughput);
+	tcase_add_test(tcase, check_Mem_Heaps);
+	tcase_add_test(tcase, check_Mem_ThreadShutdown);
+	tcase_add_test(tcase, check_Mem_Throughput);
 
 	Suite *suite = suite_create("check_mem");
 	suite_add_tcase(suite, tcase);
@@ -0,0 +1,1182 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include <SDL_timer.h>
+
+#include "tests.h"
+#include "cmd.h"
+#include "cvar.h"
+#include "filesystem.h"
+#include "net/net_chan.h"
+
+#define NET_DIR_RANDOM 4000000
+#define NET_DIR_BENCH 1000000
+
+#define NET_BITS_FUZZ 2000
+
+#define NET_CHAN_RELIABLE 200
+#define NET_CHAN_TICKS 20000
+
+#define NET_UDP_PORT (PORT_SERVER + 11)
+#define NET_UDP_DATAGRAMS 200000
+#define NET_UDP_BURST 32
+
+#define NET_REPLAY_ENTITIES 64
+#define NET_REPLAY_FRAMES 1200
+
+/**
+ * @brief The age of the cached frame a lagged client is delta'd from, at most.
+ */
+#define NET_REPLAY_RECOVERY (PACKET_BACKUP + (PACKET_BACKUP >> 2))
+
+quetoo_t quetoo;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	Fs_Init(FS_NONE);
+
+	Cmd_Init();
+
+	Cvar_Init();
+
+	Netchan_Init();
+
+	Net_Config(NS_UDP_CLIENT, true);
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	Netchan_Shutdown();
+
+	Cvar_Shutdown();
+
+	Cmd_Shutdown();
+
+	Fs_Shutdown();
+
+	Mem_Shutdown();
+}
+
+/**
+ * @return The index of the nearest approximate normal, by exhaustive search.
+ */
+static int32_t check_Net_DirIndex_BruteForce(const vec3_t dir) {
+	int32_t best = 0;
+	vec_t best_d = 0.0;
+
+	for (int32_t i = 0; i < NUM_APPROXIMATE_NORMALS; i++) {
+		const vec_t d = DotProduct(dir, approximate_normals[i]);
+		if (d > best_d) {
+			best_d = d;
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+/**
+ * @brief Asserts that the specified direction is quantized as by exhaustive search.
+ */
+static void check_Net_DirIndex_Equal(const vec3_t dir) {
+
+	const int32_t a = Net_DirIndex(dir);
+	const int32_t b = check_Net_DirIndex_BruteForce(dir);
+
+	ck_assert_msg(a == b, "%s: %d != %d", vtos(dir), a, b);
+}
+
+START_TEST(check_Net_DirIndex) {
+	vec3_t dir;
+
+	// random directions, normalized or not
+	for (int32_t i = 0; i < NET_DIR_RANDOM; i++) {
+
+		dir[0] = Randomfr(-1.0, 1.0);
+		dir[1] = Randomfr(-1.0, 1.0);
+		dir[2] = Randomfr(-1.0, 1.0);
+
+		if (i & 1) {
+			VectorNormalize(dir);
+		} else {
+			VectorScale(dir, Randomfr(0.001, 1000.0), dir);
+		}
+
+		check_Net_DirIndex_Equal(dir);
+	}
+
+	// the normals themselves, and the midpoints between them, where ties are likeliest
+	for (int32_t i = 0; i < NUM_APPROXIMATE_NORMALS; i++) {
+		check_Net_DirIndex_Equal(approximate_normals[i]);
+
+		for (int32_t j = i + 1; j < NUM_APPROXIMATE_NORMALS; j++) {
+			VectorAdd(approximate_normals[i], approximate_normals[j], dir);
+			check_Net_DirIndex_Equal(dir);
+
+			VectorNormalize(dir);
+			check_Net_DirIndex_Equal(dir);
+		}
+	}
+
+	// the cube map cell and face boundaries
+	for (int32_t i = -64; i <= 64; i++) {
+		for (int32_t j = -64; j <= 64; j++) {
+			for (int32_t k = 0; k < 3; k++) {
+				dir[k] = 1.0;
+				dir[(k + 1) % 3] = i / 64.0;
+				dir[(k + 2) % 3] = j / 64.0;
+
+				check_Net_DirIndex_Equal(dir);
+
+				dir[k] = -1.0;
+				check_Net_DirIndex_Equal(dir);
+			}
+		}
+	}
+
+	// degenerate directions
+	const vec3_t degenerate[] = {
+		{ 0.0, 0.0, 0.0 },
+		{ 1e-30, 0.0, -1e-30 },
+		{ 1e30, -1e30, 1.0 },
+		{ NAN, 1.0, 0.0 },
+		{ 0.0, NAN, 0.0 },
+		{ INFINITY, 0.0, 0.0 },
+		{ -INFINITY, INFINITY, 1.0 },
+	};
+
+	for (size_t i = 0; i < lengthof(degenerate); i++) {
+		check_Net_DirIndex_Equal(degenerate[i]);
+	}
+
+} END_TEST
+
+START_TEST(check_Net_WriteDir_Throughput) {
+	static vec3_t dirs[1024];
+	byte data[1024];
+	mem_buf_t msg;
+
+	for (size_t i = 0; i < lengthof(dirs); i++) {
+		dirs[i][0] = Randomfr(-1.0, 1.0);
+		dirs[i][1] = Randomfr(-1.0, 1.0);
+		dirs[i][2] = Randomfr(-1.0, 1.0);
+		VectorNormalize(dirs[i]);
+	}
+
+	Mem_InitBuffer(&msg, data, sizeof(data));
+
+	uint32_t start = SDL_GetTicks();
+	for (int32_t i = 0; i < NET_DIR_BENCH; i++) {
+		if (msg.size == msg.max_size) {
+			Mem_ClearBuffer(&msg);
+		}
+		Net_WriteByte(&msg, check_Net_DirIndex_BruteForce(dirs[i & (lengthof(dirs) - 1)]));
+	}
+	const uint32_t brute_force = MAX(SDL_GetTicks() - start, 1u);
+
+	Mem_ClearBuffer(&msg);
+
+	start = SDL_GetTicks();
+	for (int32_t i = 0; i < NET_DIR_BENCH; i++) {
+		if (msg.size == msg.max_size) {
+			Mem_ClearBuffer(&msg);
+		}
+		Net_WriteDir(&msg, dirs[i & (lengthof(dirs) - 1)]);
+	}
+	const uint32_t table = MAX(SDL_GetTicks() - start, 1u);
+
+	printf("brute force: %.1fM encodes/s, table: %.1fM encodes/s\n",
+	       NET_DIR_BENCH / 1000.0 / brute_force, NET_DIR_BENCH / 1000.0 / table);
+
+} END_TEST
+
+START_TEST(check_Net_VarInt) {
+	byte data[1024];
+	mem_buf_t msg;
+
+	const int32_t values[] = {
+		0, 1, -1, 63, -64, 64, -65, 8191, -8192, 8192, INT16_MAX, INT16_MIN,
+		1 << 20, -(1 << 20), INT32_MAX, INT32_MIN, INT32_MAX - 1, INT32_MIN + 1
+	};
+
+	Mem_InitBuffer(&msg, data, sizeof(data));
+
+	for (size_t i = 0; i < lengthof(values); i++) {
+		Net_WriteVarInt(&msg, values[i]);
+	}
+
+	for (size_t i = 0; i < lengthof(values); i++) {
+		const int32_t v = Net_ReadVarInt(&msg);
+		ck_assert_msg(v == values[i], "%d != %d", v, values[i]);
+	}
+
+	ck_assert(msg.read == msg.size);
+
+	// small magnitudes fit in a single byte
+	Mem_ClearBuffer(&msg);
+
+	Net_WriteVarInt(&msg, 63);
+	Net_WriteVarInt(&msg, -64);
+	ck_assert_int_eq(msg.size, 2);
+
+	Net_WriteVarInt(&msg, INT32_MIN);
+	ck_assert_int_eq(msg.size, 7);
+
+	// truncated input
+	Mem_ClearBuffer(&msg);
+	Net_WriteByte(&msg, 0x80);
+
+	ck_assert_int_eq(Net_ReadVarInt(&msg), 0);
+	ck_assert(msg.read > msg.size);
+
+} END_TEST
+
+START_TEST(check_Net_Bits) {
+	static byte data[0x10000];
+	static uint32_t values[256];
+	static int32_t counts[256];
+	mem_buf_t msg;
+
+	Mem_InitBuffer(&msg, data, sizeof(data));
+
+	for (int32_t i = 0; i < NET_BITS_FUZZ; i++) {
+		const size_t num_values = Randomr(1, lengthof(values));
+		net_bits_t bits;
+
+		Mem_ClearBuffer(&msg);
+
+		// a random mix of fixed width fields, varints and byte-aligned fields
+		Net_BeginWritingBits(&bits, &msg);
+
+		for (size_t j = 0; j < num_values; j++) {
+			counts[j] = Randomr(0, 35) - 2;
+			values[j] = Random();
+
+			switch (Randomr(0, 4)) {
+				case 0:
+					values[j] >>= Randomr(0, 32);
+					break;
+				case 1:
+					values[j] = -(int32_t) (values[j] >> Randomr(0, 32));
+					break;
+				default:
+					break;
+			}
+
+			if (counts[j] == -2) {
+				Net_FlushBits(&bits);
+				Net_WriteByte(&msg, values[j] & 0xff);
+			} else if (counts[j] == -1) {
+				Net_WriteBitsVarInt(&bits, values[j]);
+			} else {
+				Net_WriteBits(&bits, values[j], counts[j]);
+			}
+		}
+
+		Net_FlushBits(&bits);
+
+		Net_BeginReading(&msg);
+		Net_BeginReadingBits(&bits, &msg);
+
+		for (size_t j = 0; j < num_values; j++) {
+			if (counts[j] == -2) {
+				Net_EndReadingBits(&bits);
+				ck_assert_int_eq(Net_ReadByte(&msg), values[j] & 0xff);
+			} else if (counts[j] == -1) {
+				ck_assert_int_eq(Net_ReadBitsVarInt(&bits), (int32_t) values[j]);
+			} else {
+				const uint32_t mask = counts[j] == 32 ? UINT32_MAX : (1u << counts[j]) - 1;
+				ck_assert_uint_eq(Net_ReadBits(&bits, counts[j]), values[j] & mask);
+			}
+		}
+
+		Net_EndReadingBits(&bits);
+
+		ck_assert(msg.read == msg.size);
+	}
+
+	// varints cost five bits plus their zig-zag width
+	Mem_ClearBuffer(&msg);
+
+	net_bits_t bits;
+	Net_BeginWritingBits(&bits, &msg);
+
+	Net_WriteBitsVarInt(&bits, 0);
+	Net_WriteBitsVarInt(&bits, -1);
+	Net_WriteBitsVarInt(&bits, 1);
+	ck_assert_int_eq(bits.count + msg.size * 8, 5 + 6 + 7);
+
+	Net_WriteBitsVarInt(&bits, INT32_MIN);
+	Net_FlushBits(&bits);
+	ck_assert_int_eq(msg.size, (5 + 6 + 7 + 5 + 32 + 7) / 8);
+
+	// reading beyond the end yields zeros, and is detectable
+	Net_BeginReading(&msg);
+	Net_BeginReadingBits(&bits, &msg);
+
+	Net_ReadBits(&bits, 32);
+	Net_ReadBits(&bits, 32);
+	ck_assert(Net_ReadBits(&bits, 32) == 0);
+	ck_assert(msg.read > msg.size);
+
+} END_TEST
+
+/**
+ * @brief A recorded match: players running, turning and jumping, projectiles in
+ * flight, items bobbing and spinning, and beams tracking their targets. The
+ * player state is that of the first player.
+ */
+typedef struct {
+	player_state_t ps[NET_REPLAY_FRAMES];
+	entity_state_t states[NET_REPLAY_FRAMES][NET_REPLAY_ENTITIES];
+} check_net_replay_t;
+
+/**
+ * @brief Records the replay.
+ */
+static void check_Net_Replay(check_net_replay_t *replay) {
+	vec3_t velocities[NET_REPLAY_ENTITIES];
+
+	memset(replay, 0, sizeof(*replay));
+
+	for (int32_t i = 0; i < NET_REPLAY_ENTITIES; i++) {
+		entity_state_t *s = &replay->states[0][i];
+
+		s->number = i + 1;
+		s->model1 = 1 + (i & 7);
+
+		for (int32_t j = 0; j < 3; j++) {
+			s->origin[j] = Randomfr(MIN_WORLD_COORD * 0.5, MAX_WORLD_COORD * 0.5);
+			velocities[i][j] = Randomfr(-400.0, 400.0);
+		}
+
+		s->angles[YAW] = Randomfr(0.0, 360.0);
+	}
+
+	for (int32_t f = 1; f < NET_REPLAY_FRAMES; f++) {
+		for (int32_t i = 0; i < NET_REPLAY_ENTITIES; i++) {
+			entity_state_t *s = &replay->states[f][i];
+
+			*s = replay->states[f - 1][i];
+			s->event = 0;
+
+			// keep everything within the world, as projectiles would be freed
+			for (int32_t j = 0; j < 3; j++) {
+				if (fabsf(s->origin[j]) > MAX_WORLD_COORD) {
+					velocities[i][j] = -copysignf(fabsf(velocities[i][j]), s->origin[j]);
+				}
+			}
+
+			switch (i & 3) {
+				case 0: // players
+					velocities[i][0] += Randomfr(-30.0, 30.0);
+					velocities[i][1] += Randomfr(-30.0, 30.0);
+					velocities[i][2] = (Randomr(0, 40) == 0) ? 270.0 : velocities[i][2] - 800.0 * QUETOO_TICK_SECONDS;
+					VectorMA(s->origin, QUETOO_TICK_SECONDS, velocities[i], s->origin);
+					if (s->origin[2] < 0.0) {
+						s->origin[2] = 0.0;
+						velocities[i][2] = 0.0;
+					}
+					s->angles[PITCH] = Clamp(s->angles[PITCH] + Randomfr(-2.0, 2.0), -89.0, 89.0);
+					s->angles[YAW] += Randomfr(-6.0, 6.0);
+					s->animation1 = (f / 4) & 63;
+					break;
+				case 1: // projectiles
+					VectorMA(s->origin, QUETOO_TICK_SECONDS, velocities[i], s->origin);
+					s->angles[ROLL] += 10.0;
+					break;
+				case 2: // items
+					s->origin[2] = replay->states[0][i].origin[2] + 4.0 * sinf(f * 0.1f);
+					s->angles[YAW] = ClampAngle(f * 3.0);
+					break;
+				case 3: // beams
+					s->origin[0] = replay->states[f][i - 3].origin[0];
+					s->origin[1] = replay->states[f][i - 3].origin[1];
+					s->origin[2] = replay->states[f][i - 3].origin[2] + 20.0;
+					VectorMA(s->origin, 256.0, vec3_up, s->termination);
+					s->termination[0] += 64.0 * cosf(f * 0.05f);
+					break;
+			}
+		}
+
+		player_state_t *ps = &replay->ps[f];
+
+		*ps = replay->ps[f - 1];
+
+		ps->pm_state.type = PM_NORMAL;
+		VectorCopy(replay->states[f][0].origin, ps->pm_state.origin);
+		VectorCopy(velocities[0], ps->pm_state.velocity);
+		ps->pm_state.flags = (ps->pm_state.origin[2] == 0.0) ? 1 : 0;
+		ps->pm_state.gravity = 800;
+		ps->pm_state.view_offset[2] = 22 * 8;
+		PackAngles(replay->states[f][0].angles, ps->pm_state.view_angles);
+
+		if (Randomr(0, 20) == 0) {
+			ps->stats[0] = Randomr(1, 200);
+		}
+		if (Randomr(0, 8) == 0) {
+			ps->stats[1]--;
+		}
+		ps->stats[12] = f / QUETOO_TICK_RATE;
+	}
+}
+
+/**
+ * @brief Writes the frame of the replay as a delta from the frame `from`, or
+ * from the null state if `from` is negative, and returns the number of bytes
+ * written.
+ */
+static size_t check_Net_WriteReplayFrame(const check_net_replay_t *replay, int32_t from, int32_t frame,
+                                         uint16_t protocol, mem_buf_t *msg) {
+
+	static player_state_t null_player_state;
+	static entity_state_t null_state;
+
+	Mem_ClearBuffer(msg);
+
+	if (from < 0) {
+		Net_WriteDeltaPlayerState(msg, &null_player_state, &replay->ps[frame], protocol);
+	} else {
+		Net_WriteDeltaPlayerState(msg, &replay->ps[from], &replay->ps[frame], protocol);
+	}
+
+	for (int32_t i = 0; i < NET_REPLAY_ENTITIES; i++) {
+		if (from < 0) {
+			Net_WriteDeltaEntity(msg, &null_state, &replay->states[frame][i], true, protocol);
+		} else {
+			Net_WriteDeltaEntity(msg, &replay->states[from][i], &replay->states[frame][i], false, protocol);
+		}
+	}
+
+	Net_WriteShort(msg, 0);
+
+	return msg->size;
+}
+
+/**
+ * @brief Reads the frame written by check_Net_WriteReplayFrame.
+ */
+static void check_Net_ReadReplayFrame(mem_buf_t *msg, uint16_t protocol, player_state_t *ps,
+                                      entity_state_t *states) {
+
+	Net_BeginReading(msg);
+
+	Net_ReadDeltaPlayerState(msg, ps, ps, protocol);
+
+	while (true) {
+		const uint16_t number = Net_ReadShort(msg);
+		if (!number) {
+			break;
+		}
+
+		const uint16_t bits = Net_ReadEntityFlags(msg, protocol);
+
+		entity_state_t *s = &states[number - 1];
+		Net_ReadDeltaEntity(msg, s, s, number, bits, protocol);
+	}
+}
+
+/**
+ * @return True if the specified angles are within `epsilon` degrees of each other.
+ */
+static _Bool check_Net_AngleEqual(vec_t a, vec_t b, vec_t epsilon) {
+
+	const vec_t delta = fmodf(fabsf(a - b), 360.0);
+
+	return delta <= epsilon || delta >= 360.0 - epsilon;
+}
+
+/**
+ * @brief Asserts that the specified player states are identical.
+ */
+static void check_Net_PlayerStateEqual(const player_state_t *a, const player_state_t *b) {
+
+	ck_assert_int_eq(a->pm_state.type, b->pm_state.type);
+	ck_assert(VectorCompare(a->pm_state.origin, b->pm_state.origin));
+	ck_assert(VectorCompare(a->pm_state.velocity, b->pm_state.velocity));
+	ck_assert_int_eq(a->pm_state.flags, b->pm_state.flags);
+	ck_assert_int_eq(a->pm_state.time, b->pm_state.time);
+	ck_assert_int_eq(a->pm_state.gravity, b->pm_state.gravity);
+	ck_assert(VectorCompare(a->pm_state.hook_position, b->pm_state.hook_position));
+	ck_assert_int_eq(a->pm_state.hook_length, b->pm_state.hook_length);
+
+	for (int32_t i = 0; i < 3; i++) {
+		ck_assert_int_eq(a->pm_state.view_offset[i], b->pm_state.view_offset[i]);
+		ck_assert_int_eq(a->pm_state.view_angles[i], b->pm_state.view_angles[i]);
+		ck_assert_int_eq(a->pm_state.delta_angles[i], b->pm_state.delta_angles[i]);
+	}
+
+	ck_assert(memcmp(a->stats, b->stats, sizeof(a->stats)) == 0);
+}
+
+START_TEST(check_Net_DeltaPlayerState) {
+	static byte data[0x1000];
+	mem_buf_t msg;
+
+	Mem_InitBuffer(&msg, data, sizeof(data));
+
+	const uint16_t protocols[] = { PROTOCOL_MAJOR_LEGACY, PROTOCOL_MAJOR_QUANTIZED, PROTOCOL_MAJOR_BITS };
+
+	for (size_t p = 0; p < lengthof(protocols); p++) {
+		player_state_t from, to, decoded;
+
+		memset(&from, 0, sizeof(from));
+
+		for (int32_t i = 0; i < NET_BITS_FUZZ; i++) {
+
+			// change a random subset of fields to random values
+			to = from;
+
+			const uint32_t changes = Random();
+
+			if (changes & (1 << 0)) {
+				to.pm_state.type = Randomr(0, PM_FREEZE + 1);
+			}
+			if (changes & (1 << 1)) {
+				to.pm_state.origin[0] = Randomfr(MIN_WORLD_COORD, MAX_WORLD_COORD);
+				to.pm_state.origin[2] = Randomfr(MIN_WORLD_COORD, MAX_WORLD_COORD);
+			}
+			if (changes & (1 << 2)) {
+				to.pm_state.velocity[1] = Randomfr(-800.0, 800.0);
+			}
+			if (changes & (1 << 3)) {
+				to.pm_state.flags = Random();
+			}
+			if (changes & (1 << 4)) {
+				to.pm_state.time = Random();
+			}
+			if (changes & (1 << 5)) {
+				to.pm_state.gravity = Random();
+			}
+			if (changes & (1 << 6)) {
+				to.pm_state.view_offset[Randomr(0, 3)] = Random();
+			}
+			if (changes & (1 << 7)) {
+				to.pm_state.view_angles[Randomr(0, 3)] = Random();
+			}
+			if (changes & (1 << 8)) {
+				to.pm_state.delta_angles[Randomr(0, 3)] = Random();
+			}
+			if (changes & (1 << 9)) {
+				to.pm_state.hook_position[Randomr(0, 3)] = Randomfr(MIN_WORLD_COORD, MAX_WORLD_COORD);
+			}
+			if (changes & (1 << 10)) {
+				to.pm_state.hook_length = Random();
+			}
+			if (changes & (1 << 11)) {
+				for (int32_t j = Randomr(0, 8); j >= 0; j--) {
+					to.stats[Randomr(0, MAX_STATS)] = Random();
+				}
+			}
+
+			Mem_ClearBuffer(&msg);
+			Net_WriteDeltaPlayerState(&msg, &from, &to, protocols[p]);
+
+			Net_BeginReading(&msg);
+			Net_ReadDeltaPlayerState(&msg, &from, &decoded, protocols[p]);
+
+			ck_assert(msg.read == msg.size);
+			check_Net_PlayerStateEqual(&decoded, &to);
+
+			from = to;
+		}
+	}
+
+} END_TEST
+
+START_TEST(check_Net_DeltaEntity) {
+	static check_net_replay_t replay;
+	static byte data[0x20000];
+	mem_buf_t msg;
+
+	check_Net_Replay(&replay);
+
+	Mem_InitBuffer(&msg, data, sizeof(data));
+
+	const uint16_t protocols[] = { PROTOCOL_MAJOR_LEGACY, PROTOCOL_MAJOR_QUANTIZED, PROTOCOL_MAJOR_BITS };
+
+	for (size_t p = 0; p < lengthof(protocols); p++) {
+		entity_state_t client[NET_REPLAY_ENTITIES];
+		player_state_t ps;
+
+		memset(client, 0, sizeof(client));
+		memset(&ps, 0, sizeof(ps));
+
+		for (int32_t f = 0; f < NET_REPLAY_FRAMES; f++) {
+
+			check_Net_WriteReplayFrame(&replay, f - 1, f, protocols[p], &msg);
+			check_Net_ReadReplayFrame(&msg, protocols[p], &ps, client);
+
+			ck_assert(msg.read == msg.size);
+			check_Net_PlayerStateEqual(&ps, &replay.ps[f]);
+
+			for (int32_t i = 0; i < NET_REPLAY_ENTITIES; i++) {
+				const entity_state_t *a = &client[i], *b = &replay.states[f][i];
+
+				ck_assert_int_eq(a->number, b->number);
+				ck_assert_int_eq(a->model1, b->model1);
+				ck_assert_int_eq(a->animation1, b->animation1);
+
+				for (int32_t j = 0; j < 3; j++) {
+					if (protocols[p] == PROTOCOL_MAJOR_LEGACY) {
+						ck_assert(a->origin[j] == b->origin[j]);
+						ck_assert(a->termination[j] == b->termination[j]);
+						ck_assert(check_Net_AngleEqual(a->angles[j], b->angles[j], 360.0 / INT16_MAX));
+					} else {
+						// decoded positions are exactly the quantization of the server's
+						const vec_t origin = lrintf(b->origin[j] * 16.0f) / 16.0f;
+						const vec_t termination = lrintf(b->termination[j] * 16.0f) / 16.0f;
+
+						ck_assert_msg(a->origin[j] == origin, "%d %d: %g != %g", f, i, a->origin[j], origin);
+						ck_assert(a->termination[j] == termination);
+
+						const int32_t q = (int32_t) lrint(ClampAngle(b->angles[j]) * (65536.0 / 360.0)) & 0xffff;
+						const vec_t angle = UnclampAngle(q * (360.0 / 65536.0));
+
+						ck_assert_msg(a->angles[j] == angle, "%d %d: %g != %g", f, i, a->angles[j], angle);
+					}
+				}
+			}
+		}
+	}
+
+	// dequantized positions and angles quantize back to themselves, so that
+	// re-encoding decoded states (e.g. demo baselines) is lossless
+	for (int32_t i = 0; i < 65536 * 2; i++) {
+		const uint16_t protocol = (i & 1) ? PROTOCOL_MAJOR_BITS : PROTOCOL_MAJOR_QUANTIZED;
+		entity_state_t from, to, decoded;
+
+		memset(&from, 0, sizeof(from));
+		memset(&to, 0, sizeof(to));
+
+		to.number = 1;
+		to.origin[0] = (i / 2 - 32768) / 16.0 * 3.0;
+		to.angles[0] = UnclampAngle(i / 2 * 360.0 / 65536.0);
+
+		Mem_ClearBuffer(&msg);
+		Net_WriteDeltaEntity(&msg, &from, &to, true, protocol);
+
+		Net_BeginReading(&msg);
+		Net_ReadShort(&msg);
+		const uint16_t bits = Net_ReadEntityFlags(&msg, protocol);
+
+		Net_ReadDeltaEntity(&msg, &from, &decoded, 1, bits, protocol);
+
+		ck_assert(msg.read == msg.size);
+		ck_assert(decoded.origin[0] == to.origin[0]);
+		ck_assert(decoded.angles[0] == to.angles[0]);
+
+		Mem_ClearBuffer(&msg);
+		Net_WriteDeltaEntity(&msg, &decoded, &to, false, protocol);
+		ck_assert_int_eq(msg.size, 0);
+	}
+
+	// solid boxes and inline models are sent at full precision, across changes
+	// of their solid type
+	const uint16_t quantized[] = { PROTOCOL_MAJOR_QUANTIZED, PROTOCOL_MAJOR_BITS };
+	const uint8_t solids[] = { SOLID_BOX, SOLID_NOT, SOLID_BSP, SOLID_BSP, SOLID_TRIGGER };
+
+	for (size_t p = 0; p < lengthof(quantized); p++) {
+		entity_state_t from, to, decoded;
+
+		memset(&from, 0, sizeof(from));
+
+		for (size_t i = 0; i < lengthof(solids); i++) {
+
+			to = from;
+			to.number = 1;
+			to.solid = solids[i];
+			VectorSet(to.origin, 1.03 + i, -2.71 * i, 64.01);
+
+			Mem_ClearBuffer(&msg);
+			Net_WriteDeltaEntity(&msg, &from, &to, true, quantized[p]);
+
+			Net_BeginReading(&msg);
+			Net_ReadShort(&msg);
+			const uint16_t bits = Net_ReadEntityFlags(&msg, quantized[p]);
+
+			Net_ReadDeltaEntity(&msg, &from, &decoded, 1, bits, quantized[p]);
+
+			ck_assert(msg.read == msg.size);
+			ck_assert_int_eq(decoded.solid, to.solid);
+
+			for (int32_t j = 0; j < 3; j++) {
+				if (to.solid == SOLID_BOX || to.solid == SOLID_BSP) {
+					ck_assert(decoded.origin[j] == to.origin[j]);
+				} else {
+					ck_assert(decoded.origin[j] == lrintf(to.origin[j] * 16.0f) / 16.0f);
+				}
+			}
+
+			from = decoded;
+		}
+	}
+
+} END_TEST
+
+/**
+ * @brief Reports the bytes per frame the replay costs under each protocol.
+ */
+START_TEST(check_Net_DeltaEntity_Replay) {
+	static check_net_replay_t replay;
+	static byte data[0x20000];
+	mem_buf_t msg;
+
+	check_Net_Replay(&replay);
+
+	Mem_InitBuffer(&msg, data, sizeof(data));
+
+	size_t legacy = 0, quantized = 0, bits = 0;
+
+	for (int32_t f = 1; f < NET_REPLAY_FRAMES; f++) {
+		legacy += check_Net_WriteReplayFrame(&replay, f - 1, f, PROTOCOL_MAJOR_LEGACY, &msg);
+		quantized += check_Net_WriteReplayFrame(&replay, f - 1, f, PROTOCOL_MAJOR_QUANTIZED, &msg);
+		bits += check_Net_WriteReplayFrame(&replay, f - 1, f, PROTOCOL_MAJOR_BITS, &msg);
+	}
+
+	const double frames = NET_REPLAY_FRAMES - 1;
+
+	printf("%d entities: legacy %.1f bytes/frame, quantized %.1f bytes/frame, bits %.1f bytes/frame\n",
+	       NET_REPLAY_ENTITIES, legacy / frames, quantized / frames, bits / frames);
+
+	ck_assert(quantized < legacy);
+	ck_assert(bits < quantized);
+
+} END_TEST
+
+/**
+ * @brief Reports the bytes a client that has fallen behind its frame backup
+ * costs to recover, when delta'd from the baselines and from its cached frame.
+ */
+START_TEST(check_Net_DeltaEntity_Recovery) {
+	static check_net_replay_t replay;
+	static byte data[0x20000];
+	mem_buf_t msg;
+
+	check_Net_Replay(&replay);
+
+	Mem_InitBuffer(&msg, data, sizeof(data));
+
+	size_t baseline = 0, cached = 0;
+	int32_t recoveries = 0;
+
+	for (int32_t f = NET_REPLAY_RECOVERY; f < NET_REPLAY_FRAMES; f++, recoveries++) {
+
+		// the replay's first frame is its baselines, and a null player state
+		baseline += check_Net_WriteReplayFrame(&replay, 0, f, PROTOCOL_MAJOR_CACHE, &msg);
+
+		cached += check_Net_WriteReplayFrame(&replay, f - NET_REPLAY_RECOVERY, f, PROTOCOL_MAJOR_CACHE, &msg);
+
+		entity_state_t client[NET_REPLAY_ENTITIES];
+		player_state_t ps = replay.ps[f - NET_REPLAY_RECOVERY];
+
+		memcpy(client, replay.states[f - NET_REPLAY_RECOVERY], sizeof(client));
+
+		check_Net_ReadReplayFrame(&msg, PROTOCOL_MAJOR_CACHE, &ps, client);
+		ck_assert(msg.read == msg.size);
+	}
+
+	printf("%d entities: recovery from baselines %.1f bytes, from cached frame %.1f bytes\n",
+	       NET_REPLAY_ENTITIES, baseline / (double) recoveries, cached / (double) recoveries);
+
+	ck_assert(cached < baseline);
+
+} END_TEST
+
+/**
+ * @brief Writes a block of `len` bytes, identified by `id`, to the message.
+ */
+static void check_Netchan_WriteBlock(mem_buf_t *msg, int32_t id, int32_t len) {
+
+	Net_WriteLong(msg, id);
+	Net_WriteLong(msg, len);
+
+	for (int32_t i = 0; i < len; i++) {
+		Net_WriteByte(msg, (byte) (id * 31 + i));
+	}
+}
+
+/**
+ * @brief Reads a block written by check_Netchan_WriteBlock, returning its id.
+ */
+static int32_t check_Netchan_ReadBlock(mem_buf_t *msg) {
+
+	const int32_t id = Net_ReadLong(msg);
+	const int32_t len = Net_ReadLong(msg);
+
+	ck_assert(len >= 0 && msg->read + len <= msg->size);
+
+	for (int32_t i = 0; i < len; i++) {
+		ck_assert_int_eq(Net_ReadByte(msg), (byte) (id * 31 + i));
+	}
+
+	return id;
+}
+
+/**
+ * @brief Sends reliable config string bursts and unreliable frames larger than
+ * a single datagram through the loopback channel, with loss and reordering.
+ */
+START_TEST(check_Netchan_Fragments) {
+	static net_chan_t server, client;
+	static byte data[MAX_MSG_SIZE];
+	mem_buf_t unreliable;
+
+	net_addr_t addr = { .type = NA_LOOP };
+
+	Netchan_Setup(NS_UDP_SERVER, &server, &addr, 0);
+	Netchan_Setup(NS_UDP_CLIENT, &client, &addr, 0);
+
+	Cvar_ForceSetValue("net_loop_loss", 0.02);
+	Cvar_ForceSetValue("net_loop_reorder", 0.2);
+
+	Mem_InitBuffer(&unreliable, data, sizeof(data));
+
+	int32_t reliable_sent = 0, reliable_received = 0;
+	int32_t unreliable_sent = 0, unreliable_received = 0;
+
+	for (int32_t i = 0; i < NET_CHAN_TICKS && reliable_received < NET_CHAN_RELIABLE; i++) {
+
+		// queue the next reliable message once the previous one is acknowledged
+		if (reliable_sent < NET_CHAN_RELIABLE && !server.message.size && !server.reliable_size) {
+			check_Netchan_WriteBlock(&server.message, reliable_sent++, Randomr(1, 24) * 1000);
+		}
+
+		Mem_ClearBuffer(&unreliable);
+		check_Netchan_WriteBlock(&unreliable, -(++unreliable_sent), Randomr(0, MAX_MSG_SIZE - 16));
+
+		Netchan_Transmit(&server, unreliable.data, unreliable.size);
+		Netchan_Transmit(&client, NULL, 0);
+
+		quetoo.ticks++;
+
+		while (Net_ReceiveDatagram(NS_UDP_SERVER, &net_from, &net_message)) {
+			Netchan_Process(&server, &net_message);
+		}
+
+		while (Net_ReceiveDatagram(NS_UDP_CLIENT, &net_from, &net_message)) {
+			if (Netchan_Process(&client, &net_message)) {
+				while (net_message.read < net_message.size) {
+					const int32_t id = check_Netchan_ReadBlock(&net_message);
+					if (id >= 0) {
+						ck_assert_int_eq(id, reliable_received);
+						reliable_received++;
+					} else {
+						unreliable_received++;
+					}
+				}
+			}
+		}
+	}
+
+	printf("%d of %d reliable, %d of %d unreliable messages received\n",
+	       reliable_received, reliable_sent, unreliable_received, unreliable_sent);
+
+	ck_assert_int_eq(reliable_received, NET_CHAN_RELIABLE);
+	ck_assert(unreliable_received > 0);
+
+	// only the receiving side of fragmented messages allocates a fragment buffer
+	ck_assert(client.fragment_buffer != NULL);
+	ck_assert(server.fragment_buffer == NULL);
+
+	Netchan_Close(&server);
+	Netchan_Close(&client);
+
+	Cvar_ForceSetValue("net_loop_loss", 0.0);
+	Cvar_ForceSetValue("net_loop_reorder", 0.0);
+
+} END_TEST
+
+/**
+ * @brief Sends datagrams in bursts over the loopback interface, receiving them
+ * after each burst, and returns the number of datagrams per second.
+ */
+static double check_Net_DatagramThroughput(_Bool batch) {
+	byte data[200];
+	net_addr_t from;
+
+	Cvar_ForceSetValue("net_batch", batch);
+
+	const net_addr_t to = { .type = NA_DATAGRAM, .addr = net_lo, .port = htons(NET_UDP_PORT) };
+
+	memset(data, 0xff, sizeof(data));
+
+	int32_t received = 0;
+
+	const uint32_t start = SDL_GetTicks();
+
+	for (int32_t i = 0; i < NET_UDP_DATAGRAMS; i += NET_UDP_BURST) {
+
+		Net_BeginBatch(NS_UDP_CLIENT);
+
+		for (int32_t j = 0; j < NET_UDP_BURST; j++) {
+			Net_SendDatagram(NS_UDP_CLIENT, &to, data, sizeof(data));
+		}
+
+		Net_FlushBatch(NS_UDP_CLIENT);
+
+		while (Net_ReceiveDatagram(NS_UDP_SERVER, &from, &net_message)) {
+			ck_assert_int_eq(net_message.size, sizeof(data));
+			received++;
+		}
+	}
+
+	const uint32_t elapsed = MAX(SDL_GetTicks() - start, 1u);
+
+	ck_assert(received >= NET_UDP_DATAGRAMS * 0.9);
+
+	return received * 1000.0 / elapsed;
+}
+
+/**
+ * @brief Reports the datagrams per second a single core sends and receives
+ * over the loopback interface, with and without batching.
+ */
+START_TEST(check_Net_Datagram_Throughput) {
+
+	Cvar_ForceSetInteger("net_port", NET_UDP_PORT);
+
+	Net_Config(NS_UDP_SERVER, true);
+
+	check_Net_DatagramThroughput(false); // warm up
+
+	const double unbatched = check_Net_DatagramThroughput(false);
+	const double batched = check_Net_DatagramThroughput(true);
+
+	printf("unbatched: %.0f datagrams/s, batched: %.0f datagrams/s\n", unbatched, batched);
+
+	Net_Config(NS_UDP_SERVER, false);
+
+} END_TEST
+
+START_TEST(check_Net_StringToNetaddr) {
+	net_addr_t a, b;
+
+	ck_assert(Net_StringToNetaddr("192.168.1.1:28000", &a));
+	ck_assert_int_eq(a.type, NA_DATAGRAM);
+	ck_assert(IN6_IS_ADDR_V4MAPPED(&a.addr));
+	ck_assert_int_eq(ntohs(a.port), 28000);
+	ck_assert_str_eq(Net_NetaddrToString(&a), "192.168.1.1:28000");
+
+	// IPv4 hosts compare equal to their v4-mapped form
+	ck_assert(Net_StringToNetaddr("[::ffff:192.168.1.1]:28000", &b));
+	ck_assert(Net_CompareNetaddr(&a, &b));
+	ck_assert(Net_CompareClientNetaddr(&a, &b));
+
+	ck_assert(Net_StringToNetaddr("[2001:db8::1]:28000", &a));
+	ck_assert(!IN6_IS_ADDR_V4MAPPED(&a.addr));
+	ck_assert_int_eq(ntohs(a.port), 28000);
+	ck_assert_str_eq(Net_NetaddrToString(&a), "[2001:db8::1]:28000");
+	ck_assert(!Net_CompareNetaddr(&a, &b));
+
+	// bare IPv6 addresses have no port
+	ck_assert(Net_StringToNetaddr("2001:db8::1", &b));
+	ck_assert_int_eq(b.port, 0);
+	ck_assert(Net_CompareClientNetaddr(&a, &b));
+	ck_assert(!Net_CompareNetaddr(&a, &b));
+
+	ck_assert(Net_StringToNetaddr("::1", &a));
+	ck_assert(IN6_IS_ADDR_LOOPBACK(&a.addr));
+
+	ck_assert(!Net_StringToNetaddr("0.0.0.0", &a));
+
+	// names resolving to both IPv4 and IPv6 addresses prefer IPv4
+	ck_assert(Net_StringToNetaddr("localhost", &a));
+	ck_assert(IN6_IS_ADDR_V4MAPPED(&a.addr));
+
+	net_sockaddr saddr;
+
+	// IPv4 sockets can reach IPv4 hosts only
+	ck_assert(Net_StringToNetaddr("192.168.1.1:28000", &a));
+	ck_assert_int_eq(Net_NetAddrToSockaddr(&a, AF_INET, &saddr), sizeof(struct sockaddr_in));
+	ck_assert_int_eq(Net_NetAddrToSockaddr(&a, AF_INET6, &saddr), sizeof(struct sockaddr_in6));
+
+	Net_SockaddrToNetaddr(&saddr, &b);
+	ck_assert(Net_CompareNetaddr(&a, &b));
+
+	ck_assert(Net_StringToNetaddr("[2001:db8::1]:28000", &a));
+	ck_assert_int_eq(Net_NetAddrToSockaddr(&a, AF_INET, &saddr), 0);
+
+	// link-local IPv6 hosts retain their scope
+	ck_assert(Net_StringToNetaddr("[fe80::1%1]:28000", &a));
+	ck_assert_int_eq(a.scope_id, 1);
+	ck_assert_str_eq(Net_NetaddrToString(&a), "[fe80::1%1]:28000");
+	ck_assert_int_eq(Net_NetAddrToSockaddr(&a, AF_INET6, &saddr), sizeof(struct sockaddr_in6));
+	ck_assert_int_eq(((struct sockaddr_in6 *) &saddr)->sin6_scope_id, 1);
+
+	Net_SockaddrToNetaddr(&saddr, &b);
+	ck_assert(Net_CompareNetaddr(&a, &b));
+
+	b.scope_id = 2;
+	ck_assert(!Net_CompareNetaddr(&a, &b));
+	ck_assert(!Net_CompareClientNetaddr(&a, &b));
+
+} END_TEST
+
+/**
+ * @brief Exchanges datagrams between the client and server sockets over the
+ * IPv6 loopback interface.
+ */
+START_TEST(check_Net_Datagram_IPv6) {
+	byte data[64];
+	net_addr_t to, from;
+
+	Cvar_ForceSetInteger("net_port", NET_UDP_PORT);
+
+	Net_Config(NS_UDP_SERVER, true);
+
+	ck_assert(Net_StringToNetaddr(va("[::1]:%d", NET_UDP_PORT), &to));
+
+	memset(data, 0xaa, sizeof(data));
+
+	if (!Net_SendDatagram(NS_UDP_CLIENT, &to, data, sizeof(data))) {
+		printf("IPv6 is unavailable, skipping\n");
+		Net_Config(NS_UDP_SERVER, false);
+		return;
+	}
+
+	const uint32_t start = SDL_GetTicks();
+
+	while (!Net_ReceiveDatagram(NS_UDP_SERVER, &from, &net_message)) {
+		ck_assert(SDL_GetTicks() - start < 1000);
+	}
+
+	ck_assert_int_eq(net_message.size, sizeof(data));
+	ck_assert_int_eq(from.type, NA_DATAGRAM);
+	ck_assert(IN6_IS_ADDR_LOOPBACK(&from.addr));
+	ck_assert(g_str_has_prefix(Net_NetaddrToString(&from), "[::1]:"));
+
+	// reply to the sender
+	memset(data, 0x55, sizeof(data));
+	ck_assert(Net_SendDatagram(NS_UDP_SERVER, &from, data, sizeof(data)));
+
+	while (!Net_ReceiveDatagram(NS_UDP_CLIENT, &from, &net_message)) {
+		ck_assert(SDL_GetTicks() - start < 1000);
+	}
+
+	ck_assert_int_eq(net_message.size, sizeof(data));
+	ck_assert_int_eq(net_message.data[0], 0x55);
+	ck_assert(Net_CompareNetaddr(&from, &to));
+
+	// IPv4 hosts are served by the same dual-stack socket
+	ck_assert(Net_StringToNetaddr(va("127.0.0.1:%d", NET_UDP_PORT), &to));
+	ck_assert(Net_SendDatagram(NS_UDP_CLIENT, &to, data, sizeof(data)));
+
+	while (!Net_ReceiveDatagram(NS_UDP_SERVER, &from, &net_message)) {
+		ck_assert(SDL_GetTicks() - start < 1000);
+	}
+
+	ck_assert(IN6_IS_ADDR_V4MAPPED(&from.addr));
+	ck_assert(g_str_has_prefix(Net_NetaddrToString(&from), "127.0.0.1:"));
+
+	Net_Config(NS_UDP_SERVER, false);
+
+} END_TEST
+
+/**
+ * @brief Broadcasts from the client socket to the server socket, and replies to
+ * the broadcast, which dual-stack sockets send from a separate IPv4 socket.
+ */
+START_TEST(check_Net_Broadcast) {
+	byte data[64];
+	net_addr_t to, from;
+
+	Cvar_ForceSetInteger("net_port", NET_UDP_PORT);
+
+	Net_Config(NS_UDP_SERVER, true);
+
+	memset(&to, 0, sizeof(to));
+	to.type = NA_BROADCAST;
+	to.port = htons(NET_UDP_PORT);
+
+	memset(data, 0xaa, sizeof(data));
+
+	if (!Net_SendDatagram(NS_UDP_CLIENT, &to, data, sizeof(data))) {
+		printf("Broadcast is unavailable, skipping\n");
+		Net_Config(NS_UDP_SERVER, false);
+		return;
+	}
+
+	const uint32_t start = SDL_GetTicks();
+
+	while (!Net_ReceiveDatagram(NS_UDP_SERVER, &from, &net_message)) {
+		ck_assert(SDL_GetTicks() - start < 1000);
+	}
+
+	ck_assert_int_eq(net_message.size, sizeof(data));
+	ck_assert(IN6_IS_ADDR_V4MAPPED(&from.addr));
+
+	// reply to the sender, which receives it alongside its unicast traffic
+	memset(data, 0x55, sizeof(data));
+	ck_assert(Net_SendDatagram(NS_UDP_SERVER, &from, data, sizeof(data)));
+
+	while (!Net_ReceiveDatagram(NS_UDP_CLIENT, &from, &net_message)) {
+		ck_assert(SDL_GetTicks() - start < 1000);
+	}
+
+	ck_assert_int_eq(net_message.size, sizeof(data));
+	ck_assert_int_eq(net_message.data[0], 0x55);
+	ck_assert_int_eq(ntohs(from.port), NET_UDP_PORT);
+
+	Net_Config(NS_UDP_SERVER, false);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_net");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Net_DirIndex);
+	tcase_add_test(tcase, check_Net_WriteDir_Throughput);
+	tcase_add_test(tcase, check_Net_VarInt);
+	tcase_add_test(tcase, check_Net_Bits);
+	tcase_add_test(tcase, check_Net_DeltaPlayerState);
+	tcase_add_test(tcase, check_Net_DeltaEntity);
+	tcase_add_test(tcase, check_Net_DeltaEntity_Replay);
+	tcase_add_test(tcase, check_Net_DeltaEntity_Recovery);
+	tcase_add_test(tcase, check_Netchan_Fragments);
+	tcase_add_test(tcase, check_Net_Datagram_Throughput);
+	tcase_add_test(tcase, check_Net_StringToNetaddr);
+	tcase_add_test(tcase, check_Net_Datagram_IPv6);
+	tcase_add_test(tcase, check_Net_Broadcast);
+
+	Suite *suite = suite_create("check_net");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
@@ -0,0 +1,335 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include <SDL_timer.h>
+
+#include "tests.h"
+#include "simd.h"
+
+/**
+ * @brief The tolerance, relative to the magnitude of the expected value, that
+ * kernels must agree with their scalar counterparts to. Kernels issue their
+ * operations in the scalar order, so they should match exactly, but the
+ * compiler may contract the scalar code to fused multiply-adds on some CPUs.
+ */
+#define SIMD_EPSILON 1e-6f
+
+#define SIMD_COUNT 1027
+#define SIMD_BENCH_COUNT 65536
+#define SIMD_BENCH_ITERATIONS 200
+
+quetoo_t quetoo;
+
+static vec3_t *points, *results;
+static vec_t *values;
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	points = Mem_Malloc(SIMD_BENCH_COUNT * sizeof(vec3_t));
+	results = Mem_Malloc(SIMD_BENCH_COUNT * sizeof(vec3_t));
+	values = Mem_Malloc(SIMD_BENCH_COUNT * sizeof(vec_t));
+
+	for (size_t i = 0; i < SIMD_BENCH_COUNT; i++) {
+		for (int32_t j = 0; j < 3; j++) {
+			points[i][j] = Randomfr(MIN_WORLD_COORD, MAX_WORLD_COORD);
+		}
+	}
+
+	VectorClear(points[7]);
+	VectorClear(points[SIMD_COUNT - 1]);
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	Simd_Init();
+
+	Mem_Shutdown();
+}
+
+/**
+ * @return True if `a` is within the tolerance of `b`.
+ */
+static _Bool check_Simd_Equal(const vec_t a, const vec_t b) {
+	return fabsf(a - b) <= SIMD_EPSILON * MAX(1.0f, fabsf(b));
+}
+
+/**
+ * @return A transform with rotation, scale and translation.
+ */
+static void check_Simd_Matrix(matrix4x4_t *m) {
+	matrix4x4_t scale;
+
+	Matrix4x4_CreateFromQuakeEntity(m, 12.0, -345.0, 67.0, 15.0, 210.0, -35.0, 1.0);
+	Matrix4x4_CreateScale3(&scale, 0.5, 2.0, 1.25);
+	Matrix4x4_Concat(m, m, &scale);
+}
+
+START_TEST(check_Simd_TransformPoints) {
+	matrix4x4_t m;
+
+	check_Simd_Matrix(&m);
+
+	for (simd_level_t level = SIMD_SCALAR; level < SIMD_LEVELS; level++) {
+		if (!Simd_SetLevel(level)) {
+			continue;
+		}
+
+		Simd_TransformPoints(&m, (const vec3_t *) points, results, SIMD_COUNT);
+
+		size_t exact = 0;
+		for (size_t i = 0; i < SIMD_COUNT; i++) {
+			vec3_t out;
+
+			Matrix4x4_Transform(&m, points[i], out);
+
+			for (int32_t j = 0; j < 3; j++) {
+				ck_assert_msg(check_Simd_Equal(results[i][j], out[j]), "%s: %zu[%d]: %g != %g",
+				              Simd_LevelName(level), i, j, results[i][j], out[j]);
+			}
+
+			exact += VectorCompare(results[i], out);
+		}
+
+		printf("%s: %zu of %d points exact\n", Simd_LevelName(level), exact, SIMD_COUNT);
+
+		// in place
+		memcpy(results, points, SIMD_COUNT * sizeof(vec3_t));
+		Simd_TransformPoints(&m, (const vec3_t *) results, results, SIMD_COUNT);
+
+		for (size_t i = 0; i < SIMD_COUNT; i++) {
+			vec3_t out;
+
+			Matrix4x4_Transform(&m, points[i], out);
+
+			for (int32_t j = 0; j < 3; j++) {
+				ck_assert(check_Simd_Equal(results[i][j], out[j]));
+			}
+		}
+	}
+
+} END_TEST
+
+START_TEST(check_Simd_NormalizeVectors) {
+
+	for (simd_level_t level = SIMD_SCALAR; level < SIMD_LEVELS; level++) {
+		if (!Simd_SetLevel(level)) {
+			continue;
+		}
+
+		Simd_NormalizeVectors((const vec3_t *) points, results, values, SIMD_COUNT);
+
+		for (size_t i = 0; i < SIMD_COUNT; i++) {
+			vec3_t out;
+
+			const vec_t length = VectorNormalize2(points[i], out);
+
+			ck_assert_msg(check_Simd_Equal(values[i], length), "%s: %zu: %g != %g",
+			              Simd_LevelName(level), i, values[i], length);
+
+			for (int32_t j = 0; j < 3; j++) {
+				ck_assert(check_Simd_Equal(results[i][j], out[j]));
+			}
+		}
+
+		ck_assert(VectorCompare(results[7], vec3_origin));
+		ck_assert(values[7] == 0.0f);
+
+		// in place, without lengths
+		memcpy(results, points, SIMD_COUNT * sizeof(vec3_t));
+		Simd_NormalizeVectors((const vec3_t *) results, results, NULL, SIMD_COUNT);
+
+		for (size_t i = 0; i < SIMD_COUNT; i++) {
+			vec3_t out;
+
+			VectorNormalize2(points[i], out);
+
+			for (int32_t j = 0; j < 3; j++) {
+				ck_assert(check_Simd_Equal(results[i][j], out[j]));
+			}
+		}
+	}
+
+} END_TEST
+
+START_TEST(check_Simd_DotProducts) {
+
+	for (simd_level_t level = SIMD_SCALAR; level < SIMD_LEVELS; level++) {
+		if (!Simd_SetLevel(level)) {
+			continue;
+		}
+
+		Simd_DotProducts((const vec3_t *) points, (const vec3_t *) points + 1, values, SIMD_COUNT);
+
+		for (size_t i = 0; i < SIMD_COUNT; i++) {
+			const vec_t dot = DotProduct(points[i], points[i + 1]);
+
+			ck_assert_msg(check_Simd_Equal(values[i], dot), "%s: %zu: %g != %g",
+			              Simd_LevelName(level), i, values[i], dot);
+		}
+	}
+
+} END_TEST
+
+START_TEST(check_Simd_AddPointsToBounds) {
+	vec3_t mins, maxs;
+
+	ClearBounds(mins, maxs);
+
+	for (size_t i = 0; i < SIMD_COUNT; i++) {
+		AddPointToBounds(points[i], mins, maxs);
+	}
+
+	for (simd_level_t level = SIMD_SCALAR; level < SIMD_LEVELS; level++) {
+		if (!Simd_SetLevel(level)) {
+			continue;
+		}
+
+		vec3_t simd_mins, simd_maxs;
+
+		for (size_t count = 0; count < 20; count++) {
+			vec3_t a, b;
+
+			ClearBounds(a, b);
+			ClearBounds(simd_mins, simd_maxs);
+
+			for (size_t i = 0; i < count; i++) {
+				AddPointToBounds(points[i], a, b);
+			}
+
+			Simd_AddPointsToBounds((const vec3_t *) points, count, simd_mins, simd_maxs);
+
+			ck_assert_msg(VectorCompare(a, simd_mins) && VectorCompare(b, simd_maxs), "%s: %zu points",
+			              Simd_LevelName(level), count);
+		}
+
+		ClearBounds(simd_mins, simd_maxs);
+
+		Simd_AddPointsToBounds((const vec3_t *) points, SIMD_COUNT, simd_mins, simd_maxs);
+
+		ck_assert(VectorCompare(mins, simd_mins));
+		ck_assert(VectorCompare(maxs, simd_maxs));
+
+		// NaN components are ignored, and existing bounds are accumulated
+		const vec3_t nan = { NAN, NAN, NAN };
+		const vec3_t far = { MAX_WORLD_COORD * 2.0f, 0.0f, 0.0f };
+
+		memcpy(results, points, SIMD_COUNT * sizeof(vec3_t));
+		VectorCopy(nan, results[3]);
+		VectorCopy(nan, results[12]);
+
+		Simd_AddPointsToBounds((const vec3_t *) results, SIMD_COUNT, simd_mins, simd_maxs);
+		Simd_AddPointsToBounds(&far, 1, simd_mins, simd_maxs);
+
+		ck_assert(VectorCompare(mins, simd_mins));
+		ck_assert(simd_maxs[0] == far[0]);
+		ck_assert(simd_maxs[1] == maxs[1]);
+		ck_assert(simd_maxs[2] == maxs[2]);
+	}
+
+} END_TEST
+
+/**
+ * @brief Reports the throughput of each kernel, in millions of elements per second.
+ */
+START_TEST(check_Simd_Throughput) {
+	matrix4x4_t m;
+	vec3_t mins, maxs;
+
+	check_Simd_Matrix(&m);
+
+	const simd_level_t best = Simd_Init();
+	printf("selected %s\n", Simd_LevelName(best));
+
+	for (simd_level_t level = SIMD_SCALAR; level < SIMD_LEVELS; level++) {
+		if (!Simd_SetLevel(level)) {
+			continue;
+		}
+
+		uint32_t start, elapsed[4];
+
+		start = SDL_GetTicks();
+		for (int32_t i = 0; i < SIMD_BENCH_ITERATIONS; i++) {
+			Simd_TransformPoints(&m, (const vec3_t *) points, results, SIMD_BENCH_COUNT);
+		}
+		elapsed[0] = MAX(SDL_GetTicks() - start, 1u);
+
+		start = SDL_GetTicks();
+		for (int32_t i = 0; i < SIMD_BENCH_ITERATIONS; i++) {
+			Simd_NormalizeVectors((const vec3_t *) points, results, values, SIMD_BENCH_COUNT);
+		}
+		elapsed[1] = MAX(SDL_GetTicks() - start, 1u);
+
+		start = SDL_GetTicks();
+		for (int32_t i = 0; i < SIMD_BENCH_ITERATIONS; i++) {
+			Simd_DotProducts((const vec3_t *) points, (const vec3_t *) results, values, SIMD_BENCH_COUNT);
+		}
+		elapsed[2] = MAX(SDL_GetTicks() - start, 1u);
+
+		start = SDL_GetTicks();
+		for (int32_t i = 0; i < SIMD_BENCH_ITERATIONS; i++) {
+			ClearBounds(mins, maxs);
+			Simd_AddPointsToBounds((const vec3_t *) points, SIMD_BENCH_COUNT, mins, maxs);
+		}
+		elapsed[3] = MAX(SDL_GetTicks() - start, 1u);
+
+		const double n = SIMD_BENCH_COUNT * (double) SIMD_BENCH_ITERATIONS / 1000.0;
+
+		printf("%s: transform %.0fM/s, normalize %.0fM/s, dot %.0fM/s, bounds %.0fM/s\n",
+		       Simd_LevelName(level), n / elapsed[0], n / elapsed[1], n / elapsed[2], n / elapsed[3]);
+	}
+
+	ck_assert(Simd_SetLevel(best));
+	ck_assert(Simd_Level() == best);
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_simd");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Simd_TransformPoints);
+	tcase_add_test(tcase, check_Simd_NormalizeVectors);
+	tcase_add_test(tcase, check_Simd_DotProducts);
+	tcase_add_test(tcase, check_Simd_AddPointsToBounds);
+	tcase_add_test(tcase, check_Simd_Throughput);
+
+	Suite *suite = suite_create("check_simd");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
@@ -0,0 +1,486 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include <SDL_timer.h>
+
+#include "tests.h"
+#include "thread.h"
+
+#include "../server/sv_world.c"
+#include "../server/sv_entity.c"
+#include "../server/sv_vis.c"
+#include "check_map.h"
+
+#define FRAME_ENTITIES 384
+#define FRAME_TICKS (QUETOO_TICK_RATE * 5)
+
+quetoo_t quetoo;
+
+sv_static_t svs;
+sv_server_t sv;
+
+static g_export_t ge;
+static g_entity_t *entities;
+static g_client_t *players;
+
+/**
+ * @brief Spawns the players, followed by a mix of visible entities, some of
+ * which emit sounds or events.
+ */
+static void check_SpawnEntities(int32_t num_players) {
+
+	ge.entities = entities;
+	ge.entity_size = sizeof(g_entity_t);
+	ge.num_entities = FRAME_ENTITIES + 1;
+
+	svs.game = &ge;
+
+	memset(entities, 0, sizeof(g_entity_t) * MAX_ENTITIES);
+	memset(players, 0, sizeof(g_client_t) * MAX_CLIENTS);
+
+	entities[0].in_use = true;
+	entities[0].solid = SOLID_BSP;
+
+	for (int32_t i = 1; i <= FRAME_ENTITIES; i++) {
+		g_entity_t *ent = &entities[i];
+
+		ent->class_name = "check_entity";
+		ent->in_use = true;
+		ent->s.number = i;
+
+		VectorSet(ent->s.origin, Randomfr(-WORLD_SIZE, WORLD_SIZE), Randomfr(-WORLD_SIZE, WORLD_SIZE), Randomfr(0.0, 256.0));
+
+		if (i <= num_players) {
+			ent->client = &players[i - 1];
+			ent->solid = SOLID_BOX;
+			ent->s.model1 = 0xff;
+			VectorSet(ent->mins, -16.0, -16.0, -24.0);
+			VectorSet(ent->maxs, 16.0, 16.0, 32.0);
+		} else {
+			ent->solid = SOLID_PROJECTILE;
+			ent->s.model1 = 1 + (i % 32);
+			ent->s.sound = (i % 3 == 0) ? i : 0;
+			VectorSet(ent->mins, -4.0, -4.0, -4.0);
+			VectorSet(ent->maxs, 4.0, 4.0, 4.0);
+		}
+
+		Sv_LinkEntity(ent);
+	}
+}
+
+/**
+ * @brief Connects the players, all of which speak the current protocol.
+ */
+static void check_ConnectClients(int32_t num_players) {
+
+	memset(svs.clients, 0, sizeof(sv_client_t) * MAX_CLIENTS);
+	memset(svs.entity_states, 0, sizeof(entity_state_t) * svs.num_entity_states);
+
+	for (int32_t i = 0; i < num_players; i++) {
+		sv_client_t *client = &svs.clients[i];
+
+		client->state = SV_CLIENT_ACTIVE;
+		client->entity = &entities[i + 1];
+		client->protocol = PROTOCOL_MAJOR;
+		client->last_frame = -1;
+	}
+}
+
+/**
+ * @brief Advances the world by one tick, moving every entity and updating
+ * the players' movement states.
+ */
+static void check_Tick(int32_t num_players) {
+
+	sv.frame_num++;
+
+	for (int32_t i = 1; i <= FRAME_ENTITIES; i++) {
+		g_entity_t *ent = &entities[i];
+
+		for (int32_t j = 0; j < 2; j++) {
+			ent->s.origin[j] = Clamp(ent->s.origin[j] + Randomfr(-16.0, 16.0), -WORLD_SIZE, WORLD_SIZE);
+		}
+
+		ent->s.event = (Randomr(0, 16) == 0) ? 1 : 0;
+
+		if (ent->client) {
+			VectorCopy(ent->s.origin, ent->client->ps.pm_state.origin);
+			ent->client->ps.pm_state.view_angles[YAW] = Randomr(0, 0xffff);
+		}
+
+		Sv_LinkEntity(ent);
+	}
+
+	// most clients acknowledge every frame, while some lag behind
+	for (int32_t i = 0; i < num_players; i++) {
+		sv_client_t *client = &svs.clients[i];
+
+		if (i % 4 != 3 || sv.frame_num % 8 == 0) {
+			client->last_frame = sv.frame_num - 1;
+		}
+	}
+}
+
+/**
+ * @return The active clients, as Sv_SendClientPackets would collect them.
+ */
+static size_t check_Clients(sv_client_t **clients, int32_t num_players) {
+
+	for (int32_t i = 0; i < num_players; i++) {
+		clients[i] = &svs.clients[i];
+	}
+
+	return num_players;
+}
+
+/**
+ * @brief Writes the clients' frames serially, on the calling thread.
+ */
+static void check_WriteClientFrames_Serial(sv_client_t **clients, size_t count) {
+
+	for (size_t i = 0; i < count; i++) {
+		Sv_ClientVis(clients[i]);
+	}
+
+	Sv_WriteClientFrames_(0, (int32_t) count, clients);
+}
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	Fs_Init(FS_NONE);
+
+	Thread_Init(4);
+
+	check_WriteMap();
+
+	memset(&sv, 0, sizeof(sv));
+	memset(&svs, 0, sizeof(svs));
+
+	sv.cm_models[0] = Cm_LoadBspModel(WORLD_MAP, NULL);
+	sv.cm_models[1] = Cm_Model("*1");
+
+	Sv_InitWorld();
+
+	Sv_InitVis();
+
+	entities = Mem_Malloc(sizeof(g_entity_t) * MAX_ENTITIES);
+	players = Mem_Malloc(sizeof(g_client_t) * MAX_CLIENTS);
+
+	svs.clients = Mem_Malloc(sizeof(sv_client_t) * MAX_CLIENTS);
+
+	svs.num_entity_states = MAX_CLIENTS * SV_CLIENT_ENTITY_STATES;
+	svs.entity_states = Mem_Malloc(sizeof(entity_state_t) * svs.num_entity_states);
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	Mem_Free(svs.entity_states);
+	Mem_Free(svs.clients);
+
+	Mem_Free(players);
+	Mem_Free(entities);
+
+	Cm_LoadBspModel(NULL, NULL);
+
+	Thread_Shutdown();
+
+	Fs_Shutdown();
+
+	Mem_Shutdown();
+}
+
+START_TEST(check_Sv_WriteClientFrames) {
+	sv_client_t *clients[MAX_CLIENTS];
+
+	const int32_t num_players = 32;
+
+	sv_client_t *serial_clients = Mem_Malloc(sizeof(sv_client_t) * MAX_CLIENTS);
+	entity_state_t *serial_states = Mem_Malloc(sizeof(entity_state_t) * svs.num_entity_states);
+
+	check_SpawnEntities(num_players);
+	check_ConnectClients(num_players);
+
+	for (int32_t i = 0; i < FRAME_TICKS; i++) {
+
+		check_Tick(num_players);
+
+		const size_t count = check_Clients(clients, num_players);
+
+		// write the frames serially from a copy of the clients
+		memcpy(serial_clients, svs.clients, sizeof(sv_client_t) * MAX_CLIENTS);
+		memcpy(serial_states, svs.entity_states, sizeof(entity_state_t) * svs.num_entity_states);
+
+		check_WriteClientFrames_Serial(clients, count);
+
+		// swap the serial results out, and write the frames concurrently
+		for (size_t j = 0; j < MAX_CLIENTS; j++) {
+			const sv_client_t tmp = serial_clients[j];
+			serial_clients[j] = svs.clients[j];
+			svs.clients[j] = tmp;
+		}
+
+		for (size_t j = 0; j < svs.num_entity_states; j++) {
+			const entity_state_t tmp = serial_states[j];
+			serial_states[j] = svs.entity_states[j];
+			svs.entity_states[j] = tmp;
+		}
+
+		Sv_WriteClientFrames(clients, count);
+
+		for (size_t j = 0; j < count; j++) {
+			const sv_client_t *a = &serial_clients[j], *b = &svs.clients[j];
+
+			ck_assert_int_eq(a->next_entity_state, b->next_entity_state);
+			ck_assert_int_eq(a->frame_message.size, b->frame_message.size);
+			ck_assert(a->frame_message.size > 0);
+			ck_assert(!a->frame_message.overflowed);
+
+			ck_assert_msg(memcmp(a->frame_message_data, b->frame_message_data, a->frame_message.size) == 0,
+			              "Frame %d for client %zd differs", sv.frame_num, j);
+		}
+	}
+
+	Mem_Free(serial_states);
+	Mem_Free(serial_clients);
+
+} END_TEST
+
+/**
+ * @brief Decompresses the row of the specified cluster and visibility type from
+ * the visibility lump, bypassing the collision model's visibility matrix.
+ */
+static size_t check_ClusterVis(const int32_t cluster, const int32_t type, byte *out) {
+
+	const bsp_file_t *bsp = &Cm_Bsp()->bsp;
+	const size_t len = (bsp->vis_data.vis->num_clusters + 7) >> 3;
+
+	if (cluster == -1) {
+		memset(out, 0, len);
+	} else {
+		Bsp_DecompressVis(bsp, bsp->vis_data.raw + bsp->vis_data.vis->bit_offsets[cluster][type], out);
+	}
+
+	return len;
+}
+
+START_TEST(check_Sv_ClientVis) {
+	sv_client_t *clients[MAX_CLIENTS];
+
+	const int32_t num_players = 32;
+
+	// with the visibility matrix, and decompressing rows on demand
+	const size_t budgets[] = { CM_VIS_BUDGET, 0 };
+
+	for (size_t b = 0; b < lengthof(budgets); b++) {
+
+		cm_vis_budget = budgets[b];
+
+		Cm_LoadBspModel(NULL, NULL);
+
+		sv.cm_models[0] = Cm_LoadBspModel(WORLD_MAP, NULL);
+		sv.cm_models[1] = Cm_Model("*1");
+
+		ck_assert((Cm_ClusterPVSRow(0) != NULL) == (cm_vis_budget > 0));
+
+		memset(sv.entities, 0, sizeof(sv.entities));
+
+		Sv_InitWorld();
+		Sv_InitVis();
+
+		check_SpawnEntities(num_players);
+		check_ConnectClients(num_players);
+
+		uint32_t lookups = 0, decompressions = 0, uncached = 0;
+
+		for (int32_t i = 0; i < FRAME_TICKS; i++) {
+
+			check_Tick(num_players);
+
+			// multicast an event at each entity that has one
+			for (int32_t j = 1; j <= FRAME_ENTITIES; j++) {
+				const g_entity_t *ent = &entities[j];
+
+				if (!ent->s.event) {
+					continue;
+				}
+
+				const int32_t cluster = Cm_LeafCluster(Cm_PointLeafnum(ent->s.origin, 0));
+
+				for (int32_t k = 0; k < num_players; k++) {
+					const sv_client_vis_t *vis = Sv_ClientVis(&svs.clients[k]);
+					const byte *phs = Sv_ClusterPHS(cluster);
+
+					byte expected[MAX_BSP_LEAFS >> 3];
+					const size_t len = check_ClusterVis(cluster, DVIS_PHS, expected);
+
+					ck_assert(memcmp(phs, expected, len) == 0);
+					ck_assert_int_eq(vis->cluster, Cm_LeafCluster(Cm_PointLeafnum(vis->origin, 0)));
+				}
+
+				uncached++;
+			}
+
+			const size_t count = check_Clients(clients, num_players);
+
+			Sv_WriteClientFrames(clients, count);
+
+			lookups += sv_vis.lookups;
+			decompressions += sv_vis.decompressions;
+
+			// compare the clients' visibility to that of their clusters
+			for (size_t j = 0; j < count; j++) {
+				const sv_client_vis_t *vis = &clients[j]->vis;
+
+				int32_t leafs[MAX_ENT_LEAFS];
+				vec3_t mins, maxs;
+
+				VectorAdd(vis->origin, ((const vec3_t) { -16.0, -16.0, -16.0 }), mins);
+				VectorAdd(vis->origin, ((const vec3_t) { 16.0, 16.0, 16.0 }), maxs);
+
+				const size_t len = Cm_BoxLeafnums(mins, maxs, leafs, lengthof(leafs), NULL, 0);
+
+				byte pvs[MAX_BSP_LEAFS >> 3], phs[MAX_BSP_LEAFS >> 3];
+				memset(pvs, 0, sizeof(pvs));
+				memset(phs, 0, sizeof(phs));
+
+				int32_t clusters[MAX_ENT_LEAFS];
+				size_t num_clusters = 0;
+
+				for (size_t k = 0; k < len; k++) {
+					byte cluster_pvs[MAX_BSP_LEAFS >> 3], cluster_phs[MAX_BSP_LEAFS >> 3];
+
+					const int32_t cluster = Cm_LeafCluster(leafs[k]);
+
+					size_t n;
+					for (n = 0; n < num_clusters; n++) {
+						if (clusters[n] == cluster) {
+							break;
+						}
+					}
+
+					if (n < num_clusters) {
+						continue;
+					}
+
+					clusters[num_clusters++] = cluster;
+
+					check_ClusterVis(cluster, DVIS_PVS, cluster_pvs);
+					check_ClusterVis(cluster, DVIS_PHS, cluster_phs);
+
+					for (size_t n = 0; n < sv_vis.row_size; n++) {
+						pvs[n] |= cluster_pvs[n];
+						phs[n] |= cluster_phs[n];
+					}
+
+					uncached += 2;
+				}
+
+				ck_assert(memcmp(vis->pvs, pvs, sv_vis.row_size) == 0);
+				ck_assert(memcmp(vis->phs, phs, sv_vis.row_size) == 0);
+			}
+		}
+
+		Com_Print("%d clients, %s: %.1f decompressions per tick, %.1f rows looked up, %.1f without the cache\n",
+		          num_players, cm_vis_budget ? "visibility matrix" : "no visibility matrix",
+		          decompressions / (vec_t) FRAME_TICKS, lookups / (vec_t) FRAME_TICKS,
+		          uncached / (vec_t) FRAME_TICKS);
+
+		if (cm_vis_budget) {
+			ck_assert_int_eq(decompressions, 0);
+		} else {
+			ck_assert(decompressions < uncached);
+		}
+	}
+
+	cm_vis_budget = CM_VIS_BUDGET;
+
+} END_TEST
+
+START_TEST(check_Sv_WriteClientFrames_Time) {
+	sv_client_t *clients[MAX_CLIENTS];
+
+	const int32_t counts[] = { 16, 32, 64 };
+
+	for (size_t i = 0; i < lengthof(counts); i++) {
+		const int32_t num_players = counts[i];
+
+		check_SpawnEntities(num_players);
+		check_ConnectClients(num_players);
+
+		uint64_t serial = 0, concurrent = 0;
+
+		for (int32_t j = 0; j < FRAME_TICKS; j++) {
+
+			check_Tick(num_players);
+
+			const size_t count = check_Clients(clients, num_players);
+
+			uint64_t start = SDL_GetPerformanceCounter();
+
+			// alternate the paths, so that neither is favored by the other's deltas
+			if (j & 1) {
+				check_WriteClientFrames_Serial(clients, count);
+				serial += SDL_GetPerformanceCounter() - start;
+			} else {
+				Sv_WriteClientFrames(clients, count);
+				concurrent += SDL_GetPerformanceCounter() - start;
+			}
+		}
+
+		const double freq = SDL_GetPerformanceFrequency() / 1000.0;
+		const int32_t ticks = FRAME_TICKS / 2;
+
+		Com_Print("%d clients, %d threads: %.3fms serial, %.3fms concurrent per tick\n",
+		          num_players, (int32_t) Thread_Count(), serial / freq / ticks, concurrent / freq / ticks);
+	}
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_sv_entity");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Sv_WriteClientFrames);
+	tcase_add_test(tcase, check_Sv_ClientVis);
+	tcase_add_test(tcase, check_Sv_WriteClientFrames_Time);
+
+	Suite *suite = suite_create("check_sv_entity");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
@@ -0,0 +1,656 @@
+/*
+ * Copyright(c) 1997-2001 id Software, Inc.
+ * Copyright(c) 2002 The Quakeforge Project.
+ * Copyright(c) 2006 Quetoo.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include <SDL_timer.h>
+
+#include "tests.h"
+#include "thread.h"
+
+#include "../server/sv_world.c"
+#include "check_map.h"
+
+#define WORLD_ENTITIES 512
+#define WORLD_TRACES 8192
+
+#define REPLAY_FIRST_ENTITY (WORLD_ENTITIES + 1)
+#define REPLAY_ACTORS (MAX_ENTITIES - REPLAY_FIRST_ENTITY)
+#define REPLAY_PLAYERS 32
+#define REPLAY_FRAMES (QUETOO_TICK_RATE * 60)
+
+quetoo_t quetoo;
+
+sv_static_t svs;
+sv_server_t sv;
+
+static g_export_t ge;
+static g_entity_t *entities;
+
+/**
+ * @brief Spawns and links a mix of players, corpses, projectiles, triggers and
+ * rotated platforms, some of which own one another.
+ */
+static void check_SpawnEntities(void) {
+	static int32_t client;
+
+	entities = Mem_Malloc(sizeof(g_entity_t) * MAX_ENTITIES);
+
+	ge.entities = entities;
+	ge.entity_size = sizeof(g_entity_t);
+
+	svs.game = &ge;
+
+	entities[0].in_use = true;
+	entities[0].solid = SOLID_BSP;
+
+	for (int32_t i = 1; i <= WORLD_ENTITIES; i++) {
+		g_entity_t *ent = &entities[i];
+
+		ent->class_name = "check_entity";
+		ent->in_use = true;
+		ent->s.number = i;
+
+		VectorSet(ent->s.origin, Randomfr(-WORLD_SIZE, WORLD_SIZE), Randomfr(-WORLD_SIZE, WORLD_SIZE), Randomfr(0.0, 256.0));
+
+		switch (i % 5) {
+			case 0:
+				ent->solid = SOLID_BOX;
+				ent->client = (g_client_t *) &client;
+				VectorSet(ent->mins, -16.0, -16.0, -24.0);
+				VectorSet(ent->maxs, 16.0, 16.0, 32.0);
+				break;
+			case 1:
+				ent->solid = SOLID_DEAD;
+				VectorSet(ent->mins, -16.0, -16.0, -24.0);
+				VectorSet(ent->maxs, 16.0, 16.0, -8.0);
+				break;
+			case 2:
+				ent->solid = SOLID_PROJECTILE;
+				ent->owner = &entities[i - 2];
+				VectorSet(ent->mins, -2.0, -2.0, -2.0);
+				VectorSet(ent->maxs, 2.0, 2.0, 2.0);
+				break;
+			case 3:
+				ent->solid = SOLID_TRIGGER;
+				VectorSet(ent->mins, -32.0, -32.0, -32.0);
+				VectorSet(ent->maxs, 32.0, 32.0, 32.0);
+				break;
+			case 4:
+				ent->solid = SOLID_BSP;
+				ent->s.model1 = 1;
+				VectorCopy(sv.cm_models[1]->mins, ent->mins);
+				VectorCopy(sv.cm_models[1]->maxs, ent->maxs);
+				VectorSet(ent->s.angles, 0.0, Randomfr(0.0, 360.0), Randomfr(-30.0, 30.0));
+				break;
+		}
+
+		Sv_LinkEntity(ent);
+	}
+}
+
+/**
+ * @brief Setup fixture.
+ */
+void setup(void) {
+
+	Mem_Init();
+
+	Fs_Init(FS_NONE);
+
+	Thread_Init(4);
+
+	check_WriteMap();
+
+	memset(&sv, 0, sizeof(sv));
+
+	sv.cm_models[0] = Cm_LoadBspModel(WORLD_MAP, NULL);
+	sv.cm_models[1] = Cm_Model("*1");
+
+	Sv_InitWorld();
+
+	check_SpawnEntities();
+}
+
+/**
+ * @brief Teardown fixture.
+ */
+void teardown(void) {
+
+	Mem_Free(entities);
+
+	Cm_LoadBspModel(NULL, NULL);
+
+	Thread_Shutdown();
+
+	Fs_Shutdown();
+
+	Mem_Shutdown();
+}
+
+/**
+ * @brief A trace, its results from the serial and concurrent paths, and the
+ * contents at its end point.
+ */
+typedef struct {
+	vec3_t start, end;
+	const vec_t *mins, *maxs;
+	const g_entity_t *skip;
+	int32_t contents;
+
+	cm_trace_t serial, concurrent;
+	int32_t serial_contents, concurrent_contents;
+	size_t serial_count, concurrent_count;
+} check_trace_t;
+
+static check_trace_t traces[WORLD_TRACES];
+
+/**
+ * @brief Runs the trace, point contents and box query for the specified trace.
+ */
+static void check_Trace(check_trace_t *t, cm_trace_t *trace, int32_t *contents, size_t *count) {
+	g_entity_t *list[MAX_ENTITIES];
+
+	*trace = Sv_Trace(t->start, t->end, t->mins, t->maxs, t->skip, t->contents);
+	*contents = Sv_PointContents(t->end);
+
+	vec3_t mins, maxs;
+	Cm_TraceBounds(t->start, t->end, t->mins ?: vec3_origin, t->maxs ?: vec3_origin, mins, maxs);
+
+	*count = Sv_BoxEntities(mins, maxs, list, lengthof(list), BOX_ALL);
+}
+
+/**
+ * @brief Thread_ParallelFor function for concurrent traces.
+ */
+static void check_Traces(int32_t begin, int32_t end, void *data) {
+
+	for (int32_t i = begin; i < end; i++) {
+		check_trace_t *t = &traces[i];
+		check_Trace(t, &t->concurrent, &t->concurrent_contents, &t->concurrent_count);
+	}
+}
+
+/**
+ * @return True if the traces are identical.
+ */
+static _Bool check_TraceEqual(const cm_trace_t *a, const cm_trace_t *b) {
+
+	return a->all_solid == b->all_solid &&
+	       a->start_solid == b->start_solid &&
+	       a->fraction == b->fraction &&
+	       VectorCompare(a->end, b->end) &&
+	       VectorCompare(a->plane.normal, b->plane.normal) &&
+	       a->plane.dist == b->plane.dist &&
+	       a->contents == b->contents &&
+	       a->ent == b->ent;
+}
+
+START_TEST(check_Sv_Trace_Concurrent) {
+	static const vec3_t player_mins = { -16.0, -16.0, -24.0 };
+	static const vec3_t player_maxs = { 16.0, 16.0, 32.0 };
+
+	static const vec3_t small_mins = { -4.0, -4.0, -4.0 };
+	static const vec3_t small_maxs = { 4.0, 4.0, 4.0 };
+
+	for (int32_t i = 0; i < WORLD_TRACES; i++) {
+		check_trace_t *t = &traces[i];
+
+		const g_entity_t *ent = &entities[1 + (i % WORLD_ENTITIES)];
+
+		VectorCopy(ent->s.origin, t->start);
+		VectorSet(t->end, Randomfr(-WORLD_SIZE, WORLD_SIZE), Randomfr(-WORLD_SIZE, WORLD_SIZE), Randomfr(-32.0, 288.0));
+
+		switch (i % 3) {
+			case 0:
+				t->mins = player_mins;
+				t->maxs = player_maxs;
+				t->contents = MASK_CLIP_PLAYER;
+				break;
+			case 1:
+				t->mins = small_mins;
+				t->maxs = small_maxs;
+				t->contents = MASK_CLIP_PROJECTILE;
+				break;
+			case 2:
+				t->mins = t->maxs = NULL;
+				t->contents = MASK_SOLID | MASK_MEAT;
+				break;
+		}
+
+		t->skip = (i & 1) ? ent : NULL;
+	}
+
+	uint32_t start = SDL_GetTicks();
+
+	for (int32_t i = 0; i < WORLD_TRACES; i++) {
+		check_trace_t *t = &traces[i];
+		check_Trace(t, &t->serial, &t->serial_contents, &t->serial_count);
+	}
+
+	const uint32_t serial = SDL_GetTicks() - start;
+
+	start = SDL_GetTicks();
+
+	Thread_ParallelFor(WORLD_TRACES, 64, check_Traces, NULL);
+
+	const uint32_t concurrent = SDL_GetTicks() - start;
+
+	int32_t hit_world = 0, hit_entity = 0;
+
+	for (int32_t i = 0; i < WORLD_TRACES; i++) {
+		const check_trace_t *t = &traces[i];
+
+		ck_assert_msg(check_TraceEqual(&t->serial, &t->concurrent), "Trace %d differs", i);
+		ck_assert_int_eq(t->serial_contents, t->concurrent_contents);
+		ck_assert_int_eq(t->serial_count, t->concurrent_count);
+
+		if (t->serial.ent == entities) {
+			hit_world++;
+		} else if (t->serial.ent) {
+			hit_entity++;
+		}
+	}
+
+	ck_assert(hit_world > 0);
+	ck_assert(hit_entity > 0);
+
+	printf("%d traces: %d hit the world, %d hit entities; serial %ums, concurrent %ums on %u threads\n",
+	       WORLD_TRACES, hit_world, hit_entity, serial, concurrent, Thread_Count());
+
+} END_TEST
+
+START_TEST(check_Sv_BoxEntities) {
+	g_entity_t *list[MAX_ENTITIES];
+
+	const vec3_t mins = { -WORLD_SIZE, -WORLD_SIZE, -64.0 };
+	const vec3_t maxs = { WORLD_SIZE, WORLD_SIZE, 512.0 };
+
+	size_t len = Sv_BoxEntities(mins, maxs, list, lengthof(list), BOX_ALL);
+	ck_assert_int_eq(len, WORLD_ENTITIES);
+
+	len = Sv_BoxEntities(mins, maxs, list, lengthof(list), BOX_COLLIDE);
+	ck_assert_int_eq(len, WORLD_ENTITIES * 3 / 5);
+
+	len = Sv_BoxEntities(mins, maxs, list, lengthof(list), BOX_OCCUPY);
+	ck_assert_int_eq(len, WORLD_ENTITIES * 2 / 5 + 1);
+
+	// the list is never overrun
+	len = Sv_BoxEntities(mins, maxs, list, 10, BOX_ALL);
+	ck_assert_int_eq(len, 10);
+
+} END_TEST
+
+/**
+ * @brief Replay events, recorded per frame.
+ */
+typedef enum {
+	REPLAY_SPAWN,
+	REPLAY_MOVE,
+	REPLAY_FREE
+} check_replay_event_type_t;
+
+typedef struct {
+	check_replay_event_type_t type;
+	uint16_t number;
+	uint16_t owner;
+	solid_t solid;
+	vec3_t origin;
+} check_replay_event_t;
+
+/**
+ * @brief A recorded match: players running about, firing projectiles which
+ * explode into gibs, on top of the entities linked by the setup fixture.
+ */
+typedef struct {
+	check_replay_event_t *events;
+	size_t num_events, max_events;
+
+	size_t frames[REPLAY_FRAMES + 1]; // the first event of each frame
+} check_replay_t;
+
+static check_replay_t replay;
+
+/**
+ * @brief The recording uses its own generator so that every build replays the
+ * same match.
+ */
+static vec_t check_ReplayRandom(vec_t min, vec_t max) {
+	static uint32_t state = 0x51ed270b;
+
+	state = state * 1664525 + 1013904223;
+
+	return min + (state >> 8) * (1.0 / (1 << 24)) * (max - min);
+}
+
+/**
+ * @brief Appends an event to the recording.
+ */
+static void check_ReplayEvent(check_replay_event_type_t type, int32_t actor, solid_t solid, int32_t owner,
+                              const vec3_t origin) {
+
+	if (replay.num_events == replay.max_events) {
+		replay.max_events = replay.max_events ? replay.max_events * 2 : 0x10000;
+		replay.events = Mem_Realloc(replay.events, replay.max_events * sizeof(check_replay_event_t));
+	}
+
+	check_replay_event_t *e = &replay.events[replay.num_events++];
+
+	e->type = type;
+	e->number = REPLAY_FIRST_ENTITY + actor;
+	e->owner = owner == -1 ? 0 : REPLAY_FIRST_ENTITY + owner;
+	e->solid = solid;
+	VectorCopy(origin, e->origin);
+}
+
+/**
+ * @brief Simulates and records the match.
+ */
+static void check_RecordReplay(void) {
+
+	typedef struct {
+		solid_t solid;
+		vec3_t origin, velocity;
+		int32_t frames;
+	} check_actor_t;
+
+	static check_actor_t actors[REPLAY_ACTORS];
+
+	memset(actors, 0, sizeof(actors));
+
+	const vec_t dt = QUETOO_TICK_SECONDS;
+	const vec_t extent = WORLD_SIZE - 32.0;
+
+	for (int32_t i = 0; i < REPLAY_PLAYERS; i++) {
+		check_actor_t *a = &actors[i];
+
+		a->solid = SOLID_BOX;
+		a->frames = -1;
+		VectorSet(a->origin, check_ReplayRandom(-extent, extent), check_ReplayRandom(-extent, extent), 24.0);
+	}
+
+	for (int32_t frame = 0; frame < REPLAY_FRAMES; frame++) {
+
+		replay.frames[frame] = replay.num_events;
+
+		for (int32_t i = 0; i < REPLAY_ACTORS; i++) {
+			check_actor_t *a = &actors[i];
+
+			if (a->solid == SOLID_NOT) {
+				continue;
+			}
+
+			if (a->frames == -1) { // players and gibs are spawned on their first frame
+				check_ReplayEvent(REPLAY_SPAWN, i, a->solid, -1, a->origin);
+				a->frames = 0;
+			}
+
+			switch (a->solid) {
+				case SOLID_BOX:
+					if (check_ReplayRandom(0.0, 1.0) < 0.05) {
+						const vec_t yaw = check_ReplayRandom(0.0, 2.0 * M_PI);
+						VectorSet(a->velocity, cos(yaw) * 300.0, sin(yaw) * 300.0, 0.0);
+					}
+					break;
+
+				case SOLID_PROJECTILE:
+					if (--a->frames == 0) {
+						if (check_ReplayRandom(0.0, 1.0) < 0.5) {
+							for (int32_t j = 0, k = REPLAY_PLAYERS; j < 4 && k < REPLAY_ACTORS; k++) {
+								check_actor_t *gib = &actors[k];
+
+								if (gib->solid == SOLID_NOT) {
+									gib->solid = SOLID_DEAD;
+									gib->frames = -1;
+
+									VectorCopy(a->origin, gib->origin);
+									VectorSet(gib->velocity, check_ReplayRandom(-200.0, 200.0),
+									          check_ReplayRandom(-200.0, 200.0), check_ReplayRandom(100.0, 400.0));
+									j++;
+								}
+							}
+						}
+
+						check_ReplayEvent(REPLAY_FREE, i, a->solid, -1, a->origin);
+						a->solid = SOLID_NOT;
+						continue;
+					}
+					break;
+
+				case SOLID_DEAD:
+					a->velocity[2] -= 800.0 * dt;
+
+					if (++a->frames == QUETOO_TICK_RATE * 2) {
+						check_ReplayEvent(REPLAY_FREE, i, a->solid, -1, a->origin);
+						a->solid = SOLID_NOT;
+						continue;
+					}
+					break;
+
+				default:
+					break;
+			}
+
+			VectorMA(a->origin, dt, a->velocity, a->origin);
+
+			for (int32_t j = 0; j < 2; j++) {
+				if (fabs(a->origin[j]) > extent) {
+					a->origin[j] = Clamp(a->origin[j], -extent, extent);
+					a->velocity[j] = -a->velocity[j];
+				}
+			}
+
+			if (a->origin[2] < 8.0) {
+				a->origin[2] = 8.0;
+				VectorScale(a->velocity, 0.5, a->velocity);
+				a->velocity[2] = 0.0;
+			}
+
+			check_ReplayEvent(REPLAY_MOVE, i, a->solid, -1, a->origin);
+
+			// players fire a few projectiles per second
+			if (a->solid == SOLID_BOX && check_ReplayRandom(0.0, 1.0) < 0.05) {
+
+				for (int32_t k = REPLAY_PLAYERS; k < REPLAY_ACTORS; k++) {
+					check_actor_t *p = &actors[k];
+
+					if (p->solid == SOLID_NOT) {
+						const vec_t yaw = check_ReplayRandom(0.0, 2.0 * M_PI);
+
+						p->solid = SOLID_PROJECTILE;
+						p->frames = QUETOO_TICK_RATE * 2;
+
+						VectorCopy(a->origin, p->origin);
+						p->origin[2] += 16.0;
+
+						VectorSet(p->velocity, cos(yaw) * 1000.0, sin(yaw) * 1000.0, check_ReplayRandom(-100.0, 100.0));
+
+						check_ReplayEvent(REPLAY_SPAWN, k, p->solid, i, p->origin);
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	replay.frames[REPLAY_FRAMES] = replay.num_events;
+}
+
+/**
+ * @brief Checks Sv_BoxEntities against every linked entity for some random boxes.
+ */
+static void check_BoxEntities_BruteForce(void) {
+	g_entity_t *list[MAX_ENTITIES];
+
+	for (int32_t i = 0; i < 64; i++) {
+		vec3_t mins, maxs;
+
+		VectorSet(mins, Randomfr(-WORLD_SIZE, WORLD_SIZE), Randomfr(-WORLD_SIZE, WORLD_SIZE), Randomfr(-64.0, 256.0));
+		VectorSet(maxs, mins[0] + Randomfr(0.0, 512.0), mins[1] + Randomfr(0.0, 512.0), mins[2] + Randomfr(0.0, 128.0));
+
+		const uint32_t type = (i & 1) ? BOX_COLLIDE : BOX_ALL;
+
+		const sv_box_query_t query = { .type = type };
+		size_t count = 0;
+
+		for (int32_t j = 1; j < MAX_ENTITIES; j++) {
+			const g_entity_t *ent = &entities[j];
+
+			if (ent->in_use && Sv_BoxEntities_Filter(&query, ent) && BoxIntersect(ent->abs_mins, ent->abs_maxs, mins, maxs)) {
+				count++;
+			}
+		}
+
+		ck_assert_int_eq(Sv_BoxEntities(mins, maxs, list, lengthof(list), type), count);
+	}
+}
+
+/**
+ * @brief Replays the recorded match, linking entities and tracing their moves
+ * as the game would, and reports the time spent per frame.
+ */
+START_TEST(check_Sv_World_Replay) {
+	static const vec3_t player_mins = { -16.0, -16.0, -24.0 };
+	static const vec3_t player_maxs = { 16.0, 16.0, 32.0 };
+
+	static const vec3_t projectile_mins = { -2.0, -2.0, -2.0 };
+	static const vec3_t projectile_maxs = { 2.0, 2.0, 2.0 };
+
+	static const vec3_t gib_mins = { -4.0, -4.0, -4.0 };
+	static const vec3_t gib_maxs = { 4.0, 4.0, 4.0 };
+
+	static int32_t client;
+	g_entity_t *list[MAX_ENTITIES];
+
+	check_RecordReplay();
+
+	size_t num_traces = 0, num_queries = 0, max_linked = 0, linked = 0;
+	uint64_t elapsed = 0;
+
+	for (int32_t frame = 0; frame < REPLAY_FRAMES; frame++) {
+
+		const uint64_t start = SDL_GetPerformanceCounter();
+
+		for (size_t i = replay.frames[frame]; i < replay.frames[frame + 1]; i++) {
+			const check_replay_event_t *e = &replay.events[i];
+			g_entity_t *ent = &entities[e->number];
+
+			switch (e->type) {
+				case REPLAY_SPAWN:
+					memset(ent, 0, sizeof(*ent));
+
+					ent->class_name = "check_replay";
+					ent->in_use = true;
+					ent->s.number = e->number;
+					ent->solid = e->solid;
+					ent->owner = e->owner ? &entities[e->owner] : NULL;
+
+					switch (ent->solid) {
+						case SOLID_BOX:
+							ent->client = (g_client_t *) &client;
+							VectorCopy(player_mins, ent->mins);
+							VectorCopy(player_maxs, ent->maxs);
+							break;
+						case SOLID_PROJECTILE:
+							VectorCopy(projectile_mins, ent->mins);
+							VectorCopy(projectile_maxs, ent->maxs);
+							break;
+						default:
+							VectorCopy(gib_mins, ent->mins);
+							VectorCopy(gib_maxs, ent->maxs);
+							break;
+					}
+
+					VectorCopy(e->origin, ent->s.origin);
+					Sv_LinkEntity(ent);
+					linked++;
+					break;
+
+				case REPLAY_MOVE: {
+					vec3_t old;
+					VectorCopy(ent->s.origin, old);
+
+					if (ent->solid != SOLID_DEAD) {
+						const int32_t mask = ent->solid == SOLID_BOX ? MASK_CLIP_PLAYER : MASK_CLIP_PROJECTILE;
+
+						Sv_Trace(old, e->origin, ent->mins, ent->maxs, ent, mask);
+						num_traces++;
+					}
+
+					VectorCopy(e->origin, ent->s.origin);
+					Sv_LinkEntity(ent);
+
+					if (ent->solid == SOLID_BOX) { // touch triggers and items
+						Sv_BoxEntities(ent->abs_mins, ent->abs_maxs, list, lengthof(list), BOX_OCCUPY);
+						num_queries++;
+					}
+				}
+					break;
+
+				case REPLAY_FREE:
+					Sv_UnlinkEntity(ent);
+					ent->in_use = false;
+					linked--;
+					break;
+			}
+		}
+
+		elapsed += SDL_GetPerformanceCounter() - start;
+		max_linked = MAX(max_linked, linked);
+
+		if (frame % QUETOO_TICK_RATE == 0) {
+			check_BoxEntities_BruteForce();
+		}
+	}
+
+	check_BoxEntities_BruteForce();
+
+	const double millis = elapsed * 1000.0 / SDL_GetPerformanceFrequency();
+
+	printf("%d frames, %zu events, %zu peak entities: %zu traces, %zu queries in %.0fms (%.3fms per frame)\n",
+	       REPLAY_FRAMES, replay.num_events, max_linked + WORLD_ENTITIES, num_traces, num_queries,
+	       millis, millis / REPLAY_FRAMES);
+
+	Mem_Free(replay.events);
+	memset(&replay, 0, sizeof(replay));
+
+} END_TEST
+
+/**
+ * @brief Test entry point.
+ */
+int32_t main(int32_t argc, char **argv) {
+
+	Test_Init(argc, argv);
+
+	TCase *tcase = tcase_create("check_sv_world");
+	tcase_add_checked_fixture(tcase, setup, teardown);
+
+	tcase_add_test(tcase, check_Sv_BoxEntities);
+	tcase_add_test(tcase, check_Sv_Trace_Concurrent);
+	tcase_add_test(tcase, check_Sv_World_Replay);
+
+	Suite *suite = suite_create("check_sv_world");
+	suite_add_tcase(suite, tcase);
+
+	int32_t failed = Test_Run(suite);
+
+	Test_Shutdown();
+	return failed;
+}
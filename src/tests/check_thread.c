@@ -19,6 +19,8 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include <SDL_timer.h>
+
 #include "tests.h"
 #include "thread.h"
 
@@ -82,6 +84,131 @@ START_TEST(check_Thread_Wait) {
 
 } END_TEST
 
+/**
+ * @brief Appends to the sequence, for checking continuation order.
+ */
+static void sequence(void *data) {
+	GString *s = (GString *) data;
+	g_string_append_c(s, 'a' + (char) s->len);
+}
+
+START_TEST(check_Thread_Then) {
+	GString *s = g_string_new(NULL);
+
+	thread_t *a = Thread_Create(sequence, s);
+	thread_t *b = Thread_Then(a, sequence, s);
+	thread_t *c = Thread_Then(b, sequence, s);
+
+	Thread_Detach(a);
+	Thread_Detach(b);
+
+	Thread_Wait(c);
+
+	ck_assert_str_eq(s->str, "abc");
+
+	g_string_free(s, true);
+
+} END_TEST
+
+/**
+ * @brief ThreadForFunc which marks its range of indices as visited.
+ */
+static void visit(int32_t begin, int32_t end, void *data) {
+
+	for (int32_t i = begin; i < end; i++) {
+		((byte *) data)[i]++;
+	}
+}
+
+START_TEST(check_Thread_ParallelFor) {
+	byte visited[100000] = { 0 };
+
+	Thread_ParallelFor(lengthof(visited), 7, visit, visited);
+
+	for (size_t i = 0; i < lengthof(visited); i++) {
+		ck_assert(visited[i] == 1);
+	}
+
+} END_TEST
+
+/**
+ * @brief Sleeps briefly, so that waiting threads must block.
+ */
+static void delay(void *data) {
+	SDL_Delay(10);
+}
+
+START_TEST(check_Thread_Stats) {
+	thread_stats_t stats;
+
+	Thread_ResetStats();
+
+	Thread_Wait(Thread_Create(delay, NULL));
+
+	Thread_Stats(&stats);
+
+	ck_assert_int_eq(stats.waits, 1);
+	ck_assert(stats.wait_time >= 5000);
+
+	Thread_ResetStats();
+	Thread_Stats(&stats);
+
+	ck_assert_int_eq(stats.waits, 0);
+	ck_assert_int_eq(stats.wait_time, 0);
+
+} END_TEST
+
+/**
+ * @brief Records the time at which the job began.
+ */
+static void dispatch(void *data) {
+	*(uint64_t *) data = SDL_GetPerformanceCounter();
+}
+
+/**
+ * @brief ThreadForFunc which burns some cycles.
+ */
+static void work(int32_t begin, int32_t end, void *data) {
+	volatile double x = 0.0;
+
+	for (int32_t i = begin; i < end; i++) {
+		for (int32_t j = 0; j < 1000; j++) {
+			x += sqrt((double) (i + j));
+		}
+	}
+}
+
+START_TEST(check_Thread_Benchmark) {
+	const double freq = SDL_GetPerformanceFrequency();
+
+	for (ssize_t num_threads = 1; num_threads <= MAX(SDL_GetCPUCount(), 4); num_threads *= 2) {
+
+		Thread_Shutdown();
+		Thread_Init(num_threads);
+
+		double latency = 0.0;
+
+		for (int32_t i = 0; i < 1000; i++) {
+			uint64_t started;
+
+			const uint64_t created = SDL_GetPerformanceCounter();
+			Thread_Wait(Thread_Create(dispatch, &started));
+
+			latency += (started - created) / freq;
+		}
+
+		const uint64_t start = SDL_GetPerformanceCounter();
+
+		Thread_ParallelFor(100000, 0, work, NULL);
+
+		const double seconds = (SDL_GetPerformanceCounter() - start) / freq;
+
+		printf("%u threads: %.2fus dispatch, %.2fms parallel-for\n",
+			   Thread_Count(), latency * 1000.0, seconds * 1000.0);
+	}
+
+} END_TEST
+
 /**
  * @brief Test entry point.
  */
@@ -93,6 +220,10 @@ int32_t main(int32_t argc, char **argv) {
 	tcase_add_checked_fixture(tcase, setup, teardown);
 
 	tcase_add_test(tcase, check_Thread_Wait);
+	tcase_add_test(tcase, check_Thread_Then);
+	tcase_add_test(tcase, check_Thread_ParallelFor);
+	tcase_add_test(tcase, check_Thread_Stats);
+	tcase_add_test(tcase, check_Thread_Benchmark);
 
 	Suite *suite = suite_create("check_threads");
 	suite_add_tcase(suite, tcase);
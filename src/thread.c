@@ -19,51 +19,345 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include <SDL_atomic.h>
 #include <SDL_cpuinfo.h>
 #include <SDL_timer.h>
 
 #include "thread.h"
 
+/**
+ * @brief A job, its dependencies and its continuations.
+ */
+struct thread_s {
+	char name[64];
+	ThreadRunFunc Run;
+	void *data;
+
+	SDL_atomic_t pending; // unfinished dependencies, plus one until created
+	SDL_atomic_t refs; // one for the scheduler, one for the handle
+	SDL_atomic_t done;
+
+	SDL_SpinLock lock; // guards continuations
+	GSList *continuations; // jobs depending on this one
+};
+
+/**
+ * @brief Each worker owns a deque of jobs. The owner pushes and pops at the
+ * bottom, while other threads steal the oldest jobs from the top.
+ */
+typedef struct {
+	SDL_SpinLock lock;
+	thread_t **jobs;
+	size_t capacity;
+	size_t top;
+	size_t count;
+} thread_deque_t;
+
+typedef struct {
+	SDL_Thread *thread;
+	thread_deque_t deque;
+	uint32_t victim; // the next deque to steal from
+} thread_worker_t;
+
 typedef struct thread_pool_s {
-	SDL_mutex *mutex;
+	thread_worker_t *workers;
+	size_t num_workers;
+
+	thread_deque_t injection; // jobs submitted from outside of the pool
 
-	thread_t *threads;
-	size_t num_threads;
+	SDL_atomic_t queued; // jobs sitting in deques
+	SDL_atomic_t sleeping; // workers waiting for jobs
+	SDL_atomic_t waiting; // threads waiting in Thread_Wait
+	SDL_atomic_t shutdown;
+
+	SDL_mutex *mutex;
+	SDL_cond *work_cond; // signaled when jobs are queued
+	SDL_cond *done_cond; // broadcast when jobs are queued or completed
+
+	struct {
+		SDL_atomic_t waits;
+		SDL_atomic_t spins;
+		SDL_atomic_t sleeps;
+		SDL_atomic_t wait_time; // microseconds
+	} stats;
 } thread_pool_t;
 
 static thread_pool_t thread_pool;
 
+static __thread thread_worker_t *thread_worker;
+
+/**
+ * @brief The bounds of the adaptive spin in Thread_Wait, in iterations.
+ */
+#define THREAD_SPIN_MIN 64
+#define THREAD_SPIN_MAX 8192
+
+/**
+ * @brief The number of iterations the calling thread spins in Thread_Wait
+ * before sleeping. This grows when spinning pays off, and shrinks when not.
+ */
+static __thread int32_t thread_spin = THREAD_SPIN_MIN;
+
+/**
+ * @brief Hints to the processor that the calling thread is spinning.
+ */
+static inline void Thread_Pause(void) {
+#if defined(__i386__) || defined(__x86_64__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
 cvar_t *threads;
 
 /**
- * @brief Wrap the user's function in our own for introspection.
+ * @brief Pushes a job onto the bottom of the deque, growing it if necessary.
+ * The grown array is allocated, and the old array freed, outside of the lock,
+ * so that thieves are never left spinning through the allocator.
+ */
+static void Thread_PushJob(thread_deque_t *deque, thread_t *job) {
+
+	while (true) {
+		SDL_AtomicLock(&deque->lock);
+
+		if (deque->count < deque->capacity) {
+			deque->jobs[(deque->top + deque->count) % deque->capacity] = job;
+			deque->count++;
+
+			SDL_AtomicUnlock(&deque->lock);
+			return;
+		}
+
+		const size_t old_capacity = deque->capacity;
+
+		SDL_AtomicUnlock(&deque->lock);
+
+		const size_t capacity = old_capacity ? old_capacity * 2 : 64;
+		thread_t **jobs = Mem_Malloc(capacity * sizeof(thread_t *));
+
+		SDL_AtomicLock(&deque->lock);
+
+		// another thread may have grown the deque in the meantime
+		if (deque->capacity == old_capacity) {
+
+			for (size_t i = 0; i < deque->count; i++) {
+				jobs[i] = deque->jobs[(deque->top + i) % deque->capacity];
+			}
+
+			thread_t **old_jobs = deque->jobs;
+
+			deque->jobs = jobs;
+			deque->capacity = capacity;
+			deque->top = 0;
+
+			jobs = old_jobs;
+		}
+
+		SDL_AtomicUnlock(&deque->lock);
+
+		if (jobs) {
+			Mem_Free(jobs);
+		}
+	}
+}
+
+/**
+ * @brief Pops the most recently pushed job from the bottom of the deque.
+ */
+static thread_t *Thread_PopJob(thread_deque_t *deque) {
+	thread_t *job = NULL;
+
+	SDL_AtomicLock(&deque->lock);
+
+	if (deque->count) {
+		deque->count--;
+		job = deque->jobs[(deque->top + deque->count) % deque->capacity];
+	}
+
+	SDL_AtomicUnlock(&deque->lock);
+
+	return job;
+}
+
+/**
+ * @brief Steals the oldest job from the top of the deque.
+ */
+static thread_t *Thread_StealJob(thread_deque_t *deque) {
+	thread_t *job = NULL;
+
+	SDL_AtomicLock(&deque->lock);
+
+	if (deque->count) {
+		job = deque->jobs[deque->top];
+		deque->top = (deque->top + 1) % deque->capacity;
+		deque->count--;
+	}
+
+	SDL_AtomicUnlock(&deque->lock);
+
+	return job;
+}
+
+/**
+ * @brief Finds a queued job for the calling thread: from its own deque if it
+ * is a worker, then from the injection deque, and finally by stealing from
+ * the other workers.
+ */
+static thread_t *Thread_FindJob(void) {
+	thread_t *job = NULL;
+
+	if (SDL_AtomicGet(&thread_pool.queued) == 0) {
+		return NULL;
+	}
+
+	if (thread_worker) {
+		job = Thread_PopJob(&thread_worker->deque);
+	}
+
+	if (job == NULL) {
+		job = Thread_StealJob(&thread_pool.injection);
+	}
+
+	if (job == NULL) {
+		const uint32_t start = thread_worker ? thread_worker->victim++ : 0;
+
+		for (size_t i = 0; i < thread_pool.num_workers && job == NULL; i++) {
+			thread_worker_t *w = &thread_pool.workers[(start + i) % thread_pool.num_workers];
+
+			if (w != thread_worker) {
+				job = Thread_StealJob(&w->deque);
+			}
+		}
+	}
+
+	if (job) {
+		SDL_AtomicAdd(&thread_pool.queued, -1);
+	}
+
+	return job;
+}
+
+/**
+ * @brief Releases a reference to the job, freeing it when none remain.
+ */
+static void Thread_Release(thread_t *job) {
+
+	if (SDL_AtomicAdd(&job->refs, -1) == 1) {
+		Mem_Free(job);
+	}
+}
+
+/**
+ * @brief Wakes any threads sleeping in the given condition.
+ */
+static void Thread_Wake(SDL_atomic_t *count, SDL_cond *cond) {
+
+	if (SDL_AtomicGet(count)) {
+		SDL_mutexP(thread_pool.mutex);
+		SDL_CondBroadcast(cond);
+		SDL_mutexV(thread_pool.mutex);
+	}
+}
+
+static void Thread_Execute(thread_t *job);
+
+/**
+ * @brief Queues a job whose dependencies have completed. Workers push onto
+ * their own deque, while other threads use the injection deque. If the pool
+ * has no workers, the job is run immediately.
+ */
+static void Thread_Submit(thread_t *job) {
+
+	if (thread_pool.num_workers == 0) {
+		Thread_Execute(job);
+		return;
+	}
+
+	Thread_PushJob(thread_worker ? &thread_worker->deque : &thread_pool.injection, job);
+
+	SDL_AtomicAdd(&thread_pool.queued, 1);
+
+	Thread_Wake(&thread_pool.sleeping, thread_pool.work_cond);
+	Thread_Wake(&thread_pool.waiting, thread_pool.done_cond);
+}
+
+/**
+ * @brief Runs the job, then submits any continuations whose dependencies are
+ * now satisfied, and wakes waiting threads.
+ */
+static void Thread_Execute(thread_t *job) {
+
+	job->Run(job->data);
+
+	SDL_AtomicLock(&job->lock);
+
+	SDL_AtomicSet(&job->done, 1);
+
+	GSList *continuations = job->continuations;
+	job->continuations = NULL;
+
+	SDL_AtomicUnlock(&job->lock);
+
+	for (GSList *c = continuations; c; c = c->next) {
+		thread_t *continuation = (thread_t *) c->data;
+
+		if (SDL_AtomicAdd(&continuation->pending, -1) == 1) {
+			Thread_Submit(continuation);
+		}
+	}
+
+	g_slist_free(continuations);
+
+	Thread_Wake(&thread_pool.waiting, thread_pool.done_cond);
+
+	Thread_Release(job);
+}
+
+/**
+ * @brief The worker thread entry point, which runs jobs until shutdown.
  */
-static int32_t Thread_Run(void *data) {
-	thread_t *t = (thread_t *) data;
+static int32_t Thread_Work(void *data) {
+
+	thread_worker = (thread_worker_t *) data;
 
-	while (thread_pool.mutex) {
+	while (true) {
 
-		SDL_mutexP(t->mutex);
+		thread_t *job = Thread_FindJob();
+		if (job) {
+			Thread_Execute(job);
+			continue;
+		}
 
-		if (t->status == THREAD_RUNNING) {
-			t->Run(t->data);
+		SDL_mutexP(thread_pool.mutex);
+
+		if (SDL_AtomicGet(&thread_pool.queued) == 0) {
+
+			if (SDL_AtomicGet(&thread_pool.shutdown)) {
+				SDL_mutexV(thread_pool.mutex);
+				break;
+			}
 
-			t->Run = NULL;
-			t->data = NULL;
+			SDL_AtomicAdd(&thread_pool.sleeping, 1);
 
-			t->status = THREAD_WAIT;
-		} else {
-			SDL_CondWait(t->cond, t->mutex);
+			if (SDL_AtomicGet(&thread_pool.queued) == 0) {
+				SDL_CondWait(thread_pool.work_cond, thread_pool.mutex);
+			}
+
+			SDL_AtomicAdd(&thread_pool.sleeping, -1);
 		}
 
-		SDL_mutexV(t->mutex);
+		SDL_mutexV(thread_pool.mutex);
 	}
 
+	Mem_ThreadShutdown();
+
+	thread_worker = NULL;
 	return 0;
 }
 
 /**
- * @brief Initializes the threads backing the thread pool.
+ * @brief Initializes the workers backing the thread pool.
  */
 static void Thread_Init_(ssize_t num_threads) {
 
@@ -75,120 +369,296 @@ static void Thread_Init_(ssize_t num_threads) {
 		num_threads = MAX_THREADS;
 	}
 
-	thread_pool.num_threads = num_threads;
+	thread_pool.num_workers = num_threads;
 
-	if (thread_pool.num_threads) {
-		thread_pool.threads = Mem_Malloc(sizeof(thread_t) * thread_pool.num_threads);
+	if (thread_pool.num_workers) {
+		thread_pool.workers = Mem_Malloc(sizeof(thread_worker_t) * thread_pool.num_workers);
 
-		thread_t *t = thread_pool.threads;
-		uint16_t i = 0;
-
-		for (i = 0; i < thread_pool.num_threads; i++, t++) {
-			t->cond = SDL_CreateCond();
-			t->mutex = SDL_CreateMutex();
-			t->thread = SDL_CreateThread(Thread_Run, __func__, t);
+		thread_worker_t *w = thread_pool.workers;
+		for (size_t i = 0; i < thread_pool.num_workers; i++, w++) {
+			w->victim = (uint32_t) i + 1;
+			w->thread = SDL_CreateThread(Thread_Work, __func__, w);
 		}
 	}
 }
 
 /**
- * Thread_Shutdown_
+ * @brief Drains the queues and stops the workers.
  */
 static void Thread_Shutdown_(void) {
 
-	if (thread_pool.num_threads) {
-		thread_t *t = thread_pool.threads;
-		uint16_t i = 0;
+	SDL_AtomicSet(&thread_pool.shutdown, 1);
+
+	SDL_mutexP(thread_pool.mutex);
+	SDL_CondBroadcast(thread_pool.work_cond);
+	SDL_mutexV(thread_pool.mutex);
+
+	thread_worker_t *w = thread_pool.workers;
+	for (size_t i = 0; i < thread_pool.num_workers; i++, w++) {
+		SDL_WaitThread(w->thread, NULL);
+		Mem_Free(w->deque.jobs);
+	}
+
+	Mem_Free(thread_pool.workers);
+	Mem_Free(thread_pool.injection.jobs);
+}
+
+/**
+ * @brief Creates a job to run the specified function once all of the given
+ * dependencies have completed. Callers must release the returned handle with
+ * Thread_Wait or Thread_Detach.
+ */
+thread_t *Thread_CreateAfter_(const char *name, ThreadRunFunc run, void *data, thread_t **dependencies, size_t num_dependencies) {
+
+	thread_t *job = Mem_Malloc(sizeof(thread_t));
 
-		for (i = 0; i < thread_pool.num_threads; i++, t++) {
-			Thread_Wait(t);
-			SDL_CondSignal(t->cond);
-			SDL_WaitThread(t->thread, NULL);
-			SDL_DestroyCond(t->cond);
-			SDL_DestroyMutex(t->mutex);
+	g_strlcpy(job->name, name, sizeof(job->name));
+
+	job->Run = run;
+	job->data = data;
+
+	SDL_AtomicSet(&job->refs, 2);
+	SDL_AtomicSet(&job->pending, 1);
+
+	for (size_t i = 0; i < num_dependencies; i++) {
+		thread_t *dependency = dependencies[i];
+
+		if (dependency == NULL) {
+			continue;
 		}
 
-		Mem_Free(thread_pool.threads);
+		SDL_AtomicLock(&dependency->lock);
+
+		if (!SDL_AtomicGet(&dependency->done)) {
+			SDL_AtomicAdd(&job->pending, 1);
+			dependency->continuations = g_slist_prepend(dependency->continuations, job);
+		}
+
+		SDL_AtomicUnlock(&dependency->lock);
 	}
+
+	if (SDL_AtomicAdd(&job->pending, -1) == 1) {
+		Thread_Submit(job);
+	}
+
+	return job;
 }
 
 /**
- * @brief Creates a new thread to run the specified function. Callers must use
- * Thread_Wait on the returned handle to release the thread when finished.
+ * @brief Creates a job to run the specified function. Callers must release
+ * the returned handle with Thread_Wait or Thread_Detach.
  */
 thread_t *Thread_Create_(const char *name, ThreadRunFunc run, void *data) {
+	return Thread_CreateAfter_(name, run, data, NULL, 0);
+}
 
-	thread_t *t = thread_pool.threads;
-	uint16_t i = 0;
+/**
+ * @brief Creates a continuation, which runs once the specified job completes.
+ */
+thread_t *Thread_Then_(thread_t *t, const char *name, ThreadRunFunc run, void *data) {
+	return Thread_CreateAfter_(name, run, data, &t, 1);
+}
 
-	// if threads are available, find an idle one and dispatch it
-	if (thread_pool.num_threads) {
-		SDL_mutexP(thread_pool.mutex);
+/**
+ * @brief The shared state of a parallel-for.
+ */
+typedef struct {
+	ThreadForFunc func;
+	void *data;
+	int32_t count;
+	int32_t grain;
+	SDL_atomic_t next;
+} thread_for_t;
 
-		for (i = 0; i < thread_pool.num_threads; i++, t++) {
+/**
+ * @brief ThreadRunFunc for Thread_ParallelFor, which claims ranges of indices
+ * until none remain.
+ */
+static void Thread_ParallelFor_run(void *data) {
+	thread_for_t *f = (thread_for_t *) data;
 
-			// if the thread appears idle, lock it and check again
-			if (t->status == THREAD_IDLE) {
+	while (true) {
+		const int32_t begin = SDL_AtomicAdd(&f->next, f->grain);
+		if (begin >= f->count) {
+			break;
+		}
 
-				SDL_mutexP(t->mutex);
+		f->func(begin, MIN(begin + f->grain, f->count), f->data);
+	}
+}
 
-				// if the thread is idle, dispatch it
-				if (t->status == THREAD_IDLE) {
-					g_strlcpy(t->name, name, sizeof(t->name));
+/**
+ * @brief Invokes the specified function over the index range [0, count) in
+ * ranges of grain indices, across the thread pool and the calling thread.
+ * This function returns once all indices have been processed.
+ *
+ * @param grain The number of indices to claim at a time, or 0 to choose one.
+ */
+void Thread_ParallelFor_(const char *name, int32_t count, int32_t grain, ThreadForFunc func, void *data) {
 
-					t->Run = run;
-					t->data = data;
+	if (count <= 0) {
+		return;
+	}
 
-					t->status = THREAD_RUNNING;
+	if (grain <= 0) {
+		grain = MAX(1, count / (int32_t) ((thread_pool.num_workers + 1) * 4));
+	}
 
-					SDL_mutexV(t->mutex);
-					SDL_CondSignal(t->cond);
+	thread_for_t f = {
+		.func = func,
+		.data = data,
+		.count = count,
+		.grain = grain
+	};
 
-					break;
-				}
+	const size_t num_ranges = (count + grain - 1) / grain;
+	const size_t num_jobs = MIN(thread_pool.num_workers, num_ranges - 1);
 
-				SDL_mutexV(t->mutex);
-			}
-		}
+	thread_t *jobs[MAX_THREADS];
 
-		SDL_mutexV(thread_pool.mutex);
+	for (size_t i = 0; i < num_jobs; i++) {
+		jobs[i] = Thread_Create_(name, Thread_ParallelFor_run, &f);
+	}
+
+	Thread_ParallelFor_run(&f);
+
+	for (size_t i = 0; i < num_jobs; i++) {
+		Thread_Wait(jobs[i]);
 	}
+}
 
-	// if we failed to allocate a thread, run the function in this thread
-	if (i == thread_pool.num_threads) {
-#if 0
-		if (thread_pool.num_threads) {
-			printf("No threads available for %s\n", name);
+/**
+ * @brief Spins briefly on the job's completion, which is far cheaper than
+ * sleeping for jobs that are about to finish. The spin is bounded, and adapts
+ * to how often it succeeds.
+ *
+ * @return True if the job completed while spinning.
+ */
+static _Bool Thread_Spin(thread_t *t) {
+
+	for (int32_t i = 0; i < thread_spin; i++) {
+
+		if (SDL_AtomicGet(&t->done)) {
+			thread_spin = MIN(thread_spin * 2, THREAD_SPIN_MAX);
+			return true;
 		}
-#endif
-		t = NULL;
-		run(data);
+
+		if (SDL_AtomicGet(&thread_pool.queued)) {
+			return false;
+		}
+
+		Thread_Pause();
 	}
 
-	return t;
+	thread_spin = MAX(thread_spin / 2, THREAD_SPIN_MIN);
+	return false;
 }
 
 /**
- * @brief Wait for the specified thread to complete.
+ * @brief Wait for the specified job to complete, and release it. The calling
+ * thread runs queued jobs while it waits, then spins briefly, and finally
+ * sleeps until the job signals its completion.
  */
 void Thread_Wait(thread_t *t) {
 
-	if (!t || t->status == THREAD_IDLE) {
+	if (!t) {
 		return;
 	}
 
-	while (t->status != THREAD_WAIT) {
-		SDL_Delay(0);
+	if (!SDL_AtomicGet(&t->done)) {
+
+		const uint64_t start = SDL_GetPerformanceCounter();
+
+		SDL_AtomicAdd(&thread_pool.stats.waits, 1);
+
+		while (!SDL_AtomicGet(&t->done)) {
+
+			thread_t *job = Thread_FindJob();
+			if (job) {
+				Thread_Execute(job);
+				continue;
+			}
+
+			if (Thread_Spin(t)) {
+				SDL_AtomicAdd(&thread_pool.stats.spins, 1);
+				break;
+			}
+
+			if (SDL_AtomicGet(&thread_pool.queued)) {
+				continue;
+			}
+
+			SDL_mutexP(thread_pool.mutex);
+
+			SDL_AtomicAdd(&thread_pool.waiting, 1);
+
+			if (!SDL_AtomicGet(&t->done) && SDL_AtomicGet(&thread_pool.queued) == 0) {
+				SDL_AtomicAdd(&thread_pool.stats.sleeps, 1);
+				SDL_CondWait(thread_pool.done_cond, thread_pool.mutex);
+			}
+
+			SDL_AtomicAdd(&thread_pool.waiting, -1);
+
+			SDL_mutexV(thread_pool.mutex);
+		}
+
+		const uint64_t elapsed = SDL_GetPerformanceCounter() - start;
+		SDL_AtomicAdd(&thread_pool.stats.wait_time, (int32_t) (elapsed * 1000000 / SDL_GetPerformanceFrequency()));
 	}
 
-	t->status = THREAD_IDLE;
+	Thread_Release(t);
 }
 
 /**
- * @brief Returns the number of threads in the pool.
+ * @brief Releases the specified job without waiting for it to complete.
+ */
+void Thread_Detach(thread_t *t) {
+
+	if (t) {
+		Thread_Release(t);
+	}
+}
+
+/**
+ * @brief Returns the number of workers in the pool.
  */
 uint16_t Thread_Count(void) {
-	return thread_pool.num_threads;
+	return thread_pool.num_workers;
+}
+
+/**
+ * @brief Returns the index of the calling thread: 0 for threads outside of the
+ * pool, such as the main thread, and 1 through Thread_Count for pool workers.
+ */
+uint16_t Thread_Index(void) {
+
+	if (thread_worker) {
+		return (uint16_t) (thread_worker - thread_pool.workers) + 1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Fetches the wait statistics accumulated since they were last reset.
+ */
+void Thread_Stats(thread_stats_t *stats) {
+
+	stats->waits = SDL_AtomicGet(&thread_pool.stats.waits);
+	stats->spins = SDL_AtomicGet(&thread_pool.stats.spins);
+	stats->sleeps = SDL_AtomicGet(&thread_pool.stats.sleeps);
+	stats->wait_time = SDL_AtomicGet(&thread_pool.stats.wait_time);
+}
+
+/**
+ * @brief Resets the wait statistics.
+ */
+void Thread_ResetStats(void) {
+
+	SDL_AtomicSet(&thread_pool.stats.waits, 0);
+	SDL_AtomicSet(&thread_pool.stats.spins, 0);
+	SDL_AtomicSet(&thread_pool.stats.sleeps, 0);
+	SDL_AtomicSet(&thread_pool.stats.wait_time, 0);
 }
 
 /**
@@ -199,6 +669,8 @@ void Thread_Init(ssize_t num_threads) {
 	memset(&thread_pool, 0, sizeof(thread_pool));
 
 	thread_pool.mutex = SDL_CreateMutex();
+	thread_pool.work_cond = SDL_CreateCond();
+	thread_pool.done_cond = SDL_CreateCond();
 
 	Thread_Init_(num_threads);
 }
@@ -209,11 +681,12 @@ void Thread_Init(ssize_t num_threads) {
 void Thread_Shutdown(void) {
 
 	if (thread_pool.mutex) {
+		Thread_Shutdown_();
+
+		SDL_DestroyCond(thread_pool.work_cond);
+		SDL_DestroyCond(thread_pool.done_cond);
 		SDL_DestroyMutex(thread_pool.mutex);
-		thread_pool.mutex = NULL;
 	}
 
-	Thread_Shutdown_();
-
 	memset(&thread_pool, 0, sizeof(thread_pool));
 }
@@ -27,28 +27,45 @@
 
 #define MAX_THREADS 128
 
-typedef enum {
-	THREAD_IDLE,
-	THREAD_RUNNING,
-	THREAD_WAIT
-} thread_status_t;
+/**
+ * @brief Threads are jobs run by the thread pool's workers. The handle is
+ * opaque, and remains valid until it is released with Thread_Wait or
+ * Thread_Detach.
+ */
+typedef struct thread_s thread_t;
 
 typedef void (*ThreadRunFunc)(void *data);
 
+/**
+ * @brief Parallel-for functions are invoked with a range of indices to process.
+ */
+typedef void (*ThreadForFunc)(int32_t begin, int32_t end, void *data);
+
+/**
+ * @brief Statistics on time spent in Thread_Wait, for profiling.
+ */
 typedef struct {
-	SDL_Thread *thread;
-	SDL_cond *cond;
-	SDL_mutex *mutex;
-	char name[64];
-	volatile thread_status_t status;
-	ThreadRunFunc Run;
-	void *data;
-} thread_t;
+	uint32_t waits; // calls that found their job unfinished
+	uint32_t spins; // waits satisfied by spinning
+	uint32_t sleeps; // times a waiting thread slept
+	uint32_t wait_time; // total wait time, in microseconds
+} thread_stats_t;
 
 thread_t *Thread_Create_(const char *name, ThreadRunFunc run, void *data);
 #define Thread_Create(function, data) Thread_Create_(#function, function, data)
+thread_t *Thread_CreateAfter_(const char *name, ThreadRunFunc run, void *data, thread_t **dependencies, size_t num_dependencies);
+#define Thread_CreateAfter(function, data, dependencies, num_dependencies) \
+	Thread_CreateAfter_(#function, function, data, dependencies, num_dependencies)
+thread_t *Thread_Then_(thread_t *t, const char *name, ThreadRunFunc run, void *data);
+#define Thread_Then(t, function, data) Thread_Then_(t, #function, function, data)
+void Thread_ParallelFor_(const char *name, int32_t count, int32_t grain, ThreadForFunc func, void *data);
+#define Thread_ParallelFor(count, grain, function, data) Thread_ParallelFor_(#function, count, grain, function, data)
 void Thread_Wait(thread_t *t);
+void Thread_Detach(thread_t *t);
 uint16_t Thread_Count(void);
+uint16_t Thread_Index(void);
+void Thread_Stats(thread_stats_t *stats);
+void Thread_ResetStats(void);
 void Thread_Init(ssize_t num_threads);
 void Thread_Shutdown(void);
 
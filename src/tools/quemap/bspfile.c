@@ -268,21 +268,21 @@ int32_t LoadBSPFile(const char *filename, const bsp_lump_id_t lumps) {
 
 	memset(&bsp_file, 0, sizeof(bsp_file));
 
-	bsp_header_t *file;
+	const bsp_header_t *file;
 
-	if (Fs_Load(filename, (void **) &file) == -1) {
+	if (Fs_Map(filename, (const void **) &file) == -1) {
 		Com_Error(ERROR_FATAL, "Invalid BSP file at %s\n", filename);
 	}
 
 	const int32_t version = Bsp_Verify(file);
 
 	if (!version) {
-		Fs_Free(file);
+		Fs_Unmap(file);
 		Com_Error(ERROR_FATAL, "Invalid BSP file at %s\n", filename);
 	}
 
 	Bsp_LoadLumps(file, &bsp_file, lumps);
-	Fs_Free(file);
+	Fs_Unmap(file);
 
 	return version;
 }
@@ -88,7 +88,7 @@ _Bool Light_PointPVS(const vec3_t org, byte *pvs) {
  * @brief
  */
 _Bool Light_InPVS(const vec3_t p1, const vec3_t p2) {
-	byte pvs[MAX_BSP_LEAFS >> 3];
+	byte vis[MAX_BSP_LEAFS >> 3];
 
 	const int32_t leaf1 = Cm_PointLeafnum(p1, 0);
 	const int32_t leaf2 = Cm_PointLeafnum(p2, 0);
@@ -103,7 +103,12 @@ _Bool Light_InPVS(const vec3_t p1, const vec3_t p2) {
 	const int32_t cluster1 = Cm_LeafCluster(leaf1);
 	const int32_t cluster2 = Cm_LeafCluster(leaf2);
 
-	Cm_ClusterPVS(cluster1, pvs);
+	// use the decompressed row when possible, rather than copying it
+	const byte *pvs = Cm_ClusterPVSRow(cluster1);
+	if (pvs == NULL) {
+		Cm_ClusterPVS(cluster1, vis);
+		pvs = vis;
+	}
 
 	if ((pvs[cluster2 >> 3] & (1 << (cluster2 & 7))) == 0) {
 		return false;
@@ -101,7 +101,7 @@ void Sem_Init(void);
 void Sem_Shutdown(void);
 
 typedef struct thread_work_s {
-	int32_t index; // current work cycle
+	int32_t index; // completed work cycles
 	int32_t count; // total work cycles
 	int32_t fraction; // last fraction of work completed
 	_Bool progress; // are we reporting progress
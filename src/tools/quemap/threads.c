@@ -56,16 +56,13 @@ void Sem_Shutdown(void) {
 }
 
 /**
- * @brief Return an iteration of work, updating progress when appropriate.
+ * @brief Updates the progress of the current work, printing it if desired.
  */
-static int32_t GetThreadWork(void) {
+static void ThreadProgress(void) {
 
 	ThreadLock();
 
-	if (thread_work.index == thread_work.count || !Com_WasInit(QUETOO_MAPTOOL)) { // done or killed
-		ThreadUnlock();
-		return -1;
-	}
+	thread_work.index++;
 
 	// update work fraction and output progress if desired
 	const int32_t f = 50 * thread_work.index / thread_work.count;
@@ -82,30 +79,27 @@ static int32_t GetThreadWork(void) {
 		thread_work.fraction = f;
 	}
 
-	// assign the next work iteration
-	const int32_t r = thread_work.index;
-	thread_work.index++;
-
 	ThreadUnlock();
-
-	return r;
 }
 
 // generic function pointer to actual work to be done
 static ThreadWorkFunc WorkFunction;
 
 /**
- * @brief Shared work entry point by all threads. Retrieve and perform
- * chunks of work iteratively until work is finished.
+ * @brief ThreadForFunc for RunThreads. Performs the claimed range of work
+ * iterations, unless the tool has been killed.
  */
-static void ThreadWork(void *p) {
+static void ThreadWork(int32_t begin, int32_t end, void *data) {
+
+	for (int32_t i = begin; i < end; i++) {
 
-	while (true) {
-		const int32_t work = GetThreadWork();
-		if (work == -1) {
-			break;
+		if (!Com_WasInit(QUETOO_MAPTOOL)) { // killed
+			return;
 		}
-		WorkFunction(work);
+
+		WorkFunction(i);
+
+		ThreadProgress();
 	}
 }
 
@@ -136,32 +130,22 @@ void ThreadUnlock(void) {
 }
 
 /**
- * @brief
+ * @brief Distributes the work iterations across the thread pool, one at a
+ * time, since their cost varies considerably.
  */
 static void RunThreads(void) {
 
-	const uint16_t thread_count = Thread_Count();
-
-	if (thread_count == 0) {
-		ThreadWork(0);
-		return;
+	if (Thread_Count()) {
+		assert(!lock);
+		lock = SDL_CreateMutex();
 	}
 
-	assert(!lock);
-	lock = SDL_CreateMutex();
-
-	thread_t *threads[thread_count];
+	Thread_ParallelFor(thread_work.count, 1, ThreadWork, NULL);
 
-	for (uint16_t i = 0; i < thread_count; i++) {
-		threads[i] = Thread_Create(ThreadWork, NULL);
+	if (lock) {
+		SDL_DestroyMutex(lock);
+		lock = NULL;
 	}
-
-	for (uint16_t i = 0; i < thread_count; i++) {
-		Thread_Wait(threads[i]);
-	}
-
-	SDL_DestroyMutex(lock);
-	lock = NULL;
 }
 
 /**
@@ -44,6 +44,7 @@
 	#include <netinet/in.h>
 	#include <sys/select.h>
 	#include <sys/socket.h>
+	#include <unistd.h>
 
 #endif
 
@@ -51,8 +52,14 @@
 
 quetoo_t quetoo;
 
+/**
+ * @brief Addresses are stored as IPv6, with IPv4 addresses v4-mapped, so that
+ * the master serves both IPv4 and IPv6 hosts from a single dual-stack socket.
+ */
+typedef struct sockaddr_in6 ms_addr_t;
+
 typedef struct ms_server_s {
-	struct sockaddr_in addr;
+	ms_addr_t addr;
 	uint16_t queued_pings;
 	time_t last_heartbeat;
 	time_t last_ping;
@@ -61,15 +68,37 @@ typedef struct ms_server_s {
 
 static GList *ms_servers;
 static int32_t ms_sock;
+static int32_t ms_family;
 
 static _Bool verbose;
 static _Bool debug;
 
+/**
+ * @return The printable host of the specified address, in dotted decimal
+ * notation for IPv4 hosts.
+ */
+static const char *Ms_Host(const ms_addr_t *addr) {
+	static char host[INET6_ADDRSTRLEN];
+
+	if (IN6_IS_ADDR_V4MAPPED(&addr->sin6_addr)) {
+		inet_ntop(AF_INET, (const void *) &addr->sin6_addr.s6_addr[12], host, sizeof(host));
+	} else {
+		inet_ntop(AF_INET6, (const void *) &addr->sin6_addr, host, sizeof(host));
+	}
+
+	return host;
+}
+
 /**
  * @brief Shorthand for printing Internet addresses.
  */
-static const char *atos(const struct sockaddr_in *addr) {
-	return va("%s:%d", inet_ntoa(addr->sin_addr), ntohs(addr->sin_port));
+static const char *atos(const ms_addr_t *addr) {
+
+	if (IN6_IS_ADDR_V4MAPPED(&addr->sin6_addr)) {
+		return va("%s:%d", Ms_Host(addr), ntohs(addr->sin6_port));
+	} else {
+		return va("[%s]:%d", Ms_Host(addr), ntohs(addr->sin6_port));
+	}
 }
 
 #define stos(s) (atos(&s->addr))
@@ -77,14 +106,14 @@ static const char *atos(const struct sockaddr_in *addr) {
 /**
  * @brief Returns the server for the specified address, or `NULL`.
  */
-static ms_server_t *Ms_GetServer(struct sockaddr_in *from) {
+static ms_server_t *Ms_GetServer(const ms_addr_t *from) {
 
 	GList *s = ms_servers;
 	while (s) {
 		ms_server_t *server = (ms_server_t *) s->data;
 
-		const struct sockaddr_in *addr = &server->addr;
-		if (addr->sin_addr.s_addr == from->sin_addr.s_addr && addr->sin_port == from->sin_port) {
+		const ms_addr_t *addr = &server->addr;
+		if (IN6_ARE_ADDR_EQUAL(&addr->sin6_addr, &from->sin6_addr) && addr->sin6_port == from->sin6_port) {
 			return server;
 		}
 
@@ -94,6 +123,36 @@ static ms_server_t *Ms_GetServer(struct sockaddr_in *from) {
 	return NULL;
 }
 
+/**
+ * @brief Sends the specified datagram, converting the address back to IPv4 if
+ * the master is running without IPv6 support.
+ */
+static void Ms_SendTo(const ms_addr_t *to, const void *data, size_t len) {
+	const struct sockaddr *addr = (const struct sockaddr *) to;
+	socklen_t addr_len = sizeof(*to);
+
+	struct sockaddr_in in;
+
+	if (ms_family == AF_INET) {
+		if (!IN6_IS_ADDR_V4MAPPED(&to->sin6_addr)) {
+			return;
+		}
+
+		memset(&in, 0, sizeof(in));
+
+		in.sin_family = AF_INET;
+		memcpy(&in.sin_addr, &to->sin6_addr.s6_addr[12], sizeof(in.sin_addr));
+		in.sin_port = to->sin6_port;
+
+		addr = (const struct sockaddr *) &in;
+		addr_len = sizeof(in);
+	}
+
+	if ((sendto(ms_sock, data, len, 0, addr, addr_len)) == -1) {
+		Com_Warn("%s: %s\n", atos(to), strerror(errno));
+	}
+}
+
 /**
  * @brief Removes the specified server.
  */
@@ -113,7 +172,7 @@ static void Ms_DropServer(ms_server_t *server) {
  *
  * Ensure that the file is new-line terminated for all rules to be evaluated.
  */
-static _Bool Ms_BlacklistServer(struct sockaddr_in *from) {
+static _Bool Ms_BlacklistServer(const ms_addr_t *from) {
 	char *buffer;
 	int64_t len;
 
@@ -122,7 +181,7 @@ static _Bool Ms_BlacklistServer(struct sockaddr_in *from) {
 	}
 
 	char *c = buffer;
-	char *ip = inet_ntoa(from->sin_addr);
+	const char *ip = Ms_Host(from);
 
 	_Bool blacklisted = false;
 
@@ -152,7 +211,7 @@ static _Bool Ms_BlacklistServer(struct sockaddr_in *from) {
 /**
  * @brief Adds the specified server to the master.
  */
-static void Ms_AddServer(struct sockaddr_in *from) {
+static void Ms_AddServer(const ms_addr_t *from) {
 
 	if (Ms_GetServer(from)) {
 		Com_Warn("Duplicate ping from %s\n", atos(from));
@@ -173,13 +232,13 @@ static void Ms_AddServer(struct sockaddr_in *from) {
 	Com_Print("Server %s registered\n", stos(server));
 
 	// send an acknowledgment
-	sendto(ms_sock, "\xFF\xFF\xFF\xFF" "ack", 7, 0, (struct sockaddr *) from, sizeof(*from));
+	Ms_SendTo(from, "\xFF\xFF\xFF\xFF" "ack", 7);
 }
 
 /**
  * @brief Removes the specified server.
  */
-static void Ms_RemoveServer(struct sockaddr_in *from) {
+static void Ms_RemoveServer(const ms_addr_t *from) {
 	ms_server_t *server = Ms_GetServer(from);
 
 	if (!server) {
@@ -213,8 +272,7 @@ static void Ms_Frame(void) {
 					Com_Verbose("Pinging %s\n", stos(server));
 
 					const char *ping = "\xFF\xFF\xFF\xFF" "ping";
-					sendto(ms_sock, ping, strlen(ping), 0, (struct sockaddr *) &server->addr,
-					       sizeof(server->addr));
+					Ms_SendTo(&server->addr, ping, strlen(ping));
 				}
 			}
 		}
@@ -224,40 +282,58 @@ static void Ms_Frame(void) {
 }
 
 /**
- * @brief Send the servers list to the specified client address.
+ * @brief Send the servers list to the specified client address. The `servers`
+ * response lists IPv4 servers by their 4 byte address, and is understood by all
+ * clients. The `servers6` response lists servers by their 16 byte address, and
+ * includes IPv6 servers only for clients that queried over IPv6, since others
+ * could not reach them.
  */
-static void Ms_GetServers(struct sockaddr_in *from) {
+static void Ms_GetServers(const ms_addr_t *from, _Bool ipv6) {
 	mem_buf_t buf;
 	byte buffer[0xffff];
 
 	Mem_InitBuffer(&buf, buffer, sizeof(buffer));
 
-	const char *servers = "\xFF\xFF\xFF\xFF" "servers ";
+	const char *servers = ipv6 ? "\xFF\xFF\xFF\xFF" "servers6 " : "\xFF\xFF\xFF\xFF" "servers ";
 	Mem_WriteBuffer(&buf, servers, strlen(servers));
 
+	const _Bool from_ipv6 = !IN6_IS_ADDR_V4MAPPED(&from->sin6_addr);
+
 	uint32_t i = 0;
 	GList *s = ms_servers;
 	while (s) {
 		const ms_server_t *server = (ms_server_t *) s->data;
 		if (server->validated) {
-			Mem_WriteBuffer(&buf, &server->addr.sin_addr, sizeof(server->addr.sin_addr));
-			Mem_WriteBuffer(&buf, &server->addr.sin_port, sizeof(server->addr.sin_port));
+			const struct in6_addr *addr = &server->addr.sin6_addr;
+
+			if (IN6_IS_ADDR_V4MAPPED(addr)) {
+				if (ipv6) {
+					Mem_WriteBuffer(&buf, addr->s6_addr, sizeof(addr->s6_addr));
+				} else {
+					Mem_WriteBuffer(&buf, &addr->s6_addr[12], 4);
+				}
+			} else if (ipv6 && from_ipv6) {
+				Mem_WriteBuffer(&buf, addr->s6_addr, sizeof(addr->s6_addr));
+			} else {
+				s = s->next;
+				continue;
+			}
+
+			Mem_WriteBuffer(&buf, &server->addr.sin6_port, sizeof(server->addr.sin6_port));
 			i++;
 		}
 		s = s->next;
 	}
 
-	if ((sendto(ms_sock, buf.data, buf.size, 0, (struct sockaddr *) from, sizeof(*from))) == -1) {
-		Com_Warn("%s: %s\n", atos(from), strerror(errno));
-	} else {
-		Com_Verbose("Sent %d servers to %s\n", i, atos(from));
-	}
+	Ms_SendTo(from, buf.data, buf.size);
+
+	Com_Verbose("Sent %d servers to %s\n", i, atos(from));
 }
 
 /**
  * @brief Acknowledge the server from the specified address.
  */
-static void Ms_Ack(struct sockaddr_in *from) {
+static void Ms_Ack(const ms_addr_t *from) {
 	ms_server_t *server = Ms_GetServer(from);
 
 	if (server) {
@@ -274,7 +350,7 @@ static void Ms_Ack(struct sockaddr_in *from) {
 /**
  * @brief Accept a "heartbeat" from the specified server address.
  */
-static void Ms_Heartbeat(struct sockaddr_in *from) {
+static void Ms_Heartbeat(const ms_addr_t *from) {
 	ms_server_t *server = Ms_GetServer(from);
 
 	if (server) {
@@ -283,7 +359,7 @@ static void Ms_Heartbeat(struct sockaddr_in *from) {
 		Com_Verbose("Heartbeat from %s\n", stos(server));
 
 		const void *ack = "\xFF\xFF\xFF\xFF" "ack";
-		sendto(ms_sock, ack, 7, 0, (struct sockaddr *) &server->addr, sizeof(server->addr));
+		Ms_SendTo(&server->addr, ack, 7);
 	} else {
 		Ms_AddServer(from);
 	}
@@ -292,7 +368,7 @@ static void Ms_Heartbeat(struct sockaddr_in *from) {
 /**
  * @brief
  */
-static void Ms_ParseMessage(struct sockaddr_in *from, char *data) {
+static void Ms_ParseMessage(const ms_addr_t *from, char *data) {
 	char *cmd = data;
 	char *line = data;
 
@@ -311,13 +387,81 @@ static void Ms_ParseMessage(struct sockaddr_in *from, char *data) {
 		Ms_Ack(from);
 	} else if (!g_ascii_strncasecmp(cmd, "shutdown", 8)) {
 		Ms_RemoveServer(from);
+	} else if (!g_ascii_strncasecmp(cmd, "getservers6", 11)) {
+		Ms_GetServers(from, true);
 	} else if (!g_ascii_strncasecmp(cmd, "getservers", 10) || !g_ascii_strncasecmp(cmd, "y", 1)) {
-		Ms_GetServers(from);
+		Ms_GetServers(from, false);
 	} else {
 		Com_Warn("Unknown command from %s: '%s'", atos(from), cmd);
 	}
 }
 
+/**
+ * @brief Initializes the master address from the IPv4 or IPv6 socket address.
+ */
+static void Ms_Address(const struct sockaddr_storage *addr, ms_addr_t *out) {
+
+	memset(out, 0, sizeof(*out));
+	out->sin6_family = AF_INET6;
+
+	if (addr->ss_family == AF_INET6) {
+		*out = *(const struct sockaddr_in6 *) addr;
+	} else if (addr->ss_family == AF_INET) {
+		const struct sockaddr_in *in = (const struct sockaddr_in *) addr;
+
+		out->sin6_addr.s6_addr[10] = out->sin6_addr.s6_addr[11] = 0xff;
+		memcpy(&out->sin6_addr.s6_addr[12], &in->sin_addr, sizeof(in->sin_addr));
+		out->sin6_port = in->sin_port;
+	}
+}
+
+/**
+ * @brief Creates and binds the master socket, preferring a dual-stack IPv6
+ * socket, and falling back to IPv4 on hosts without IPv6 support.
+ */
+static int32_t Ms_Socket(void) {
+
+	int32_t sock = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock != -1) {
+		const int32_t v6only = 0;
+
+		struct sockaddr_in6 address;
+		memset(&address, 0, sizeof(address));
+
+		address.sin6_family = AF_INET6;
+		address.sin6_port = htons(PORT_MASTER);
+		address.sin6_addr = in6addr_any;
+
+		if (setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, (const void *) &v6only, sizeof(v6only)) == 0 &&
+		    bind(sock, (struct sockaddr *) &address, sizeof(address)) == 0) {
+			ms_family = AF_INET6;
+			return sock;
+		}
+
+#if defined(_WIN32)
+		closesocket(sock);
+#else
+		close(sock);
+#endif
+	}
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+
+	address.sin_family = AF_INET;
+	address.sin_port = htons(PORT_MASTER);
+	address.sin_addr.s_addr = INADDR_ANY;
+
+	if ((bind(sock, (struct sockaddr *) &address, sizeof(address))) == -1) {
+		Com_Error(ERROR_FATAL, "Failed to bind port %i\n", PORT_MASTER);
+	}
+
+	ms_family = AF_INET;
+	return sock;
+}
+
 /**
  * @brief Com_Debug implementation.
  */
@@ -403,20 +547,9 @@ int32_t main(int32_t argc, char **argv) {
 		}
 	}
 
-	ms_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-
-	struct sockaddr_in address;
-	memset(&address, 0, sizeof(address));
-
-	address.sin_family = AF_INET;
-	address.sin_port = htons(PORT_MASTER);
-	address.sin_addr.s_addr = INADDR_ANY;
+	ms_sock = Ms_Socket();
 
-	if ((bind(ms_sock, (struct sockaddr *) &address, sizeof(address))) == -1) {
-		Com_Error(ERROR_FATAL, "Failed to bind port %i\n", PORT_MASTER);
-	}
-
-	Com_Print("Listening on %s\n", atos(&address));
+	Com_Print("Listening on port %d (%s)\n", PORT_MASTER, ms_family == AF_INET6 ? "IPv6 and IPv4" : "IPv4");
 
 	while (true) {
 		fd_set set;
@@ -435,13 +568,16 @@ int32_t main(int32_t argc, char **argv) {
 				char buffer[0xffff];
 				memset(buffer, 0, sizeof(buffer));
 
-				struct sockaddr_in from;
-				memset(&from, 0, sizeof(from));
+				struct sockaddr_storage addr;
+				memset(&addr, 0, sizeof(addr));
 
-				socklen_t from_len = sizeof(from);
+				socklen_t addr_len = sizeof(addr);
 
 				const ssize_t len = recvfrom(ms_sock, buffer, sizeof(buffer), 0,
-				                             (struct sockaddr *) &from, &from_len);
+				                             (struct sockaddr *) &addr, &addr_len);
+
+				ms_addr_t from;
+				Ms_Address(&addr, &from);
 
 				if (len > 0) {
 					if (len > 4) {